@@ -0,0 +1,143 @@
+/*
+ *  The ManaPlus Client
+ *  Copyright (C) 2011-2014  The ManaPlus Developers
+ *
+ *  This file is part of The ManaPlus Client.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "actorgrid.h"
+
+#include "being/actorsprite.h"
+
+#include "debug.h"
+
+// cell size in tiles
+static const int cellSize = 8;
+
+ActorGrid::ActorGrid() :
+    mCells(1),
+    mWidth(1),
+    mHeight(1)
+{
+}
+
+ActorGrid::~ActorGrid()
+{
+    clear();
+}
+
+void ActorGrid::resize(const int width, const int height)
+{
+    clear();
+    mWidth = width > 0 ? (width + cellSize - 1) / cellSize : 1;
+    mHeight = height > 0 ? (height + cellSize - 1) / cellSize : 1;
+    mCells.clear();
+    mCells.resize(mWidth * mHeight);
+}
+
+void ActorGrid::clear()
+{
+    FOR_EACH (std::vector<ActorCell>::iterator, it, mCells)
+    {
+        ActorCell &cell = *it;
+        FOR_EACH (ActorCellIterator, it2, cell)
+            (*it2)->setGridCell(-1);
+        cell.clear();
+    }
+}
+
+int ActorGrid::getCell(const int x, const int y) const
+{
+    int cellX = x / cellSize;
+    int cellY = y / cellSize;
+    if (cellX < 0)
+        cellX = 0;
+    else if (cellX >= mWidth)
+        cellX = mWidth - 1;
+    if (cellY < 0)
+        cellY = 0;
+    else if (cellY >= mHeight)
+        cellY = mHeight - 1;
+    return cellY * mWidth + cellX;
+}
+
+void ActorGrid::add(ActorSprite *const actor)
+{
+    if (!actor)
+        return;
+    if (actor->getGridCell() >= 0)
+        remove(actor);
+
+    const int cell = getCell(actor->getTileX(), actor->getTileY());
+    mCells[cell].push_back(actor);
+    actor->setGridCell(cell);
+}
+
+void ActorGrid::remove(ActorSprite *const actor)
+{
+    if (!actor)
+        return;
+    const int cell = actor->getGridCell();
+    if (cell < 0)
+        return;
+    actor->setGridCell(-1);
+
+    ActorCell &actors = mCells[cell];
+    FOR_EACH (ActorCellIterator, it, actors)
+    {
+        if (*it == actor)
+        {
+            *it = actors.back();
+            actors.pop_back();
+            return;
+        }
+    }
+}
+
+void ActorGrid::update(ActorSprite *const actor)
+{
+    if (!actor)
+        return;
+    const int oldCell = actor->getGridCell();
+    if (oldCell < 0)
+        return;
+    if (getCell(actor->getTileX(), actor->getTileY()) != oldCell)
+        add(actor);
+}
+
+void ActorGrid::find(std::vector<ActorSprite*> &actors,
+                     int x1, int y1, int x2, int y2) const
+{
+    if (x1 > x2 || y1 > y2)
+        return;
+
+    const int cell1 = getCell(x1, y1);
+    const int cell2 = getCell(x2, y2);
+    const int cellX1 = cell1 % mWidth;
+    const int cellY1 = cell1 / mWidth;
+    const int cellX2 = cell2 % mWidth;
+    const int cellY2 = cell2 / mWidth;
+
+    for (int cellY = cellY1; cellY <= cellY2; cellY ++)
+    {
+        const int offset = cellY * mWidth;
+        for (int cellX = cellX1; cellX <= cellX2; cellX ++)
+        {
+            const ActorCell &cell = mCells[offset + cellX];
+            actors.insert(actors.end(), cell.begin(), cell.end());
+        }
+    }
+}
@@ -0,0 +1,84 @@
+/*
+ *  The ManaPlus Client
+ *  Copyright (C) 2011-2014  The ManaPlus Developers
+ *
+ *  This file is part of The ManaPlus Client.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ACTORGRID_H
+#define ACTORGRID_H
+
+#include <vector>
+
+#include "localconsts.h"
+
+class ActorSprite;
+
+/**
+ * Uniform spatial index of actors, bucketed by tile coordinates.
+ * Each actor remembers its cell, so moving or removing it does not need
+ * the old coordinates.
+ */
+class ActorGrid final
+{
+    public:
+        ActorGrid();
+
+        A_DELETE_COPY(ActorGrid)
+
+        ~ActorGrid();
+
+        /**
+         * Sets the grid size in tiles. Removes all actors from the grid.
+         */
+        void resize(const int width, const int height);
+
+        /**
+         * Removes all actors from the grid.
+         */
+        void clear();
+
+        void add(ActorSprite *const actor);
+
+        void remove(ActorSprite *const actor);
+
+        /**
+         * Moves the actor to the cell of its current tile coordinates.
+         * Actors not added to the grid are ignored.
+         */
+        void update(ActorSprite *const actor);
+
+        /**
+         * Adds to actors all actors from the cells overlapping the given
+         * inclusive tile rectangle. Result can contain actors outside of
+         * the rectangle.
+         */
+        void find(std::vector<ActorSprite*> &actors,
+                  int x1, int y1, int x2, int y2) const;
+
+    private:
+        int getCell(const int x, const int y) const A_WARN_UNUSED;
+
+        typedef std::vector<ActorSprite*> ActorCell;
+        typedef ActorCell::iterator ActorCellIterator;
+        typedef ActorCell::const_iterator ActorCellConstIterator;
+
+        std::vector<ActorCell> mCells;
+        int mWidth;
+        int mHeight;
+};
+
+#endif  // ACTORGRID_H
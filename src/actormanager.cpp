@@ -48,6 +48,8 @@
 #include "net/packetlimiter.h"
 #include "net/playerhandler.h"
 
+#include "resources/map/map.h"
+
 #include <algorithm>
 #include <list>
 
@@ -59,6 +61,9 @@
 #define for_actorsm for (ActorSpritesIterator it = mActors.begin(), \
     it_end = mActors.end() ; it != it_end; ++it)
 
+#define for_found for (std::vector<ActorSprite*>::const_iterator \
+    it = found.begin(), it_end = found.end() ; it != it_end; ++it)
+
 ActorManager *actorManager = nullptr;
 
 class FindBeingFunctor final
@@ -181,6 +186,10 @@ class SortBeingFunctor final
 ActorManager::ActorManager() :
     mActors(),
     mDeleteActors(),
+    mBeingsById(),
+    mItemsById(),
+    mGrid(),
+    mPixelMargin(0),
     mBlockedBeings(),
     mMap(nullptr),
     mSpellHeal1(serverConfig.getValue("spellHeal1", "#lum")),
@@ -209,12 +218,20 @@ ActorManager::~ActorManager()
     CHECKLISTENERS
     storeAttackList();
     clear();
+    mGrid.clear();
 }
 
 void ActorManager::setMap(Map *const map)
 {
     mMap = map;
 
+    if (map)
+        mGrid.resize(map->getWidth(), map->getHeight());
+    else
+        mGrid.resize(0, 0);
+    for_actorsm
+        mGrid.add(*it);
+
     if (player_node)
         player_node->setMap(map);
 }
@@ -223,6 +240,7 @@ void ActorManager::setPlayer(LocalPlayer *const player)
 {
     player_node = player;
     mActors.insert(player);
+    mGrid.add(player);
     if (socialWindow)
         socialWindow->updateAttackFilter();
     if (socialWindow)
@@ -236,6 +254,8 @@ Being *ActorManager::createBeing(const int id,
     Being *const being = new Being(id, type, subtype, mMap);
 
     mActors.insert(being);
+    mBeingsById[id] = being;
+    mGrid.add(being);
     return being;
 }
 
@@ -252,6 +272,8 @@ FloorItem *ActorManager::createItem(const int id, const int itemId,
     if (!checkForPickup(floorItem))
         floorItem->disableHightlight();
     mActors.insert(floorItem);
+    mItemsById[id] = floorItem;
+    mGrid.add(floorItem);
     return floorItem;
 }
 
@@ -269,6 +291,25 @@ void ActorManager::erase(ActorSprite *const actor)
         return;
 
     mActors.erase(actor);
+    removeFromIdMaps(actor);
+    mGrid.remove(actor);
+}
+
+void ActorManager::removeFromIdMap(ActorSpritesMap &map,
+                                   const ActorSprite *const actor)
+{
+    // id can be already reused by new actor, so remove only own entry
+    const ActorSpritesMapIterator it = map.find(actor->getId());
+    if (it != map.end() && (*it).second == actor)
+        map.erase(it);
+}
+
+void ActorManager::removeFromIdMaps(const ActorSprite *const actor)
+{
+    if (actor->getType() == ActorType::FLOOR_ITEM)
+        removeFromIdMap(mItemsById, actor);
+    else
+        removeFromIdMap(mBeingsById, actor);
 }
 
 void ActorManager::undelete(const ActorSprite *const actor)
@@ -288,17 +329,13 @@ void ActorManager::undelete(const ActorSprite *const actor)
 
 Being *ActorManager::findBeing(const int id) const
 {
-    for_actors
-    {
-        ActorSprite *const actor = *it;
-        if (actor->getId() == id &&
-            actor->getType() != ActorType::FLOOR_ITEM)
-        {
-            return static_cast<Being*>(actor);
-        }
-    }
+    if (player_node && player_node->getId() == id)
+        return player_node;
 
-    return nullptr;
+    const ActorSpritesMapConstIterator it = mBeingsById.find(id);
+    if (it == mBeingsById.end())
+        return nullptr;
+    return static_cast<Being*>((*it).second);
 }
 
 Being *ActorManager::findBeing(const int x, const int y,
@@ -308,10 +345,45 @@ Being *ActorManager::findBeing(const int x, const int y,
     beingActorFinder.y = static_cast<uint16_t>(y);
     beingActorFinder.type = type;
 
-    const ActorSpritesConstIterator it = std::find_if(
-        mActors.begin(), mActors.end(), beingActorFinder);
+    // being pixel position is tile below its tile position, and
+    // walking or height offsets can move it by some tiles
+    std::vector<ActorSprite*> found;
+    mGrid.find(found, x - 2, y - 2, x + 2, y + 4);
+    const std::vector<ActorSprite*>::const_iterator it = std::find_if(
+        found.begin(), found.end(), beingActorFinder);
+
+    return (it == found.end()) ? nullptr : static_cast<Being*>(*it);
+}
 
-    return (it == mActors.end()) ? nullptr : static_cast<Being*>(*it);
+void ActorManager::findActorsNearPixel(std::vector<ActorSprite*> &actors,
+                                       const int x, const int y) const
+{
+    // targeting areas extend around actor pixel position, which can be
+    // away from actor tile position while walking, on hills or before
+    // first logic call after tile position changed
+    const int tileX = x / mapTileSize;
+    const int tileY = y / mapTileSize;
+    const int margin = mPixelMargin;
+    mGrid.find(actors, tileX - 3 - margin, tileY - 3 - margin,
+        tileX + 3 + margin, tileY + 5 + margin);
+}
+
+void ActorManager::updatePixelMargin(const ActorSprite *const actor)
+{
+    const int dx = abs(actor->getPixelX()
+        - actor->getTileX() * mapTileSize - mapTileSize / 2);
+    const int dy = abs(actor->getPixelY()
+        - actor->getTileY() * mapTileSize - mapTileSize);
+    const int margin = (std::max(dx, dy) + mapTileSize - 1) / mapTileSize;
+    if (margin > mPixelMargin)
+        mPixelMargin = margin;
+}
+
+void ActorManager::updateActorPosition(ActorSprite *const actor)
+{
+    mGrid.update(actor);
+    if (actor)
+        updatePixelMargin(actor);
 }
 
 Being *ActorManager::findBeingByPixel(const int x, const int y,
@@ -324,12 +396,15 @@ Being *ActorManager::findBeingByPixel(const int x, const int y,
     const bool modActive = inputManager.isActionActive(
         InputAction::STOP_ATTACK);
 
+    std::vector<ActorSprite*> found;
+    findActorsNearPixel(found, x, y);
+
     if (mExtMouseTargeting)
     {
         Being *tempBeing = nullptr;
         bool noBeing(false);
 
-        for_actorsm
+        for_found
         {
             if (!*it)
                 continue;
@@ -392,7 +467,7 @@ Being *ActorManager::findBeingByPixel(const int x, const int y,
     }
     else
     {
-        for_actorsm
+        for_found
         {
             if (!*it)
                 continue;
@@ -435,7 +510,10 @@ void ActorManager::findBeingsByPixel(std::vector<ActorSprite*> &beings,
     const bool modActive = inputManager.isActionActive(
         InputAction::STOP_ATTACK);
 
-    for_actors
+    std::vector<ActorSprite*> found;
+    findActorsNearPixel(found, x, y);
+
+    for_found
     {
         if (!*it)
             continue;
@@ -474,7 +552,9 @@ Being *ActorManager::findPortalByTile(const int x, const int y) const
     if (!mMap)
         return nullptr;
 
-    for_actorsm
+    std::vector<ActorSprite*> found;
+    mGrid.find(found, x, y, x, y);
+    for_found
     {
         if (!*it)
             continue;
@@ -493,24 +573,17 @@ Being *ActorManager::findPortalByTile(const int x, const int y) const
 
 FloorItem *ActorManager::findItem(const int id) const
 {
-    for_actorsm
-    {
-        if (!*it)
-            continue;
-
-        if ((*it)->getId() == id &&
-            (*it)->getType() == ActorType::FLOOR_ITEM)
-        {
-            return static_cast<FloorItem*>(*it);
-        }
-    }
-
-    return nullptr;
+    const ActorSpritesMapConstIterator it = mItemsById.find(id);
+    if (it == mItemsById.end())
+        return nullptr;
+    return static_cast<FloorItem*>((*it).second);
 }
 
 FloorItem *ActorManager::findItem(const int x, const int y) const
 {
-    for_actorsm
+    std::vector<ActorSprite*> found;
+    mGrid.find(found, x, y, x, y);
+    for_found
     {
         if (!*it)
             continue;
@@ -534,9 +607,11 @@ bool ActorManager::pickUpAll(const int x1, const int y1,
 
     bool finded(false);
     const bool allowAll = mPickupItemsSet.find("") != mPickupItemsSet.end();
+    std::vector<ActorSprite*> found;
+    mGrid.find(found, x1, y1, x2, y2);
     if (!serverBuggy)
     {
-        for_actorsm
+        for_found
         {
             if (!*it)
                 continue;
@@ -571,7 +646,7 @@ bool ActorManager::pickUpAll(const int x1, const int y1,
     {
         FloorItem *item = nullptr;
         unsigned cnt = 65535;
-        for_actorsm
+        for_found
         {
             if (!*it)
                 continue;
@@ -628,12 +703,16 @@ bool ActorManager::pickUpNearest(const int x, const int y,
     if (!player_node)
         return false;
 
+    // items outside of this square are farther than maxdist
+    std::vector<ActorSprite*> found;
+    mGrid.find(found, x - maxdist, y - maxdist, x + maxdist, y + maxdist);
+
     maxdist = maxdist * maxdist;
     FloorItem *closestItem = nullptr;
     int dist = 0;
     const bool allowAll = mPickupItemsSet.find("") != mPickupItemsSet.end();
 
-    for_actorsm
+    for_found
     {
         if (!*it)
             continue;
@@ -758,10 +837,14 @@ const ActorSprites &ActorManager::getAll() const
 void ActorManager::logic()
 {
     BLOCK_START("ActorManager::logic")
+    mPixelMargin = 0;
     for_actors
     {
         if (*it)
+        {
             (*it)->logic();
+            updatePixelMargin(*it);
+        }
     }
 
     if (mDeleteActors.empty())
@@ -798,6 +881,8 @@ void ActorManager::logic()
     {
         ActorSprite *actor = *it;
         mActors.erase(actor);
+        removeFromIdMaps(actor);
+        mGrid.remove(actor);
         delete actor;
     }
 
@@ -818,13 +903,19 @@ void ActorManager::clear()
         mActors.erase(player_node);
     }
 
+    mGrid.clear();
     for_actors
         delete *it;
     mActors.clear();
     mDeleteActors.clear();
+    mBeingsById.clear();
+    mItemsById.clear();
 
     if (player_node)
+    {
         mActors.insert(player_node);
+        mGrid.add(player_node);
+    }
 }
 
 Being *ActorManager::findNearestLivingBeing(const int x, const int y,
@@ -884,6 +975,7 @@ Being *ActorManager::findNearestLivingBeing(const Being *const aroundBeing,
         specialDistance = true;
     }
 
+    const int range = abs(maxDist);
     maxDist = maxDist * maxDist;
 
     const bool cycleSelect = allowSort
@@ -1022,7 +1114,18 @@ Being *ActorManager::findNearestLivingBeing(const Being *const aroundBeing,
         int index = defaultPriorityIndex;
         Being *closestBeing = nullptr;
 
-        FOR_EACH (ActorSprites::iterator, i, mActors)
+        std::vector<ActorSprite*> found;
+        if (!filtered && !mTargetOnlyReachable)
+        {
+            // beings outside of this square are farther than maxDist
+            mGrid.find(found, x - range, y - range, x + range, y + range);
+        }
+        else
+        {
+            found.assign(mActors.begin(), mActors.end());
+        }
+
+        FOR_EACH (std::vector<ActorSprite*>::const_iterator, i, found)
         {
             if (!*i)
                 continue;
@@ -23,6 +23,7 @@
 #ifndef ACTORMANAGER_H
 #define ACTORMANAGER_H
 
+#include "actorgrid.h"
 #include "flooritem.h"
 
 #include "listeners/configlistener.h"
@@ -31,6 +32,12 @@
 
 #include "localconsts.h"
 
+#ifdef __GXX_EXPERIMENTAL_CXX0X__
+#include <unordered_map>
+#else
+#include <map>
+#endif
+
 class Being;
 class LocalPlayer;
 class Map;
@@ -39,6 +46,14 @@ typedef std::set<ActorSprite*> ActorSprites;
 typedef ActorSprites::iterator ActorSpritesIterator;
 typedef ActorSprites::const_iterator ActorSpritesConstIterator;
 
+#ifdef __GXX_EXPERIMENTAL_CXX0X__
+typedef std::unordered_map<int, ActorSprite*> ActorSpritesMap;
+#else
+typedef std::map<int, ActorSprite*> ActorSpritesMap;
+#endif
+typedef ActorSpritesMap::iterator ActorSpritesMapIterator;
+typedef ActorSpritesMap::const_iterator ActorSpritesMapConstIterator;
+
 class ActorManager final: public ConfigListener
 {
     public:
@@ -58,6 +73,11 @@ class ActorManager final: public ConfigListener
          */
         void setPlayer(LocalPlayer *const player);
 
+        /**
+         * Updates actor position in spatial index after tile change.
+         */
+        void updateActorPosition(ActorSprite *const actor);
+
         /**
          * Create a Being and add it to the list of ActorSprites.
          */
@@ -328,8 +348,24 @@ class ActorManager final: public ConfigListener
 
         void storeAttackList() const;
 
+        static void removeFromIdMap(ActorSpritesMap &map,
+                                    const ActorSprite *const actor);
+
+        void removeFromIdMaps(const ActorSprite *const actor);
+
+        void findActorsNearPixel(std::vector<ActorSprite*> &actors,
+                                 const int x, const int y) const;
+
+        void updatePixelMargin(const ActorSprite *const actor);
+
         ActorSprites mActors;
         ActorSprites mDeleteActors;
+        // beings and floor items indexed by id, player not included
+        ActorSpritesMap mBeingsById;
+        ActorSpritesMap mItemsById;
+        ActorGrid mGrid;
+        // max distance in tiles between actor pixel and tile positions
+        int mPixelMargin;
         std::set<uint32_t> mBlockedBeings;
         Map *mMap;
         std::string mSpellHeal1;
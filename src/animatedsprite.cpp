@@ -79,11 +79,14 @@ AnimatedSprite *AnimatedSprite::delayedLoad(const std::string &filename,
     if (!mEnableCache)
         return load(filename, variant);
     ResourceManager *const resman = ResourceManager::getInstance();
-    Resource *const res = resman->getFromCache(filename, variant);
-    if (res)
+    SpriteDef *const s = static_cast<SpriteDef*>(
+        resman->getFromCache(filename, variant));
+    if (s)
     {
-        res->decRef();
-        return load(filename, variant);
+        AnimatedSprite *const as = new AnimatedSprite(s);
+        as->play(SpriteAction::STAND);
+        s->decRef();
+        return as;
     }
 
     AnimatedSprite *const as = new AnimatedSprite(nullptr);
@@ -189,7 +192,7 @@ bool AnimatedSprite::update(const int time)
 bool AnimatedSprite::updateCurrentAnimation(const unsigned int time)
 {
     // move code from Animation::isTerminator(*mFrame)
-    if (!mFrame || !mAnimation || (!mFrame->image
+    if (!mFrame || !mAnimation || (!mFrame->image && mFrame->imageIndex < 0
         && mFrame->type == Frame::ANIMATION))
     {
         return false;
@@ -256,7 +259,8 @@ bool AnimatedSprite::updateCurrentAnimation(const unsigned int time)
             }
         }
         // copy code from Animation::isTerminator(*mFrame)
-        else if (!mFrame->image && mFrame->type == Frame::ANIMATION)
+        else if (!mFrame->image && mFrame->imageIndex < 0
+                 && mFrame->type == Frame::ANIMATION)
         {
             if (mFrame->rand == 100 || rand() % 100 <= mFrame->rand)
             {
@@ -293,10 +297,12 @@ void AnimatedSprite::draw(Graphics *const graphics,
                           const int posX, const int posY) const
 {
     FUNC_BLOCK("AnimatedSprite::draw", 1)
-    if (!mFrame || !mFrame->image)
+    if (!mFrame || !mSprite)
         return;
 
-    Image *const image = mFrame->image;
+    Image *const image = mSprite->getImage(*mFrame);
+    if (!image)
+        return;
     if (image->getAlpha() != mAlpha)
         image->setAlpha(mAlpha);
 
@@ -342,16 +348,18 @@ unsigned int AnimatedSprite::getFrameCount() const
 
 int AnimatedSprite::getWidth() const
 {
-    if (mFrame && mFrame->image)
-        return mFrame->image->mBounds.w;
+    const Image *const image = getImage();
+    if (image)
+        return image->mBounds.w;
     else
         return 0;
 }
 
 int AnimatedSprite::getHeight() const
 {
-    if (mFrame && mFrame->image)
-        return mFrame->image->mBounds.h;
+    const Image *const image = getImage();
+    if (image)
+        return image->mBounds.h;
     else
         return 0;
 }
@@ -365,16 +373,16 @@ std::string AnimatedSprite::getIdPath() const
 
 const Image* AnimatedSprite::getImage() const
 {
-    return mFrame ? mFrame->image : nullptr;
+    return mFrame && mSprite ? mSprite->getImage(*mFrame) : nullptr;
 }
 
 void AnimatedSprite::setAlpha(float alpha)
 {
     mAlpha = alpha;
 
-    if (mFrame)
+    if (mFrame && mSprite)
     {
-        Image *const image = mFrame->image;
+        Image *const image = mSprite->getImage(*mFrame);
         if (image && image->getAlpha() != mAlpha)
             image->setAlpha(mAlpha);
     }
@@ -382,8 +390,9 @@ void AnimatedSprite::setAlpha(float alpha)
 
 const void *AnimatedSprite::getHash() const
 {
-    if (mFrame)
-        return mFrame;
+    // frames shared by all palettes and variants of sprite
+    if (mFrame && mSprite)
+        return mSprite->getHash(*mFrame);
 //    if (mFrame && mFrame->image)
 //        return mFrame->image;
 //    if (mAnimation)
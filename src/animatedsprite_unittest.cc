@@ -152,3 +152,34 @@ TEST(AnimatedSprite, basic2)
     delete client;
     client = nullptr;
 }
+
+TEST(AnimatedSprite, missingFrameImage)
+{
+    client = new Client;
+    init();
+    AnimatedSprite *sprite = AnimatedSprite::load(
+        "graphics/sprites/test.xml", 0);
+    sprite->play(SpriteAction::ATTACK);
+
+    // frame with index out of image set range dropped
+    EXPECT_EQ(2, const_cast<Animation*>(sprite->getAnimation())
+        ->getFrames().size());
+    EXPECT_EQ(false, sprite->update(1));
+    EXPECT_EQ(0, sprite->getFrameIndex());
+    EXPECT_EQ(10, sprite->getFrame()->delay);
+    EXPECT_NE(nullptr, sprite->getImage());
+
+    EXPECT_EQ(true, sprite->update(1 + 10 + 1));
+    EXPECT_EQ(1, sprite->getFrameIndex());
+    EXPECT_EQ(30, sprite->getFrame()->delay);
+    EXPECT_NE(nullptr, sprite->getImage());
+
+    // other actions keep all frames
+    sprite->play(SpriteAction::SIT);
+    EXPECT_EQ(2, const_cast<Animation*>(sprite->getAnimation())
+        ->getFrames().size());
+
+    delete sprite;
+    delete client;
+    client = nullptr;
+}
@@ -22,9 +22,12 @@
 
 #include "animatedsprite.h"
 
+#include "resources/asyncimageloader.h"
 #include "resources/resourcemanager.h"
 #include "resources/spriteaction.h"
 
+#include "utils/timer.h"
+
 #include "debug.h"
 
 AnimationDelayLoad::AnimationDelayLoad(const std::string &fileName,
@@ -33,8 +36,10 @@ AnimationDelayLoad::AnimationDelayLoad(const std::string &fileName,
     mFileName(fileName),
     mVariant(variant),
     mSprite(sprite),
-    mAction(SpriteAction::STAND)
+    mAction(SpriteAction::STAND),
+    mRequestTime(cur_time)
 {
+    AsyncImageLoader::requestSprite(fileName);
 }
 
 AnimationDelayLoad::~AnimationDelayLoad()
@@ -51,6 +56,13 @@ void AnimationDelayLoad::clearSprite()
     mSprite = nullptr;
 }
 
+bool AnimationDelayLoad::isReady() const
+{
+    // after timeout sprite will be loaded synchronously
+    return AsyncImageLoader::isSpriteReady(mFileName)
+        || cur_time - mRequestTime > 2;
+}
+
 void AnimationDelayLoad::load()
 {
     if (mSprite)
@@ -41,6 +41,12 @@ class AnimationDelayLoad final
 
         void load();
 
+        /**
+         * Returns true if images of sprite was loaded in background,
+         * or if sprite waits for them too long.
+         */
+        bool isReady() const A_WARN_UNUSED;
+
         void setAction(const std::string &action)
         { mAction = action; }
 
@@ -49,6 +55,7 @@ class AnimationDelayLoad final
         int mVariant;
         AnimatedSprite *mSprite;
         std::string mAction;
+        int mRequestTime;
 };
 
 #endif  // ANIMATIONDELAYLOAD_H
@@ -24,7 +24,7 @@
 
 #include "vector.h"
 
-#include <list>
+#include <vector>
 
 #include "localconsts.h"
 
@@ -32,7 +32,7 @@ class Actor;
 class Graphics;
 class Map;
 
-typedef std::list<Actor*> Actors;
+typedef std::vector<Actor*> Actors;
 typedef Actors::const_iterator ActorsCIter;
 
 class Actor notfinal
@@ -135,7 +135,10 @@ protected:
     int mYDiff;
 
 private:
-    Actors::iterator mMapActor;
+    friend class Map;
+
+    /** Index in map actors array, or -1 if not on map. */
+    int mMapIndex;
 };
 
 #endif  // BEING_ACTOR_H
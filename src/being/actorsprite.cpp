@@ -71,6 +71,7 @@ ActorSprite::ActorSprite(const int id) :
     mActorSpriteListeners(),
     mCursorPaddingX(0),
     mCursorPaddingY(0),
+    mGridCell(-1),
     mMustResetParticles(false),
     mPoison(false)
 {
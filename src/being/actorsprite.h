@@ -169,6 +169,12 @@ public:
     bool getPoison() const A_WARN_UNUSED
     { return mPoison; }
 
+    int getGridCell() const A_WARN_UNUSED
+    { return mGridCell; }
+
+    void setGridCell(const int cell)
+    { mGridCell = cell; }
+
 protected:
     /**
      * Notify self that the stun mode has been updated. Invoked by
@@ -227,6 +233,9 @@ private:
     int mCursorPaddingX;
     int mCursorPaddingY;
 
+    /** Cell in actors spatial grid, or -1 if actor not in grid. */
+    int mGridCell;
+
     /** Reset particle status effects on next redraw? */
     bool mMustResetParticles;
     bool mPoison;
@@ -1383,6 +1383,8 @@ void Being::nextTile()
         mOldHeight = mMap->getHeightOffset(mX, mY);
     mX = pos.x;
     mY = pos.y;
+    if (actorManager)
+        actorManager->updateActorPosition(this);
     const uint8_t height = mMap->getHeightOffset(mX, mY);
     mOffsetY = height - mOldHeight;
     setAction(BeingAction::MOVE, 0);
@@ -3338,6 +3340,8 @@ void Being::setTileCoords(const int x, const int y)
 {
     mX = x;
     mY = y;
+    if (actorManager)
+        actorManager->updateActorPosition(this);
     if (mMap)
         mOffsetY = mMap->getHeightOffset(mX, mY);
 }
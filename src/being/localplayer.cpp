@@ -96,6 +96,9 @@
 
 static const int16_t awayLimitTimer = 60;
 static const int MAX_TICK_VALUE = INT_MAX / 2;
+// cost limit for synchronous paths to target. targets selected on screen,
+// longer paths searched by navigation in path worker.
+static const int targetPathMaxCost = 50;
 
 typedef std::map<int, Guild*>::const_iterator GuildMapCIter;
 
@@ -139,6 +142,8 @@ LocalPlayer::LocalPlayer(const int id, const uint16_t subtype) :
     mNavigateX(0),
     mNavigateY(0),
     mNavigateId(0),
+    mNavigateRequest(0),
+    mNavigateFallback(NavigateFallback::NONE),
     mCrossX(0),
     mCrossY(0),
     mOldX(0),
@@ -245,6 +250,8 @@ void LocalPlayer::logic()
     if (mActivityTime == 0 || mLastAction != -1)
         mActivityTime = cur_time;
 
+    updateNavigatePath();
+
     if ((mAction != BeingAction::MOVE || mNextStep) && !mNavigatePath.empty())
     {
         mNextStep = false;
@@ -486,15 +493,8 @@ bool LocalPlayer::pickUp(FloorItem *const item)
     }
     else if (pickUpType >= 4 && pickUpType <= 6)
     {
-        const Vector &playerPos = getPosition();
-        const Path debugPath = mMap->findPath(
-            static_cast<int>(playerPos.x - mapTileSize / 2) / mapTileSize,
-            static_cast<int>(playerPos.y - mapTileSize) / mapTileSize,
-            item->getTileX(), item->getTileY(), getWalkMask(), 0);
-        if (!debugPath.empty())
-            navigateTo(item->getTileX(), item->getTileY());
-        else
-            setDestination(item->getTileX(), item->getTileY());
+        navigateTo(item->getTileX(), item->getTileY(),
+            NavigateFallback::DESTINATION);
 
         mPickUpTarget = item;
         mPickUpTarget->addActorSpriteListener(this);
@@ -1148,9 +1148,17 @@ void LocalPlayer::moveToTarget(int dist)
             debugPath = mMap->findPath(static_cast<int>(
                 playerPos.x - mapTileSize / 2) / mapTileSize,
                 static_cast<int>(playerPos.y - mapTileSize) / mapTileSize,
-                mTarget->getTileX(), mTarget->getTileY(), getWalkMask(), 0);
+                mTarget->getTileX(), mTarget->getTileY(), getWalkMask(),
+                targetPathMaxCost);
         }
 
+        // target too far for limited search, navigate in path worker
+        if (debugPath.empty())
+        {
+            if (!mNavigateRequest)
+                navigateTo(mTarget);
+            return;
+        }
         const size_t sz = debugPath.size();
         if (sz < static_cast<size_t>(dist))
             return;
@@ -1159,6 +1167,9 @@ void LocalPlayer::moveToTarget(int dist)
     }
     else if (mNavigateX || mNavigateY)
     {
+        // navigation path still searching
+        if (mNavigateRequest)
+            return;
         debugPath = mNavigatePath;
         limit = dist;
         gotPos = true;
@@ -2531,14 +2542,18 @@ void LocalPlayer::afkRespond(ChatTab *const tab, const std::string &nick)
     }
 }
 
-bool LocalPlayer::navigateTo(const int x, const int y)
+bool LocalPlayer::navigateTo(const int x, const int y,
+                             const NavigateFallback::Type fallback)
 {
     if (!mMap)
         return false;
 
     SpecialLayer *const tmpLayer = mMap->getTempLayer();
     if (!tmpLayer)
+    {
+        navigateFallback(x, y, fallback);
         return false;
+    }
 
     const Vector &playerPos = getPosition();
     mShowNavigePath = true;
@@ -2550,14 +2565,14 @@ bool LocalPlayer::navigateTo(const int x, const int y)
     mNavigateY = y;
     mNavigateId = 0;
 
-    mNavigatePath = mMap->findPath(
-        static_cast<int>(playerPos.x - mapTileSize / 2) / mapTileSize,
-        static_cast<int>(playerPos.y - mapTileSize) / mapTileSize,
-        x, y, getWalkMask(), 0);
-
-    if (mDrawPath)
-        tmpLayer->addRoad(mNavigatePath);
-    return !mNavigatePath.empty();
+    requestNavigatePath(x, y);
+    if (!mNavigateRequest)
+    {
+        navigateFallback(x, y, fallback);
+        return false;
+    }
+    mNavigateFallback = fallback;
+    return true;
 }
 
 void LocalPlayer::navigateTo(const Being *const being)
@@ -2578,14 +2593,85 @@ void LocalPlayer::navigateTo(const Being *const being)
     mNavigateX = being->getTileX();
     mNavigateY = being->getTileY();
 
-    mNavigatePath = mMap->findPath(
+    requestNavigatePath(mNavigateX, mNavigateY);
+}
+
+void LocalPlayer::requestNavigatePath(const int x, const int y)
+{
+    const Vector &playerPos = getPosition();
+    mMap->cancelPathRequest(mNavigateRequest);
+    mNavigatePath.clear();
+    mNavigateFallback = NavigateFallback::NONE;
+    mNavigateRequest = mMap->requestPath(
         static_cast<int>(playerPos.x - mapTileSize / 2) / mapTileSize,
         static_cast<int>(playerPos.y - mapTileSize) / mapTileSize,
-        being->getTileX(), being->getTileY(),
-        getWalkMask(), 0);
+        x, y, getWalkMask(), 0);
+}
+
+void LocalPlayer::updateNavigatePath()
+{
+    if (!mNavigateRequest || !mMap)
+        return;
+
+    if (!mMap->getPathResult(mNavigateRequest, mNavigatePath))
+        return;
+    mNavigateRequest = 0;
+
+    if (mNavigatePath.empty())
+    {
+        const NavigateFallback::Type fallback = mNavigateFallback;
+        mNavigateFallback = NavigateFallback::NONE;
+        if (fallback != NavigateFallback::NONE)
+        {
+            navigateFallback(mNavigateX, mNavigateY, fallback);
+            return;
+        }
+    }
 
     if (mDrawPath)
-        tmpLayer->addRoad(mNavigatePath);
+    {
+        SpecialLayer *const tmpLayer = mMap->getTempLayer();
+        if (tmpLayer)
+            tmpLayer->addRoad(mNavigatePath);
+    }
+}
+
+void LocalPlayer::navigateFallback(const int x, const int y,
+                                   const NavigateFallback::Type fallback)
+{
+    switch (fallback)
+    {
+        case NavigateFallback::DESTINATION:
+            navigateClean();
+            setDestination(x, y);
+            break;
+        case NavigateFallback::STEP:
+        {
+            int stepX = mX;
+            int stepY = mY;
+            if (stepX > x)
+                stepX --;
+            else if (stepX < x)
+                stepX ++;
+            if (stepY > y)
+                stepY --;
+            else if (stepY < y)
+                stepY ++;
+            if ((stepX != x || stepY != y) && mMap
+                && mMap->getWalk(stepX, stepY, 0))
+            {
+                navigateTo(stepX, stepY);
+            }
+            else
+            {
+                navigateClean();
+            }
+            break;
+        }
+        case NavigateFallback::NONE:
+        default:
+            break;
+    }
 }
 
 void LocalPlayer::navigateClean()
@@ -2602,6 +2688,9 @@ void LocalPlayer::navigateClean()
     mNavigateY = 0;
     mNavigateId = 0;
 
+    mMap->cancelPathRequest(mNavigateRequest);
+    mNavigateRequest = 0;
+    mNavigateFallback = NavigateFallback::NONE;
     mNavigatePath.clear();
 
     const SpecialLayer *const tmpLayer = mMap->getTempLayer();
@@ -2747,7 +2836,10 @@ int LocalPlayer::getPathLength(const Being *const being) const
             static_cast<int>(playerPos.x - mapTileSize / 2) / mapTileSize,
             static_cast<int>(playerPos.y - mapTileSize) / mapTileSize,
             being->getTileX(), being->getTileY(),
-            getWalkMask(), 0);
+            getWalkMask(), targetPathMaxCost);
+        // not found paths longer than cost limit
+        if (debugPath.empty())
+            return targetPathMaxCost + 1;
         return static_cast<int>(debugPath.size());
     }
     else
@@ -3122,7 +3214,7 @@ void LocalPlayer::fixAttackTarget()
         static_cast<int>(playerPos.x - mapTileSize / 2) / mapTileSize,
         static_cast<int>(playerPos.y - mapTileSize) / mapTileSize,
         mTarget->getTileX(), mTarget->getTileY(),
-        getWalkMask(), 0);
+        getWalkMask(), targetPathMaxCost);
 
     if (!debugPath.empty())
     {
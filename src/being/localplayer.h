@@ -24,6 +24,7 @@
 #define BEING_LOCALPLAYER_H
 
 #include "being/being.h"
+#include "being/navigatefallback.h"
 
 #include "gui/userpalette.h"
 
@@ -246,7 +247,14 @@ class LocalPlayer final : public Being,
 
         static void setAfkMessage(std::string message);
 
-        bool navigateTo(const int x, const int y);
+        /**
+         * Starts navigation to tile. Path is searched in background and
+         * if it not found, fallback is applied. Returns false if search
+         * can't be started, fallback is applied at once in this case.
+         */
+        bool navigateTo(const int x, const int y,
+                        const NavigateFallback::Type fallback
+                        = NavigateFallback::NONE);
 
         void navigateTo(const Being *const being);
 
@@ -417,6 +425,13 @@ class LocalPlayer final : public Being,
 
         void startWalking(const unsigned char dir);
 
+        void requestNavigatePath(const int x, const int y);
+
+        void updateNavigatePath();
+
+        void navigateFallback(const int x, const int y,
+                              const NavigateFallback::Type fallback);
+
         void changeEquipmentBeforeAttack(const Being *const target) const;
 
         static void tryMagic(const std::string &spell, const int baseMagic,
@@ -483,6 +498,8 @@ class LocalPlayer final : public Being,
         int mNavigateX;
         int mNavigateY;
         int mNavigateId;
+        int mNavigateRequest;
+        NavigateFallback::Type mNavigateFallback;
         int mCrossX;
         int mCrossY;
         int mOldX;
@@ -0,0 +1,40 @@
+/*
+ *  The ManaPlus Client
+ *  Copyright (C) 2011-2014  The ManaPlus Developers
+ *
+ *  This file is part of The ManaPlus Client.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BEING_NAVIGATEFALLBACK_H
+#define BEING_NAVIGATEFALLBACK_H
+
+/**
+ * What to do if navigation path not found.
+ */
+namespace NavigateFallback
+{
+    enum Type
+    {
+        // stop navigation
+        NONE = 0,
+        // walk directly to destination
+        DESTINATION,
+        // navigate to neighbour tile in direction of destination
+        STEP
+    };
+}
+
+#endif  // BEING_NAVIGATEFALLBACK_H
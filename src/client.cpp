@@ -92,6 +92,9 @@
 
 #include "particle/particle.h"
 
+#include "resources/atlascache.h"
+#include "resources/beingcommon.h"
+#include "resources/dyedimagecache.h"
 #include "resources/imagehelper.h"
 #include "resources/openglimagehelper.h"
 #include "resources/resourcemanager.h"
@@ -125,6 +128,8 @@
 #include "utils/sdlcheckutils.h"
 #include "utils/sdlhelper.h"
 #include "utils/timer.h"
+#include "utils/xmlcache.h"
+#include "utils/xmlpreloader.h"
 
 #include "utils/translation/translationmanager.h"
 
@@ -362,6 +367,23 @@ void Client::gameInit()
 
     // Add the local data directory to PhysicsFS search path
     resman->addToSearchPath(settings.localDataDir, false);
+
+    if (config.getValue("dyedImageCache", 1))
+    {
+        // size limit in megabytes
+        DyedImageCache::setDir(settings.localDataDir + "/cache/images",
+            static_cast<size_t>(config.getValue("dyedImageCacheSize", 200))
+            * 1024 * 1024);
+    }
+#ifdef USE_OPENGL
+    if (config.getValue("atlasCache", 1))
+    {
+        // size limit in megabytes
+        AtlasCache::setDir(settings.localDataDir + "/cache/atlas",
+            static_cast<size_t>(config.getValue("atlasCacheSize", 200))
+            * 1024 * 1024);
+    }
+#endif
     TranslationManager::loadCurrentLang();
 
     WindowManager::initTitle();
@@ -566,6 +588,60 @@ static void setProgress(const int val)
 #endif
 #endif
 
+static void preloadDatabases()
+{
+    static const char *const files[] =
+    {
+        "charCreationFile",
+        "deadMessagesFile",
+        "deadMessagesPatchFile",
+        "hairColorFile",
+        "hairColorPatchFile",
+        "itemColorsFile",
+        "itemColorsPatchFile",
+        "soundsFile",
+        "soundsPatchFile",
+        "mapsFile",
+        "mapsPatchFile",
+        "mapsRemapFile",
+        "itemsFile",
+        "itemsPatchFile",
+        "monstersFile",
+        "monstersPatchFile",
+        "avatarsFile",
+        "avatarsPatchFile",
+        "npcsFile",
+        "npcsPatchFile",
+        "petsFile",
+        "petsPatchFile",
+        "emotesFile",
+        "emotesPatchFile",
+        "statusEffectsFile",
+        "statusEffectsPatchFile",
+        "unitsFile",
+        "unitsPatchFile"
+    };
+
+    StringVect list;
+    for (size_t f = 0; f < sizeof(files) / sizeof(files[0]); f ++)
+        list.push_back(paths.getStringValue(files[f]));
+    BeingCommon::getIncludeFiles(paths.getStringValue("hairColorPatchDir"),
+        list, ".xml");
+    BeingCommon::getIncludeFiles(paths.getStringValue("itemsPatchDir"),
+        list, ".xml");
+
+    if (config.getValue("xmlDbCache", 1))
+    {
+        // data from different update hosts can have same file names
+        XmlCache::setDir(std::string(settings.localDataDir).append(
+            "/cache/xml/").append(settings.updatesDir.empty()
+            ? "local" : settings.updatesDir));
+    }
+    else
+        XmlCache::setDir(std::string());
+    XmlPreloader::preload(list);
+}
+
 void Client::setEnv(const char *const name, const char *const value)
 {
     if (!name || !value)
@@ -1240,6 +1316,9 @@ int Client::gameExec()
                     TranslationManager::loadCurrentLang();
                     PlayerInfo::stateChange(mState);
 
+                    // Parse XML databases in background threads
+                    preloadDatabases();
+
                     // Load XML databases
                     CharDB::load();
                     DeadDB::load();
@@ -1258,6 +1337,7 @@ int Client::gameExec()
 //                    ModDB::load();
                     StatusEffect::load();
                     Units::loadUnits();
+                    XmlPreloader::clear();
 
                     ActorSprite::load();
 
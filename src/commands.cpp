@@ -39,6 +39,7 @@
 
 #include "gui/chatconsts.h"
 #include "gui/gui.h"
+#include "gui/viewport.h"
 
 #include "gui/windows/buydialog.h"
 #include "gui/windows/chatwindow.h"
@@ -71,17 +72,27 @@
 #include "net/pethandler.h"
 #include "net/tradehandler.h"
 
+#include "particle/particle.h"
+#include "particle/particlepool.h"
+
 #ifdef DEBUG_DUMP_LEAKS1
 #include "resources/image.h"
 #include "resources/resource.h"
 #include "resources/subimage.h"
 #endif
 
+#ifdef USE_OPENGL
+#include "resources/atlasmanager.h"
+#include "resources/atlasresource.h"
+#endif
+
 #include "resources/iteminfo.h"
 #include "resources/resourcemanager.h"
 
 #include "resources/db/itemdb.h"
 
+#include "resources/map/map.h"
+
 #include "utils/delete2.h"
 #include "utils/gettext.h"
 #include "utils/process.h"
@@ -1431,6 +1442,54 @@ impHandler0(testsdlfont)
 #endif
 }
 
+impHandler0(benchParticles)
+{
+    if (!debugChatTab)
+        return;
+
+    timespec time1;
+    timespec time2;
+    // detached map, so benchmark particles never visible in game view
+    Map *const map = new Map(1, 1, mapTileSize, mapTileSize);
+    Particle *const root = new Particle();
+    root->setMap(map);
+    root->disableAutoDelete();
+
+    clock_gettime(CLOCK_MONOTONIC, &time1);
+    // about 20000 alive particles with constant turnover
+    for (int tick = 0; tick < 1000; tick ++)
+    {
+        for (int f = 0; f < 100; f ++)
+        {
+            Particle *const particle = root->createChild();
+            particle->setVelocity(
+                static_cast<float>((rand() % 100) - 50) / 50.0F,
+                static_cast<float>((rand() % 100) - 50) / 50.0F,
+                static_cast<float>(rand() % 100) / 20.0F);
+            particle->setGravity(0.1F);
+            particle->setBounce(0.5F);
+            particle->setRandomness(10);
+            particle->setLifetime(100 + rand() % 200);
+        }
+        root->update();
+    }
+    clock_gettime(CLOCK_MONOTONIC, &time2);
+
+    const int count = Particle::particleCount;
+    const size_t memory = ParticlePool::getMemoryUsage();
+    delete root;
+    delete map;
+
+    const int64_t diff = (static_cast<long long int>(
+        time2.tv_sec) * 1000000000LL + static_cast<long long int>(
+        time2.tv_nsec)) / 1000000 - (static_cast<long long int>(
+        time1.tv_sec) * 1000000000LL + static_cast<long long int>(
+        time1.tv_nsec)) / 1000000;
+    debugChatTab->chatLog(strprintf("particles time: %d ms, "
+        "particles: %d, pool memory: %u",
+        static_cast<int>(diff), count, static_cast<unsigned int>(memory)));
+}
+
 impHandler2(dumpMods)
 {
     std::string str = "enabled mods: " + serverConfig.getValue("mods", "");
@@ -1449,6 +1508,29 @@ impHandler0(dumpGL)
 }
 #endif
 
+#ifdef USE_OPENGL
+impHandler2(dumpAtlas)
+{
+    if (!viewport)
+        return;
+    const Map *const map = viewport->getMap();
+    if (!map)
+        return;
+    const AtlasResource *const atlas = static_cast<const AtlasResource*>(
+        map->getAtlas());
+    std::string str;
+    if (atlas)
+        str = "atlas " + AtlasManager::getStatistics(atlas);
+    else
+        str = "map atlas not loaded";
+    outStringNormal(tab, str, str);
+}
+#else
+impHandler0(dumpAtlas)
+{
+}
+#endif
+
 #ifdef DEBUG_DUMP_LEAKS1
 void showRes(std::string str, ResourceManager::Resources *res);
 
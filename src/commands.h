@@ -120,9 +120,11 @@ namespace Commands
     decHandler(dumpOGL);
     decHandler(dumpGL);
     decHandler(dumpMods);
+    decHandler(dumpAtlas);
     decHandler(cacheInfo);
     decHandler(execute);
     decHandler(testsdlfont);
+    decHandler(benchParticles);
     decHandler(enableHighlight);
     decHandler(disableHighlight);
     decHandler(dontRemoveName);
@@ -240,6 +242,8 @@ enum
     COMMAND_UPLOADLOG,
     COMMAND_GM,
     COMMAND_HACK,
+    COMMAND_BENCHPARTICLES,
+    COMMAND_DUMPATLAS,
     END_COMMANDS
 };
 
@@ -341,7 +345,9 @@ static const CommandInfo commands[] =
     {"uploadserverconfig", &Commands::uploadServerConfig, -1, false},
     {"uploadlog", &Commands::uploadLog, -1, false},
     {"gm", &Commands::gm, -1, true},
-    {"hack", &Commands::hack, -1, true}
+    {"hack", &Commands::hack, -1, true},
+    {"benchparticles", &Commands::benchParticles, -1, false},
+    {"dumpatlas", &Commands::dumpAtlas, -1, false}
 };
 
 #undef decHandler
@@ -33,6 +33,7 @@
 #include "resources/surfaceimagehelper.h"
 #endif
 
+#include "utils/cpu.h"
 #include "utils/gettext.h"
 #include "utils/physfstools.h"
 
@@ -61,6 +62,7 @@ int main(int argc, char **argv)
 
     logger = new Logger;
     logger->setLogToStandardOut(false);
+    Cpu::detect();
 
     PhysFs::init(argv[0]);
     SDL_Init(SDL_INIT_VIDEO);
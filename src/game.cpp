@@ -45,6 +45,7 @@
 #include "being/playerinfo.h"
 
 #include "particle/particle.h"
+#include "particle/particlepool.h"
 
 #include "input/inputmanager.h"
 #include "input/joystick.h"
@@ -97,6 +98,7 @@
 #include "net/net.h"
 #include "net/packetcounters.h"
 
+#include "resources/asyncimageloader.h"
 #include "resources/delayedmanager.h"
 #include "resources/imagewriter.h"
 #include "resources/mapreader.h"
@@ -384,6 +386,7 @@ Game::Game() :
 
     AnimatedSprite::setEnableCache(mainGraphics->getOpenGL()
         && config.getBoolValue("enableDelayedAnimations"));
+    AsyncImageLoader::setEnabled(config.getValue("asyncImageLoad", 1) != 0);
 
     CompoundSprite::setEnableDelay(
         config.getBoolValue("enableCompoundSpriteDelay"));
@@ -422,6 +425,8 @@ Game::~Game()
     destroyGuiWindows();
 
     AnimatedSprite::setEnableCache(false);
+    AsyncImageLoader::stop();
+    AsyncImageLoader::setEnabled(false);
 
     delete2(modifiers);
     delete2(actorManager)
@@ -430,6 +435,7 @@ Game::~Game()
     delete2(commandHandler)
     delete2(effectManager)
     delete2(particleEngine)
+    ParticlePool::clear();
     delete2(viewport)
     delete2(mCurrentMap)
     delete2(spellManager)
@@ -66,8 +66,10 @@
 
 #include "gui/fonts/font.h"
 
+#include "configuration.h"
 #include "logger.h"
 
+#include "gui/fonts/glyphatlas.h"
 #include "gui/fonts/textchunk.h"
 
 #include "render/graphics.h"
@@ -75,6 +77,7 @@
 #include "resources/image.h"
 #include "resources/imagehelper.h"
 
+#include "utils/delete2.h"
 #include "utils/files.h"
 #include "utils/paths.h"
 #include "utils/sdlcheckutils.h"
@@ -90,6 +93,7 @@ const unsigned int CACHE_SIZE_SMALL3 = 170;
 const unsigned int CLEAN_TIME = 7;
 
 bool Font::mSoftMode(false);
+bool Font::mUseGlyphAtlas(false);
 
 extern char *strBuf;
 
@@ -99,13 +103,23 @@ Font::Font(std::string filename,
            const int size,
            const int style) :
     mFont(nullptr),
+    mGlyphs(nullptr),
     mCreateCounter(0),
     mDeleteCounter(0),
-    mCleanTime(cur_time + CLEAN_TIME)
+    mCleanTime(cur_time + CLEAN_TIME),
+    mMetrics(),
+    mOverhang(0),
+    mKerning(false)
 {
     if (fontCounter == 0)
     {
-        mSoftMode = imageHelper->useOpenGL() == RENDER_SOFTWARE;
+        const RenderType mode = imageHelper->useOpenGL();
+        mSoftMode = mode == RENDER_SOFTWARE;
+        mUseGlyphAtlas = config.getValue("glyphAtlas", 1)
+            && (mode == RENDER_NORMAL_OPENGL
+            || mode == RENDER_SAFE_OPENGL
+            || mode == RENDER_GLES_OPENGL
+            || mode == RENDER_MODERN_OPENGL);
         if (TTF_Init() == -1)
         {
             logger->error("Unable to initialize SDL_ttf: " +
@@ -137,10 +151,13 @@ Font::Font(std::string filename,
     }
 
     TTF_SetFontStyle(mFont, style);
+    resetMetrics();
+    createGlyphAtlas();
 }
 
 Font::~Font()
 {
+    delete2(mGlyphs);
     TTF_CloseFont(mFont);
     mFont = nullptr;
     --fontCounter;
@@ -167,6 +184,13 @@ TTF_Font *Font::openFont(const char *const name, const int size)
 // #endif
 }
 
+void Font::createGlyphAtlas()
+{
+    delete2(mGlyphs);
+    if (mUseGlyphAtlas && mFont)
+        mGlyphs = new GlyphAtlas(mFont);
+}
+
 void Font::loadFont(std::string filename,
                     const int size,
                     const int style)
@@ -188,11 +212,14 @@ void Font::loadFont(std::string filename,
         return;
     }
 
+    delete2(mGlyphs);
     if (mFont)
         TTF_CloseFont(mFont);
 
     mFont = font;
     TTF_SetFontStyle(mFont, style);
+    resetMetrics();
+    createGlyphAtlas();
     clear();
 }
 
@@ -200,6 +227,8 @@ void Font::clear()
 {
     for (size_t f = 0; f < CACHES_NUMBER; f ++)
         mCache[f].clear();
+    if (mGlyphs)
+        mGlyphs->clear();
 }
 
 void Font::drawString(Graphics *const graphics,
@@ -226,6 +255,13 @@ void Font::drawString(Graphics *const graphics,
      */
     col.a = 255;
 
+    if (mGlyphs)
+    {
+        mGlyphs->drawString(g, text, x, y, col, col2, alpha);
+        BLOCK_END("Font::drawString")
+        return;
+    }
+
     const unsigned char chr = text[0];
     TextChunkList *const cache = &mCache[chr];
 
@@ -284,30 +320,116 @@ void Font::slowLogic(const int rnd)
 
 int Font::getWidth(const std::string &text) const
 {
-    if (text.empty())
-        return 0;
+    return getWidth(text, 0, text.size());
+}
 
-    const unsigned char chr = text[0];
-    TextChunkList *const cache = &mCache[chr];
+int Font::getWidth(const std::string &text,
+                   const size_t start,
+                   const size_t end) const
+{
+    const size_t sz = std::min(end, text.size());
+    int penX = 0;
+    int minX = 0;
+    int maxX = 0;
+    int prevIndex = 0;
+    int width = 0;
+    size_t pos = start;
+    while (pos < sz)
+        width = addChar(text, pos, penX, minX, maxX, prevIndex);
+    return width;
+}
 
-    std::map<std::string, TextChunk*> &search = cache->searchWidth;
-    std::map<std::string, TextChunk*>::iterator i = search.find(text);
-    if (i != search.end())
+void Font::resetMetrics()
+{
+    for (unsigned int f = 0; f < 256; f ++)
+        mLatinMetrics[f] = CharMetrics();
+    mMetrics.clear();
+    mOverhang = 0;
+    mKerning = false;
+    if (!mFont)
+        return;
+
+    mKerning = TTF_GetFontKerning(mFont) != 0;
+    if (TTF_GetFontStyle(mFont) & TTF_STYLE_BOLD)
     {
-        TextChunk *const chunk = (*i).second;
-        cache->moveToFirst(chunk);
-        const Image *const image = chunk->img;
-        if (image)
-            return image->getWidth();
-        else
-            return 0;
+        // SDL_ttf moves pen for bold glyphs by hidden overhang
+        int w1 = 0;
+        int w2 = 0;
+        int h = 0;
+        if (!TTF_SizeUTF8(mFont, " ", &w1, &h)
+            && !TTF_SizeUTF8(mFont, "  ", &w2, &h))
+        {
+            const CharMetrics &metrics = getCharMetrics(" ", 0, 1, ' ');
+            mOverhang = w2 - w1 - metrics.advance;
+        }
     }
+}
 
-    // if string was not drawed
-    int w, h;
-    getSafeUtf8String(text, strBuf);
-    TTF_SizeUTF8(mFont, strBuf, &w, &h);
-    return w;
+const Font::CharMetrics &Font::getCharMetrics(const std::string &text,
+                                              const size_t start,
+                                              const size_t end,
+                                              const int chr) const
+{
+    CharMetrics *metrics = nullptr;
+    if (chr >= 0 && chr < 256)
+    {
+        metrics = &mLatinMetrics[chr];
+        if (metrics->index >= 0)
+            return *metrics;
+    }
+    else
+    {
+        const std::map<int, CharMetrics>::const_iterator
+            it = mMetrics.find(chr);
+        if (it != mMetrics.end())
+            return (*it).second;
+        metrics = &mMetrics[chr];
+    }
+
+    int minY = 0;
+    int maxY = 0;
+    if (chr <= 0xffff && !TTF_GlyphMetrics(mFont, static_cast<uint16_t>(chr),
+        &metrics->minX, &metrics->maxX, &minY, &maxY, &metrics->advance))
+    {
+        metrics->index = TTF_GlyphIsProvided(mFont,
+            static_cast<uint16_t>(chr));
+    }
+    else
+    {
+        int w = 0;
+        int h = 0;
+        getSafeUtf8String(text.substr(start, end - start), strBuf);
+        TTF_SizeUTF8(mFont, strBuf, &w, &h);
+        metrics->minX = 0;
+        metrics->maxX = w;
+        metrics->advance = w;
+        metrics->index = 0;
+    }
+    return *metrics;
+}
+
+int Font::addChar(const std::string &text,
+                  size_t &pos,
+                  int &penX,
+                  int &minX,
+                  int &maxX,
+                  int &prevIndex) const
+{
+    const size_t start = pos;
+    const int chr = GlyphAtlas::nextChar(text, pos);
+    const CharMetrics &metrics = getCharMetrics(text, start, pos, chr);
+    if (mKerning && prevIndex && metrics.index)
+        penX += TTF_GetFontKerningSize(mFont, prevIndex, metrics.index);
+
+    if (penX + metrics.minX < minX)
+        minX = penX + metrics.minX;
+    penX += mOverhang;
+    const int right = penX + std::max(metrics.advance, metrics.maxX);
+    if (right > maxX)
+        maxX = right;
+    penX += metrics.advance;
+    prevIndex = metrics.index;
+    return maxX - minX;
 }
 
 int Font::getHeight() const
@@ -360,15 +482,70 @@ void Font::doClean()
 int Font::getStringIndexAt(const std::string& text, const int x) const
 {
     const size_t sz = text.size();
-    for (size_t i = 0; i < sz; ++i)
+    int penX = 0;
+    int minX = 0;
+    int maxX = 0;
+    int prevIndex = 0;
+    int width = 0;
+    size_t pos = 0;
+    while (pos < sz)
     {
-        if (getWidth(text.substr(0, i)) > x)
-            return static_cast<int>(i);
+        if (width > x)
+            return static_cast<int>(pos);
+        width = addChar(text, pos, penX, minX, maxX, prevIndex);
     }
 
     return static_cast<int>(sz);
 }
 
+size_t Font::getWrapIndex(const std::string &text,
+                          const size_t start,
+                          const size_t end,
+                          const int width,
+                          const bool forced) const
+{
+    const size_t sz = std::min(end, text.size());
+    int penX = 0;
+    int minX = 0;
+    int maxX = 0;
+    int prevIndex = 0;
+    size_t space = std::string::npos;
+    size_t pos = start;
+    while (pos < sz)
+    {
+        if (!forced && pos != start && text[pos] == ' ')
+            space = pos;
+        const size_t charStart = pos;
+        if (addChar(text, pos, penX, minX, maxX, prevIndex) > width)
+        {
+            if (!forced)
+                return space;
+            return charStart != start ? charStart : pos;
+        }
+    }
+    return sz;
+}
+
+void Font::getWrapPositions(const std::string &text,
+                            const int width,
+                            std::vector<size_t> &positions) const
+{
+    const size_t sz = text.size();
+    size_t start = 0;
+    while (start < sz)
+    {
+        size_t pos = getWrapIndex(text, start, sz, width, false);
+        if (pos == sz)
+            return;
+        if (pos == std::string::npos)
+            pos = getWrapIndex(text, start, sz, width, true);
+        else
+            pos ++;
+        positions.push_back(pos);
+        start = pos;
+    }
+}
+
 const TextChunkList *Font::getCache() const
 {
     return mCache;
@@ -71,10 +71,13 @@
 
 #include <SDL_ttf.h>
 
+#include <map>
 #include <string>
+#include <vector>
 
 #include "localconsts.h"
 
+class GlyphAtlas;
 class Graphics;
 
 const unsigned int CACHES_NUMBER = 256;
@@ -101,6 +104,13 @@ class Font final
 
         int getWidth(const std::string &text) const A_WARN_UNUSED;
 
+        /**
+         * Returns width of text part from start to end.
+         */
+        int getWidth(const std::string &text,
+                     const size_t start,
+                     const size_t end) const A_WARN_UNUSED;
+
         int getHeight() const A_WARN_UNUSED;
 
         const TextChunkList *getCache() const A_WARN_UNUSED;
@@ -127,18 +137,83 @@ class Font final
         int getStringIndexAt(const std::string& text,
                              const int x) const A_WARN_UNUSED;
 
+        /**
+         * Finds where text part from start to end should be wrapped to fit
+         * into width.
+         * Returns end if whole part fit.
+         * If forced is false returns position of last fitting space or
+         * npos, else end of last fitting char (at least one char).
+         */
+        size_t getWrapIndex(const std::string &text,
+                            const size_t start,
+                            const size_t end,
+                            const int width,
+                            const bool forced) const A_WARN_UNUSED;
+
+        /**
+         * Calculates positions where wrapped lines of text starts.
+         */
+        void getWrapPositions(const std::string &text,
+                              const int width,
+                              std::vector<size_t> &positions) const;
+
         static bool mSoftMode;
 
+        static bool mUseGlyphAtlas;
+
     private:
+        struct CharMetrics final
+        {
+            CharMetrics() :
+                minX(0),
+                maxX(0),
+                advance(0),
+                index(-1)
+            {
+            }
+
+            int minX;
+            int maxX;
+            int advance;
+            int index;
+        };
+
         static TTF_Font *openFont(const char *const name, const int size);
 
+        void createGlyphAtlas();
+
+        void resetMetrics();
+
+        const CharMetrics &getCharMetrics(const std::string &text,
+                                          const size_t start,
+                                          const size_t end,
+                                          const int chr) const A_WARN_UNUSED;
+
+        /**
+         * Measures char at pos and moves pos to next char.
+         * Same pen rules as TTF_SizeUTF8. Returns width of text until pos.
+         */
+        int addChar(const std::string &text,
+                    size_t &pos,
+                    int &penX,
+                    int &minX,
+                    int &maxX,
+                    int &prevIndex) const;
+
         TTF_Font *mFont;
+        GlyphAtlas *mGlyphs;
         unsigned mCreateCounter;
         unsigned mDeleteCounter;
 
         // Word surfaces cache
         int mCleanTime;
         mutable TextChunkList mCache[CACHES_NUMBER];
+
+        // Glyph metrics cache
+        mutable CharMetrics mLatinMetrics[256];
+        mutable std::map<int, CharMetrics> mMetrics;
+        int mOverhang;
+        bool mKerning;
 };
 
 #ifdef UNITTESTS
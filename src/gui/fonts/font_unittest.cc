@@ -26,8 +26,14 @@
 #include "gui/fonts/textchunk.h"
 #include "gui/fonts/textchunksmall.h"
 
+#include "resources/sdlimagehelper.h"
+
+#include "utils/delete2.h"
+
 #include "gtest/gtest.h"
 
+#include <physfs.h>
+
 #include "debug.h"
 
 TEST(TextChunkList, empty)
@@ -460,3 +466,57 @@ TEST(TextChunkList, sort7)
     EXPECT_EQ(true, item1 < item2);
     EXPECT_EQ(false, item2 < item1);
 }
+
+TEST(Font, metrics)
+{
+    PHYSFS_init("manaplus");
+    logger = new Logger();
+    imageHelper = new SDLImageHelper();
+    Font *const font = new Font("/usr/share/fonts/truetype/"
+        "ttf-dejavu/DejaVuSans-Oblique.ttf", 18);
+
+    const std::string text = "test line with some words";
+    EXPECT_EQ(0, font->getWidth(""));
+    EXPECT_EQ(font->getWidth("test"), font->getWidth(text, 0, 4));
+    EXPECT_EQ(font->getWidth("line"), font->getWidth(text, 5, 9));
+    EXPECT_EQ(font->getWidth(text), font->getWidth(text, 0,
+        std::string::npos));
+
+    const int width = font->getWidth(text);
+    for (int x = 0; x < width; x += 5)
+    {
+        const int idx = font->getStringIndexAt(text, x);
+        EXPECT_TRUE(font->getWidth(text, 0, idx) > x);
+        EXPECT_TRUE(font->getWidth(text, 0, idx - 1) <= x);
+    }
+    EXPECT_EQ(static_cast<int>(text.size()),
+        font->getStringIndexAt(text, width));
+
+    EXPECT_EQ(text.size(), font->getWrapIndex(text, 0, text.size(),
+        width, false));
+    EXPECT_EQ(4U, font->getWrapIndex(text, 0, text.size(),
+        font->getWidth("test l"), false));
+    EXPECT_EQ(std::string::npos, font->getWrapIndex(text, 0, text.size(),
+        font->getWidth("te"), false));
+    EXPECT_EQ(2U, font->getWrapIndex(text, 0, text.size(),
+        font->getWidth("te"), true));
+    EXPECT_EQ(1U, font->getWrapIndex(text, 0, text.size(), 0, true));
+
+    std::vector<size_t> positions;
+    const int wrapWidth = font->getWidth("test line");
+    font->getWrapPositions(text, wrapWidth, positions);
+    ASSERT_TRUE(positions.size() > 1);
+    EXPECT_EQ(10U, positions[0]);
+    size_t start = 0;
+    for (size_t f = 0; f < positions.size(); f ++)
+    {
+        EXPECT_EQ(' ', text[positions[f] - 1]);
+        EXPECT_TRUE(font->getWidth(text, start, positions[f] - 1)
+            <= wrapWidth);
+        start = positions[f];
+    }
+
+    delete font;
+    delete2(imageHelper);
+    delete2(logger);
+}
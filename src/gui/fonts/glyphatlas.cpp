@@ -0,0 +1,276 @@
+/*
+ *  The ManaPlus Client
+ *  Copyright (C) 2011-2014  The ManaPlus Developers
+ *
+ *  This file is part of The ManaPlus Client.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gui/fonts/glyphatlas.h"
+
+#include "logger.h"
+
+#include "gui/color.h"
+
+#include "gui/fonts/textchunk.h"
+
+#include "render/graphics.h"
+
+#include "resources/image.h"
+#include "resources/imagehelper.h"
+
+#include "utils/sdlcheckutils.h"
+
+#include "debug.h"
+
+static const int GLYPH_PAGE_SIZE = 512;
+static const int GLYPH_PAGES_MAX = 4;
+static const int GLYPH_PADDING = 1;
+
+GlyphAtlas::GlyphAtlas(TTF_Font *const font) :
+    mFont(font),
+    mGlyphs(),
+    mPages(),
+    mLine(),
+    mFull(false)
+{
+}
+
+GlyphAtlas::~GlyphAtlas()
+{
+    clear();
+}
+
+void GlyphAtlas::clear()
+{
+    FOR_EACH (GlyphMapIter, it, mGlyphs)
+        delete (*it).second.image;
+    mGlyphs.clear();
+    mLine.clear();
+
+    FOR_EACH (std::vector<Page>::iterator, it, mPages)
+        delete (*it).image;
+    mPages.clear();
+    mFull = false;
+}
+
+int GlyphAtlas::nextChar(const std::string &text, size_t &pos)
+{
+    const size_t sz = text.size();
+    const unsigned char c = static_cast<unsigned char>(text[pos]);
+    pos ++;
+    if (c < 0x80)
+        return c;
+
+    int len = 0;
+    int chr = 0;
+    if ((c & 0xe0) == 0xc0)
+    {
+        len = 1;
+        chr = c & 0x1f;
+    }
+    else if ((c & 0xf0) == 0xe0)
+    {
+        len = 2;
+        chr = c & 0x0f;
+    }
+    else if ((c & 0xf8) == 0xf0)
+    {
+        len = 3;
+        chr = c & 0x07;
+    }
+    else
+    {
+        return c;
+    }
+
+    if (pos + static_cast<size_t>(len) > sz)
+        return c;
+    for (int f = 0; f < len; f ++)
+    {
+        const unsigned char c2 = static_cast<unsigned char>(text[pos + f]);
+        if ((c2 & 0xc0) != 0x80)
+            return c;
+        chr = (chr << 6) | (c2 & 0x3f);
+    }
+    pos += len;
+    return chr;
+}
+
+bool GlyphAtlas::addPage()
+{
+    if (static_cast<int>(mPages.size()) >= GLYPH_PAGES_MAX)
+        return false;
+
+    SDL_Surface *const surface = imageHelper->create32BitSurface(
+        GLYPH_PAGE_SIZE, GLYPH_PAGE_SIZE);
+    if (!surface)
+        return false;
+    Image *const image = imageHelper->createTextSurface(surface,
+        GLYPH_PAGE_SIZE, GLYPH_PAGE_SIZE, 1.0F);
+    MSDL_FreeSurface(surface);
+    if (!image)
+        return false;
+
+    // page owned by atlas, glyph sub images must not release it
+    image->setNotCount(true);
+    Page page;
+    page.image = image;
+    mPages.push_back(page);
+    return true;
+}
+
+Image *GlyphAtlas::addGlyph(SDL_Surface *const surface)
+{
+    const int width = surface->w + GLYPH_PADDING;
+    const int height = surface->h + GLYPH_PADDING;
+    if (width > GLYPH_PAGE_SIZE || height > GLYPH_PAGE_SIZE)
+        return nullptr;
+
+    if (mPages.empty() && !addPage())
+    {
+        mFull = true;
+        return nullptr;
+    }
+
+    Page *page = &mPages.back();
+    if (page->x + width > GLYPH_PAGE_SIZE)
+    {
+        page->x = 0;
+        page->y += page->lineHeight;
+        page->lineHeight = 0;
+    }
+    if (page->y + height > GLYPH_PAGE_SIZE)
+    {
+        if (!addPage())
+        {
+            mFull = true;
+            return nullptr;
+        }
+        page = &mPages.back();
+    }
+
+    // glyphs uploaded directly to page texture
+    imageHelper->copySurfaceToImage(page->image,
+        page->x, page->y, surface);
+    Image *const image = page->image->getSubImage(page->x, page->y,
+        surface->w, surface->h);
+    page->x += width;
+    if (height > page->lineHeight)
+        page->lineHeight = height;
+    return image;
+}
+
+const GlyphAtlas::Glyph *GlyphAtlas::getGlyph(const std::string &text,
+                                              const size_t start,
+                                              const size_t end,
+                                              const int chr,
+                                              const Color &color,
+                                              const Color &color2)
+{
+    const GlyphKey key(chr,
+        (color.r << 16) | (color.g << 8) | color.b,
+        (color2.r << 16) | (color2.g << 8) | color2.b);
+    const GlyphMapIter it = mGlyphs.find(key);
+    if (it != mGlyphs.end())
+        return &(*it).second;
+
+    SDL_Surface *const surface = TextChunk::createSurface(mFont,
+        text.substr(start, end - start), color, color2);
+    Glyph glyph;
+    if (surface)
+    {
+        glyph.image = addGlyph(surface);
+        if (!glyph.image && mFull)
+        {
+            MSDL_FreeSurface(surface);
+            return nullptr;
+        }
+        glyph.advance = surface->w;
+        MSDL_FreeSurface(surface);
+    }
+
+    if (chr <= 0xffff)
+    {
+        int minX = 0;
+        int maxX = 0;
+        int minY = 0;
+        int maxY = 0;
+        int advance = 0;
+        if (!TTF_GlyphMetrics(mFont, static_cast<uint16_t>(chr),
+            &minX, &maxX, &minY, &maxY, &advance))
+        {
+            glyph.advance = advance;
+            if (minX < 0)
+                glyph.offsetX = minX;
+        }
+        glyph.index = TTF_GlyphIsProvided(mFont,
+            static_cast<uint16_t>(chr));
+    }
+    return &(mGlyphs[key] = glyph);
+}
+
+void GlyphAtlas::drawString(Graphics *const graphics,
+                            const std::string &text,
+                            const int x, const int y,
+                            const Color &color,
+                            const Color &color2,
+                            const float alpha)
+{
+    BLOCK_START("GlyphAtlas::drawString")
+    const size_t sz = text.size();
+    mLine.clear();
+    bool rebuilt = false;
+    size_t pos = 0;
+    while (pos < sz)
+    {
+        const size_t start = pos;
+        const int chr = nextChar(text, pos);
+        const Glyph *const glyph = getGlyph(text, start, pos,
+            chr, color, color2);
+        if (!glyph)
+        {
+            if (rebuilt)
+                continue;
+            // atlas full, start from empty pages
+            logger->log("Glyph atlas full. Rebuilding.");
+            rebuilt = true;
+            clear();
+            pos = 0;
+            continue;
+        }
+        mLine.push_back(glyph);
+    }
+
+    const bool kerning = TTF_GetFontKerning(mFont) != 0;
+    int posX = x;
+    int prevIndex = 0;
+    FOR_EACH (std::vector<const Glyph*>::const_iterator, it, mLine)
+    {
+        const Glyph *const glyph = *it;
+        if (kerning && prevIndex && glyph->index)
+            posX += TTF_GetFontKerningSize(mFont, prevIndex, glyph->index);
+        Image *const image = glyph->image;
+        if (image)
+        {
+            image->setAlpha(alpha);
+            graphics->drawImageCached(image, posX + glyph->offsetX, y);
+        }
+        posX += glyph->advance;
+        prevIndex = glyph->index;
+    }
+    graphics->completeCache();
+    BLOCK_END("GlyphAtlas::drawString")
+}
@@ -0,0 +1,155 @@
+/*
+ *  The ManaPlus Client
+ *  Copyright (C) 2011-2014  The ManaPlus Developers
+ *
+ *  This file is part of The ManaPlus Client.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GUI_FONTS_GLYPHATLAS_H
+#define GUI_FONTS_GLYPHATLAS_H
+
+#include <SDL_ttf.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "localconsts.h"
+
+class Color;
+class Graphics;
+class Image;
+
+/**
+ * Per font texture pages with single rendered glyphs.
+ * Text drawn from glyphs in one batch instead of texture per string.
+ */
+class GlyphAtlas final
+{
+    public:
+        struct Glyph final
+        {
+            Glyph() :
+                image(nullptr),
+                advance(0),
+                offsetX(0),
+                index(0)
+            {
+            }
+
+            Image *image;
+            int advance;
+            int offsetX;
+            int index;
+        };
+
+        explicit GlyphAtlas(TTF_Font *const font);
+
+        A_DELETE_COPY(GlyphAtlas)
+
+        ~GlyphAtlas();
+
+        void drawString(Graphics *const graphics,
+                        const std::string &text,
+                        const int x, const int y,
+                        const Color &color,
+                        const Color &color2,
+                        const float alpha);
+
+        void clear();
+
+        int getPagesCount() const A_WARN_UNUSED
+        { return static_cast<int>(mPages.size()); }
+
+        int getGlyphsCount() const A_WARN_UNUSED
+        { return static_cast<int>(mGlyphs.size()); }
+
+        /**
+         * Decodes UTF-8 char at pos and moves pos to next char.
+         * Broken bytes returned as is.
+         */
+        static int nextChar(const std::string &text,
+                            size_t &pos) A_WARN_UNUSED;
+
+    private:
+        /**
+         * Glyphs stored per colors pair, because renderers can't tint
+         * textures and outline colour baked into glyph surface.
+         * Unused colours dropped when full atlas rebuilt.
+         */
+        struct GlyphKey final
+        {
+            GlyphKey(const int chr0,
+                     const unsigned int color0,
+                     const unsigned int color1) :
+                chr(chr0),
+                color(color0),
+                color2(color1)
+            {
+            }
+
+            bool operator<(const GlyphKey &key) const
+            {
+                if (chr != key.chr)
+                    return chr < key.chr;
+                if (color != key.color)
+                    return color < key.color;
+                return color2 < key.color2;
+            }
+
+            int chr;
+            unsigned int color;
+            unsigned int color2;
+        };
+
+        struct Page final
+        {
+            Page() :
+                image(nullptr),
+                x(0),
+                y(0),
+                lineHeight(0)
+            {
+            }
+
+            Image *image;
+            int x;
+            int y;
+            int lineHeight;
+        };
+
+        typedef std::map<GlyphKey, Glyph> GlyphMap;
+        typedef GlyphMap::iterator GlyphMapIter;
+
+        const Glyph *getGlyph(const std::string &text,
+                              const size_t start,
+                              const size_t end,
+                              const int chr,
+                              const Color &color,
+                              const Color &color2) A_WARN_UNUSED;
+
+        Image *addGlyph(SDL_Surface *const surface) A_WARN_UNUSED;
+
+        bool addPage();
+
+        TTF_Font *mFont;
+        GlyphMap mGlyphs;
+        std::vector<Page> mPages;
+        std::vector<const Glyph*> mLine;
+        bool mFull;
+};
+
+#endif  // GUI_FONTS_GLYPHATLAS_H
@@ -73,50 +73,46 @@ bool TextChunk::operator==(const TextChunk &chunk) const
             && chunk.color2 == color2);
 }
 
-void TextChunk::generate(TTF_Font *const font, const float alpha)
+SDL_Surface *TextChunk::createSurface(TTF_Font *const font,
+                                      const std::string &text0,
+                                      const Color &color0,
+                                      const Color &color1)
 {
-    BLOCK_START("TextChunk::generate")
     SDL_Color sdlCol;
-    sdlCol.b = static_cast<uint8_t>(color.b);
-    sdlCol.r = static_cast<uint8_t>(color.r);
-    sdlCol.g = static_cast<uint8_t>(color.g);
+    sdlCol.b = static_cast<uint8_t>(color0.b);
+    sdlCol.r = static_cast<uint8_t>(color0.r);
+    sdlCol.g = static_cast<uint8_t>(color0.g);
 #ifdef USE_SDL2
     sdlCol.a = 255;
 #else
     sdlCol.unused = 0;
 #endif
 
-    getSafeUtf8String(text, strBuf);
+    getSafeUtf8String(text0, strBuf);
 
     SDL_Surface *surface = MTTF_RenderUTF8_Blended(
         font, strBuf, sdlCol);
 
     if (!surface)
-    {
-        img = nullptr;
-        BLOCK_END("TextChunk::generate")
-        return;
-    }
+        return nullptr;
 
     const int width = surface->w;
     const int height = surface->h;
 
-    if (color.r != color2.r || color.g != color2.g
-        || color.b != color2.b)
+    if (color0.r != color1.r || color0.g != color1.g
+        || color0.b != color1.b)
     {   // outlining
         SDL_Color sdlCol2;
         SDL_Surface *const background = imageHelper->create32BitSurface(
             width, height);
         if (!background)
         {
-            img = nullptr;
             MSDL_FreeSurface(surface);
-            BLOCK_END("TextChunk::generate")
-            return;
+            return nullptr;
         }
-        sdlCol2.b = static_cast<uint8_t>(color2.b);
-        sdlCol2.r = static_cast<uint8_t>(color2.r);
-        sdlCol2.g = static_cast<uint8_t>(color2.g);
+        sdlCol2.b = static_cast<uint8_t>(color1.b);
+        sdlCol2.r = static_cast<uint8_t>(color1.r);
+        sdlCol2.g = static_cast<uint8_t>(color1.g);
 #ifdef USE_SDL2
         sdlCol2.a = 255;
 #else
@@ -126,10 +122,9 @@ void TextChunk::generate(TTF_Font *const font, const float alpha)
             font, strBuf, sdlCol2);
         if (!surface2)
         {
-            img = nullptr;
             MSDL_FreeSurface(surface);
-            BLOCK_END("TextChunk::generate")
-            return;
+            MSDL_FreeSurface(background);
+            return nullptr;
         }
         SDL_Rect rect =
         {
@@ -158,8 +153,22 @@ void TextChunk::generate(TTF_Font *const font, const float alpha)
         MSDL_FreeSurface(surface2);
         surface = background;
     }
+    return surface;
+}
+
+void TextChunk::generate(TTF_Font *const font, const float alpha)
+{
+    BLOCK_START("TextChunk::generate")
+    SDL_Surface *const surface = createSurface(font, text, color, color2);
+    if (!surface)
+    {
+        img = nullptr;
+        BLOCK_END("TextChunk::generate")
+        return;
+    }
+
     img = imageHelper->createTextSurface(
-        surface, width, height, alpha);
+        surface, surface->w, surface->h, alpha);
     MSDL_FreeSurface(surface);
 
     BLOCK_END("TextChunk::generate")
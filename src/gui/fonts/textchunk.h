@@ -49,6 +49,14 @@ class TextChunk final
 
         void generate(TTF_Font *const font, const float alpha);
 
+        /**
+         * Renders text with outline to new surface.
+         */
+        static SDL_Surface *createSurface(TTF_Font *const font,
+                                          const std::string &text0,
+                                          const Color &color0,
+                                          const Color &color1) A_WARN_UNUSED;
+
         Image *img;
         std::string text;
         Color color;
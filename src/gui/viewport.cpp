@@ -64,6 +64,8 @@ Viewport::Viewport() :
     WindowContainer(nullptr),
     MouseListener(),
     mMap(nullptr),
+    mDebugPath(),
+    mDebugPathRequest(0),
     mPopupMenu(new PopupMenu),
     mHoverBeing(nullptr),
     mHoverItem(nullptr),
@@ -122,6 +124,9 @@ void Viewport::setMap(Map *const map)
 {
     if (mMap && map)
         map->setDrawLayersFlags(mMap->getDrawLayersFlags());
+    // request id belongs to old map path worker
+    mDebugPath.clear();
+    mDebugPathRequest = 0;
     mMap = map;
 }
 
@@ -317,7 +322,6 @@ void Viewport::drawDebugPath(Graphics *const graphics)
 
     Gui::getMouseState(&mMouseX, &mMouseY);
 
-    static Path debugPath;
     static Vector lastMouseDestination = Vector(0.0F, 0.0F);
     const int mousePosX = mMouseX + mPixelViewX;
     const int mousePosY = mMouseY + mPixelViewY;
@@ -328,7 +332,8 @@ void Viewport::drawDebugPath(Graphics *const graphics)
     {
         const Vector &playerPos = player_node->getPosition();
 
-        debugPath = mMap->findPath(
+        mMap->cancelPathRequest(mDebugPathRequest);
+        mDebugPathRequest = mMap->requestPath(
             static_cast<int>(playerPos.x - mapTileSize / 2) / mapTileSize,
             static_cast<int>(playerPos.y - mapTileSize) / mapTileSize,
             mousePosX / mapTileSize, mousePosY / mapTileSize,
@@ -336,7 +341,12 @@ void Viewport::drawDebugPath(Graphics *const graphics)
             500);
         lastMouseDestination = mouseDestination;
     }
-    drawPath(graphics, debugPath, userPalette->getColorWithAlpha(
+    if (mDebugPathRequest && mMap->getPathResult(mDebugPathRequest,
+        mDebugPath))
+    {
+        mDebugPathRequest = 0;
+    }
+    drawPath(graphics, mDebugPath, userPalette->getColorWithAlpha(
         UserPalette::ROAD_POINT));
 
     const ActorSprites &actors = actorManager->getAll();
@@ -574,8 +584,8 @@ void Viewport::walkByMouse(const MouseEvent &event)
         {
             mLocalWalkTime = cur_time;
             player_node->unSetPickUpTarget();
-            int playerX = player_node->getTileX();
-            int playerY = player_node->getTileY();
+            const int playerX = player_node->getTileX();
+            const int playerY = player_node->getTileY();
             if (mMouseDirectionMove)
             {
                 const int width = mainGraphics->mWidth / 2;
@@ -666,19 +676,8 @@ void Viewport::walkByMouse(const MouseEvent &event)
                     / static_cast<float>(mMap->getTileHeight()));
                 if (playerX != destX || playerY != destY)
                 {
-                    if (!player_node->navigateTo(destX, destY))
-                    {
-                        if (playerX > destX)
-                            playerX --;
-                        else if (playerX < destX)
-                            playerX ++;
-                        if (playerY > destY)
-                            playerY --;
-                        else if (playerY < destY)
-                            playerY ++;
-                        if (mMap->getWalk(playerX, playerY, 0))
-                            player_node->navigateTo(playerX, playerY);
-                    }
+                    player_node->navigateTo(destX, destY,
+                        NavigateFallback::STEP);
                 }
             }
         }
@@ -294,7 +294,8 @@ class Viewport final : public WindowContainer,
     private:
         /**
          * Finds a path from the player to the mouse, and draws it. This is for
-         * debug purposes.
+         * debug purposes. Path searched in map path worker, last found path
+         * drawn while search is running.
          */
         void drawDebugPath(Graphics *const graphics);
 
@@ -318,6 +319,9 @@ class Viewport final : public WindowContainer,
 
         Map *mMap;                   /**< The current map. */
 
+        Path mDebugPath;
+        int mDebugPathRequest;
+
         PopupMenu *mPopupMenu;       /**< Popup menu. */
         Being *mHoverBeing;          /**< Being mouse is currently over. */
         FloorItem *mHoverItem;       /**< FloorItem mouse is currently over. */
@@ -36,6 +36,7 @@
 #include "resources/imageset.h"
 #include "resources/resourcemanager.h"
 
+#include "utils/dtor.h"
 #include "utils/stringutils.h"
 #include "utils/timer.h"
 
@@ -62,6 +63,19 @@ namespace
         }
         int mX, mY;
     };
+
+    struct RowAbove final
+    {
+        explicit RowAbove(const int offset) :
+            mOffset(offset)
+        { }
+
+        bool operator() (const BrowserRow *const row, const int y) const
+        {
+            return row->y - mOffset + row->step <= y;
+        }
+        int mOffset;
+    };
 }  // namespace
 
 ImageSet *BrowserBox::mEmotes = nullptr;
@@ -75,7 +89,7 @@ BrowserBox::BrowserBox(const Widget2 *const widget,
     MouseListener(),
     mTextRows(),
     mTextRowLinksCount(),
-    mLineParts(),
+    mRows(),
     mLinks(),
     mLinkHandler(nullptr),
     mSkin(nullptr),
@@ -91,6 +105,9 @@ BrowserBox::BrowserBox(const Widget2 *const widget,
     mNewLinePadding(15),
     mItemPadding(0),
     mDataWidth(0),
+    mRowsHeight(0),
+    mYOffset(0),
+    mFontHeight(0),
     mHighlightColor(getThemeColor(Theme::HIGHLIGHT)),
     mHyperLinkColor(getThemeColor(Theme::HYPERLINK)),
     mOpaque(opaque),
@@ -100,7 +117,8 @@ BrowserBox::BrowserBox(const Widget2 *const widget,
     mProcessVersion(false),
     mEnableImages(false),
     mEnableKeys(false),
-    mEnableTabs(false)
+    mEnableTabs(false),
+    mLayoutDirty(false)
 {
     mAllowLogic = false;
 
@@ -160,6 +178,8 @@ BrowserBox::~BrowserBox()
     if (gui)
         gui->removeDragged(this);
 
+    delete_all(mRows);
+
     if (theme)
     {
         theme->unload(mSkin);
@@ -294,32 +314,18 @@ void BrowserBox::addRow(const std::string &row, const bool atTop)
         }
     }
 
+    BrowserRow *const layout = new BrowserRow;
     if (atTop)
     {
         mTextRows.push_front(newRow);
         mTextRowLinksCount.push_front(linksCount);
+        mRows.push_front(layout);
     }
     else
     {
         mTextRows.push_back(newRow);
         mTextRowLinksCount.push_back(linksCount);
-    }
-
-    // discard older rows when a row limit has been set
-    if (mMaxRows > 0 && !mTextRows.empty())
-    {
-        while (mTextRows.size() > static_cast<size_t>(mMaxRows))
-        {
-            mTextRows.pop_front();
-            int cnt = mTextRowLinksCount.front();
-            mTextRowLinksCount.pop_front();
-
-            while (cnt && !mLinks.empty())
-            {
-                mLinks.erase(mLinks.begin());
-                cnt --;
-            }
-        }
+        mRows.push_back(layout);
     }
 
     // Auto size mode
@@ -339,63 +345,94 @@ void BrowserBox::addRow(const std::string &row, const bool atTop)
             setWidth(w);
     }
 
-    const int fontHeight = font->getHeight();
-    if (mMode == AUTO_WRAP)
-    {
-        unsigned int y = 0;
-        unsigned int nextChar;
-        const char *const hyphen = "~";
-        const int hyphenWidth = font->getWidth(hyphen);
-        unsigned x = 0;
+    int rowWidth = 0;
+    // Layout only new row if width and font not changed
+    const bool fullLayout = mLayoutDirty
+        || getWidth() != mWidth
+        || getWidth() < mPadding
+        || font->getHeight() != mFontHeight;
 
-        FOR_EACH (TextRowCIter, i, mTextRows)
+    if (!fullLayout)
+    {
+        if (atTop)
+        {
+            layout->color = mForegroundColor;
+            layout->color2 = mForegroundColor2;
+            layoutRow(layout, newRow, 0, linksCount);
+            if (mRows.size() > 1)
+                layout->y = mRows[1]->y - layout->step;
+            else
+                layout->y = mPadding;
+            for (int f = 0; f < linksCount; f ++)
+            {
+                mLinks[f].y1 += layout->y;
+                mLinks[f].y2 += layout->y;
+            }
+        }
+        else
         {
-            std::string tempRow = *i;
-            for (unsigned int j = 0, sz = static_cast<unsigned int>(
-                 tempRow.size()); j < sz; j++)
+            const size_t sz = mRows.size();
+            if (sz > 1)
             {
-                const std::string character = tempRow.substr(j, 1);
-                x += font->getWidth(character);
-                nextChar = j + 1;
-
-                // Wraping between words (at blank spaces)
-                if (nextChar < sz && tempRow.at(nextChar) == ' ')
-                {
-                    int nextSpacePos = static_cast<int>(
-                        tempRow.find(" ", (nextChar + 1)));
-                    if (nextSpacePos <= 0)
-                        nextSpacePos = static_cast<int>(sz) - 1;
+                const BrowserRow *const prev = mRows[sz - 2];
+                layout->color = prev->endColor;
+                layout->color2 = prev->endColor2;
+                layout->y = prev->y + prev->step;
+            }
+            else
+            {
+                layout->color = mForegroundColor;
+                layout->color2 = mForegroundColor2;
+                layout->y = mPadding;
+            }
+            layoutRow(layout, newRow,
+                static_cast<int>(mLinks.size()) - linksCount, linksCount);
+        }
+        mRowsHeight += layout->height;
+        rowWidth = layout->width;
+    }
 
-                    const unsigned nextWordWidth = font->getWidth(
-                        tempRow.substr(nextChar,
-                        (nextSpacePos - nextChar)));
+    // discard older rows when a row limit has been set
+    bool evicted = false;
+    if (mMaxRows > 0 && !mTextRows.empty())
+    {
+        while (mTextRows.size() > static_cast<size_t>(mMaxRows))
+        {
+            mTextRows.pop_front();
+            int cnt = mTextRowLinksCount.front();
+            mTextRowLinksCount.pop_front();
+            BrowserRow *const row = mRows.front();
+            mRowsHeight -= row->height;
+            delete row;
+            mRows.pop_front();
+            evicted = true;
 
-                    if ((x + nextWordWidth + 10)
-                        > static_cast<unsigned>(getWidth()))
-                    {
-                        x = mNewLinePadding;  // Ident in new line
-                        y += 1;
-                        j ++;
-                    }
-                }
-                // Wrapping looong lines (brutal force)
-                else if ((x + 2 * hyphenWidth)
-                         > static_cast<unsigned>(getWidth()))
-                {
-                    x = mNewLinePadding;  // Ident in new line
-                    y += 1;
-                }
+            while (cnt && !mLinks.empty())
+            {
+                mLinks.erase(mLinks.begin());
+                cnt --;
             }
         }
-
-        setHeight(fontHeight * (static_cast<int>(mTextRows.size()) + y));
     }
-    else
+
+    if (fullLayout)
     {
-        setHeight(fontHeight * static_cast<int>(mTextRows.size()));
+        mUpdateTime = 0;
+        updateHeight();
+        return;
     }
-    mUpdateTime = 0;
-    updateHeight();
+
+    // colors of rows after changed first row may be changed too
+    if (evicted)
+        updateRowsColors(0);
+    else if (atTop)
+        updateRowsColors(1);
+
+    mYOffset = mRows.empty() ? 0 : mRows.front()->y - mPadding;
+    mHeight = mRowsHeight + 2 * mPadding;
+    setHeight(mHeight);
+    if (rowWidth > getWidth() - mPadding)
+        setWidth(rowWidth);
 }
 
 void BrowserBox::addRow(const std::string &cmd, const char *const text)
@@ -409,14 +446,53 @@ void BrowserBox::addImage(const std::string &path)
     if (!mEnableImages)
         return;
 
-    mTextRows.push_back("~~~" + path);
+    const std::string row = "~~~" + path;
+    BrowserRow *const layout = new BrowserRow;
+    mTextRows.push_back(row);
     mTextRowLinksCount.push_back(0);
+    mRows.push_back(layout);
+
+    if (mLayoutDirty
+        || getWidth() != mWidth
+        || getWidth() < mPadding
+        || getFont()->getHeight() != mFontHeight)
+    {
+        mLayoutDirty = true;
+        mUpdateTime = 0;
+        updateHeight();
+        return;
+    }
+
+    const size_t sz = mRows.size();
+    if (sz > 1)
+    {
+        const BrowserRow *const prev = mRows[sz - 2];
+        layout->color = prev->endColor;
+        layout->color2 = prev->endColor2;
+        layout->y = prev->y + prev->step;
+    }
+    else
+    {
+        layout->color = mForegroundColor;
+        layout->color2 = mForegroundColor2;
+        layout->y = mPadding;
+    }
+    layoutRow(layout, row, static_cast<int>(mLinks.size()), 0);
+    mRowsHeight += layout->height;
+    mHeight = mRowsHeight + 2 * mPadding;
+    setHeight(mHeight);
+    if (layout->width > getWidth() - mPadding)
+        setWidth(layout->width);
 }
 
 void BrowserBox::clearRows()
 {
     mTextRows.clear();
     mTextRowLinksCount.clear();
+    delete_all(mRows);
+    mRows.clear();
+    mRowsHeight = 0;
+    mYOffset = 0;
     mLinks.clear();
     setWidth(0);
     setHeight(0);
@@ -432,7 +508,7 @@ void BrowserBox::mousePressed(MouseEvent &event)
         return;
 
     const LinkIterator i = std::find_if(mLinks.begin(), mLinks.end(),
-        MouseOverLink(event.getX(), event.getY()));
+        MouseOverLink(event.getX(), event.getY() + mYOffset));
 
     if (i != mLinks.end())
     {
@@ -444,7 +520,7 @@ void BrowserBox::mousePressed(MouseEvent &event)
 void BrowserBox::mouseMoved(MouseEvent &event)
 {
     const LinkIterator i = std::find_if(mLinks.begin(), mLinks.end(),
-        MouseOverLink(event.getX(), event.getY()));
+        MouseOverLink(event.getX(), event.getY() + mYOffset));
 
     mSelectedLink = (i != mLinks.end())
         ? static_cast<int>(i - mLinks.begin()) : -1;
@@ -466,59 +542,78 @@ void BrowserBox::draw(Graphics *graphics)
     if (mYStart < 0)
         mYStart = 0;
 
-    if (getWidth() != mWidth)
+    if (mLayoutDirty)
+        mUpdateTime = 0;
+    if (mLayoutDirty || getWidth() != mWidth)
         updateHeight();
 
     if (mOpaque)
     {
-        graphics->setColor(mBackgroundColor);
-        graphics->fillRectangle(Rect(0, 0, getWidth(), getHeight()));
+        // only visible part of box need background
+        const int height = std::min(getHeight(), yEnd) - mYStart;
+        if (height > 0)
+        {
+            graphics->setColor(mBackgroundColor);
+            graphics->fillRectangle(Rect(0, mYStart, getWidth(), height));
+        }
     }
 
     if (mSelectedLink >= 0 && mSelectedLink
         < static_cast<signed>(mLinks.size()))
     {
+        const BrowserLink &link = mLinks[mSelectedLink];
         if ((mHighMode & BACKGROUND))
         {
             graphics->setColor(mHighlightColor);
             graphics->fillRectangle(Rect(
-                mLinks[mSelectedLink].x1,
-                mLinks[mSelectedLink].y1,
-                mLinks[mSelectedLink].x2 - mLinks[mSelectedLink].x1,
-                mLinks[mSelectedLink].y2 - mLinks[mSelectedLink].y1));
+                link.x1,
+                link.y1 - mYOffset,
+                link.x2 - link.x1,
+                link.y2 - link.y1));
         }
 
         if ((mHighMode & UNDERLINE))
         {
             graphics->setColor(mHyperLinkColor);
             graphics->drawLine(
-                mLinks[mSelectedLink].x1,
-                mLinks[mSelectedLink].y2,
-                mLinks[mSelectedLink].x2,
-                mLinks[mSelectedLink].y2);
+                link.x1,
+                link.y2 - mYOffset,
+                link.x2,
+                link.y2 - mYOffset);
         }
     }
 
     Font *const font = getFont();
 
-    FOR_EACH (LinePartCIter, i, mLineParts)
+    // draw only rows from visible part of box
+    const BrowserRowsCIter it_end = mRows.end();
+    for (BrowserRowsCIter it = findRow(mYStart - 50); it != it_end; ++ it)
     {
-        const LinePart &part = *i;
-        if (part.mY + 50 < mYStart)
-            continue;
-        if (part.mY > yEnd)
+        const BrowserRow *const row = *it;
+        const int rowY = row->y - mYOffset;
+        if (rowY > yEnd)
             break;
-        if (!part.mType)
-        {
-            graphics->setColorAll(part.mColor, part.mColor2);
-            if (part.mBold)
-                boldFont->drawString(graphics, part.mText, part.mX, part.mY);
-            else
-                font->drawString(graphics, part.mText, part.mX, part.mY);
-        }
-        else if (part.mImage)
+
+        FOR_EACH (LinePartCIter, i, row->parts)
         {
-            graphics->drawImage(part.mImage, part.mX, part.mY);
+            const LinePart &part = *i;
+            const int y = rowY + part.mY;
+            if (y + 50 < mYStart)
+                continue;
+            if (y > yEnd)
+                break;
+            if (!part.mType)
+            {
+                graphics->setColorAll(part.mColor, part.mColor2);
+                if (part.mBold)
+                    boldFont->drawString(graphics, part.mText, part.mX, y);
+                else
+                    font->drawString(graphics, part.mText, part.mX, y);
+            }
+            else if (part.mImage)
+            {
+                graphics->drawImage(part.mImage, part.mX, y);
+            }
         }
     }
 
@@ -527,338 +622,395 @@ void BrowserBox::draw(Graphics *graphics)
 
 int BrowserBox::calcHeight()
 {
-    unsigned int y = mPadding;
-    int wrappedLines = 0;
-    int moreHeight = 0;
-    int maxWidth = getWidth() - mPadding;
-    int link = 0;
-    bool bold = false;
-    unsigned int wWidth = maxWidth;
+    const int maxWidth0 = getWidth() - mPadding;
+    int maxWidth = maxWidth0;
 
     if (maxWidth < 0)
         return 1;
 
+    mFontHeight = getFont()->getHeight();
+    mLayoutDirty = false;
+    mRowsHeight = 0;
+    mYOffset = 0;
+
+    Color color = mForegroundColor;
+    Color color2 = mForegroundColor2;
+    int y = mPadding;
+    int link = 0;
+    std::list<int>::const_iterator linksIt = mTextRowLinksCount.begin();
+    BrowserRowsIter rowsIt = mRows.begin();
+
+    FOR_EACH (TextRowCIter, i, mTextRows)
+    {
+        BrowserRow *const layout = *rowsIt;
+        const int linksCount = *linksIt;
+        layout->color = color;
+        layout->color2 = color2;
+        layout->y = y;
+        layoutRow(layout, *i, link, linksCount);
+
+        color = layout->endColor;
+        color2 = layout->endColor2;
+        y += layout->step;
+        mRowsHeight += layout->height;
+        link += linksCount;
+        if (layout->width > maxWidth)
+            maxWidth = layout->width;
+        ++ rowsIt;
+        ++ linksIt;
+    }
+    if (maxWidth0 != maxWidth)
+        setWidth(maxWidth);
+
+    return mRowsHeight + 2 * mPadding;
+}
+
+void BrowserBox::layoutRow(BrowserRow *const layout,
+                           const std::string &row,
+                           const int firstLink,
+                           const int linksCount)
+{
     const Font *const font = getFont();
     const int fontHeight = font->getHeight() + 2 * mItemPadding;
-    const int fontWidthMinus = font->getWidth("-");
+    const unsigned int wWidth = getWidth() - mPadding;
     const char *const hyphen = "~";
     const int hyphenWidth = font->getWidth(hyphen);
-
-    Color selColor[2] = {mForegroundColor, mForegroundColor2};
     const Color textColor[2] = {mForegroundColor, mForegroundColor2};
-    ResourceManager *const resman = ResourceManager::getInstance();
-
-    mLineParts.clear();
-
-    FOR_EACH (TextRowCIter, i, mTextRows)
+    Color selColor[2] = {layout->color, layout->color2};
+    unsigned int x = mPadding;
+    unsigned int y = 0;
+    int wrappedLines = 0;
+    int link = 0;
+    bool wrapped = false;
+    int objects = 0;
+
+    layout->parts.clear();
+    layout->step = fontHeight;
+    layout->height = fontHeight;
+    layout->width = 0;
+    layout->endColor = selColor[0];
+    layout->endColor2 = selColor[1];
+
+    // Links not found in row keep position of row
+    for (int f = 0; f < linksCount; f ++)
     {
-        unsigned int x = mPadding;
-        const std::string row = *(i);
-        bool wrapped = false;
-        int objects = 0;
+        BrowserLink &bLink = mLinks[firstLink + f];
+        bLink.y1 = layout->y;
+        bLink.y2 = layout->y + fontHeight - 1;
+    }
 
-        // Check for separator lines
-        if (row.find("---", 0) == 0)
+    // Check for separator lines
+    if (row.find("---", 0) == 0)
+    {
+        const int dashWidth = font->getWidth("-");
+        for (x = mPadding; x < wWidth; x ++)
         {
-            const int dashWidth = fontWidthMinus;
-            for (x = mPadding; x < wWidth; x ++)
-            {
-                mLineParts.push_back(LinePart(x, y + mItemPadding,
-                    selColor[0], selColor[1], "-", false));
-                x += dashWidth - 2;
-            }
-
-            y += fontHeight;
-            continue;
+            layout->parts.push_back(LinePart(x, mItemPadding,
+                selColor[0], selColor[1], "-", false));
+            x += dashWidth - 2;
         }
-        else if (mEnableImages && row.find("~~~", 0) == 0)
+        return;
+    }
+    else if (mEnableImages && row.find("~~~", 0) == 0)
+    {
+        std::string str = row.substr(3);
+        const size_t sz = str.size();
+        if (sz > 2 && str.substr(sz - 1) == "~")
+            str = str.substr(0, sz - 1);
+        Image *const img = ResourceManager::getInstance()->getImage(str);
+        layout->step = 0;
+        if (img)
         {
-            std::string str = row.substr(3);
-            const size_t sz = str.size();
-            if (sz > 2 && str.substr(sz - 1) == "~")
-                str = str.substr(0, sz - 1);
-            Image *const img = resman->getImage(str);
-            if (img)
-            {
-                img->incRef();
-                mLineParts.push_back(LinePart(x, y + mItemPadding,
-                    selColor[0], selColor[1], img));
-                y += img->getHeight() + 2;
-                moreHeight += img->getHeight();
-                if (img->getWidth() > maxWidth)
-                    maxWidth = img->getWidth() + 2;
-            }
-            continue;
+            img->incRef();
+            layout->parts.push_back(LinePart(x, mItemPadding,
+                selColor[0], selColor[1], img));
+            layout->step = img->getHeight() + 2;
+            layout->height += img->getHeight();
+            if (img->getWidth() > static_cast<int>(wWidth))
+                layout->width = img->getWidth() + 2;
         }
+        return;
+    }
 
-        Color prevColor[2];
-        prevColor[0] = selColor[0];
-        prevColor[1] = selColor[1];
-        bold = false;
+    Color prevColor[2];
+    prevColor[0] = selColor[0];
+    prevColor[1] = selColor[1];
+    bool bold = false;
 
-        for (size_t start = 0, end = std::string::npos;
-             start != std::string::npos;
-             start = end, end = std::string::npos)
-        {
-            bool processed(false);
+    for (size_t start = 0, end = std::string::npos;
+         start != std::string::npos;
+         start = end, end = std::string::npos)
+    {
+        bool processed(false);
 
-            // Wrapped line continuation shall be indented
-            if (wrapped)
-            {
-                y += fontHeight;
-                x = mNewLinePadding + mPadding;
-                wrapped = false;
-            }
+        // Wrapped line continuation shall be indented
+        if (wrapped)
+        {
+            y += fontHeight;
+            x = mNewLinePadding + mPadding;
+            wrapped = false;
+        }
 
-            size_t idx1 = end;
-            size_t idx2 = end;
+        size_t idx1 = end;
+        size_t idx2 = end;
 
-            // "Tokenize" the string at control sequences
-            if (mUseLinksAndUserColors)
-                idx1 = row.find("##", start + 1);
-            if (mUseEmotes)
-                idx2 = row.find("%%", start + 1);
-            if (idx1 < idx2)
-                end = idx1;
-            else
-                end = idx2;
+        // "Tokenize" the string at control sequences
+        if (mUseLinksAndUserColors)
+            idx1 = row.find("##", start + 1);
+        if (mUseEmotes)
+            idx2 = row.find("%%", start + 1);
+        if (idx1 < idx2)
+            end = idx1;
+        else
+            end = idx2;
 
-            if (start == 0 || mUseLinksAndUserColors)
+        if (start == 0 || mUseLinksAndUserColors)
+        {
+            // Check for color change in format "##x", x = [L,P,0..9]
+            if (row.find("##", start) == start && row.size() > start + 2)
             {
-                // Check for color change in format "##x", x = [L,P,0..9]
-                if (row.find("##", start) == start && row.size() > start + 2)
-                {
-                    const signed char c = row.at(start + 2);
-
-                    bool valid(false);
-                    const Color col[2] =
-                    {
-                        getThemeCharColor(c, valid),
-                        getThemeCharColor(static_cast<signed char>(
-                            c | 0x80), valid)
-                    };
+                const signed char c = row.at(start + 2);
 
-                    if (c == '>')
-                    {
-                        selColor[0] = prevColor[0];
-                        selColor[1] = prevColor[1];
-                    }
-                    else if (c == '<')
-                    {
-                        prevColor[0] = selColor[0];
-                        prevColor[1] = selColor[1];
-                        selColor[0] = col[0];
-                        selColor[1] = col[1];
-                    }
-                    else if (c == 'B')
-                    {
-                        bold = true;
-                    }
-                    else if (c == 'b')
-                    {
-                        bold = false;
-                    }
-                    else if (valid)
-                    {
-                        selColor[0] = col[0];
-                        selColor[1] = col[1];
-                    }
-                    else
-                    {
-                        switch (c)
-                        {
-                            case '0':
-                                selColor[0] = mColors[0][BLACK];
-                                selColor[1] = mColors[1][BLACK];
-                                break;
-                            case '1':
-                                selColor[0] = mColors[0][RED];
-                                selColor[1] = mColors[1][RED];
-                                break;
-                            case '2':
-                                selColor[0] = mColors[0][GREEN];
-                                selColor[1] = mColors[1][GREEN];
-                                break;
-                            case '3':
-                                selColor[0] = mColors[0][BLUE];
-                                selColor[1] = mColors[1][BLUE];
-                                break;
-                            case '4':
-                                selColor[0] = mColors[0][ORANGE];
-                                selColor[1] = mColors[1][ORANGE];
-                                break;
-                            case '5':
-                                selColor[0] = mColors[0][YELLOW];
-                                selColor[1] = mColors[1][YELLOW];
-                                break;
-                            case '6':
-                                selColor[0] = mColors[0][PINK];
-                                selColor[1] = mColors[1][PINK];
-                                break;
-                            case '7':
-                                selColor[0] = mColors[0][PURPLE];
-                                selColor[1] = mColors[1][PURPLE];
-                                break;
-                            case '8':
-                                selColor[0] = mColors[0][GRAY];
-                                selColor[1] = mColors[1][GRAY];
-                                break;
-                            case '9':
-                                selColor[0] = mColors[0][BROWN];
-                                selColor[1] = mColors[1][BROWN];
-                                break;
-                            default:
-                                selColor[0] = textColor[0];
-                                selColor[1] = textColor[1];
-                                break;
-                        }
-                    }
+                bool valid(false);
+                const Color col[2] =
+                {
+                    getThemeCharColor(c, valid),
+                    getThemeCharColor(static_cast<signed char>(
+                        c | 0x80), valid)
+                };
 
-                    if (c == '<' && link < static_cast<signed>(mLinks.size()))
+                if (c == '>')
+                {
+                    selColor[0] = prevColor[0];
+                    selColor[1] = prevColor[1];
+                }
+                else if (c == '<')
+                {
+                    prevColor[0] = selColor[0];
+                    prevColor[1] = selColor[1];
+                    selColor[0] = col[0];
+                    selColor[1] = col[1];
+                }
+                else if (c == 'B')
+                {
+                    bold = true;
+                }
+                else if (c == 'b')
+                {
+                    bold = false;
+                }
+                else if (valid)
+                {
+                    selColor[0] = col[0];
+                    selColor[1] = col[1];
+                }
+                else
+                {
+                    switch (c)
                     {
-                        const int size =
-                            font->getWidth(mLinks[link].caption) + 1;
-
-                        mLinks[link].x1 = x;
-                        mLinks[link].y1 = y;
-                        mLinks[link].x2 = mLinks[link].x1 + size;
-                        mLinks[link].y2 = y + fontHeight - 1;
-                        link++;
+                        case '0':
+                            selColor[0] = mColors[0][BLACK];
+                            selColor[1] = mColors[1][BLACK];
+                            break;
+                        case '1':
+                            selColor[0] = mColors[0][RED];
+                            selColor[1] = mColors[1][RED];
+                            break;
+                        case '2':
+                            selColor[0] = mColors[0][GREEN];
+                            selColor[1] = mColors[1][GREEN];
+                            break;
+                        case '3':
+                            selColor[0] = mColors[0][BLUE];
+                            selColor[1] = mColors[1][BLUE];
+                            break;
+                        case '4':
+                            selColor[0] = mColors[0][ORANGE];
+                            selColor[1] = mColors[1][ORANGE];
+                            break;
+                        case '5':
+                            selColor[0] = mColors[0][YELLOW];
+                            selColor[1] = mColors[1][YELLOW];
+                            break;
+                        case '6':
+                            selColor[0] = mColors[0][PINK];
+                            selColor[1] = mColors[1][PINK];
+                            break;
+                        case '7':
+                            selColor[0] = mColors[0][PURPLE];
+                            selColor[1] = mColors[1][PURPLE];
+                            break;
+                        case '8':
+                            selColor[0] = mColors[0][GRAY];
+                            selColor[1] = mColors[1][GRAY];
+                            break;
+                        case '9':
+                            selColor[0] = mColors[0][BROWN];
+                            selColor[1] = mColors[1][BROWN];
+                            break;
+                        default:
+                            selColor[0] = textColor[0];
+                            selColor[1] = textColor[1];
+                            break;
                     }
+                }
 
-                    processed = true;
-                    start += 3;
-                    if (start == row.size())
-                        break;
+                if (c == '<' && link < linksCount)
+                {
+                    BrowserLink &bLink = mLinks[firstLink + link];
+                    const int size = font->getWidth(bLink.caption) + 1;
+
+                    bLink.x1 = x;
+                    bLink.y1 = layout->y + y;
+                    bLink.x2 = bLink.x1 + size;
+                    bLink.y2 = layout->y + y + fontHeight - 1;
+                    link++;
                 }
+
+                processed = true;
+                start += 3;
+                if (start == row.size())
+                    break;
             }
-            if (mUseEmotes)
+        }
+        if (mUseEmotes)
+        {
+            // check for emote icons
+            if (row.size() > start + 2 && row.substr(start, 2) == "%%")
             {
-                // check for emote icons
-                if (row.size() > start + 2 && row.substr(start, 2) == "%%")
+                if (objects < 5)
                 {
-                    if (objects < 5)
+                    const int cid = row.at(start + 2) - '0';
+                    if (cid >= 0)
                     {
-                        const int cid = row.at(start + 2) - '0';
-                        if (cid >= 0)
+                        if (mEmotes)
                         {
-                            if (mEmotes)
+                            const size_t sz = mEmotes->size();
+                            if (static_cast<size_t>(cid) < sz)
                             {
-                                const size_t sz = mEmotes->size();
-                                if (static_cast<size_t>(cid) < sz)
+                                Image *const img = mEmotes->get(cid);
+                                if (img)
                                 {
-                                    Image *const img = mEmotes->get(cid);
-                                    if (img)
-                                    {
-                                        mLineParts.push_back(LinePart(
-                                            x, y + mItemPadding,
-                                            selColor[0], selColor[1], img));
-                                        x += 18;
-                                    }
+                                    layout->parts.push_back(LinePart(
+                                        x, y + mItemPadding,
+                                        selColor[0], selColor[1], img));
+                                    x += 18;
                                 }
                             }
                         }
-                        objects ++;
-                        processed = true;
                     }
+                    objects ++;
+                    processed = true;
+                }
 
-                    start += 3;
-                    if (start == row.size())
-                    {
-                        if (x > mDataWidth)
-                            mDataWidth = x;
-                        break;
-                    }
+                start += 3;
+                if (start == row.size())
+                {
+                    if (x > mDataWidth)
+                        mDataWidth = x;
+                    break;
                 }
             }
-            const size_t len = (end == std::string::npos) ? end : end - start;
-
-            if (start >= row.length())
-                break;
+        }
+        const size_t len = (end == std::string::npos) ? end : end - start;
 
-            std::string part = row.substr(start, len);
-            int width = 0;
-            if (bold)
-                width = boldFont->getWidth(part);
-            else
-                width = font->getWidth(part);
+        if (start >= row.length())
+            break;
 
-            // Auto wrap mode
-            if (mMode == AUTO_WRAP && wWidth > 0 && width > 0
-                && (x + width + 10) > wWidth)
-            {
-                bool forced = false;
+        std::string part = row.substr(start, len);
+        int width = 0;
+        if (bold)
+            width = boldFont->getWidth(part);
+        else
+            width = font->getWidth(part);
 
-                /* FIXME: This code layout makes it easy to crash remote
-                   clients by talking garbage. Forged long utf-8 characters
-                   will cause either a buffer underflow in substr or an
-                   infinite loop in the main loop. */
-                do
-                {
-                    if (!forced)
-                        end = row.rfind(' ', end);
+        // Auto wrap mode
+        if (mMode == AUTO_WRAP && wWidth > 0 && width > 0
+            && (x + width + 10) > wWidth)
+        {
+            const Font *const partFont = bold ? boldFont : font;
+            end = partFont->getWrapIndex(row, start, end,
+                static_cast<int>(wWidth - x) - 10, false);
 
-                    // Check if we have to (stupidly) force-wrap
-                    if (end == std::string::npos || end <= start)
-                    {
-                        forced = true;
-                        end = row.size();
-                        x += hyphenWidth;  // Account for the wrap-notifier
-                        continue;
-                    }
+            // Check if we have to (stupidly) force-wrap
+            if (end == std::string::npos)
+            {
+                end = partFont->getWrapIndex(row, start, row.size(),
+                    static_cast<int>(wWidth - x - hyphenWidth) - 10,
+                    true);
+                layout->parts.push_back(LinePart(
+                    wWidth - hyphenWidth, y + mItemPadding,
+                    selColor[0], selColor[1], hyphen, bold));
+                part = row.substr(start, end - start);
+            }
+            else
+            {
+                part = row.substr(start, end - start);
+                end ++;  // Skip to after the space
+            }
 
-                    // Skip to the start of the current character
-                    while ((row[end] & 192) == 128)
-                        end--;
-                    end--;  // And then to the last byte of the previous one
+            wrapped = true;
+            wrappedLines++;
+        }
 
-                    part = row.substr(start, end - start + 1);
-                    if (bold)
-                        width = boldFont->getWidth(part);
-                    else
-                        width = font->getWidth(part);
-                }
-                while (end > start && width > 0 && (x + width + 10) > wWidth);
+        layout->parts.push_back(LinePart(x, y + mItemPadding,
+            selColor[0], selColor[1], part.c_str(), bold));
 
-                if (forced)
-                {
-                    x -= hyphenWidth;  // Remove the wrap-notifier accounting
-                    mLineParts.push_back(LinePart(
-                        wWidth - hyphenWidth, y + mItemPadding,
-                        selColor[0], selColor[1], hyphen, bold));
-                    end++;  // Skip to the next character
-                }
-                else
-                {
-                    end += 2;  // Skip to after the space
-                }
+        if (bold)
+            width = boldFont->getWidth(part);
+        else
+            width = font->getWidth(part);
 
-                wrapped = true;
-                wrappedLines++;
-            }
+        if (mMode == AUTO_WRAP && (width == 0 && !processed))
+            break;
 
-            mLineParts.push_back(LinePart(x, y + mItemPadding,
-                selColor[0], selColor[1], part.c_str(), bold));
+        x += width;
+        if (x > mDataWidth)
+            mDataWidth = x;
+    }
+    layout->step = y + fontHeight;
+    layout->height = (wrappedLines + 1) * fontHeight;
+    layout->endColor = selColor[0];
+    layout->endColor2 = selColor[1];
+}
 
-            if (bold)
-                width = boldFont->getWidth(part);
-            else
-                width = font->getWidth(part);
+void BrowserBox::updateRowsColors(const size_t skip)
+{
+    Color color = mForegroundColor;
+    Color color2 = mForegroundColor2;
+    int link = 0;
+    std::list<int>::const_iterator linksIt = mTextRowLinksCount.begin();
+    TextRowCIter textIt = mTextRows.begin();
+    const size_t sz = mRows.size();
 
-            if (mMode == AUTO_WRAP && (width == 0 && !processed))
+    for (size_t f = 0; f < sz; f ++)
+    {
+        BrowserRow *const layout = mRows[f];
+        const int linksCount = *linksIt;
+        if (f >= skip)
+        {
+            if (layout->color == color && layout->color2 == color2)
                 break;
-
-            x += width;
-            if (x > mDataWidth)
-                mDataWidth = x;
+            // colors not change row size, so next rows not moved
+            layout->color = color;
+            layout->color2 = color2;
+            layoutRow(layout, *textIt, link, linksCount);
         }
-        y += fontHeight;
+        color = layout->endColor;
+        color2 = layout->endColor2;
+        link += linksCount;
+        ++ linksIt;
+        ++ textIt;
     }
-    if (static_cast<signed>(wWidth) != maxWidth)
-        setWidth(maxWidth);
+}
 
-    return (static_cast<int>(mTextRows.size()) + wrappedLines)
-        * fontHeight + moreHeight + 2 * mPadding;
+BrowserBox::BrowserRowsCIter BrowserBox::findRow(const int y) const
+{
+    // rows not sorted by y until next full layout
+    if (mLayoutDirty)
+        return mRows.begin();
+    return std::lower_bound(mRows.begin(), mRows.end(), y,
+        RowAbove(mYOffset));
 }
 
 void BrowserBox::updateHeight()
@@ -886,22 +1038,32 @@ std::string BrowserBox::getTextAtPos(const int x, const int y) const
     std::string str;
     int lastY = 0;
 
-    FOR_EACH (LinePartCIter, i, mLineParts)
+    const BrowserRowsCIter it_end = mRows.end();
+    for (BrowserRowsCIter it = findRow(mYStart - 50); it != it_end; ++ it)
     {
-        const LinePart &part = *i;
-        if (part.mY + 50 < mYStart)
-            continue;
-        if (part.mY > textY)
+        const BrowserRow *const row = *it;
+        const int rowY = row->y - mYOffset;
+        if (rowY > textY)
             break;
 
-        if (part.mY > lastY)
+        FOR_EACH (LinePartCIter, i, row->parts)
         {
-            str = part.mText;
-            lastY = part.mY;
-        }
-        else
-        {
-            str.append(part.mText);
+            const LinePart &part = *i;
+            const int partY = rowY + part.mY;
+            if (partY + 50 < mYStart)
+                continue;
+            if (partY > textY)
+                break;
+
+            if (partY > lastY)
+            {
+                str = part.mText;
+                lastY = partY;
+            }
+            else
+            {
+                str.append(part.mText);
+            }
         }
     }
 
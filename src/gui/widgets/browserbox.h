@@ -29,6 +29,7 @@
 #include "gui/widgets/linepart.h"
 #include "gui/widgets/widget.h"
 
+#include <deque>
 #include <list>
 #include <vector>
 
@@ -56,6 +57,38 @@ struct BrowserLink final
     std::string caption;
 };
 
+/**
+ * Cached layout of one BrowserBox row.
+ * Line parts y is relative to row y.
+ */
+struct BrowserRow final
+{
+    BrowserRow() :
+        parts(),
+        color(),
+        color2(),
+        endColor(),
+        endColor2(),
+        y(0),
+        step(0),
+        height(0),
+        width(0)
+    {
+    }
+
+    A_DELETE_COPY(BrowserRow)
+
+    std::vector<LinePart> parts;
+    Color color;
+    Color color2;
+    Color endColor;
+    Color endColor2;
+    int y;
+    int step;
+    int height;
+    int width;
+};
+
 /**
  * A simple browser box able to handle links and forward events to the
  * parent conteiner.
@@ -196,9 +229,33 @@ class BrowserBox final : public Widget,
         int getDataWidth() const
         { return mDataWidth; }
 
+        void fontChanged() override final
+        { mLayoutDirty = true; }
+
+#ifdef UNITTESTS
+        const std::deque<BrowserRow*> &getLineRows() const
+        { return mRows; }
+
+        const std::vector<BrowserLink> &getLinks() const
+        { return mLinks; }
+
+        int getYOffset() const
+        { return mYOffset; }
+
+        int getItemPadding() const
+        { return mItemPadding; }
+#endif
+
     private:
         int calcHeight() A_WARN_UNUSED;
 
+        void layoutRow(BrowserRow *const layout,
+                       const std::string &row,
+                       const int firstLink,
+                       const int linksCount);
+
+        void updateRowsColors(const size_t skip);
+
         typedef TextRows::iterator TextRowIterator;
         typedef TextRows::const_iterator TextRowCIter;
         TextRows mTextRows;
@@ -207,7 +264,17 @@ class BrowserBox final : public Widget,
         typedef std::vector<LinePart> LinePartList;
         typedef LinePartList::iterator LinePartIterator;
         typedef LinePartList::const_iterator LinePartCIter;
-        LinePartList mLineParts;
+
+        typedef std::deque<BrowserRow*> BrowserRows;
+        typedef BrowserRows::iterator BrowserRowsIter;
+        typedef BrowserRows::const_iterator BrowserRowsCIter;
+
+        /**
+         * Returns first row what ends below y.
+         */
+        BrowserRowsCIter findRow(const int y) const A_WARN_UNUSED;
+
+        BrowserRows mRows;
 
         typedef std::vector<BrowserLink> Links;
         typedef Links::iterator LinkIterator;
@@ -227,6 +294,9 @@ class BrowserBox final : public Widget,
         int mNewLinePadding;
         int mItemPadding;
         unsigned int mDataWidth;
+        int mRowsHeight;
+        int mYOffset;
+        int mFontHeight;
 
         Color mHighlightColor;
         Color mHyperLinkColor;
@@ -240,6 +310,7 @@ class BrowserBox final : public Widget,
         bool mEnableImages;
         bool mEnableKeys;
         bool mEnableTabs;
+        bool mLayoutDirty;
 
         static ImageSet *mEmotes;
         static int mInstances;
@@ -30,6 +30,8 @@
 
 #include "resources/sdlimagehelper.h"
 
+#include "utils/stringutils.h"
+
 #include "gtest/gtest.h"
 
 #include <physfs.h>
@@ -42,6 +44,62 @@
 
 extern const char *dirSeparator;
 
+static std::string dumpLayout(const BrowserBox *const box)
+{
+    std::string str = strprintf("height %d\n", box->getHeight());
+    const int offset = box->getYOffset();
+    const std::deque<BrowserRow*> &rows = box->getLineRows();
+    FOR_EACH (std::deque<BrowserRow*>::const_iterator, it, rows)
+    {
+        const BrowserRow *const row = *it;
+        const std::vector<LinePart> &parts = row->parts;
+        FOR_EACH (std::vector<LinePart>::const_iterator, it2, parts)
+        {
+            const LinePart &part = *it2;
+            str.append(strprintf("%d,%d,%u,%u,%u,%d,%s\n",
+                part.mX, row->y - offset + part.mY,
+                part.mColor.r, part.mColor.g, part.mColor.b,
+                part.mBold ? 1 : 0, part.mText.c_str()));
+        }
+    }
+    const std::vector<BrowserLink> &links = box->getLinks();
+    FOR_EACH (std::vector<BrowserLink>::const_iterator, it, links)
+    {
+        const BrowserLink &link = *it;
+        str.append(strprintf("link %d,%d,%d,%d,%s\n",
+            link.x1, link.y1 - offset, link.x2, link.y2 - offset,
+            link.caption.c_str()));
+    }
+    return str;
+}
+
+static std::string dumpPositions(const BrowserBox *const box)
+{
+    std::string str = strprintf("height %d\n", box->getHeight());
+    const int offset = box->getYOffset();
+    const std::deque<BrowserRow*> &rows = box->getLineRows();
+    FOR_EACH (std::deque<BrowserRow*>::const_iterator, it, rows)
+    {
+        const BrowserRow *const row = *it;
+        const std::vector<LinePart> &parts = row->parts;
+        FOR_EACH (std::vector<LinePart>::const_iterator, it2, parts)
+        {
+            const LinePart &part = *it2;
+            str.append(strprintf("%d,%d,%s\n", part.mX,
+                row->y - offset + part.mY, part.mText.c_str()));
+        }
+    }
+    const std::vector<BrowserLink> &links = box->getLinks();
+    FOR_EACH (std::vector<BrowserLink>::const_iterator, it, links)
+    {
+        const BrowserLink &link = *it;
+        str.append(strprintf("link %d,%d,%d,%d,%s\n",
+            link.x1, link.y1 - offset, link.x2, link.y2 - offset,
+            link.caption.c_str()));
+    }
+    return str;
+}
+
 TEST(browserbox, test1)
 {
     PHYSFS_init("manaplus");
@@ -151,3 +209,95 @@ TEST(browserbox, test1)
     delete client;
     client = nullptr;
 }
+
+TEST(browserbox, layout)
+{
+    PHYSFS_init("manaplus");
+    dirSeparator = "/";
+    client = new Client;
+    logger = new Logger();
+    imageHelper = new SDLImageHelper();
+    theme = new Theme;
+    Widget::setGlobalFont(new Font("/usr/share/fonts/truetype/"
+        "ttf-dejavu/DejaVuSans-Oblique.ttf", 18));
+    BrowserBox *box = new BrowserBox(nullptr, BrowserBox::AUTO_WRAP, true, "");
+    box->setWidth(100);
+    box->setMaxRow(10);
+
+    const char *const rows[] =
+    {
+        "test",
+        "##1red text in long row what should be wrapped",
+        "@@link|caption@@ text after link",
+        "---",
+        "##Bbold##b normal %%1 emote",
+        "##3 color for next rows",
+        "next row without color",
+        "verylongwordwithoutspaceswhatshouldbeforcewrapped",
+        "@@l1|c1@@ and @@l2|c2@@",
+        "##<open color",
+        "last row",
+        nullptr
+    };
+
+    for (int f = 0; rows[f]; f ++)
+    {
+        // top rows added below and at rows limit
+        box->addRow(rows[f], f == 3 || f == 7 || f == 10);
+        const std::string incremental = dumpLayout(box);
+        box->updateHeight();
+        EXPECT_EQ(dumpLayout(box), incremental);
+    }
+
+    delete box;
+    delete client;
+    client = nullptr;
+}
+
+TEST(browserbox, baseline)
+{
+    PHYSFS_init("manaplus");
+    dirSeparator = "/";
+    client = new Client;
+    logger = new Logger();
+    imageHelper = new SDLImageHelper();
+    theme = new Theme;
+    Font *const font = new Font("/usr/share/fonts/truetype/"
+        "ttf-dejavu/DejaVuSans-Oblique.ttf", 18);
+    Widget::setGlobalFont(font);
+    BrowserBox *box = new BrowserBox(nullptr, BrowserBox::AUTO_WRAP, true, "");
+    box->setWidth(1000);
+
+    box->addRow("first");
+    box->addRow("second @@l1|c1@@ end");
+    box->addRow("top row", true);
+    box->addRow("@@l2|c2@@");
+
+    // positions what calcHeight before incremental layout produced
+    const int pad = box->getPadding();
+    const int item = box->getItemPadding();
+    const int h = font->getHeight() + 2 * item;
+    const int x1 = pad + font->getWidth("second ");
+    const int x2 = x1 + font->getWidth("c1");
+    std::string expected = strprintf("height %d\n", 4 * h + 2 * pad);
+    expected.append(strprintf("%d,%d,top row\n", pad, pad + item));
+    expected.append(strprintf("%d,%d,first\n", pad, pad + h + item));
+    expected.append(strprintf("%d,%d,second \n", pad, pad + 2 * h + item));
+    expected.append(strprintf("%d,%d,c1\n", x1, pad + 2 * h + item));
+    expected.append(strprintf("%d,%d, end\n", x2, pad + 2 * h + item));
+    expected.append(strprintf("%d,%d,c2\n", pad, pad + 3 * h + item));
+    expected.append(strprintf("link %d,%d,%d,%d,c1\n",
+        x1, pad + 2 * h,
+        x1 + font->getWidth("c1") + 1, pad + 3 * h - 1));
+    expected.append(strprintf("link %d,%d,%d,%d,c2\n",
+        pad, pad + 3 * h,
+        pad + font->getWidth("c2") + 1, pad + 4 * h - 1));
+
+    EXPECT_EQ(expected, dumpPositions(box));
+    box->updateHeight();
+    EXPECT_EQ(expected, dumpPositions(box));
+
+    delete box;
+    delete client;
+    client = nullptr;
+}
@@ -71,8 +71,6 @@
 
 #include "gui/fonts/font.h"
 
-#include <sstream>
-
 #include "debug.h"
 
 TextBox::TextBox(const Widget2 *const widget) :
@@ -111,116 +109,62 @@ void TextBox::setTextWrapped(const std::string &text, const int minDimension)
     if (getParent())
         getParent()->logic();
 
-    // Take the supplied minimum dimension as a starting
-    // point and try to beat it
-    mMinWidth = minDimension;
-
+    const Font *const font = getFont();
     const size_t textSize = text.size();
-    size_t spacePos = text.rfind(" ", textSize);
 
-    if (spacePos != std::string::npos)
+    // Words never broken, so widest word sets minimal width
+    mMinWidth = minDimension;
+    size_t wordStart = 0;
+    while (wordStart <= textSize)
     {
-        const std::string word = text.substr(spacePos + 1);
-        const int length = getFont()->getWidth(word);
-
-        if (length > mMinWidth)
-            mMinWidth = length;
+        size_t wordEnd = text.find_first_of(" \n", wordStart);
+        if (wordEnd == std::string::npos)
+            wordEnd = textSize;
+        const int width = font->getWidth(text, wordStart, wordEnd);
+        if (width > mMinWidth)
+            mMinWidth = width;
+        wordStart = wordEnd + 1;
     }
 
-    std::stringstream wrappedStream;
-    size_t newlinePos;
-    size_t lastNewlinePos = 0;
+    std::string wrapped;
     int minWidth = 0;
-    int xpos;
-
-    do
+    size_t lineStart = 0;
+    while (lineStart <= textSize)
     {
-        // Determine next piece of string to wrap
-        newlinePos = text.find("\n", lastNewlinePos);
-
-        if (newlinePos == std::string::npos)
-            newlinePos = textSize;
+        size_t lineEnd = text.find("\n", lineStart);
+        if (lineEnd == std::string::npos)
+            lineEnd = textSize;
 
-        std::string line =
-            text.substr(lastNewlinePos, newlinePos - lastNewlinePos);
-        size_t lastSpacePos = 0;
-        xpos = 0;
-        const Font *const font = getFont();
-        const int spaceWidth = font->getWidth(" ");
-        size_t sz = line.size();
-
-        do
+        size_t start = lineStart;
+        while (true)
         {
-            spacePos = line.find(" ", lastSpacePos);
-
-            if (spacePos == std::string::npos)
-                spacePos = sz;
-
-            const std::string word =
-                line.substr(lastSpacePos, spacePos - lastSpacePos);
-
-            const int width = font->getWidth(word);
-
-            if (xpos == 0 && width > mMinWidth)
+            size_t pos = font->getWrapIndex(text, start, lineEnd,
+                mMinWidth, false);
+            if (pos == std::string::npos)
             {
-                mMinWidth = width;
-                xpos = width;
-                wrappedStream << word;
+                // leading spaces made first word too wide, keep it whole
+                pos = text.find(" ", start + 1);
+                if (pos == std::string::npos || pos > lineEnd)
+                    pos = lineEnd;
             }
-            else if (xpos != 0 && xpos + spaceWidth + width <=
-                     mMinWidth)
-            {
-                xpos += spaceWidth + width;
-                wrappedStream << " " << word;
-            }
-            else if (lastSpacePos == 0)
-            {
-                xpos += width;
-                wrappedStream << word;
-            }
-            else
-            {
-                if (xpos > minWidth)
-                    minWidth = xpos;
-
-                // The window wasn't big enough. Resize it and try again.
-                if (minWidth > mMinWidth)
-                {
-                    mMinWidth = minWidth;
-                    wrappedStream.clear();
-                    wrappedStream.str("");
-                    lastNewlinePos = 0;
-                    newlinePos = text.find("\n", lastNewlinePos);
-                    if (newlinePos == std::string::npos)
-                        newlinePos = textSize;
-                    line = text.substr(lastNewlinePos, newlinePos -
-                                       lastNewlinePos);
-                    sz = line.size();
-                    break;
-                }
-                else
-                {
-                    wrappedStream << "\n" << word;
-                }
-                xpos = width;
-            }
-            lastSpacePos = spacePos + 1;
+            const int width = font->getWidth(text, start, pos);
+            if (width > minWidth)
+                minWidth = width;
+            wrapped.append(text, start, pos - start);
+            if (pos == lineEnd)
+                break;
+            wrapped.append("\n");
+            start = pos + 1;
         }
-        while (spacePos != sz);
-
-        if (text.find("\n", lastNewlinePos) != std::string::npos)
-            wrappedStream << "\n";
 
-        lastNewlinePos = newlinePos + 1;
+        if (lineEnd != textSize)
+            wrapped.append("\n");
+        lineStart = lineEnd + 1;
     }
-    while (newlinePos != textSize);
-
-    if (xpos > minWidth)
-        minWidth = xpos;
 
     mMinWidth = minWidth;
 
-    setText(wrappedStream.str());
+    setText(wrapped);
 }
 
 void TextBox::setText(const std::string& text)
@@ -447,7 +391,7 @@ void TextBox::draw(Graphics* graphics)
     if (isFocused() && isEditable())
     {
         drawCaret(graphics, font->getWidth(
-            mTextRows[mCaretRow].substr(0, mCaretColumn)),
+            mTextRows[mCaretRow], 0, mCaretColumn),
             mCaretRow * font->getHeight());
     }
 
@@ -570,7 +514,7 @@ void TextBox::scrollToCaret()
 {
     const Font *const font = getFont();
     Rect scroll;
-    scroll.x = font->getWidth(mTextRows[mCaretRow].substr(0, mCaretColumn));
+    scroll.x = font->getWidth(mTextRows[mCaretRow], 0, mCaretColumn);
     scroll.y = font->getHeight() * mCaretRow;
     scroll.width = font->getWidth(" ");
     // add 2 for some extra space
@@ -200,7 +200,7 @@ void TextField::draw(Graphics *graphics)
     if (isFocused())
     {
         drawCaret(graphics,
-            font->getWidth(mText.substr(0, mCaretPosition)) - mXScroll);
+            font->getWidth(mText, 0, mCaretPosition) - mXScroll);
     }
 
     graphics->setColorAll(mForegroundColor, mForegroundColor2);
@@ -665,8 +665,7 @@ void TextField::fixScroll()
 {
     if (isFocused())
     {
-        const int caretX = getFont()->getWidth(
-            mText.substr(0, mCaretPosition));
+        const int caretX = getFont()->getWidth(mText, 0, mCaretPosition);
 
         const int width = mDimension.width;
         const int pad = 2 * mPadding;
@@ -40,7 +40,6 @@
 #include "resources/resourcemanager.h"
 
 #include "resources/map/map.h"
-#include "resources/map/metatile.h"
 
 #include "utils/delete2.h"
 #include "utils/gettext.h"
@@ -157,7 +156,7 @@ void Minimap::setMap(const Map *const map)
                 | BlockMask::WATER);
 
             for (int ptr = 0; ptr < size; ptr ++)
-                *(data ++) = -!(map->mMetaTiles[ptr].blockmask & mask);
+                *(data ++) = -!(map->mBlockMasks[ptr] & mask);
 
             SDL_UnlockSurface(surface);
 
@@ -133,11 +133,13 @@ void Logger::log1(const char *const buf)
     DATESTREAM
     LOG_ANDROID(buf)
 
+    SDL_mutexP(mMutex);
     if (mLogFile.is_open())
         mLogFile << timeStr.str() << buf << std::endl;
 
     if (mLogToStandardOut)
         std::cout << timeStr.str() << buf << std::endl;
+    SDL_mutexV(mMutex);
 }
 
 void Logger::log(const char *const log_text, ...)
@@ -164,11 +166,14 @@ void Logger::log(const char *const log_text, ...)
     DATESTREAM
     LOG_ANDROID(buf)
 
+    // images can be decoded in worker threads, and they can report errors
+    SDL_mutexP(mMutex);
     if (mLogFile.is_open())
         mLogFile << timeStr.str() << buf << std::endl;
 
     if (mLogToStandardOut)
         std::cout << timeStr.str() << buf << std::endl;
+    SDL_mutexV(mMutex);
 
     // Delete temporary buffer
     delete [] buf;
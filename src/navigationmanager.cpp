@@ -21,7 +21,6 @@
 #include "navigationmanager.h"
 
 #include "resources/map/map.h"
-#include "resources/map/metatile.h"
 #include "resources/map/walklayer.h"
 
 #include "debug.h"
@@ -63,15 +62,15 @@ Resource *NavigationManager::loadWalkLayer(const Map *const map)
         return nullptr;
     WalkLayer *const walkLayer = new WalkLayer(width, height);
 
-    const MetaTile *const tiles = map->getMetaTiles();
+    const unsigned char *const blockMasks = map->getBlockMasks();
     int *const data = walkLayer->getData();
 
     int x = 0;
     int y = 0;
     int num = 1;
-    while (findWalkableTile(x, y, width, height, tiles, data))
+    while (findWalkableTile(x, y, width, height, blockMasks, data))
     {
-        fillNum(x, y, width, height, num, tiles, data);
+        fillNum(x, y, width, height, num, blockMasks, data);
         num ++;
     }
 
@@ -80,7 +79,7 @@ Resource *NavigationManager::loadWalkLayer(const Map *const map)
 
 bool NavigationManager::findWalkableTile(int &x1, int &y1,
                                          const int width, const int height,
-                                         const MetaTile *const tiles,
+                                         const unsigned char *const blockMasks,
                                          const int *const data)
 {
     for (int y = 0; y < height; y ++)
@@ -89,7 +88,7 @@ bool NavigationManager::findWalkableTile(int &x1, int &y1,
         for (int x = 0; x < width; x ++)
         {
             const int ptr = x + y2;
-            if (!(tiles[ptr].blockmask & walkMask) && !data[ptr])
+            if (!(blockMasks[ptr] & walkMask) && !data[ptr])
             {
                 x1 = x;
                 y1 = y;
@@ -102,7 +101,8 @@ bool NavigationManager::findWalkableTile(int &x1, int &y1,
 
 void NavigationManager::fillNum(int x, int y,
                                 const int width, const int height,
-                                const int num, const MetaTile *const tiles,
+                                const int num,
+                                const unsigned char *const blockMasks,
                                 int *const data)
 {
     std::vector<Cell> cells;
@@ -120,7 +120,7 @@ void NavigationManager::fillNum(int x, int y,
             ptr = (x - 1) + width * y;
             if (!data[ptr])
             {
-                if (!(tiles[ptr].blockmask & walkMask))
+                if (!(blockMasks[ptr] & walkMask))
                     cells.push_back(Cell(x - 1, y));
                 else
                     data[ptr] = -num;
@@ -131,7 +131,7 @@ void NavigationManager::fillNum(int x, int y,
             ptr = (x + 1) + width * y;
             if (!data[ptr])
             {
-                if (!(tiles[ptr].blockmask & walkMask))
+                if (!(blockMasks[ptr] & walkMask))
                     cells.push_back(Cell(x + 1, y));
                 else
                     data[ptr] = -num;
@@ -142,7 +142,7 @@ void NavigationManager::fillNum(int x, int y,
             ptr = x + width * (y - 1);
             if (!data[ptr])
             {
-                if (!(tiles[ptr].blockmask & walkMask))
+                if (!(blockMasks[ptr] & walkMask))
                     cells.push_back(Cell(x, y - 1));
                 else
                     data[ptr] = -num;
@@ -153,7 +153,7 @@ void NavigationManager::fillNum(int x, int y,
             ptr = x + width * (y + 1);
             if (!data[ptr])
             {
-                if (!(tiles[ptr].blockmask & walkMask))
+                if (!(blockMasks[ptr] & walkMask))
                     cells.push_back(Cell(x, y + 1));
                 else
                     data[ptr] = -num;
@@ -26,8 +26,6 @@
 class Map;
 class Resource;
 
-struct MetaTile;
-
 class NavigationManager final
 {
     public:
@@ -42,12 +40,13 @@ class NavigationManager final
     private:
         static bool findWalkableTile(int &x1, int &y1,
                                      const int width, const int height,
-                                     const MetaTile *const tiles,
+                                     const unsigned char *const blockMasks,
                                      const int *const data);
 
         static void fillNum(int x, int y,
                             const int width, const int height,
-                            const int num, const MetaTile *const tiles,
+                            const int num,
+                            const unsigned char *const blockMasks,
                             int *const data);
 };
 
@@ -57,6 +57,8 @@ Network::Network() :
     mServer(),
     mInBuffer(new char[BUFFER_SIZE]),
     mOutBuffer(new char[BUFFER_SIZE]),
+    mInQueue(BUFFER_SIZE),
+    mInStart(0),
     mInSize(0),
     mOutSize(0),
     mToSkip(0),
@@ -110,6 +112,8 @@ bool Network::connect(const ServerInfo &server)
 
     // Reset to sane values
     mOutSize = 0;
+    mInQueue.clear();
+    mInStart = 0;
     mInSize = 0;
     mToSkip = 0;
 
@@ -167,16 +171,16 @@ void Network::skip(const int len)
 {
     SDL_mutexP(mMutexIn);
     mToSkip += len;
-    if (!mInSize)
-    {
-        SDL_mutexV(mMutexIn);
-        return;
-    }
+    SDL_mutexV(mMutexIn);
+}
 
+void Network::skipInput()
+{
+    SDL_mutexP(mMutexIn);
     if (mInSize >= mToSkip)
     {
+        mInStart += mToSkip;
         mInSize -= mToSkip;
-        memmove(mInBuffer, mInBuffer + static_cast<size_t>(mToSkip), mInSize);
         mToSkip = 0;
     }
     else
@@ -187,6 +191,50 @@ void Network::skip(const int len)
     SDL_mutexV(mMutexIn);
 }
 
+bool Network::framePackets()
+{
+    while (mInSize >= 2)
+    {
+        const int msgId = readWord(0);
+        int len = getPacketLength(msgId);
+        if (len == -1)
+        {
+            if (mInSize < 4)
+                break;
+            len = readWord(2);
+        }
+        // broken length, pass only id and let main thread report it
+        if (len < 2)
+            len = 2;
+        if (mInSize < static_cast<unsigned int>(len))
+            break;
+
+        while (!mInQueue.push(getInData(), len))
+        {
+            // main thread is behind by whole queue
+            if (mState != CONNECTED)
+                return false;
+            SDL_Delay(1);
+        }
+        mInStart += len;
+        mInSize -= len;
+    }
+
+    if (!mInSize)
+    {
+        mInStart = 0;
+    }
+    else if (mInStart > BUFFER_SIZE / 2)
+    {
+        // unframed tail is smaller than already framed part,
+        // so this copy is amortized over framed packets
+        memmove(mInBuffer, mInBuffer + static_cast<size_t>(mInStart),
+            mInSize);
+        mInStart = 0;
+    }
+    return true;
+}
+
 bool Network::realConnect()
 {
     IPaddress ipAddress;
@@ -259,17 +307,10 @@ void Network::receive()
             case 1:
             {
                 // Receive data from the socket
-                SDL_mutexP(mMutexIn);
-                if (mInSize > BUFFER_LIMIT)
-                {
-                    SDL_mutexV(mMutexIn);
-                    SDL_Delay(100);
-                    continue;
-                }
-
+                const unsigned int inEnd = mInStart + mInSize;
                 const int ret = TcpNet::recv(mSocket,
-                    mInBuffer + static_cast<size_t>(mInSize),
-                    BUFFER_SIZE - mInSize);
+                    mInBuffer + static_cast<size_t>(inEnd),
+                    BUFFER_SIZE - inEnd);
 
                 if (!ret)
                 {
@@ -287,24 +328,11 @@ void Network::receive()
                 {
 //                    DEBUGLOG("Receive " + toString(ret) + " bytes");
                     mInSize += ret;
-                    if (mToSkip)
-                    {
-                        if (mInSize >= mToSkip)
-                        {
-                            mInSize -= mToSkip;
-                            memmove(mInBuffer,
-                                mInBuffer + static_cast<size_t>(mToSkip),
-                                mInSize);
-                            mToSkip = 0;
-                        }
-                        else
-                        {
-                            mToSkip -= mInSize;
-                            mInSize = 0;
-                        }
-                    }
+                    // mToSkip changed from main thread, so checked
+                    // in skipInput under lock
+                    skipInput();
+                    framePackets();
                 }
-                SDL_mutexV(mMutexIn);
                 break;
             }
 
@@ -336,10 +364,10 @@ uint16_t Network::readWord(const int pos) const
 {
 #if SDL_BYTEORDER == SDL_BIG_ENDIAN
     return SDL_Swap16(*reinterpret_cast<uint16_t*>(
-        mInBuffer + static_cast<size_t>(pos)));
+        mInBuffer + static_cast<size_t>(mInStart + pos)));
 #else
     return (*reinterpret_cast<uint16_t*>(
-        mInBuffer + static_cast<size_t>(pos)));
+        mInBuffer + static_cast<size_t>(mInStart + pos)));
 #endif
 }
 
@@ -26,6 +26,8 @@
 #include "net/serverinfo.h"
 #include "net/sdltcpnet.h"
 
+#include "net/ea/packetqueue.h"
+
 #include <SDL_thread.h>
 
 #include <string>
@@ -58,9 +60,6 @@ class Network notfinal
         bool isConnected() const A_WARN_UNUSED
         { return mState == CONNECTED; }
 
-        int getInSize() const A_WARN_UNUSED
-        { return mInSize; }
-
         void skip(const int len);
 
         void flush();
@@ -84,16 +83,36 @@ class Network notfinal
 
         uint16_t readWord(const int pos) const A_WARN_UNUSED;
 
+        const char *getInData() const A_WARN_UNUSED
+        { return mInBuffer + static_cast<size_t>(mInStart); }
+
         bool realConnect();
 
         void receive();
 
+        void skipInput();
+
+        bool framePackets();
+
+        /**
+         * Returns length of packet with given id, or -1 if length is
+         * stored in packet itself.
+         */
+        virtual int getPacketLength(const int msgId) const
+                                    A_WARN_UNUSED = 0;
+
         TcpNet::Socket mSocket;
 
         ServerInfo mServer;
 
+        // raw received data, used only by network thread
         char *mInBuffer;
         char *mOutBuffer;
+        // complete packets framed by network thread
+        PacketQueue mInQueue;
+        // offset of first not framed byte in mInBuffer
+        unsigned int mInStart;
+        // not framed bytes starting from mInStart
         unsigned int mInSize;
         unsigned int mOutSize;
 
@@ -0,0 +1,154 @@
+/*
+ *  The ManaPlus Client
+ *  Copyright (C) 2011-2014  The ManaPlus Developers
+ *
+ *  This file is part of The ManaPlus Client.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "net/ea/packetqueue.h"
+
+#include <string.h>
+
+#include "debug.h"
+
+namespace Ea
+{
+
+namespace
+{
+    const uint32_t WRAP_MARKER = 0xffffffffU;
+    const unsigned int HEADER_SIZE = sizeof(uint32_t);
+
+    inline unsigned int recordSize(const unsigned int len)
+    {
+        // keep headers aligned
+        return HEADER_SIZE + ((len + 3U) & ~3U);
+    }
+}  // namespace
+
+PacketQueue::PacketQueue(const unsigned int size) :
+    mBuffer(new char[(size + 3U) & ~3U]),
+    mSize((size + 3U) & ~3U),
+    mHead(0),
+    mTail(0),
+    mMutex(SDL_CreateMutex())
+{
+}
+
+PacketQueue::~PacketQueue()
+{
+    SDL_DestroyMutex(mMutex);
+    mMutex = nullptr;
+    delete []mBuffer;
+}
+
+bool PacketQueue::push(const char *const data, const unsigned int len)
+{
+    const unsigned int need = recordSize(len);
+    // head changed only by this thread
+    unsigned int head = mHead;
+    SDL_mutexP(mMutex);
+    const unsigned int tail = mTail;
+    SDL_mutexV(mMutex);
+
+    if (head >= tail)
+    {
+        // head must not reach tail, or queue will look empty
+        if (head + need > mSize || (head + need == mSize && !tail))
+        {
+            if (need >= tail)
+                return false;
+            const uint32_t marker = WRAP_MARKER;
+            memcpy(mBuffer + head, &marker, HEADER_SIZE);
+            head = 0;
+        }
+    }
+    else if (head + need >= tail)
+    {
+        return false;
+    }
+
+    const uint32_t len32 = len;
+    memcpy(mBuffer + head, &len32, HEADER_SIZE);
+    memcpy(mBuffer + head + HEADER_SIZE, data, len);
+    head += need;
+    if (head == mSize)
+        head = 0;
+
+    // publish data before new head position
+    SDL_mutexP(mMutex);
+    mHead = head;
+    SDL_mutexV(mMutex);
+    return true;
+}
+
+const char *PacketQueue::front(unsigned int &len)
+{
+    SDL_mutexP(mMutex);
+    const unsigned int head = mHead;
+    SDL_mutexV(mMutex);
+    // tail changed only by this thread
+    unsigned int tail = mTail;
+    if (head == tail)
+        return nullptr;
+
+    uint32_t len32;
+    memcpy(&len32, mBuffer + tail, HEADER_SIZE);
+    if (len32 == WRAP_MARKER)
+    {
+        tail = 0;
+        SDL_mutexP(mMutex);
+        mTail = 0;
+        SDL_mutexV(mMutex);
+        memcpy(&len32, mBuffer, HEADER_SIZE);
+    }
+    len = len32;
+    return mBuffer + tail + HEADER_SIZE;
+}
+
+void PacketQueue::pop()
+{
+    unsigned int len = 0;
+    if (!front(len))
+        return;
+
+    unsigned int tail = mTail + recordSize(len);
+    if (tail == mSize)
+        tail = 0;
+
+    // finish reading record before producer can overwrite it
+    SDL_mutexP(mMutex);
+    mTail = tail;
+    SDL_mutexV(mMutex);
+}
+
+void PacketQueue::clear()
+{
+    SDL_mutexP(mMutex);
+    mHead = 0;
+    mTail = 0;
+    SDL_mutexV(mMutex);
+}
+
+bool PacketQueue::empty() const
+{
+    SDL_mutexP(mMutex);
+    const bool res = mHead == mTail;
+    SDL_mutexV(mMutex);
+    return res;
+}
+
+}  // namespace Ea
@@ -0,0 +1,87 @@
+/*
+ *  The ManaPlus Client
+ *  Copyright (C) 2011-2014  The ManaPlus Developers
+ *
+ *  This file is part of The ManaPlus Client.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NET_EA_PACKETQUEUE_H
+#define NET_EA_PACKETQUEUE_H
+
+#include <SDL_thread.h>
+
+#include <stdint.h>
+
+#include "localconsts.h"
+
+namespace Ea
+{
+
+/**
+ * Single producer / single consumer queue of framed packets.
+ *
+ * Packets are stored as length prefixed records in one ring buffer.
+ * A record never wraps around the buffer end, so each packet can be read
+ * in place. Only network thread may call push(), and only main thread
+ * may call front() and pop(). Only read and write positions are guarded
+ * by mutex, packet data copied and read without lock.
+ */
+class PacketQueue final
+{
+    public:
+        explicit PacketQueue(const unsigned int size);
+
+        A_DELETE_COPY(PacketQueue)
+
+        ~PacketQueue();
+
+        /**
+         * Copies packet into queue. Returns false if queue is full.
+         */
+        bool push(const char *const data,
+                  const unsigned int len) A_WARN_UNUSED;
+
+        /**
+         * Returns oldest packet and its length, or nullptr if queue empty.
+         */
+        const char *front(unsigned int &len) A_WARN_UNUSED;
+
+        /**
+         * Removes packet returned by last front() call.
+         */
+        void pop();
+
+        /**
+         * Drops all packets. Must not be called while other thread
+         * uses queue.
+         */
+        void clear();
+
+        bool empty() const A_WARN_UNUSED;
+
+    private:
+        char *mBuffer;
+        const unsigned int mSize;
+        // write position, changed only by producer
+        unsigned int mHead;
+        // read position, changed only by consumer
+        unsigned int mTail;
+        SDL_mutex *mMutex;
+};
+
+}  // namespace Ea
+
+#endif  // NET_EA_PACKETQUEUE_H
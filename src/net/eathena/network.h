@@ -50,8 +50,6 @@ class Network final : public Ea::Network
 
         void clearHandlers();
 
-        bool messageReady();
-
         void dispatchMessages();
 
     protected:
@@ -59,6 +57,9 @@ class Network final : public Ea::Network
 
         static Network *instance() A_WARN_UNUSED;
 
+        int getPacketLength(const int msgId) const override final
+                            A_WARN_UNUSED;
+
         MessageHandler **mMessageHandlers;
 
         static Network *mInstance;
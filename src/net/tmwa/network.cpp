@@ -99,6 +99,9 @@ Network::Network() :
 
 Network::~Network()
 {
+    // stop network thread before it can call getPacketLength
+    if (mState != IDLE && mState != NET_ERROR)
+        disconnect();
     clearHandlers();
     delete2(mMessageHandlers);
     mInstance = nullptr;
@@ -141,33 +144,21 @@ void Network::clearHandlers()
 void Network::dispatchMessages()
 {
     BLOCK_START("Network::dispatchMessages 1")
-    while (messageReady())
+    unsigned int len = 0;
+    const char *data = nullptr;
+    while ((data = mInQueue.front(len)))
     {
-        SDL_mutexP(mMutexIn);
         BLOCK_START("Network::dispatchMessages 2")
-        const unsigned int msgId = readWord(0);
-        int len = -1;
-        if (msgId == SMSG_SERVER_VERSION_RESPONSE)
-            len = 10;
-        else if (msgId == SMSG_UPDATE_HOST2)
-            len = -1;
-        else if (msgId < packet_lengths_size)
-            len = packet_lengths[msgId];
-
-        if (len == -1)
-            len = readWord(2);
-
-        MessageIn msg(mInBuffer, len);
+        MessageIn msg(data, len);
         msg.postInit();
-        SDL_mutexV(mMutexIn);
-        BLOCK_END("Network::dispatchMessages 2")
-        BLOCK_START("Network::dispatchMessages 3")
+        const int msgId = msg.getId();
+        const int msgLen = getPacketLength(msgId);
 
-        if (len == 0)
+        if (msgLen == 0 || (msgLen == -1 && len < 4))
         {
             // need copy data for safty
             std::string str = strprintf("Wrong packet %u ""received. Exiting.",
-                msgId);
+                static_cast<unsigned int>(msgId));
             logger->safeError(str);
         }
 
@@ -180,42 +171,21 @@ void Network::dispatchMessages()
                 logger->log("Unhandled packet: %x", msgId);
         }
 
-        skip(len);
-        BLOCK_END("Network::dispatchMessages 3")
+        mInQueue.pop();
+        BLOCK_END("Network::dispatchMessages 2")
     }
     BLOCK_END("Network::dispatchMessages 1")
 }
 
-bool Network::messageReady()
+int Network::getPacketLength(const int msgId) const
 {
-    int len = -1;
-
-    SDL_mutexP(mMutexIn);
-    if (mInSize >= 2)
-    {
-        const int msgId = readWord(0);
-        if (msgId == SMSG_SERVER_VERSION_RESPONSE)
-        {
-            len = 10;
-        }
-        else if (msgId == SMSG_UPDATE_HOST2)
-        {
-            len = -1;
-        }
-        else
-        {
-            if (msgId >= 0 && msgId < packet_lengths_size)
-                len = packet_lengths[msgId];
-        }
-
-        if (len == -1 && mInSize > 4)
-            len = readWord(2);
-    }
-
-    const bool ret = (mInSize >= static_cast<unsigned int>(len));
-    SDL_mutexV(mMutexIn);
-
-    return ret;
+    if (msgId == SMSG_SERVER_VERSION_RESPONSE)
+        return 10;
+    else if (msgId == SMSG_UPDATE_HOST2)
+        return -1;
+    else if (msgId >= 0 && msgId < packet_lengths_size)
+        return packet_lengths[msgId];
+    return 0;
 }
 
 Network *Network::instance()
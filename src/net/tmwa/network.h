@@ -51,8 +51,6 @@ class Network final : public Ea::Network
 
         void clearHandlers();
 
-        bool messageReady();
-
         void dispatchMessages();
 
     protected:
@@ -60,6 +58,9 @@ class Network final : public Ea::Network
 
         static Network *instance() A_WARN_UNUSED;
 
+        int getPacketLength(const int msgId) const override final
+                            A_WARN_UNUSED;
+
         MessageHandler **mMessageHandlers;
 
         static Network *mInstance;
@@ -27,22 +27,23 @@
 #include "logger.h"
 
 #include "particle/animationparticle.h"
+#include "particle/particlebatch.h"
 #include "particle/particleemitter.h"
+#include "particle/particlepool.h"
 #include "particle/rotationalparticle.h"
 #include "particle/textparticle.h"
 
 #include "resources/resourcemanager.h"
 
+#include "utils/delete2.h"
 #include "utils/dtor.h"
-#include "utils/mathutils.h"
-
-#include <cmath>
 
 #include "debug.h"
 
 Particle *particleEngine = nullptr;
 
-static const float SIN45 = 0.707106781F;
+// seeds of random generators for particles without emitter
+static uint32_t randomSeed = 1;
 
 class Graphics;
 class Image;
@@ -73,21 +74,43 @@ Particle::Particle() :
     mMomentum(1.0F),
     mTarget(nullptr),
     mRandomness(0),
+    mRandomState(1),
+    mChildrenBatch(nullptr),
+    mParentBatch(nullptr),
+    mBatchIndex(0),
+    mOldPos(),
+    mNewAlive(ALIVE),
     mDeathEffectConditions(0x00),
     mAutoDelete(true),
     mAllowSizeAdjust(false),
-    mFollow(false)
+    mFollow(false),
+    mPhysicsDone(false)
 {
+    setRandomSeed(particleRandom(randomSeed));
     Particle::particleCount++;
 }
 
 Particle::~Particle()
 {
+    leaveBatch();
     // Delete child emitters and child particles
     clear();
+    delete2(mChildrenBatch);
     Particle::particleCount--;
 }
 
+#ifndef ENABLE_MEM_DEBUG
+void *Particle::operator new(size_t size)
+{
+    return ParticlePool::allocate(size);
+}
+
+void Particle::operator delete(void *ptr, size_t size)
+{
+    ParticlePool::release(ptr, size);
+}
+#endif
+
 void Particle::setupEngine()
 {
     Particle::maxCount = config.getIntValue("particleMaxCount");
@@ -112,106 +135,36 @@ bool Particle::update()
     if (mLifetimeLeft == 0 && mAlive == ALIVE)
         mAlive = DEAD_TIMEOUT;
 
-    const Vector oldPos = mPos;
+    Vector oldPos = mPos;
 
     if (mAlive == ALIVE)
     {
-        // calculate particle movement
-        if (mMomentum != 1.0F)
-            mVelocity *= mMomentum;
-
-        if (mTarget && mAcceleration != 0.0F)
+        // movement calculated by parent batch. Particles without parent
+        // and particles added while children was updated not moved.
+        if (mPhysicsDone)
         {
-            Vector dist = mPos - mTarget->mPos;
-            dist.x *= SIN45;
-            float invHypotenuse;
-
-            switch (Particle::fastPhysics)
-            {
-                case 1:
-                    invHypotenuse = fastInvSqrt(
-                        dist.x * dist.x + dist.y * dist.y + dist.z * dist.z);
-                    break;
-                case 2:
-                    if (!dist.x)
-                    {
-                        invHypotenuse = 0;
-                        break;
-                    }
-
-                    invHypotenuse = 2.0F / (static_cast<float>(fabs(dist.x))
-                                    + static_cast<float>(fabs(dist.y))
-                                    + static_cast<float>(fabs(dist.z)));
-                    break;
-                default:
-                    invHypotenuse = 1.0F / static_cast<float>(sqrt(
-                        dist.x * dist.x + dist.y * dist.y + dist.z * dist.z));
-                    break;
-            }
-
-            if (invHypotenuse)
-            {
-                if (mInvDieDistance > 0.0F && invHypotenuse > mInvDieDistance)
-                    mAlive = DEAD_IMPACT;
-                const float accFactor = invHypotenuse * mAcceleration;
-                mVelocity -= dist * accFactor;
-            }
-        }
-
-        if (mRandomness > 0)
-        {
-            mVelocity.x += static_cast<float>((rand() % mRandomness - rand()
-                           % mRandomness)) / 1000.0F;
-            mVelocity.y += static_cast<float>((rand() % mRandomness - rand()
-                           % mRandomness)) / 1000.0F;
-            mVelocity.z += static_cast<float>((rand() % mRandomness - rand()
-                           % mRandomness)) / 1000.0F;
+            mPhysicsDone = false;
+            oldPos = mOldPos;
+            mAlive = mNewAlive;
         }
 
-        mVelocity.z -= mGravity;
-
-        // Update position
-        mPos.x += mVelocity.x;
-        mPos.y += mVelocity.y * SIN45;
-        mPos.z += mVelocity.z * SIN45;
-
         // Update other stuff
         if (mLifetimeLeft > 0)
             mLifetimeLeft--;
 
         mLifetimePast++;
 
-        if (mPos.z < 0.0F)
-        {
-            if (mBounce > 0.0F)
-            {
-                mPos.z *= -mBounce;
-                mVelocity *= mBounce;
-                mVelocity.z = -mVelocity.z;
-            }
-            else
-            {
-                mAlive = DEAD_FLOOR;
-            }
-        }
-        else if (mPos.z > PARTICLE_SKY)
-        {
-            mAlive = DEAD_SKY;
-        }
-
         // Update child emitters
         if (Particle::emitterSkip && (mLifetimePast - 1)
             % Particle::emitterSkip == 0)
         {
             FOR_EACH (EmitterConstIterator, e, mChildEmitters)
             {
-                Particles newParticles = (*e)->createParticles(mLifetimePast);
-                FOR_EACH (ParticleConstIterator, it, newParticles)
-                {
-                    Particle *const p = *it;
-                    p->moveBy(mPos);
-                    mChildParticles.push_back(p);
-                }
+                const size_t oldSize = mChildParticles.size();
+                (*e)->createParticles(mLifetimePast, mChildParticles);
+                const size_t sz = mChildParticles.size();
+                for (size_t f = oldSize; f < sz; f ++)
+                    mChildParticles[f]->moveBy(mPos);
             }
         }
     }
@@ -230,27 +183,29 @@ bool Particle::update()
         mAlive = DEAD_LONG_AGO;
     }
 
+    // particle will not move anymore
+    if (mAlive != ALIVE || mLifetimeLeft == 0)
+        leaveBatch();
+
     const Vector change = mPos - oldPos;
 
-    // Update child particles
+    updateChildrenPhysics(change);
 
-    for (ParticleIterator p = mChildParticles.begin(),
-         p2 = mChildParticles.end(); p != p2; )
+    // Update child particles
+    // new particles can be added while updating, so use index
+    for (size_t f = 0; f < mChildParticles.size(); )
     {
-        Particle *const particle = *p;
-        // move particle with its parent if desired
-        if (particle->mFollow)
-            particle->moveBy(change);
-
-        // update particle
+        Particle *const particle = mChildParticles[f];
         if (particle->update())
         {
-            ++p;
+            f ++;
         }
         else
         {
             delete particle;
-            p = mChildParticles.erase(p);
+            // swap with last, it will be updated on this index
+            mChildParticles[f] = mChildParticles.back();
+            mChildParticles.pop_back();
         }
     }
     if (mAlive != ALIVE && mChildParticles.empty() && mAutoDelete)
@@ -259,9 +214,183 @@ bool Particle::update()
     return true;
 }
 
+void Particle::joinBatch(ParticleBatch *const batch)
+{
+    mParentBatch = batch;
+    const size_t index = batch->add(this);
+    mBatchIndex = index;
+    batch->posX[index] = mPos.x;
+    batch->posY[index] = mPos.y;
+    batch->posZ[index] = mPos.z;
+    batch->velX[index] = mVelocity.x;
+    batch->velY[index] = mVelocity.y;
+    batch->velZ[index] = mVelocity.z;
+    batch->acceleration[index] = mTarget ? mAcceleration : 0.0F;
+    batch->momentum[index] = mMomentum;
+    batch->gravity[index] = mGravity;
+    batch->invDieDistance[index] = mInvDieDistance;
+    batch->bounce[index] = mBounce;
+    batch->randomness[index] = mRandomness > 0
+        ? static_cast<uint32_t>(mRandomness) : 0U;
+    batch->randomState[index] = mRandomState;
+}
+
+void Particle::leaveBatch()
+{
+    ParticleBatch *const batch = mParentBatch;
+    if (!batch)
+        return;
+
+    const size_t index = mBatchIndex;
+    mVelocity.x = batch->velX[index];
+    mVelocity.y = batch->velY[index];
+    mVelocity.z = batch->velZ[index];
+    mRandomState = batch->randomState[index];
+    batch->remove(index);
+    if (index < batch->size())
+        batch->particles[index]->mBatchIndex = index;
+    mParentBatch = nullptr;
+    mBatchIndex = 0;
+}
+
+void Particle::updateChildrenPhysics(const Vector &change)
+{
+    const size_t sz = mChildParticles.size();
+    if (!sz)
+        return;
+
+    for (size_t f = 0; f < sz; f ++)
+    {
+        Particle *const particle = mChildParticles[f];
+        // move particle with its parent if desired
+        if (particle->mFollow)
+            particle->moveBy(change);
+        if (!particle->mParentBatch && particle->mMap
+            && particle->mAlive == ALIVE && particle->mLifetimeLeft != 0)
+        {
+            if (!mChildrenBatch)
+                mChildrenBatch = new ParticleBatch;
+            particle->joinBatch(mChildrenBatch);
+        }
+    }
+    if (!mChildrenBatch)
+        return;
+
+    ParticleBatch &batch = *mChildrenBatch;
+    const size_t cnt = batch.size();
+    if (!cnt)
+        return;
+
+    // targets can move
+    for (size_t f = 0; f < cnt; f ++)
+    {
+        if (batch.acceleration[f] != 0.0F)
+        {
+            const Vector &target = batch.particles[f]->mTarget->mPos;
+            batch.targetX[f] = target.x;
+            batch.targetY[f] = target.y;
+            batch.targetZ[f] = target.z;
+        }
+    }
+
+    batch.integrate(Particle::fastPhysics);
+
+    // actor position used for drawing and sorting
+    for (size_t f = 0; f < cnt; f ++)
+    {
+        Particle *const particle = batch.particles[f];
+        particle->mOldPos = particle->mPos;
+        particle->mPos.x = batch.posX[f];
+        particle->mPos.y = batch.posY[f];
+        particle->mPos.z = batch.posZ[f];
+        particle->mNewAlive = static_cast<AliveStatus>(batch.status[f]);
+        particle->mPhysicsDone = true;
+    }
+}
+
+Vector Particle::getVelocity() const
+{
+    if (!mParentBatch)
+        return mVelocity;
+    const size_t index = mBatchIndex;
+    return Vector(mParentBatch->velX[index],
+        mParentBatch->velY[index],
+        mParentBatch->velZ[index]);
+}
+
+void Particle::setVelocity(const float x, const float y, const float z)
+{
+    mVelocity.x = x;
+    mVelocity.y = y;
+    mVelocity.z = z;
+    if (mParentBatch)
+    {
+        mParentBatch->velX[mBatchIndex] = x;
+        mParentBatch->velY[mBatchIndex] = y;
+        mParentBatch->velZ[mBatchIndex] = z;
+    }
+}
+
+void Particle::setGravity(const float gravity)
+{
+    mGravity = gravity;
+    if (mParentBatch)
+        mParentBatch->gravity[mBatchIndex] = gravity;
+}
+
+void Particle::setRandomness(const int r)
+{
+    mRandomness = r;
+    if (mParentBatch)
+    {
+        mParentBatch->randomness[mBatchIndex] = r > 0
+            ? static_cast<uint32_t>(r) : 0U;
+    }
+}
+
+void Particle::setRandomSeed(const uint32_t seed)
+{
+    mRandomState = seed ? seed : 1;
+    if (mParentBatch)
+        mParentBatch->randomState[mBatchIndex] = mRandomState;
+}
+
+void Particle::setBounce(const float bouncieness)
+{
+    mBounce = bouncieness;
+    if (mParentBatch)
+        mParentBatch->bounce[mBatchIndex] = bouncieness;
+}
+
+void Particle::setDestination(Particle *const target,
+                              const float accel, const float moment)
+{
+    mTarget = target;
+    mAcceleration = accel;
+    mMomentum = moment;
+    if (mParentBatch)
+    {
+        mParentBatch->acceleration[mBatchIndex] = target ? accel : 0.0F;
+        mParentBatch->momentum[mBatchIndex] = moment;
+    }
+}
+
+void Particle::setDieDistance(const float dist)
+{
+    mInvDieDistance = 1.0F / dist;
+    if (mParentBatch)
+        mParentBatch->invDieDistance[mBatchIndex] = mInvDieDistance;
+}
+
 void Particle::moveBy(const Vector &change)
 {
     mPos += change;
+    if (mParentBatch)
+    {
+        mParentBatch->posX[mBatchIndex] = mPos.x;
+        mParentBatch->posY[mBatchIndex] = mPos.y;
+        mParentBatch->posZ[mBatchIndex] = mPos.z;
+    }
     FOR_EACH (ParticleConstIterator, p, mChildParticles)
     {
         Particle *const particle = *p;
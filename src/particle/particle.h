@@ -29,13 +29,17 @@
 
 #include <list>
 #include <string>
+#include <vector>
+
+#include <stdint.h>
 
 class Color;
 class Font;
 class Particle;
+class ParticleBatch;
 class ParticleEmitter;
 
-typedef std::list<Particle *> Particles;
+typedef std::vector<Particle *> Particles;
 typedef Particles::iterator ParticleIterator;
 typedef Particles::const_iterator ParticleConstIterator;
 typedef std::list<ParticleEmitter *> Emitters;
@@ -76,6 +80,16 @@ class Particle notfinal : public Actor
          */
         virtual ~Particle();
 
+#ifndef ENABLE_MEM_DEBUG
+        /**
+         * Particles and derived classes allocated from ParticlePool.
+         * Memory debug build keeps global new for leaks tracking.
+         */
+        static void *operator new(size_t size);
+
+        static void operator delete(void *ptr, size_t size);
+#endif
+
         /**
          * Deletes all child particles and emitters.
          */
@@ -189,27 +203,28 @@ class Particle notfinal : public Actor
         /**
          * Sets the current velocity in 3 dimensional space.
          */
-        void setVelocity(const float x, const float y, const float z)
-        { mVelocity.x = x; mVelocity.y = y; mVelocity.z = z; }
+        void setVelocity(const float x, const float y, const float z);
 
         /**
          * Sets the downward acceleration.
          */
-        void setGravity(const float gravity)
-        { mGravity = gravity; }
+        void setGravity(const float gravity);
 
         /**
          * Sets the ammount of random vector changes
          */
-        void setRandomness(const int r)
-        { mRandomness = r; }
+        void setRandomness(const int r);
+
+        /**
+         * Sets the seed of random vector changes
+         */
+        void setRandomSeed(const uint32_t seed);
 
         /**
          * Sets the ammount of velocity particles retain after
          * hitting the ground.
          */
-        void setBounce(const float bouncieness)
-        { mBounce = bouncieness; }
+        void setBounce(const float bouncieness);
 
         /**
          * Sets the flag if the particle is supposed to be moved by its parent
@@ -228,16 +243,14 @@ class Particle notfinal : public Actor
          * given acceleration and momentum
          */
         void setDestination(Particle *const target,
-                            const float accel, const float moment)
-        { mTarget = target; mAcceleration = accel; mMomentum = moment; }
+                            const float accel, const float moment);
 
         /**
          * Sets the distance in pixel the particle can come near the target
          * particle before it is destroyed. Does only make sense after a target
          * particle has been set using setDestination.
          */
-        void setDieDistance(const float dist)
-        { mInvDieDistance = 1.0F / dist; }
+        void setDieDistance(const float dist);
 
         /**
          * Changes the size of the emitters so that the effect fills a
@@ -285,6 +298,11 @@ class Particle notfinal : public Actor
         { mDeathEffect = effectFile; mDeathEffectConditions = conditions; }
 
     protected:
+        /**
+         * Gets the current velocity.
+         */
+        Vector getVelocity() const A_WARN_UNUSED;
+
         // Opacity of the graphical representation of the particle
         float mAlpha;
 
@@ -300,16 +318,33 @@ class Particle notfinal : public Actor
         // Age in game ticks where fading in is finished
         int mFadeIn;
 
-        // Speed in pixels per game-tick.
+        // Speed in pixels per game-tick. Actual value is in parent batch
+        // while particle moved by it.
         Vector mVelocity;
 
         // Is the particle supposed to be drawn and updated?
         AliveStatus mAlive;
     private:
+        /**
+         * Adds particle movement state to parent batch.
+         */
+        void joinBatch(ParticleBatch *const batch);
+
+        /**
+         * Removes particle from parent batch, when it not moving anymore.
+         */
+        void leaveBatch();
+
+        /**
+         * Moves following children and integrates movement of alive
+         * children in one batch.
+         */
+        void updateChildrenPhysics(const Vector &change);
+
         // List of child emitters.
         Emitters mChildEmitters;
 
-        // List of particles controlled by this particle
+        // Particles controlled by this particle. Order is not kept.
         Particles mChildParticles;
 
         // Particle effect file to be spawned when the particle dies
@@ -338,6 +373,24 @@ class Particle notfinal : public Actor
         // Ammount of random vector change
         int mRandomness;
 
+        // State of random generator for vector changes
+        uint32_t mRandomState;
+
+        // Movement state of children
+        ParticleBatch *mChildrenBatch;
+
+        // Batch of parent particle what moves this particle
+        ParticleBatch *mParentBatch;
+
+        // Index in parent batch
+        size_t mBatchIndex;
+
+        // Position before movement update
+        Vector mOldPos;
+
+        // Alive status after movement update
+        AliveStatus mNewAlive;
+
         // Bitfield of death conditions which trigger spawning
         // of the death particle
         signed char mDeathEffectConditions;
@@ -350,6 +403,9 @@ class Particle notfinal : public Actor
 
         // is this particle moved when its parent particle moves?
         bool mFollow;
+
+        // was movement for current tick already updated by parent?
+        bool mPhysicsDone;
 };
 
 extern Particle *particleEngine;
@@ -0,0 +1,392 @@
+/*
+ *  The ManaPlus Client
+ *  Copyright (C) 2011-2014  The ManaPlus Developers
+ *
+ *  This file is part of The ManaPlus Client.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "particle/particlebatch.h"
+
+#include "particle/particle.h"
+
+#include "utils/mathutils.h"
+
+#include <cfloat>
+#include <cmath>
+
+#ifdef SIMD_SUPPORTED
+#include <emmintrin.h>
+#endif  // SIMD_SUPPORTED
+
+#include "debug.h"
+
+static const float SIN45 = 0.707106781F;
+
+ParticleBatch::ParticleBatch() :
+    particles(),
+    posX(),
+    posY(),
+    posZ(),
+    velX(),
+    velY(),
+    velZ(),
+    targetX(),
+    targetY(),
+    targetZ(),
+    acceleration(),
+    momentum(),
+    gravity(),
+    invDieDistance(),
+    bounce(),
+    randomness(),
+    randomState(),
+    randomX(),
+    randomY(),
+    randomZ(),
+    status()
+{
+}
+
+size_t ParticleBatch::add(Particle *const particle)
+{
+    const size_t index = particles.size();
+    particles.push_back(particle);
+    posX.push_back(0.0F);
+    posY.push_back(0.0F);
+    posZ.push_back(0.0F);
+    velX.push_back(0.0F);
+    velY.push_back(0.0F);
+    velZ.push_back(0.0F);
+    targetX.push_back(0.0F);
+    targetY.push_back(0.0F);
+    targetZ.push_back(0.0F);
+    acceleration.push_back(0.0F);
+    momentum.push_back(1.0F);
+    gravity.push_back(0.0F);
+    invDieDistance.push_back(-1.0F);
+    bounce.push_back(0.0F);
+    randomness.push_back(0);
+    randomState.push_back(1);
+    randomX.push_back(0.0F);
+    randomY.push_back(0.0F);
+    randomZ.push_back(0.0F);
+    status.push_back(Particle::ALIVE);
+    return index;
+}
+
+template<typename T>
+static inline void removeItem(std::vector<T> &vect, const size_t index)
+{
+    vect[index] = vect.back();
+    vect.pop_back();
+}
+
+void ParticleBatch::remove(const size_t index)
+{
+    removeItem(particles, index);
+    removeItem(posX, index);
+    removeItem(posY, index);
+    removeItem(posZ, index);
+    removeItem(velX, index);
+    removeItem(velY, index);
+    removeItem(velZ, index);
+    removeItem(targetX, index);
+    removeItem(targetY, index);
+    removeItem(targetZ, index);
+    removeItem(acceleration, index);
+    removeItem(momentum, index);
+    removeItem(gravity, index);
+    removeItem(invDieDistance, index);
+    removeItem(bounce, index);
+    removeItem(randomness, index);
+    removeItem(randomState, index);
+    removeItem(randomX, index);
+    removeItem(randomY, index);
+    removeItem(randomZ, index);
+    removeItem(status, index);
+}
+
+void ParticleBatch::clear()
+{
+    particles.clear();
+    posX.clear();
+    posY.clear();
+    posZ.clear();
+    velX.clear();
+    velY.clear();
+    velZ.clear();
+    targetX.clear();
+    targetY.clear();
+    targetZ.clear();
+    acceleration.clear();
+    momentum.clear();
+    gravity.clear();
+    invDieDistance.clear();
+    bounce.clear();
+    randomness.clear();
+    randomState.clear();
+    randomX.clear();
+    randomY.clear();
+    randomZ.clear();
+    status.clear();
+}
+
+static inline float randomChange(uint32_t &state, const uint32_t r)
+{
+    const int r1 = static_cast<int>(particleRandom(state) % r);
+    const int r2 = static_cast<int>(particleRandom(state) % r);
+    return static_cast<float>(r1 - r2) / 1000.0F;
+}
+
+void ParticleBatch::updateRandom()
+{
+    const size_t sz = particles.size();
+    for (size_t f = 0; f < sz; f ++)
+    {
+        const uint32_t r = randomness[f];
+        if (!r)
+            continue;
+        uint32_t &state = randomState[f];
+        randomX[f] = randomChange(state, r);
+        randomY[f] = randomChange(state, r);
+        randomZ[f] = randomChange(state, r);
+    }
+}
+
+void ParticleBatch::integrate(const int fastPhysics)
+{
+    const size_t size = particles.size();
+    updateRandom();
+    size_t done = 0;
+#ifdef SIMD_SUPPORTED
+    if (Cpu::getFlags() & Cpu::FEATURE_SSE2)
+        done = integrateSse2(size, fastPhysics);
+#endif  // SIMD_SUPPORTED
+    integrateScalar(done, size, fastPhysics);
+}
+
+void ParticleBatch::integrateScalar(const size_t start, const size_t end,
+                                    const int fastPhysics)
+{
+    for (size_t f = start; f < end; f ++)
+    {
+        int alive = Particle::ALIVE;
+        float vx = velX[f] * momentum[f];
+        float vy = velY[f] * momentum[f];
+        float vz = velZ[f] * momentum[f];
+
+        const float acc = acceleration[f];
+        if (acc != 0.0F)
+        {
+            const float dx = (posX[f] - targetX[f]) * SIN45;
+            const float dy = posY[f] - targetY[f];
+            const float dz = posZ[f] - targetZ[f];
+            const float dist2 = dx * dx + dy * dy + dz * dz;
+            float invHypotenuse;
+
+            switch (fastPhysics)
+            {
+                case 1:
+                    invHypotenuse = fastInvSqrt(dist2);
+                    break;
+                case 2:
+                    if (!dx)
+                    {
+                        invHypotenuse = 0;
+                        break;
+                    }
+
+                    invHypotenuse = 2.0F / (static_cast<float>(fabs(dx))
+                                    + static_cast<float>(fabs(dy))
+                                    + static_cast<float>(fabs(dz)));
+                    break;
+                default:
+                    invHypotenuse = dist2 > 0.0F ? 1.0F / static_cast<float>(
+                        sqrt(dist2)) : FLT_MAX;
+                    break;
+            }
+
+            if (invHypotenuse)
+            {
+                const float invDie = invDieDistance[f];
+                if (invDie > 0.0F && invHypotenuse > invDie)
+                    alive = Particle::DEAD_IMPACT;
+                const float accFactor = invHypotenuse * acc;
+                vx -= dx * accFactor;
+                vy -= dy * accFactor;
+                vz -= dz * accFactor;
+            }
+        }
+
+        vx += randomX[f];
+        vy += randomY[f];
+        vz += randomZ[f] - gravity[f];
+
+        const float x = posX[f] + vx;
+        const float y = posY[f] + vy * SIN45;
+        float z = posZ[f] + vz * SIN45;
+
+        if (z < 0.0F)
+        {
+            const float b = bounce[f];
+            if (b > 0.0F)
+            {
+                z *= -b;
+                vx *= b;
+                vy *= b;
+                vz = -vz * b;
+            }
+            else
+            {
+                alive = Particle::DEAD_FLOOR;
+            }
+        }
+        else if (z > Particle::PARTICLE_SKY)
+        {
+            alive = Particle::DEAD_SKY;
+        }
+
+        posX[f] = x;
+        posY[f] = y;
+        posZ[f] = z;
+        velX[f] = vx;
+        velY[f] = vy;
+        velZ[f] = vz;
+        status[f] = alive;
+    }
+}
+
+#ifdef SIMD_SUPPORTED
+__attribute__ ((target ("sse2")))
+static inline __m128 selectPs(const __m128 mask, const __m128 a,
+                              const __m128 b)
+{
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+__attribute__ ((target ("sse2")))
+size_t ParticleBatch::integrateSse2(const size_t size,
+                                    const int fastPhysics)
+{
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0F);
+    const __m128 two = _mm_set1_ps(2.0F);
+    const __m128 sin45 = _mm_set1_ps(SIN45);
+    const __m128 sky = _mm_set1_ps(Particle::PARTICLE_SKY);
+    const __m128 fltMax = _mm_set1_ps(FLT_MAX);
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    const size_t end = size & ~static_cast<size_t>(3);
+
+    for (size_t f = 0; f < end; f += 4)
+    {
+        const __m128 mom = _mm_loadu_ps(&momentum[f]);
+        __m128 vx = _mm_mul_ps(_mm_loadu_ps(&velX[f]), mom);
+        __m128 vy = _mm_mul_ps(_mm_loadu_ps(&velY[f]), mom);
+        __m128 vz = _mm_mul_ps(_mm_loadu_ps(&velZ[f]), mom);
+        __m128 x = _mm_loadu_ps(&posX[f]);
+        __m128 y = _mm_loadu_ps(&posY[f]);
+        __m128 z = _mm_loadu_ps(&posZ[f]);
+
+        // attraction to target
+        const __m128 acc = _mm_loadu_ps(&acceleration[f]);
+        __m128 impact = zero;
+        const __m128 hasTarget = _mm_cmpneq_ps(acc, zero);
+        if (_mm_movemask_ps(hasTarget))
+        {
+            const __m128 dx = _mm_mul_ps(_mm_sub_ps(x,
+                _mm_loadu_ps(&targetX[f])), sin45);
+            const __m128 dy = _mm_sub_ps(y, _mm_loadu_ps(&targetY[f]));
+            const __m128 dz = _mm_sub_ps(z, _mm_loadu_ps(&targetZ[f]));
+            const __m128 dist2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx),
+                _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+            __m128 invHypotenuse;
+            switch (fastPhysics)
+            {
+                case 1:
+                    invHypotenuse = _mm_min_ps(_mm_rsqrt_ps(dist2), fltMax);
+                    break;
+                case 2:
+                    invHypotenuse = selectPs(_mm_cmpneq_ps(dx, zero),
+                        _mm_div_ps(two, _mm_add_ps(_mm_add_ps(
+                        _mm_and_ps(dx, absMask), _mm_and_ps(dy, absMask)),
+                        _mm_and_ps(dz, absMask))), zero);
+                    break;
+                default:
+                    invHypotenuse = _mm_min_ps(_mm_div_ps(one,
+                        _mm_sqrt_ps(dist2)), fltMax);
+                    break;
+            }
+            const __m128 active = _mm_and_ps(hasTarget,
+                _mm_cmpneq_ps(invHypotenuse, zero));
+            const __m128 invDie = _mm_loadu_ps(&invDieDistance[f]);
+            impact = _mm_and_ps(active, _mm_and_ps(
+                _mm_cmpgt_ps(invDie, zero),
+                _mm_cmpgt_ps(invHypotenuse, invDie)));
+            const __m128 accFactor = _mm_and_ps(active,
+                _mm_mul_ps(invHypotenuse, acc));
+            vx = _mm_sub_ps(vx, _mm_mul_ps(dx, accFactor));
+            vy = _mm_sub_ps(vy, _mm_mul_ps(dy, accFactor));
+            vz = _mm_sub_ps(vz, _mm_mul_ps(dz, accFactor));
+        }
+
+        vx = _mm_add_ps(vx, _mm_loadu_ps(&randomX[f]));
+        vy = _mm_add_ps(vy, _mm_loadu_ps(&randomY[f]));
+        vz = _mm_sub_ps(_mm_add_ps(vz, _mm_loadu_ps(&randomZ[f])),
+            _mm_loadu_ps(&gravity[f]));
+
+        x = _mm_add_ps(x, vx);
+        y = _mm_add_ps(y, _mm_mul_ps(vy, sin45));
+        z = _mm_add_ps(z, _mm_mul_ps(vz, sin45));
+
+        // bounce or die on floor, die in sky
+        const __m128 b = _mm_loadu_ps(&bounce[f]);
+        const __m128 below = _mm_cmplt_ps(z, zero);
+        const __m128 bouncing = _mm_and_ps(below, _mm_cmpgt_ps(b, zero));
+        const __m128 floorMask = _mm_andnot_ps(bouncing, below);
+        const __m128 inSky = _mm_andnot_ps(below, _mm_cmpgt_ps(z, sky));
+        const __m128 bounceFactor = selectPs(bouncing, b, one);
+        z = selectPs(bouncing, _mm_mul_ps(z, _mm_sub_ps(zero, b)), z);
+        vx = _mm_mul_ps(vx, bounceFactor);
+        vy = _mm_mul_ps(vy, bounceFactor);
+        vz = _mm_mul_ps(vz, bounceFactor);
+        vz = selectPs(bouncing, _mm_sub_ps(zero, vz), vz);
+
+        _mm_storeu_ps(&posX[f], x);
+        _mm_storeu_ps(&posY[f], y);
+        _mm_storeu_ps(&posZ[f], z);
+        _mm_storeu_ps(&velX[f], vx);
+        _mm_storeu_ps(&velY[f], vy);
+        _mm_storeu_ps(&velZ[f], vz);
+
+        const int impactBits = _mm_movemask_ps(impact);
+        const int floorBits = _mm_movemask_ps(floorMask);
+        const int skyBits = _mm_movemask_ps(inSky);
+        for (int k = 0; k < 4; k ++)
+        {
+            const int bit = 1 << k;
+            int alive = Particle::ALIVE;
+            if (floorBits & bit)
+                alive = Particle::DEAD_FLOOR;
+            else if (skyBits & bit)
+                alive = Particle::DEAD_SKY;
+            else if (impactBits & bit)
+                alive = Particle::DEAD_IMPACT;
+            status[f + k] = alive;
+        }
+    }
+    return end;
+}
+#endif  // SIMD_SUPPORTED
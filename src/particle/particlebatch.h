@@ -0,0 +1,116 @@
+/*
+ *  The ManaPlus Client
+ *  Copyright (C) 2011-2014  The ManaPlus Developers
+ *
+ *  This file is part of The ManaPlus Client.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PARTICLE_PARTICLEBATCH_H
+#define PARTICLE_PARTICLEBATCH_H
+
+#include "utils/cpu.h"
+
+#include <stdint.h>
+#include <cstddef>
+#include <vector>
+
+#include "localconsts.h"
+
+class Particle;
+
+/**
+ * Xorshift random generator. State must be not zero.
+ */
+inline uint32_t particleRandom(uint32_t &state)
+{
+    uint32_t x = state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    state = x;
+    return x;
+}
+
+/**
+ * Movement state of child particles in separate arrays, so it can be
+ * integrated by vectorized kernel. Owned by parent particle and updated
+ * in place, particles only keep index in it.
+ */
+class ParticleBatch final
+{
+    public:
+        ParticleBatch();
+
+        A_DELETE_COPY(ParticleBatch)
+
+        size_t size() const A_WARN_UNUSED
+        { return particles.size(); }
+
+        /**
+         * Adds particle with zero state and returns its index.
+         */
+        size_t add(Particle *const particle);
+
+        /**
+         * Removes particle at index. Last particle moved to this index.
+         */
+        void remove(const size_t index);
+
+        void clear();
+
+        /**
+         * Integrates movement of all particles for one game tick.
+         * Fills status with Particle::AliveStatus values.
+         * Target positions must be updated before this call.
+         */
+        void integrate(const int fastPhysics);
+
+        std::vector<Particle*> particles;
+        std::vector<float> posX;
+        std::vector<float> posY;
+        std::vector<float> posZ;
+        std::vector<float> velX;
+        std::vector<float> velY;
+        std::vector<float> velZ;
+        // target position, used if acceleration not zero
+        std::vector<float> targetX;
+        std::vector<float> targetY;
+        std::vector<float> targetZ;
+        std::vector<float> acceleration;
+        std::vector<float> momentum;
+        std::vector<float> gravity;
+        std::vector<float> invDieDistance;
+        std::vector<float> bounce;
+        std::vector<uint32_t> randomness;
+        std::vector<uint32_t> randomState;
+        // random velocity change for this tick
+        std::vector<float> randomX;
+        std::vector<float> randomY;
+        std::vector<float> randomZ;
+        std::vector<int> status;
+
+    private:
+        void updateRandom();
+
+        void integrateScalar(const size_t start, const size_t end,
+                             const int fastPhysics);
+
+#ifdef SIMD_SUPPORTED
+        size_t integrateSse2(const size_t size, const int fastPhysics);
+#endif  // SIMD_SUPPORTED
+};
+
+#endif  // PARTICLE_PARTICLEBATCH_H
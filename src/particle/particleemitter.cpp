@@ -27,6 +27,7 @@
 #include "resources/map/mapconsts.h"
 
 #include "particle/animationparticle.h"
+#include "particle/particlebatch.h"
 #include "particle/rotationalparticle.h"
 
 #include "resources/dye.h"
@@ -52,6 +53,7 @@ ParticleEmitter::ParticleEmitter(const XmlNodePtrConst emitterNode,
     mMap(map),
     mParticleImage(nullptr),
     mOutputPauseLeft(0),
+    mRandomState(static_cast<uint32_t>(rand()) | 1),
     mDeathEffectConditions(0),
     mParticleFollow(false)
 {
@@ -502,6 +504,7 @@ ParticleEmitter & ParticleEmitter::operator=(const ParticleEmitter &o)
     }
 
     mOutputPauseLeft = 0;
+    mRandomState = static_cast<uint32_t>(rand()) | 1;
 
     if (mParticleImage)
         mParticleImage->incRef();
@@ -555,14 +558,13 @@ ParticleEmitter::readParticleEmitterProp(XmlNodePtrConst propertyNode, T def)
     return retval;
 }
 
-std::list<Particle *> ParticleEmitter::createParticles(const int tick)
+void ParticleEmitter::createParticles(const int tick,
+                                      Particles &newParticles)
 {
-    std::list<Particle *> newParticles;
-
     if (mOutputPauseLeft > 0)
     {
         mOutputPauseLeft --;
-        return newParticles;
+        return;
     }
     mOutputPauseLeft = mOutputPause.value(tick);
 
@@ -623,6 +625,7 @@ std::list<Particle *> ParticleEmitter::createParticles(const int tick)
             sinAngleV * power);
 
         newParticle->setRandomness(mParticleRandomness.value(tick));
+        newParticle->setRandomSeed(particleRandom(mRandomState));
         newParticle->setGravity(mParticleGravity.value(tick));
         newParticle->setBounce(mParticleBounce.value(tick));
         newParticle->setFollow(mParticleFollow);
@@ -646,8 +649,6 @@ std::list<Particle *> ParticleEmitter::createParticles(const int tick)
 
         newParticles.push_back(newParticle);
     }
-
-    return newParticles;
 }
 
 void ParticleEmitter::adjustSize(const int w, const int h)
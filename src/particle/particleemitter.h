@@ -23,6 +23,7 @@
 #ifndef PARTICLE_PARTICLEEMITTER_H
 #define PARTICLE_PARTICLEEMITTER_H
 
+#include "particle/particle.h"
 #include "particle/particleemitterprop.h"
 
 #include "resources/animation.h"
@@ -34,7 +35,6 @@
 class Image;
 class ImageSet;
 class Map;
-class Particle;
 
 /**
  * Every Particle can have one or more particle emitters that create new
@@ -65,10 +65,9 @@ class ParticleEmitter final
         ~ParticleEmitter();
 
         /**
-         * Spawns new particles
-         * @return: a list of created particles
+         * Spawns new particles and adds them to particles
          */
-        std::list<Particle *> createParticles(const int tick);
+        void createParticles(const int tick, Particles &particles);
 
         /**
          * Sets the target of the particles that are created
@@ -162,6 +161,9 @@ class ParticleEmitter final
 
         int mOutputPauseLeft;
 
+        // Random generator state for seeding of spawned particles
+        uint32_t mRandomState;
+
         signed char mDeathEffectConditions;
 
         bool mParticleFollow;
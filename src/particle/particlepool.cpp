@@ -0,0 +1,123 @@
+/*
+ *  The ManaPlus Client
+ *  Copyright (C) 2011-2014  The ManaPlus Developers
+ *
+ *  This file is part of The ManaPlus Client.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "particle/particlepool.h"
+
+#include <new>
+#include <vector>
+
+#include "debug.h"
+
+namespace
+{
+    struct FreeNode final
+    {
+        FreeNode *next;
+    };
+
+    struct SizePool final
+    {
+        FreeNode *freeList;
+        std::vector<char*> chunks;
+    };
+
+    // object sizes rounded to this value
+    const size_t sizeStep = 16;
+    // bigger objects allocated by global new
+    const size_t maxPoolSize = 1024;
+    const size_t poolsCount = maxPoolSize / sizeStep;
+    const size_t objectsInChunk = 256;
+
+    SizePool pools[poolsCount];
+}  // namespace
+
+int ParticlePool::mAllocated = 0;
+
+void *ParticlePool::allocate(const size_t size)
+{
+    if (!size || size > maxPoolSize)
+        return ::operator new(size);
+
+    SizePool &pool = pools[(size - 1) / sizeStep];
+    if (!pool.freeList)
+    {
+        const size_t objSize = ((size - 1) / sizeStep + 1) * sizeStep;
+        char *const chunk = new char[objSize * objectsInChunk];
+        pool.chunks.push_back(chunk);
+        // link in address order
+        FreeNode *next = nullptr;
+        for (size_t f = objectsInChunk; f > 0; f --)
+        {
+            FreeNode *const node = reinterpret_cast<FreeNode*>(
+                chunk + (f - 1) * objSize);
+            node->next = next;
+            next = node;
+        }
+        pool.freeList = next;
+    }
+
+    FreeNode *const node = pool.freeList;
+    pool.freeList = node->next;
+    mAllocated ++;
+    return node;
+}
+
+void ParticlePool::release(void *const ptr, const size_t size)
+{
+    if (!ptr)
+        return;
+    if (!size || size > maxPoolSize)
+    {
+        ::operator delete(ptr);
+        return;
+    }
+
+    SizePool &pool = pools[(size - 1) / sizeStep];
+    FreeNode *const node = static_cast<FreeNode*>(ptr);
+    node->next = pool.freeList;
+    pool.freeList = node;
+    mAllocated --;
+}
+
+void ParticlePool::clear()
+{
+    if (mAllocated)
+        return;
+
+    for (size_t f = 0; f < poolsCount; f ++)
+    {
+        SizePool &pool = pools[f];
+        FOR_EACH (std::vector<char*>::iterator, it, pool.chunks)
+            delete [] *it;
+        pool.chunks.clear();
+        pool.freeList = nullptr;
+    }
+}
+
+size_t ParticlePool::getMemoryUsage()
+{
+    size_t sz = 0;
+    for (size_t f = 0; f < poolsCount; f ++)
+    {
+        sz += pools[f].chunks.size() * objectsInChunk
+            * (f + 1) * sizeStep;
+    }
+    return sz;
+}
@@ -0,0 +1,55 @@
+/*
+ *  The ManaPlus Client
+ *  Copyright (C) 2011-2014  The ManaPlus Developers
+ *
+ *  This file is part of The ManaPlus Client.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PARTICLE_PARTICLEPOOL_H
+#define PARTICLE_PARTICLEPOOL_H
+
+#include <cstddef>
+
+#include "localconsts.h"
+
+/**
+ * Allocator for particle objects.
+ * Keeps free list per object size, so each particle class gets own list,
+ * and allocates objects in big chunks. Memory returns to system only in
+ * clear().
+ */
+class ParticlePool final
+{
+    public:
+        static void *allocate(const size_t size);
+
+        static void release(void *const ptr, const size_t size);
+
+        /**
+         * Frees all chunks if no objects allocated.
+         */
+        static void clear();
+
+        static int getAllocatedCount() A_WARN_UNUSED
+        { return mAllocated; }
+
+        static size_t getMemoryUsage() A_WARN_UNUSED;
+
+    private:
+        static int mAllocated;
+};
+
+#endif  // PARTICLE_PARTICLEPOOL_H
@@ -63,7 +63,8 @@ bool RotationalParticle::update()
     if (!size)
         return false;
 
-    float rad = static_cast<float>(atan2(mVelocity.x, mVelocity.y));
+    const Vector velocity = getVelocity();
+    float rad = static_cast<float>(atan2(velocity.x, velocity.y));
     if (rad < 0)
         rad = PI2 + rad;
 
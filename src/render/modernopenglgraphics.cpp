@@ -381,9 +381,10 @@ void ModernOpenGLGraphics::testDraw()
 //    glDrawElements(GL_TRIANGLE_STRIP, 4, GL_UNSIGNED_INT, 0);
 }
 
-void ModernOpenGLGraphics::drawImageCached(const Image *const image A_UNUSED,
-                                           int A_UNUSED x, int y A_UNUSED)
+void ModernOpenGLGraphics::drawImageCached(const Image *const image,
+                                           int x, int y)
 {
+    drawImageInline(image, x, y);
 }
 
 void ModernOpenGLGraphics::drawPatternCached(const Image *const image A_UNUSED,
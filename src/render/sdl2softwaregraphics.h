@@ -75,8 +75,6 @@ class SDL2SoftwareGraphics final : public Graphics
 
         uint32_t mRendererFlags;
         SDL_Surface *mSurface;
-        uint32_t mOldPixel;
-        unsigned int mOldAlpha;
 };
 
 #endif  // USE_SDL2
@@ -29,6 +29,8 @@
 #include "graphicsmanager.h"
 #include "graphicsvertexes.h"
 
+#include "render/softwareblend.h"
+
 #include "utils/sdlcheckutils.h"
 
 #include "utils/sdlpixel.h"
@@ -38,16 +40,8 @@
 
 #include "debug.h"
 
-#if SDL_BYTEORDER == SDL_LIL_ENDIAN
-static unsigned int *cR = nullptr;
-static unsigned int *cG = nullptr;
-static unsigned int *cB = nullptr;
-#endif
-
 SDLGraphics::SDLGraphics() :
-    Graphics(),
-    mOldPixel(0),
-    mOldAlpha(0)
+    Graphics()
 {
     mOpenGL = RENDER_SOFTWARE;
     mName = "Software";
@@ -185,7 +179,7 @@ void SDLGraphics::drawImageInline(const Image *const image,
             static_cast<uint16_t>(h)
         };
 
-        SDL_LowerBlit(src, &srcRect, mWindow, &dstRect);
+        SoftwareBlend::lowerBlit(src, &srcRect, mWindow, &dstRect);
     }
 }
 
@@ -278,7 +272,7 @@ void SDLGraphics::drawImageCached(const Image *const image,
             static_cast<uint16_t>(h)
         };
 
-        SDL_LowerBlit(src, &srcRect, mWindow, &dstRect);
+        SoftwareBlend::lowerBlit(src, &srcRect, mWindow, &dstRect);
     }
 }
 
@@ -383,7 +377,7 @@ void SDLGraphics::drawPatternCached(const Image *const image,
                         static_cast<uint16_t>(h2)
                     };
 
-                    SDL_LowerBlit(src, &srcRect, mWindow, &dstRect);
+                    SoftwareBlend::lowerBlit(src, &srcRect, mWindow, &dstRect);
                 }
 
 //            SDL_BlitSurface(image->mSDLSurface, &srcRect, mWindow, &dstRect);
@@ -504,7 +498,7 @@ void SDLGraphics::drawPatternInline(const Image *const image,
                         static_cast<uint16_t>(h2)
                     };
 
-                    SDL_LowerBlit(src, &srcRect, mWindow, &dstRect);
+                    SoftwareBlend::lowerBlit(src, &srcRect, mWindow, &dstRect);
                 }
 
 //            SDL_BlitSurface(image->mSDLSurface, &srcRect, mWindow, &dstRect);
@@ -740,7 +734,7 @@ void SDLGraphics::drawTileCollection(const ImageCollection
         const DoubleRects::const_iterator it2_end = rects->end();
         while (it2 != it2_end)
         {
-            SDL_LowerBlit(img->mSDLSurface, &(*it2)->src,
+            SoftwareBlend::lowerBlit(img->mSDLSurface, &(*it2)->src,
                 mWindow, &(*it2)->dst);
             ++ it2;
         }
@@ -756,7 +750,8 @@ void SDLGraphics::drawTileVertexes(const ImageVertexes *const vert)
     const DoubleRects::const_iterator it_end = rects->end();
     while (it != it_end)
     {
-        SDL_LowerBlit(img->mSDLSurface, &(*it)->src, mWindow, &(*it)->dst);
+        SoftwareBlend::lowerBlit(img->mSDLSurface, &(*it)->src,
+            mWindow, &(*it)->dst);
         ++ it;
     }
 }
@@ -988,93 +983,9 @@ void SDLGraphics::fillRectangle(const Rect& rectangle)
                 break;
             }
             case 4:
-            {
-#if SDL_BYTEORDER == SDL_BIG_ENDIAN
-                const unsigned pb = (pixel & 0xff) * mColor.a;
-                const unsigned pg = (pixel & 0xff00) * mColor.a;
-                const unsigned pr = (pixel & 0xff0000) * mColor.a;
-                const unsigned a1 = (255 - mColor.a);
-
-                for (y = y1; y < y2; y++)
-                {
-                    uint8_t *const p0 = static_cast<uint8_t *>(mWindow->pixels)
-                        + y * mWindow->pitch;
-                    for (x = x1; x < x2; x++)
-                    {
-                        uint8_t *p = p0 + x * 4;
-                        uint32_t dst = *reinterpret_cast<uint32_t *>(p);
-                        const unsigned int b = (pb + (dst & 0xff) * a1) >> 8;
-                        const unsigned int g = (pg + (dst & 0xff00) * a1) >> 8;
-                        const unsigned int r = (pr
-                            + (dst & 0xff0000) * a1) >> 8;
-
-                        *reinterpret_cast<uint32_t *>(p) = ((b & 0xff)
-                            | (g & 0xff00) | (r & 0xff0000));
-                    }
-                }
-#else
-                if (!cR)
-                {
-                    cR = new unsigned int[0x100];
-                    cG = new unsigned int[0x100];
-                    cB = new unsigned int[0x100];
-                    mOldPixel = 0;
-                    mOldAlpha = mColor.a;
-                }
-
-                const SDL_PixelFormat * const format = mWindow->format;
-                const unsigned rMask = format->Rmask;
-                const unsigned gMask = format->Gmask;
-                const unsigned bMask = format->Bmask;
-//                const unsigned aMask = format->Amask;
-                unsigned rShift = rMask / 0xff;
-                unsigned gShift = gMask / 0xff;
-                unsigned bShift = bMask / 0xff;
-                if (!rShift)
-                    rShift = 1;
-                if (!gShift)
-                    gShift = 1;
-                if (!bShift)
-                    bShift = 1;
-                if (pixel != mOldPixel || mColor.a != mOldAlpha)
-                {
-                    const unsigned pb = (pixel & bMask) * mColor.a;
-                    const unsigned pg = (pixel & gMask) * mColor.a;
-                    const unsigned pr = (pixel & rMask) * mColor.a;
-                    const unsigned a0 = (255 - mColor.a);
-
-                    const unsigned int a1 = a0 * bShift;
-                    const unsigned int a2 = a0 * gShift;
-                    const unsigned int a3 = a0 * rShift;
-
-                    for (int f = 0; f <= 0xff; f ++)
-                    {
-                        cB[f] = ((pb + f * a1) >> 8) & bMask;
-                        cG[f] = ((pg + f * a2) >> 8) & gMask;
-                        cR[f] = ((pr + f * a3) >> 8) & rMask;
-                    }
-
-                    mOldPixel = pixel;
-                    mOldAlpha = mColor.a;
-                }
-
-                for (y = y1; y < y2; y++)
-                {
-                    uint32_t *const p0 = reinterpret_cast<uint32_t*>(
-                        static_cast<uint8_t*>(mWindow->pixels)
-                        + static_cast<size_t>(y * mWindow->pitch));
-                    for (x = x1; x < x2; x++)
-                    {
-                        uint32_t *const p = p0 + static_cast<size_t>(x);
-                        const uint32_t dst = *p;
-                        *p = cB[dst & bMask / bShift]
-                            | cG[(dst & gMask) / gShift]
-                            | cR[(dst & rMask) / rShift];
-                    }
-                }
-#endif
+                SoftwareBlend::fillRectangle(mWindow, x1, y1, x2, y2,
+                    pixel, mColor.a);
                 break;
-            }
             default:
                 break;
         }
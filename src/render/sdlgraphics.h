@@ -67,9 +67,6 @@ class SDLGraphics final : public Graphics
         void drawHLine(int x1, int y, int x2);
 
         void drawVLine(int x, int y1, int y2);
-
-        uint32_t mOldPixel;
-        unsigned int mOldAlpha;
 };
 
 #endif  // USE_SDL2
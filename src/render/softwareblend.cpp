@@ -0,0 +1,528 @@
+/*
+ *  The ManaPlus Client
+ *  Copyright (C) 2011-2014  The ManaPlus Developers
+ *
+ *  This file is part of The ManaPlus Client.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "render/softwareblend.h"
+
+#include "utils/cpu.h"
+
+#ifdef SIMD_SUPPORTED
+#include <immintrin.h>
+#endif
+
+#include "debug.h"
+
+typedef void (*BlendColorFunc)(uint32_t *restrict dst,
+                               const int width,
+                               const uint32_t pixel,
+                               const uint32_t mask,
+                               const unsigned int alpha);
+
+typedef void (*BlendImageFunc)(uint32_t *restrict dst,
+                               const uint32_t *restrict src,
+                               const int width,
+                               const uint32_t mask,
+                               const unsigned int alphaShift,
+                               const unsigned int alpha);
+
+// (src * a + dst * (255 - a)) / 255 for each byte, two bytes per multiply
+static inline uint32_t blendPixel(const uint32_t src,
+                                  const uint32_t dst,
+                                  const unsigned int alpha,
+                                  const uint32_t mask)
+{
+    const unsigned int ia = 255U - alpha;
+    uint32_t rb = (src & 0x00ff00ffU) * alpha
+        + (dst & 0x00ff00ffU) * ia + 0x00800080U;
+    rb = ((rb + ((rb >> 8) & 0x00ff00ffU)) >> 8) & 0x00ff00ffU;
+    uint32_t ag = ((src >> 8) & 0x00ff00ffU) * alpha
+        + ((dst >> 8) & 0x00ff00ffU) * ia + 0x00800080U;
+    ag = (ag + ((ag >> 8) & 0x00ff00ffU)) & 0xff00ff00U;
+    return ((rb | ag) & mask) | (dst & ~mask);
+}
+
+static inline unsigned int pixelAlpha(const uint32_t src,
+                                      const unsigned int alphaShift,
+                                      const unsigned int alpha)
+{
+    const unsigned int a = (src >> alphaShift) & 0xffU;
+    if (alpha == 255)
+        return a;
+    const unsigned int t = a * alpha + 128U;
+    return (t + (t >> 8)) >> 8;
+}
+
+void SoftwareBlend::blendColorRow(uint32_t *restrict dst,
+                                  const int width,
+                                  const uint32_t pixel,
+                                  const uint32_t mask,
+                                  const unsigned int alpha)
+{
+    for (int x = 0; x < width; x ++)
+        dst[x] = blendPixel(pixel, dst[x], alpha, mask);
+}
+
+void SoftwareBlend::blendConstRow(uint32_t *restrict dst,
+                                  const uint32_t *restrict src,
+                                  const int width,
+                                  const uint32_t mask,
+                                  const unsigned int alphaShift A_UNUSED,
+                                  const unsigned int alpha)
+{
+    for (int x = 0; x < width; x ++)
+        dst[x] = blendPixel(src[x], dst[x], alpha, mask);
+}
+
+void SoftwareBlend::blendAlphaRow(uint32_t *restrict dst,
+                                  const uint32_t *restrict src,
+                                  const int width,
+                                  const uint32_t mask,
+                                  const unsigned int alphaShift,
+                                  const unsigned int alpha)
+{
+    for (int x = 0; x < width; x ++)
+    {
+        const uint32_t p = src[x];
+        const unsigned int a = pixelAlpha(p, alphaShift, alpha);
+        if (a)
+            dst[x] = blendPixel(p, dst[x], a, mask);
+    }
+}
+
+#ifdef SIMD_SUPPORTED
+// blends 16 bit channels, same rounding as blendPixel
+__attribute__ ((target ("sse2")))
+static inline __m128i blendSse2(const __m128i src,
+                                const __m128i dst,
+                                const __m128i alpha,
+                                const __m128i ia)
+{
+    const __m128i t = _mm_add_epi16(_mm_add_epi16(
+        _mm_mullo_epi16(src, alpha), _mm_mullo_epi16(dst, ia)),
+        _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+}
+
+__attribute__ ((target ("sse2")))
+static inline __m128i mergeSse2(const __m128i res,
+                                const __m128i dst,
+                                const __m128i mask)
+{
+    return _mm_or_si128(_mm_and_si128(res, mask),
+        _mm_andnot_si128(mask, dst));
+}
+
+__attribute__ ((target ("sse2")))
+void SoftwareBlend::blendColorRowSse2(uint32_t *restrict dst,
+                                      const int width,
+                                      const uint32_t pixel,
+                                      const uint32_t mask,
+                                      const unsigned int alpha)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i maskV = _mm_set1_epi32(static_cast<int>(mask));
+    const __m128i src = _mm_unpacklo_epi8(
+        _mm_set1_epi32(static_cast<int>(pixel)), zero);
+    const __m128i alphaV = _mm_set1_epi16(static_cast<int16_t>(alpha));
+    const __m128i ia = _mm_set1_epi16(static_cast<int16_t>(255 - alpha));
+    int x = 0;
+    for (; x + 4 <= width; x += 4)
+    {
+        __m128i *const ptr = reinterpret_cast<__m128i*>(dst + x);
+        const __m128i d = _mm_loadu_si128(ptr);
+        const __m128i lo = blendSse2(src, _mm_unpacklo_epi8(d, zero),
+            alphaV, ia);
+        const __m128i hi = blendSse2(src, _mm_unpackhi_epi8(d, zero),
+            alphaV, ia);
+        _mm_storeu_si128(ptr, mergeSse2(_mm_packus_epi16(lo, hi),
+            d, maskV));
+    }
+    blendColorRow(dst + x, width - x, pixel, mask, alpha);
+}
+
+__attribute__ ((target ("sse2")))
+void SoftwareBlend::blendConstRowSse2(uint32_t *restrict dst,
+                                      const uint32_t *restrict src,
+                                      const int width,
+                                      const uint32_t mask,
+                                      const unsigned int alphaShift,
+                                      const unsigned int alpha)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i maskV = _mm_set1_epi32(static_cast<int>(mask));
+    const __m128i alphaV = _mm_set1_epi16(static_cast<int16_t>(alpha));
+    const __m128i ia = _mm_set1_epi16(static_cast<int16_t>(255 - alpha));
+    int x = 0;
+    for (; x + 4 <= width; x += 4)
+    {
+        __m128i *const ptr = reinterpret_cast<__m128i*>(dst + x);
+        const __m128i s = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(src + x));
+        const __m128i d = _mm_loadu_si128(ptr);
+        const __m128i lo = blendSse2(_mm_unpacklo_epi8(s, zero),
+            _mm_unpacklo_epi8(d, zero), alphaV, ia);
+        const __m128i hi = blendSse2(_mm_unpackhi_epi8(s, zero),
+            _mm_unpackhi_epi8(d, zero), alphaV, ia);
+        _mm_storeu_si128(ptr, mergeSse2(_mm_packus_epi16(lo, hi),
+            d, maskV));
+    }
+    blendConstRow(dst + x, src + x, width - x, mask, alphaShift, alpha);
+}
+
+__attribute__ ((target ("sse2")))
+void SoftwareBlend::blendAlphaRowSse2(uint32_t *restrict dst,
+                                      const uint32_t *restrict src,
+                                      const int width,
+                                      const uint32_t mask,
+                                      const unsigned int alphaShift,
+                                      const unsigned int alpha)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i byteMask = _mm_set1_epi32(0xff);
+    const __m128i round = _mm_set1_epi32(128);
+    const __m128i full = _mm_set1_epi16(0xff);
+    const __m128i maskV = _mm_set1_epi32(static_cast<int>(mask));
+    const __m128i alphaV = _mm_set1_epi32(static_cast<int>(alpha));
+    const __m128i count = _mm_cvtsi32_si128(static_cast<int>(alphaShift));
+    int x = 0;
+    for (; x + 4 <= width; x += 4)
+    {
+        __m128i *const ptr = reinterpret_cast<__m128i*>(dst + x);
+        const __m128i s = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(src + x));
+        __m128i a = _mm_and_si128(_mm_srl_epi32(s, count), byteMask);
+        if (alpha != 255)
+        {
+            const __m128i t = _mm_add_epi32(
+                _mm_mullo_epi16(a, alphaV), round);
+            a = _mm_srli_epi32(_mm_add_epi32(t, _mm_srli_epi32(t, 8)), 8);
+        }
+        // skip fully transparent pixels
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(a, zero)) == 0xffff)
+            continue;
+        const __m128i d = _mm_loadu_si128(ptr);
+        // opaque pixels copied as is
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(a, byteMask)) == 0xffff)
+        {
+            _mm_storeu_si128(ptr, mergeSse2(s, d, maskV));
+            continue;
+        }
+        const __m128i a16 = _mm_or_si128(a, _mm_slli_epi32(a, 16));
+        const __m128i aLo = _mm_unpacklo_epi32(a16, a16);
+        const __m128i aHi = _mm_unpackhi_epi32(a16, a16);
+        const __m128i lo = blendSse2(_mm_unpacklo_epi8(s, zero),
+            _mm_unpacklo_epi8(d, zero), aLo, _mm_sub_epi16(full, aLo));
+        const __m128i hi = blendSse2(_mm_unpackhi_epi8(s, zero),
+            _mm_unpackhi_epi8(d, zero), aHi, _mm_sub_epi16(full, aHi));
+        _mm_storeu_si128(ptr, mergeSse2(_mm_packus_epi16(lo, hi),
+            d, maskV));
+    }
+    blendAlphaRow(dst + x, src + x, width - x, mask, alphaShift, alpha);
+}
+
+__attribute__ ((target ("avx2")))
+static inline __m256i blendAvx2(const __m256i src,
+                                const __m256i dst,
+                                const __m256i alpha,
+                                const __m256i ia)
+{
+    const __m256i t = _mm256_add_epi16(_mm256_add_epi16(
+        _mm256_mullo_epi16(src, alpha), _mm256_mullo_epi16(dst, ia)),
+        _mm256_set1_epi16(128));
+    return _mm256_srli_epi16(_mm256_add_epi16(t,
+        _mm256_srli_epi16(t, 8)), 8);
+}
+
+__attribute__ ((target ("avx2")))
+static inline __m256i mergeAvx2(const __m256i res,
+                                const __m256i dst,
+                                const __m256i mask)
+{
+    return _mm256_or_si256(_mm256_and_si256(res, mask),
+        _mm256_andnot_si256(mask, dst));
+}
+
+// unpack and pack works inside 128 bit lanes, so pixels order kept
+__attribute__ ((target ("avx2")))
+void SoftwareBlend::blendColorRowAvx2(uint32_t *restrict dst,
+                                      const int width,
+                                      const uint32_t pixel,
+                                      const uint32_t mask,
+                                      const unsigned int alpha)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i maskV = _mm256_set1_epi32(static_cast<int>(mask));
+    const __m256i src = _mm256_unpacklo_epi8(
+        _mm256_set1_epi32(static_cast<int>(pixel)), zero);
+    const __m256i alphaV = _mm256_set1_epi16(static_cast<int16_t>(alpha));
+    const __m256i ia = _mm256_set1_epi16(
+        static_cast<int16_t>(255 - alpha));
+    int x = 0;
+    for (; x + 8 <= width; x += 8)
+    {
+        __m256i *const ptr = reinterpret_cast<__m256i*>(dst + x);
+        const __m256i d = _mm256_loadu_si256(ptr);
+        const __m256i lo = blendAvx2(src, _mm256_unpacklo_epi8(d, zero),
+            alphaV, ia);
+        const __m256i hi = blendAvx2(src, _mm256_unpackhi_epi8(d, zero),
+            alphaV, ia);
+        _mm256_storeu_si256(ptr, mergeAvx2(_mm256_packus_epi16(lo, hi),
+            d, maskV));
+    }
+    blendColorRow(dst + x, width - x, pixel, mask, alpha);
+}
+
+__attribute__ ((target ("avx2")))
+void SoftwareBlend::blendConstRowAvx2(uint32_t *restrict dst,
+                                      const uint32_t *restrict src,
+                                      const int width,
+                                      const uint32_t mask,
+                                      const unsigned int alphaShift,
+                                      const unsigned int alpha)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i maskV = _mm256_set1_epi32(static_cast<int>(mask));
+    const __m256i alphaV = _mm256_set1_epi16(static_cast<int16_t>(alpha));
+    const __m256i ia = _mm256_set1_epi16(
+        static_cast<int16_t>(255 - alpha));
+    int x = 0;
+    for (; x + 8 <= width; x += 8)
+    {
+        __m256i *const ptr = reinterpret_cast<__m256i*>(dst + x);
+        const __m256i s = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i*>(src + x));
+        const __m256i d = _mm256_loadu_si256(ptr);
+        const __m256i lo = blendAvx2(_mm256_unpacklo_epi8(s, zero),
+            _mm256_unpacklo_epi8(d, zero), alphaV, ia);
+        const __m256i hi = blendAvx2(_mm256_unpackhi_epi8(s, zero),
+            _mm256_unpackhi_epi8(d, zero), alphaV, ia);
+        _mm256_storeu_si256(ptr, mergeAvx2(_mm256_packus_epi16(lo, hi),
+            d, maskV));
+    }
+    blendConstRow(dst + x, src + x, width - x, mask, alphaShift, alpha);
+}
+
+__attribute__ ((target ("avx2")))
+void SoftwareBlend::blendAlphaRowAvx2(uint32_t *restrict dst,
+                                      const uint32_t *restrict src,
+                                      const int width,
+                                      const uint32_t mask,
+                                      const unsigned int alphaShift,
+                                      const unsigned int alpha)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i byteMask = _mm256_set1_epi32(0xff);
+    const __m256i round = _mm256_set1_epi32(128);
+    const __m256i full = _mm256_set1_epi16(0xff);
+    const __m256i maskV = _mm256_set1_epi32(static_cast<int>(mask));
+    const __m256i alphaV = _mm256_set1_epi32(static_cast<int>(alpha));
+    const __m128i count = _mm_cvtsi32_si128(static_cast<int>(alphaShift));
+    int x = 0;
+    for (; x + 8 <= width; x += 8)
+    {
+        __m256i *const ptr = reinterpret_cast<__m256i*>(dst + x);
+        const __m256i s = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i*>(src + x));
+        __m256i a = _mm256_and_si256(_mm256_srl_epi32(s, count), byteMask);
+        if (alpha != 255)
+        {
+            const __m256i t = _mm256_add_epi32(
+                _mm256_mullo_epi16(a, alphaV), round);
+            a = _mm256_srli_epi32(_mm256_add_epi32(t,
+                _mm256_srli_epi32(t, 8)), 8);
+        }
+        // skip fully transparent pixels
+        if (_mm256_movemask_epi8(_mm256_cmpeq_epi32(a, zero)) == -1)
+            continue;
+        const __m256i d = _mm256_loadu_si256(ptr);
+        // opaque pixels copied as is
+        if (_mm256_movemask_epi8(_mm256_cmpeq_epi32(a, byteMask)) == -1)
+        {
+            _mm256_storeu_si256(ptr, mergeAvx2(s, d, maskV));
+            continue;
+        }
+        const __m256i a16 = _mm256_or_si256(a, _mm256_slli_epi32(a, 16));
+        const __m256i aLo = _mm256_unpacklo_epi32(a16, a16);
+        const __m256i aHi = _mm256_unpackhi_epi32(a16, a16);
+        const __m256i lo = blendAvx2(_mm256_unpacklo_epi8(s, zero),
+            _mm256_unpacklo_epi8(d, zero), aLo, _mm256_sub_epi16(full, aLo));
+        const __m256i hi = blendAvx2(_mm256_unpackhi_epi8(s, zero),
+            _mm256_unpackhi_epi8(d, zero), aHi, _mm256_sub_epi16(full, aHi));
+        _mm256_storeu_si256(ptr, mergeAvx2(_mm256_packus_epi16(lo, hi),
+            d, maskV));
+    }
+    blendAlphaRow(dst + x, src + x, width - x, mask, alphaShift, alpha);
+}
+#endif  // SIMD_SUPPORTED
+
+static bool isByteChannel(const uint32_t mask,
+                          const unsigned int shift)
+{
+    return shift < 32 && mask == (0xffU << shift);
+}
+
+// return true if blit can be done by own kernels
+static bool getBlendMode(const SDL_Surface *const src,
+                         const SDL_Surface *const dst,
+                         unsigned int &alpha)
+{
+    const SDL_PixelFormat *const srcFormat = src->format;
+    const SDL_PixelFormat *const dstFormat = dst->format;
+    if (srcFormat->BytesPerPixel != 4
+        || dstFormat->BytesPerPixel != 4
+        || dstFormat->Amask
+        || (src->flags & SDL_RLEACCEL)
+        || srcFormat->Rmask != dstFormat->Rmask
+        || srcFormat->Gmask != dstFormat->Gmask
+        || srcFormat->Bmask != dstFormat->Bmask
+        || !isByteChannel(dstFormat->Rmask, dstFormat->Rshift)
+        || !isByteChannel(dstFormat->Gmask, dstFormat->Gshift)
+        || !isByteChannel(dstFormat->Bmask, dstFormat->Bshift))
+    {
+        return false;
+    }
+    if (srcFormat->Amask
+        && !isByteChannel(srcFormat->Amask, srcFormat->Ashift))
+    {
+        return false;
+    }
+
+#ifdef USE_SDL2
+    SDL_BlendMode mode = SDL_BLENDMODE_NONE;
+    if (SDL_GetSurfaceBlendMode(const_cast<SDL_Surface*>(src), &mode)
+        || mode != SDL_BLENDMODE_BLEND)
+    {
+        return false;
+    }
+    uint32_t key = 0;
+    if (!SDL_GetColorKey(const_cast<SDL_Surface*>(src), &key))
+        return false;
+    uint8_t r = 0;
+    uint8_t g = 0;
+    uint8_t b = 0;
+    if (SDL_GetSurfaceColorMod(const_cast<SDL_Surface*>(src), &r, &g, &b)
+        || r != 255 || g != 255 || b != 255)
+    {
+        return false;
+    }
+    uint8_t mod = 255;
+    if (SDL_GetSurfaceAlphaMod(const_cast<SDL_Surface*>(src), &mod))
+        return false;
+    alpha = mod;
+#else  // USE_SDL2
+    if (!(src->flags & SDL_SRCALPHA) || (src->flags & SDL_SRCCOLORKEY))
+        return false;
+    // per pixel alpha ignore surface alpha
+    alpha = srcFormat->Amask ? 255U : srcFormat->alpha;
+#endif  // USE_SDL2
+
+    // opaque copy already fast in SDL
+    return srcFormat->Amask || alpha < 255;
+}
+
+void SoftwareBlend::fillRectangle(SDL_Surface *const surface,
+                                  const int x1, const int y1,
+                                  const int x2, const int y2,
+                                  const uint32_t pixel,
+                                  const unsigned int alpha)
+{
+    const int width = x2 - x1;
+    if (width <= 0 || y2 <= y1)
+        return;
+
+    const SDL_PixelFormat *const format = surface->format;
+    const uint32_t mask = format->Rmask | format->Gmask | format->Bmask;
+
+    BlendColorFunc func = &blendColorRow;
+#ifdef SIMD_SUPPORTED
+    const int flags = Cpu::getFlags();
+    if (flags & Cpu::FEATURE_AVX2)
+        func = &blendColorRowAvx2;
+    else if (flags & Cpu::FEATURE_SSE2)
+        func = &blendColorRowSse2;
+#endif  // SIMD_SUPPORTED
+
+    const int pitch = surface->pitch;
+    uint8_t *row = static_cast<uint8_t*>(surface->pixels)
+        + y1 * pitch + x1 * 4;
+    for (int y = y1; y < y2; y ++)
+    {
+        func(reinterpret_cast<uint32_t*>(row), width, pixel, mask, alpha);
+        row += pitch;
+    }
+}
+
+void SoftwareBlend::lowerBlit(SDL_Surface *const src,
+                              SDL_Rect *const srcRect,
+                              SDL_Surface *const dst,
+                              SDL_Rect *const dstRect)
+{
+    unsigned int alpha = 255;
+    if (!getBlendMode(src, dst, alpha))
+    {
+        SDL_LowerBlit(src, srcRect, dst, dstRect);
+        return;
+    }
+    if (!alpha)
+        return;
+
+    const SDL_PixelFormat *const srcFormat = src->format;
+    const uint32_t mask = srcFormat->Rmask
+        | srcFormat->Gmask | srcFormat->Bmask;
+    const unsigned int alphaShift = srcFormat->Ashift;
+    const bool perPixel = srcFormat->Amask != 0;
+
+    BlendImageFunc func = perPixel ? &blendAlphaRow : &blendConstRow;
+#ifdef SIMD_SUPPORTED
+    const int flags = Cpu::getFlags();
+    if (flags & Cpu::FEATURE_AVX2)
+        func = perPixel ? &blendAlphaRowAvx2 : &blendConstRowAvx2;
+    else if (flags & Cpu::FEATURE_SSE2)
+        func = perPixel ? &blendAlphaRowSse2 : &blendConstRowSse2;
+#endif  // SIMD_SUPPORTED
+
+    const bool lockSrc = SDL_MUSTLOCK(src);
+    const bool lockDst = SDL_MUSTLOCK(dst);
+    if (lockSrc)
+        SDL_LockSurface(src);
+    if (lockDst)
+        SDL_LockSurface(dst);
+
+    const int width = srcRect->w;
+    const int height = srcRect->h;
+    const int srcPitch = src->pitch;
+    const int dstPitch = dst->pitch;
+    const uint8_t *srcRow = static_cast<const uint8_t*>(src->pixels)
+        + srcRect->y * srcPitch + srcRect->x * 4;
+    uint8_t *dstRow = static_cast<uint8_t*>(dst->pixels)
+        + dstRect->y * dstPitch + dstRect->x * 4;
+    for (int y = 0; y < height; y ++)
+    {
+        func(reinterpret_cast<uint32_t*>(dstRow),
+            reinterpret_cast<const uint32_t*>(srcRow),
+            width, mask, alphaShift, alpha);
+        srcRow += srcPitch;
+        dstRow += dstPitch;
+    }
+
+    if (lockDst)
+        SDL_UnlockSurface(dst);
+    if (lockSrc)
+        SDL_UnlockSurface(src);
+}
@@ -0,0 +1,124 @@
+/*
+ *  The ManaPlus Client
+ *  Copyright (C) 2011-2014  The ManaPlus Developers
+ *
+ *  This file is part of The ManaPlus Client.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef RENDER_SOFTWAREBLEND_H
+#define RENDER_SOFTWAREBLEND_H
+
+#include "utils/cpu.h"
+
+#include <SDL_video.h>
+
+#include "localconsts.h"
+
+/**
+ * Blending kernels for 32 bit software surfaces.
+ * Uses SSE2 or AVX2 if cpu support it, or plain C code if not.
+ */
+namespace SoftwareBlend
+{
+    /**
+     * Blends color with alpha into rectangle x1,y1 - x2,y2 of 32 bit
+     * surface. Surface must be locked.
+     */
+    void fillRectangle(SDL_Surface *const surface,
+                       const int x1, const int y1,
+                       const int x2, const int y2,
+                       const uint32_t pixel,
+                       const unsigned int alpha);
+
+    /**
+     * Blits already clipped rectangle.
+     * Alpha blits between 32 bit surfaces done by own kernels,
+     * all other blits passed to SDL_LowerBlit.
+     */
+    void lowerBlit(SDL_Surface *const src,
+                   SDL_Rect *const srcRect,
+                   SDL_Surface *const dst,
+                   SDL_Rect *const dstRect);
+
+    /**
+     * Row kernels. Blend width pixels and keep bits outside of mask.
+     * Color rows blend one color, const rows blend source with alpha,
+     * alpha rows use source alpha at alphaShift multiplied by alpha.
+     */
+    void blendColorRow(uint32_t *restrict dst,
+                       const int width,
+                       const uint32_t pixel,
+                       const uint32_t mask,
+                       const unsigned int alpha);
+
+    void blendConstRow(uint32_t *restrict dst,
+                       const uint32_t *restrict src,
+                       const int width,
+                       const uint32_t mask,
+                       const unsigned int alphaShift,
+                       const unsigned int alpha);
+
+    void blendAlphaRow(uint32_t *restrict dst,
+                       const uint32_t *restrict src,
+                       const int width,
+                       const uint32_t mask,
+                       const unsigned int alphaShift,
+                       const unsigned int alpha);
+
+#ifdef SIMD_SUPPORTED
+    void blendColorRowSse2(uint32_t *restrict dst,
+                           const int width,
+                           const uint32_t pixel,
+                           const uint32_t mask,
+                           const unsigned int alpha);
+
+    void blendConstRowSse2(uint32_t *restrict dst,
+                           const uint32_t *restrict src,
+                           const int width,
+                           const uint32_t mask,
+                           const unsigned int alphaShift,
+                           const unsigned int alpha);
+
+    void blendAlphaRowSse2(uint32_t *restrict dst,
+                           const uint32_t *restrict src,
+                           const int width,
+                           const uint32_t mask,
+                           const unsigned int alphaShift,
+                           const unsigned int alpha);
+
+    void blendColorRowAvx2(uint32_t *restrict dst,
+                           const int width,
+                           const uint32_t pixel,
+                           const uint32_t mask,
+                           const unsigned int alpha);
+
+    void blendConstRowAvx2(uint32_t *restrict dst,
+                           const uint32_t *restrict src,
+                           const int width,
+                           const uint32_t mask,
+                           const unsigned int alphaShift,
+                           const unsigned int alpha);
+
+    void blendAlphaRowAvx2(uint32_t *restrict dst,
+                           const uint32_t *restrict src,
+                           const int width,
+                           const uint32_t mask,
+                           const unsigned int alphaShift,
+                           const unsigned int alpha);
+#endif  // SIMD_SUPPORTED
+}  // namespace SoftwareBlend
+
+#endif  // RENDER_SOFTWAREBLEND_H
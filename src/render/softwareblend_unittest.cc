@@ -0,0 +1,182 @@
+/*
+ *  The ManaPlus Client
+ *  Copyright (C) 2011-2014  The ManaPlus Developers
+ *
+ *  This file is part of The ManaPlus Client.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "logger.h"
+
+#include "render/softwareblend.h"
+
+#include "gtest/gtest.h"
+
+#include <stdlib.h>
+#include <vector>
+
+#include "debug.h"
+
+typedef void (*ColorRowFunc)(uint32_t *restrict dst,
+                             const int width,
+                             const uint32_t pixel,
+                             const uint32_t mask,
+                             const unsigned int alpha);
+
+typedef void (*ImageRowFunc)(uint32_t *restrict dst,
+                             const uint32_t *restrict src,
+                             const int width,
+                             const uint32_t mask,
+                             const unsigned int alphaShift,
+                             const unsigned int alpha);
+
+static uint32_t randomPixel()
+{
+    return (static_cast<uint32_t>(rand() & 0xffff) << 16)
+        | static_cast<uint32_t>(rand() & 0xffff);
+}
+
+// (s * a + d * (255 - a)) / 255 with rounding for each byte in mask
+static uint32_t refBlend(const uint32_t src,
+                         const uint32_t dst,
+                         const unsigned int alpha,
+                         const uint32_t mask)
+{
+    uint32_t res = 0;
+    for (int f = 0; f < 32; f += 8)
+    {
+        const unsigned int s = (src >> f) & 0xff;
+        const unsigned int d = (dst >> f) & 0xff;
+        res |= ((s * alpha + d * (255 - alpha) + 127) / 255) << f;
+    }
+    return (res & mask) | (dst & ~mask);
+}
+
+static unsigned int refAlpha(const uint32_t src,
+                             const unsigned int alphaShift,
+                             const unsigned int alpha)
+{
+    const unsigned int a = (src >> alphaShift) & 0xff;
+    return (a * alpha + 127) / 255;
+}
+
+static void fillRow(std::vector<uint32_t> &pixels)
+{
+    const size_t sz = pixels.size();
+    for (size_t f = 0; f < sz; f ++)
+    {
+        uint32_t pixel = randomPixel();
+        // fully transparent and opaque runs
+        const int kind = (static_cast<int>(f) / 5) % 4;
+        if (kind == 1)
+            pixel &= 0x00ffff00U;
+        else if (kind == 2)
+            pixel |= 0xff0000ffU;
+        pixels[f] = pixel;
+    }
+}
+
+static void checkColorRow(const ColorRowFunc func)
+{
+    const uint32_t masks[2] = {0x00ffffffU, 0xffffff00U};
+    for (int f = 0; f < 300; f ++)
+    {
+        const int width = rand() % 70;
+        const uint32_t mask = masks[f % 2];
+        const unsigned int alpha = static_cast<unsigned int>(rand() % 256);
+        const uint32_t pixel = randomPixel();
+        std::vector<uint32_t> dst(static_cast<size_t>(width) + 1);
+        fillRow(dst);
+        std::vector<uint32_t> expected = dst;
+        for (int k = 0; k < width; k ++)
+            expected[k] = refBlend(pixel, dst[k], alpha, mask);
+        func(&dst[0], width, pixel, mask, alpha);
+        EXPECT_TRUE(expected == dst);
+    }
+}
+
+static void checkImageRow(const ImageRowFunc func,
+                          const bool perPixel)
+{
+    const uint32_t masks[2] = {0x00ffffffU, 0xffffff00U};
+    const unsigned int shifts[2] = {24, 0};
+    for (int f = 0; f < 300; f ++)
+    {
+        const int width = rand() % 70;
+        const uint32_t mask = masks[f % 2];
+        const unsigned int alphaShift = shifts[f % 2];
+        unsigned int alpha = static_cast<unsigned int>(rand() % 256);
+        if (f % 3 == 0)
+            alpha = 255;
+        std::vector<uint32_t> src(static_cast<size_t>(width) + 1);
+        std::vector<uint32_t> dst(static_cast<size_t>(width) + 1);
+        fillRow(src);
+        fillRow(dst);
+        std::vector<uint32_t> expected = dst;
+        for (int k = 0; k < width; k ++)
+        {
+            const unsigned int a = perPixel
+                ? refAlpha(src[k], alphaShift, alpha) : alpha;
+            expected[k] = refBlend(src[k], dst[k], a, mask);
+        }
+        func(&dst[0], &src[0], width, mask, alphaShift, alpha);
+        EXPECT_TRUE(expected == dst);
+    }
+}
+
+TEST(SoftwareBlend, colorRow)
+{
+    srand(1);
+    checkColorRow(&SoftwareBlend::blendColorRow);
+#ifdef SIMD_SUPPORTED
+    if (!logger)
+        logger = new Logger();
+    Cpu::detect();
+    if (Cpu::getFlags() & Cpu::FEATURE_SSE2)
+        checkColorRow(&SoftwareBlend::blendColorRowSse2);
+    if (Cpu::getFlags() & Cpu::FEATURE_AVX2)
+        checkColorRow(&SoftwareBlend::blendColorRowAvx2);
+#endif
+}
+
+TEST(SoftwareBlend, constRow)
+{
+    srand(2);
+    checkImageRow(&SoftwareBlend::blendConstRow, false);
+#ifdef SIMD_SUPPORTED
+    if (!logger)
+        logger = new Logger();
+    Cpu::detect();
+    if (Cpu::getFlags() & Cpu::FEATURE_SSE2)
+        checkImageRow(&SoftwareBlend::blendConstRowSse2, false);
+    if (Cpu::getFlags() & Cpu::FEATURE_AVX2)
+        checkImageRow(&SoftwareBlend::blendConstRowAvx2, false);
+#endif
+}
+
+TEST(SoftwareBlend, alphaRow)
+{
+    srand(3);
+    checkImageRow(&SoftwareBlend::blendAlphaRow, true);
+#ifdef SIMD_SUPPORTED
+    if (!logger)
+        logger = new Logger();
+    Cpu::detect();
+    if (Cpu::getFlags() & Cpu::FEATURE_SSE2)
+        checkImageRow(&SoftwareBlend::blendAlphaRowSse2, true);
+    if (Cpu::getFlags() & Cpu::FEATURE_AVX2)
+        checkImageRow(&SoftwareBlend::blendAlphaRowAvx2, true);
+#endif
+}
@@ -83,3 +83,16 @@ void Action::setLastFrameDelay(const int delay) noexcept
         animation->setLastFrameDelay(delay);
     }
 }
+
+Action *Action::copyLoaded(const std::vector<Image*> &images) const
+{
+    Action *const action = new Action;
+    action->mNumber = mNumber;
+    FOR_EACH (Animations::const_iterator, it, mAnimations)
+    {
+        const Animation *const animation = (*it).second;
+        if (animation)
+            action->mAnimations[(*it).first] = animation->copyLoaded(images);
+    }
+    return action;
+}
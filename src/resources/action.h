@@ -26,10 +26,12 @@
 #include "resources/spritedirection.h"
 
 #include <map>
+#include <vector>
 
 #include "localconsts.h"
 
 class Animation;
+class Image;
 
 /**
  * An action consists of several animations, one for each direction.
@@ -57,6 +59,13 @@ class Action final
 
         void setLastFrameDelay(const int delay) noexcept;
 
+        /**
+         * Creates copy of action with animations without sprite frames
+         * which images not loaded.
+         */
+        Action *copyLoaded(const std::vector<Image*> &images) const
+                           A_WARN_UNUSED;
+
     protected:
         typedef std::map<int, Animation*> Animations;
         typedef Animations::iterator AnimationIter;
@@ -35,7 +35,17 @@ void Animation::addFrame(Image *const image, const int delay,
                          const int rand) noexcept
 {
     Frame frame
-        = { image, delay, offsetX, offsetY, rand, Frame::ANIMATION, "" };
+        = { image, delay, offsetX, offsetY, rand, Frame::ANIMATION, "", -1 };
+    mFrames.push_back(frame);
+    mDuration += delay;
+}
+
+void Animation::addSpriteFrame(const int imageIndex, const int delay,
+                               const int offsetX, const int offsetY,
+                               const int rand) noexcept
+{
+    Frame frame = { nullptr, delay, offsetX, offsetY, rand,
+        Frame::ANIMATION, "", imageIndex };
     mFrames.push_back(frame);
     mDuration += delay;
 }
@@ -47,30 +57,31 @@ void Animation::addTerminator(const int rand) noexcept
 
 bool Animation::isTerminator(const Frame &candidate) noexcept
 {
-    return (!candidate.image && candidate.type == Frame::ANIMATION);
+    return (!candidate.image && candidate.imageIndex < 0
+        && candidate.type == Frame::ANIMATION);
 }
 
 void Animation::addJump(const std::string &name, const int rand) noexcept
 {
-    Frame frame = { nullptr, 0, 0, 0, rand, Frame::JUMP, name };
+    Frame frame = { nullptr, 0, 0, 0, rand, Frame::JUMP, name, -1 };
     mFrames.push_back(frame);
 }
 
 void Animation::addLabel(const std::string &name) noexcept
 {
-    Frame frame = { nullptr, 0, 0, 0, 100, Frame::LABEL, name };
+    Frame frame = { nullptr, 0, 0, 0, 100, Frame::LABEL, name, -1 };
     mFrames.push_back(frame);
 }
 
 void Animation::addGoto(const std::string &name, const int rand) noexcept
 {
-    Frame frame = { nullptr, 0, 0, 0, rand, Frame::GOTO, name };
+    Frame frame = { nullptr, 0, 0, 0, rand, Frame::GOTO, name, -1 };
     mFrames.push_back(frame);
 }
 
 void Animation::addPause(const int delay, const int rand) noexcept
 {
-    Frame frame = { nullptr, delay, 0, 0, rand, Frame::PAUSE, "" };
+    Frame frame = { nullptr, delay, 0, 0, rand, Frame::PAUSE, "", -1 };
     mFrames.push_back(frame);
 }
 
@@ -79,10 +90,30 @@ void Animation::setLastFrameDelay(const int delay) noexcept
     for (FramesRevIter it = mFrames.rbegin(), it_end = mFrames.rend();
          it != it_end; ++ it)
     {
-        if ((*it).type == Frame::ANIMATION && (*it).image)
+        if ((*it).type == Frame::ANIMATION
+            && ((*it).image || (*it).imageIndex >= 0))
         {
             (*it).delay = delay;
             break;
         }
     }
 }
+
+Animation *Animation::copyLoaded(const std::vector<Image*> &images) const
+{
+    Animation *const animation = new Animation;
+    const int sz = static_cast<int>(images.size());
+    FOR_EACH (Frames::const_iterator, it, mFrames)
+    {
+        const Frame &frame = *it;
+        if (frame.type == Frame::ANIMATION && frame.imageIndex >= 0)
+        {
+            if (frame.imageIndex >= sz || !images[frame.imageIndex])
+                continue;
+        }
+        animation->mFrames.push_back(frame);
+        if (frame.type == Frame::ANIMATION)
+            animation->mDuration += frame.delay;
+    }
+    return animation;
+}
@@ -52,6 +52,13 @@ class Animation final
                       const int offsetX, const int offsetY,
                       const int rand) noexcept;
 
+        /**
+         * Appends a new frame with image from sprite definition.
+         */
+        void addSpriteFrame(const int imageIndex, const int delay,
+                            const int offsetX, const int offsetY,
+                            const int rand) noexcept;
+
         /**
          * Appends an animation terminator that states that the animation
          * should not loop.
@@ -74,6 +81,13 @@ class Animation final
 
         void setLastFrameDelay(const int delay) noexcept;
 
+        /**
+         * Creates copy of animation without sprite frames which images
+         * not loaded.
+         */
+        Animation *copyLoaded(const std::vector<Image*> &images) const
+                              A_WARN_UNUSED;
+
         typedef std::vector<Frame> Frames;
         typedef Frames::iterator FramesIter;
         typedef Frames::reverse_iterator FramesRevIter;
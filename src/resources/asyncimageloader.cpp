@@ -0,0 +1,495 @@
+/*
+ *  The ManaPlus Client
+ *  Copyright (C) 2011-2014  The ManaPlus Developers
+ *
+ *  This file is part of The ManaPlus Client.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "resources/asyncimageloader.h"
+
+#include "configuration.h"
+#include "logger.h"
+
+#include "resources/dye.h"
+#include "resources/image.h"
+#include "resources/imagehelper.h"
+#include "resources/resourcemanager.h"
+
+#include "utils/physfscheckutils.h"
+#include "utils/physfsrwops.h"
+#include "utils/physfstools.h"
+#include "utils/sdlcheckutils.h"
+#include "utils/sdlhelper.h"
+#include "utils/stringvector.h"
+#include "utils/xml.h"
+#include "utils/xmlcache.h"
+
+#include <SDL_thread.h>
+
+#include <list>
+#include <map>
+#include <set>
+
+#ifndef USE_SDL2
+#include <unistd.h>
+#endif
+
+#include "debug.h"
+
+namespace
+{
+    enum JobType
+    {
+        JOB_SPRITE = 0,
+        JOB_IMAGE
+    };
+
+    struct Job final
+    {
+        std::string path;
+        std::string spritesDir;
+        JobType type;
+    };
+
+    struct PreparedImage final
+    {
+        SDL_Surface *surface;
+        int width;
+        int height;
+    };
+
+    struct SpriteRequest final
+    {
+        SpriteRequest() :
+            images(),
+            parsed(false)
+        { }
+
+        StringVect images;
+        bool parsed;
+    };
+
+    typedef std::map<std::string, StringVect> ParsedSprites;
+    typedef ParsedSprites::const_iterator ParsedSpritesCIter;
+    typedef std::map<std::string, PreparedImage> PreparedImages;
+    typedef PreparedImages::iterator PreparedImagesIter;
+    typedef std::map<std::string, SpriteRequest> SpriteRequests;
+    typedef SpriteRequests::iterator SpriteRequestsIter;
+
+    const unsigned int maxThreads = 4;
+    // textures created per call to process
+    const int maxUploads = 4;
+
+    // shared with worker threads, protected by mMutex
+    std::list<Job> mJobs;
+    ParsedSprites mParsed;
+    PreparedImages mPrepared;
+    bool mStop = false;
+    SDL_mutex *mMutex = nullptr;
+    SDL_cond *mCondition = nullptr;
+
+    // used only by main thread
+    std::vector<SDL_Thread*> mThreads;
+    SpriteRequests mSprites;
+    std::set<std::string> mPendingImages;
+}  // namespace
+
+bool AsyncImageLoader::mEnabled = false;
+
+static void silentErrorLogger(void *ctx A_UNUSED, const char *msg A_UNUSED,
+                              ...)
+{
+    // errors will be reported by main thread while loading sprite
+}
+
+static unsigned int getThreadsCount()
+{
+    int cpus = 2;
+#ifdef USE_SDL2
+    cpus = SDL_GetCPUCount();
+#elif defined(_SC_NPROCESSORS_ONLN)
+    cpus = static_cast<int>(sysconf(_SC_NPROCESSORS_ONLN));
+#endif
+    // keep one cpu for main thread
+    cpus --;
+    if (cpus < 1)
+        return 1;
+    if (static_cast<unsigned int>(cpus) > maxThreads)
+        return maxThreads;
+    return static_cast<unsigned int>(cpus);
+}
+
+static xmlDocPtr parseFile(const std::string &fileName)
+{
+    if (!PhysFs::exists(fileName.c_str()))
+        return nullptr;
+    PHYSFS_file *const file = PhysFs::openRead(fileName.c_str());
+    if (!file)
+        return nullptr;
+
+    const int size = static_cast<int>(PHYSFS_fileLength(file));
+    xmlDocPtr doc = XmlCache::load(fileName,
+        XmlCache::getStamp(fileName, size));
+    if (doc)
+    {
+        PHYSFS_close(file);
+        return doc;
+    }
+
+    char *const data = static_cast<char*>(calloc(size, 1));
+    PHYSFS_read(file, data, 1, size);
+    PHYSFS_close(file);
+
+    doc = xmlParseMemory(data, size);
+    free(data);
+    return doc;
+}
+
+static void collectImages(const std::string &fileName,
+                          const std::string &palettes,
+                          const std::string &spritesDir,
+                          std::set<std::string> &files,
+                          std::set<std::string> &imageSets,
+                          StringVect &images)
+{
+    const xmlDocPtr doc = parseFile(fileName);
+    if (!doc)
+        return;
+
+    const XmlNodePtr rootNode = xmlDocGetRootElement(doc);
+    if (rootNode && xmlNameEqual(rootNode, "sprite"))
+    {
+        // same rules as in SpriteTemplate::loadSprite
+        for_each_xml_child_node(node, rootNode)
+        {
+            if (xmlNameEqual(node, "imageset"))
+            {
+                if (!imageSets.insert(XML::getProperty(
+                    node, "name", "")).second)
+                {
+                    continue;
+                }
+                std::string imageSrc = XML::getProperty(node, "src", "");
+                if (imageSrc.empty())
+                    continue;
+                Dye::instantiate(imageSrc, palettes);
+                images.push_back(imageSrc);
+            }
+            else if (xmlNameEqual(node, "include"))
+            {
+                std::string file = XML::getProperty(node, "file", "");
+                if (file.empty())
+                    continue;
+                file = std::string(spritesDir).append(file);
+                if (files.insert(file).second)
+                {
+                    collectImages(file, "", spritesDir,
+                        files, imageSets, images);
+                }
+            }
+        }
+    }
+    xmlFreeDoc(doc);
+}
+
+static void parseSprite(const Job &job, StringVect &images)
+{
+    const size_t pos = job.path.find('|');
+    std::string palettes;
+    if (pos != std::string::npos)
+        palettes = job.path.substr(pos + 1);
+
+    std::set<std::string> files;
+    std::set<std::string> imageSets;
+    const std::string fileName = job.path.substr(0, pos);
+    files.insert(fileName);
+    collectImages(fileName, palettes, job.spritesDir,
+        files, imageSets, images);
+}
+
+static PreparedImage prepareImage(const std::string &idPath)
+{
+    PreparedImage image = { nullptr, 0, 0 };
+    std::string path = idPath;
+    std::string dyeString;
+    const size_t p = path.find('|');
+    Dye *d = nullptr;
+    if (p != std::string::npos)
+    {
+        dyeString = path.substr(p + 1);
+        d = new Dye(dyeString);
+        path = path.substr(0, p);
+    }
+    SDL_RWops *const rw = MPHYSFSRWOPS_openRead(path.c_str());
+    if (rw)
+    {
+        image.surface = imageHelper->loadSurface(rw, d, path, dyeString,
+            image.width, image.height);
+    }
+    delete d;
+    return image;
+}
+
+static Image *uploadImage(const PreparedImage &prepared)
+{
+    if (!prepared.surface)
+        return nullptr;
+    Image *const image = imageHelper->loadPrepared(prepared.surface,
+        prepared.width, prepared.height);
+    MSDL_FreeSurface(prepared.surface);
+    return image;
+}
+
+static int SDLCALL loaderThread(void *ptr A_UNUSED)
+{
+    xmlSetGenericErrorFunc(nullptr, &silentErrorLogger);
+
+    SDL_mutexP(mMutex);
+    while (!mStop)
+    {
+        if (mJobs.empty())
+        {
+            SDL_CondWait(mCondition, mMutex);
+            continue;
+        }
+        const Job job = mJobs.front();
+        mJobs.pop_front();
+        SDL_mutexV(mMutex);
+
+        if (job.type == JOB_SPRITE)
+        {
+            StringVect images;
+            parseSprite(job, images);
+            SDL_mutexP(mMutex);
+            mParsed[job.path].swap(images);
+        }
+        else
+        {
+            const PreparedImage image = prepareImage(job.path);
+            SDL_mutexP(mMutex);
+            mPrepared[job.path] = image;
+        }
+    }
+    SDL_mutexV(mMutex);
+    return 0;
+}
+
+static bool startThreads()
+{
+    if (!mThreads.empty())
+        return true;
+
+    mMutex = SDL_CreateMutex();
+    mCondition = SDL_CreateCond();
+    mStop = false;
+
+    const unsigned int threads = getThreadsCount();
+    for (unsigned int f = 0; f < threads; f ++)
+    {
+        SDL_Thread *const thread = SDL::createThread(&loaderThread,
+            "imageloader", nullptr);
+        if (thread)
+            mThreads.push_back(thread);
+    }
+    if (mThreads.empty())
+    {
+        logger->log1("Error: cant start image loader threads");
+        SDL_DestroyCond(mCondition);
+        mCondition = nullptr;
+        SDL_DestroyMutex(mMutex);
+        mMutex = nullptr;
+        return false;
+    }
+    logger->log("Started %u image loader threads",
+        static_cast<unsigned int>(mThreads.size()));
+    return true;
+}
+
+static void addJob(const std::string &path,
+                   const std::string &spritesDir,
+                   const JobType type)
+{
+    const Job job = { path, spritesDir, type };
+    SDL_mutexP(mMutex);
+    mJobs.push_back(job);
+    SDL_CondSignal(mCondition);
+    SDL_mutexV(mMutex);
+}
+
+void AsyncImageLoader::requestSprite(const std::string &fileName)
+{
+    if (!mEnabled || fileName.empty())
+        return;
+    if (mSprites.find(fileName) != mSprites.end())
+        return;
+    if (!startThreads())
+    {
+        mEnabled = false;
+        return;
+    }
+
+    mSprites[fileName] = SpriteRequest();
+    addJob(fileName, paths.getStringValue("sprites"), JOB_SPRITE);
+}
+
+void AsyncImageLoader::requestImage(const std::string &idPath)
+{
+    if (!mEnabled || idPath.empty())
+        return;
+    if (mPendingImages.find(idPath) != mPendingImages.end())
+        return;
+    if (ResourceManager::getInstance()->isLoaded(idPath))
+        return;
+    if (!startThreads())
+    {
+        mEnabled = false;
+        return;
+    }
+
+    mPendingImages.insert(idPath);
+    addJob(idPath, std::string(), JOB_IMAGE);
+}
+
+bool AsyncImageLoader::isSpriteReady(const std::string &fileName)
+{
+    return mSprites.find(fileName) == mSprites.end();
+}
+
+Image *AsyncImageLoader::takeImage(const std::string &idPath)
+{
+    if (mThreads.empty())
+        return nullptr;
+
+    SDL_mutexP(mMutex);
+    const PreparedImagesIter it = mPrepared.find(idPath);
+    if (it == mPrepared.end())
+    {
+        SDL_mutexV(mMutex);
+        return nullptr;
+    }
+    const PreparedImage prepared = (*it).second;
+    mPrepared.erase(it);
+    SDL_mutexV(mMutex);
+
+    mPendingImages.erase(idPath);
+    return uploadImage(prepared);
+}
+
+void AsyncImageLoader::process()
+{
+    if (mThreads.empty())
+        return;
+
+    BLOCK_START("AsyncImageLoader::process")
+    ParsedSprites parsed;
+    PreparedImages prepared;
+    SDL_mutexP(mMutex);
+    parsed.swap(mParsed);
+    for (int f = 0; f < maxUploads && !mPrepared.empty(); f ++)
+    {
+        const PreparedImagesIter it = mPrepared.begin();
+        prepared[(*it).first] = (*it).second;
+        mPrepared.erase(it);
+    }
+    SDL_mutexV(mMutex);
+
+    FOR_EACH (ParsedSpritesCIter, it, parsed)
+    {
+        const SpriteRequestsIter req = mSprites.find((*it).first);
+        if (req == mSprites.end())
+            continue;
+        SpriteRequest &request = (*req).second;
+        request.parsed = true;
+        request.images = (*it).second;
+        FOR_EACH (StringVectCIter, it2, request.images)
+            requestImage(*it2);
+    }
+
+    ResourceManager *const resman = ResourceManager::getInstance();
+    FOR_EACH (PreparedImagesIter, it, prepared)
+    {
+        const std::string &idPath = (*it).first;
+        mPendingImages.erase(idPath);
+        // image can be loaded synchronously while it was prepared
+        if (resman->isLoaded(idPath))
+        {
+            if ((*it).second.surface)
+                MSDL_FreeSurface((*it).second.surface);
+            continue;
+        }
+        Image *const image = uploadImage((*it).second);
+        if (image)
+        {
+            // stay in orphaned resources until sprite takes it
+            resman->addResource(idPath, image);
+            image->decRef();
+        }
+    }
+
+    SpriteRequestsIter it = mSprites.begin();
+    while (it != mSprites.end())
+    {
+        const SpriteRequest &request = (*it).second;
+        bool ready = request.parsed;
+        if (ready)
+        {
+            FOR_EACH (StringVectCIter, it2, request.images)
+            {
+                if (mPendingImages.find(*it2) != mPendingImages.end())
+                {
+                    ready = false;
+                    break;
+                }
+            }
+        }
+        if (ready)
+            mSprites.erase(it++);
+        else
+            ++ it;
+    }
+    BLOCK_END("AsyncImageLoader::process")
+}
+
+void AsyncImageLoader::stop()
+{
+    if (!mThreads.empty())
+    {
+        SDL_mutexP(mMutex);
+        mStop = true;
+        mJobs.clear();
+        SDL_CondBroadcast(mCondition);
+        SDL_mutexV(mMutex);
+
+        FOR_EACH (std::vector<SDL_Thread*>::const_iterator, it, mThreads)
+            SDL_WaitThread(*it, nullptr);
+        mThreads.clear();
+
+        FOR_EACH (PreparedImagesIter, it, mPrepared)
+        {
+            if ((*it).second.surface)
+                MSDL_FreeSurface((*it).second.surface);
+        }
+        mPrepared.clear();
+        mParsed.clear();
+
+        SDL_DestroyCond(mCondition);
+        mCondition = nullptr;
+        SDL_DestroyMutex(mMutex);
+        mMutex = nullptr;
+    }
+    mSprites.clear();
+    mPendingImages.clear();
+}
@@ -0,0 +1,86 @@
+/*
+ *  The ManaPlus Client
+ *  Copyright (C) 2011-2014  The ManaPlus Developers
+ *
+ *  This file is part of The ManaPlus Client.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef RESOURCES_ASYNCIMAGELOADER_H
+#define RESOURCES_ASYNCIMAGELOADER_H
+
+#include <string>
+
+#include "localconsts.h"
+
+class Image;
+
+/**
+ * Loads images in worker threads.
+ *
+ * Workers parse sprite definitions, decode, recolor and convert images.
+ * Main thread only creates textures or display surfaces from prepared
+ * images and adds them to resource manager. Until then sprites using
+ * these images stay in delayed load list.
+ */
+class AsyncImageLoader final
+{
+    public:
+        /**
+         * Requests loading of all images used by sprite.
+         *
+         * @param fileName sprite file name with optional dye palettes.
+         */
+        static void requestSprite(const std::string &fileName);
+
+        /**
+         * Requests loading of image. Path can contain dye.
+         */
+        static void requestImage(const std::string &idPath);
+
+        /**
+         * Returns true if all images of requested sprite was prepared,
+         * or if sprite was not requested.
+         */
+        static bool isSpriteReady(const std::string &fileName) A_WARN_UNUSED;
+
+        /**
+         * Creates image from prepared surface and passes its ownership to
+         * caller. Returns nullptr if image is not prepared yet.
+         */
+        static Image *takeImage(const std::string &idPath) A_WARN_UNUSED;
+
+        /**
+         * Queues images of parsed sprites and adds prepared images to
+         * resource manager. Must be called from main thread.
+         */
+        static void process();
+
+        /**
+         * Stops worker threads and drops all requests.
+         */
+        static void stop();
+
+        static void setEnabled(const bool b)
+        { mEnabled = b; }
+
+        static bool isEnabled() A_WARN_UNUSED
+        { return mEnabled; }
+
+    private:
+        static bool mEnabled;
+};
+
+#endif  // RESOURCES_ASYNCIMAGELOADER_H
@@ -0,0 +1,343 @@
+/*
+ *  The ManaPlus Client
+ *  Copyright (C) 2011-2014  The ManaPlus Developers
+ *
+ *  This file is part of The ManaPlus Client.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "main.h"
+
+#ifdef USE_OPENGL
+
+#include "resources/atlascache.h"
+
+#include "logger.h"
+
+#include "resources/atlasitem.h"
+#include "resources/imagehelper.h"
+#include "resources/imagewriter.h"
+#include "resources/textureatlas.h"
+
+#include "resources/db/palettedb.h"
+
+#include "utils/delete2.h"
+#include "utils/dtor.h"
+#include "utils/files.h"
+#include "utils/mkdir.h"
+#include "utils/physfstools.h"
+#include "utils/sdlcheckutils.h"
+#include "utils/stringutils.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <zlib.h>
+
+#include "debug.h"
+
+namespace
+{
+    const char cacheMagic[4] = {'M', 'P', 'A', 'T'};
+    const uint32_t cacheVersion = 1;
+    const uint32_t cacheByteOrder = 0x01020304;
+    // protection from broken files
+    const uint32_t maxStringSize = 4096;
+
+    struct CacheHeader final
+    {
+        char magic[4];
+        uint32_t version;
+        uint32_t byteOrder;
+        uint32_t pages;
+    };
+
+    struct CacheRect final
+    {
+        int32_t x;
+        int32_t y;
+        int32_t width;
+        int32_t height;
+    };
+
+    std::string mDir;
+    size_t mMaxSize = 0;
+}  // namespace
+
+static std::string getTableName(const std::string &key)
+{
+    return std::string(mDir).append("/").append(key).append(".atlas");
+}
+
+static std::string getPageName(const std::string &key, const size_t page)
+{
+    return std::string(mDir).append("/").append(key).append(
+        strprintf("_%u.png", static_cast<unsigned int>(page)));
+}
+
+static bool writeString(FILE *const file, const std::string &str)
+{
+    const uint32_t sz = static_cast<uint32_t>(str.size());
+    if (fwrite(&sz, sizeof(sz), 1, file) != 1)
+        return false;
+    return str.empty() || fwrite(str.c_str(), 1, sz, file) == sz;
+}
+
+static bool readString(FILE *const file, std::string &str)
+{
+    uint32_t sz = 0;
+    if (fread(&sz, sizeof(sz), 1, file) != 1 || sz > maxStringSize)
+        return false;
+    str.assign(sz, ' ');
+    return !sz || fread(&str[0], 1, sz, file) == sz;
+}
+
+static bool writeRect(FILE *const file,
+                      const int x, const int y,
+                      const int width, const int height)
+{
+    CacheRect rect;
+    rect.x = x;
+    rect.y = y;
+    rect.width = width;
+    rect.height = height;
+    return fwrite(&rect, sizeof(rect), 1, file) == 1;
+}
+
+static TextureAtlas *readAtlas(FILE *const file)
+{
+    CacheRect rect;
+    uint32_t count = 0;
+    TextureAtlas *const atlas = new TextureAtlas;
+    if (fread(&rect, sizeof(rect), 1, file) != 1
+        || !readString(file, atlas->name)
+        || fread(&count, sizeof(count), 1, file) != 1
+        || rect.width <= 0 || rect.height <= 0)
+    {
+        delete atlas;
+        return nullptr;
+    }
+    atlas->width = rect.width;
+    atlas->height = rect.height;
+
+    for (uint32_t f = 0; f < count; f ++)
+    {
+        std::string name;
+        if (fread(&rect, sizeof(rect), 1, file) != 1
+            || !readString(file, name)
+            || rect.x < 0 || rect.y < 0
+            || rect.x + rect.width > atlas->width
+            || rect.y + rect.height > atlas->height)
+        {
+            delete_all(atlas->items);
+            delete atlas;
+            return nullptr;
+        }
+        atlas->items.push_back(new AtlasItem(name,
+            rect.x, rect.y, rect.width, rect.height));
+    }
+    return atlas;
+}
+
+namespace AtlasCache
+{
+    void setDir(const std::string &dir,
+                const size_t maxSize)
+    {
+        mDir = dir;
+        mMaxSize = maxSize;
+        if (mDir.empty())
+            return;
+        if (mkdir_r(mDir.c_str()))
+        {
+            logger->log("Cant create atlas cache dir: %s", mDir.c_str());
+            mDir.clear();
+            return;
+        }
+        Files::limitDirSize(mDir, mMaxSize);
+    }
+
+    bool isEnabled()
+    {
+        return !mDir.empty();
+    }
+
+    std::string getKey(const std::string &name,
+                       const StringVect &files,
+                       const int size)
+    {
+        if (mDir.empty())
+            return std::string();
+
+        std::string str = strprintf("%s\n%d\n", name.c_str(), size);
+        bool palette = false;
+        FOR_EACH (StringVectCIter, it, files)
+        {
+            const std::string &file = *it;
+            const size_t pos = file.find('|');
+            const std::string path = file.substr(0, pos);
+            str.append(strprintf("%s\n%lld\n", file.c_str(),
+                static_cast<long long>(PhysFs::getLastModTime(
+                path.c_str()))));
+            if (pos != std::string::npos
+                && file.find('@', pos) != std::string::npos)
+            {
+                palette = true;
+            }
+        }
+        // colors from palette file can be changed
+        if (palette)
+            str.append(PaletteDB::getStamp());
+
+        const Bytef *const data = reinterpret_cast<const Bytef*>(
+            str.c_str());
+        const uInt sz = static_cast<uInt>(str.size());
+        const uLong adler = adler32(adler32(0L, Z_NULL, 0), data, sz);
+        const uLong crc = crc32(crc32(0L, Z_NULL, 0), data, sz);
+        return strprintf("%08x%08x",
+            static_cast<unsigned int>(adler),
+            static_cast<unsigned int>(crc));
+    }
+
+    bool load(const std::string &key,
+              std::vector<TextureAtlas*> &atlases,
+              std::vector<SDL_Surface*> &surfaces)
+    {
+        if (mDir.empty() || key.empty())
+            return false;
+
+        FILE *const file = fopen(getTableName(key).c_str(), "rb");
+        if (!file)
+            return false;
+
+        CacheHeader header;
+        bool ok = fread(&header, sizeof(header), 1, file) == 1
+            && !memcmp(header.magic, cacheMagic, 4)
+            && header.version == cacheVersion
+            && header.byteOrder == cacheByteOrder;
+        for (uint32_t f = 0; ok && f < header.pages; f ++)
+        {
+            TextureAtlas *const atlas = readAtlas(file);
+            if (!atlas)
+            {
+                ok = false;
+                break;
+            }
+            atlases.push_back(atlas);
+
+            SDL_RWops *const rw = SDL_RWFromFile(
+                getPageName(key, f).c_str(), "rb");
+            SDL_Surface *const surface = ImageHelper::loadPng(rw);
+            if (!surface)
+            {
+                ok = false;
+                break;
+            }
+            surfaces.push_back(surface);
+            if (surface->w != atlas->width || surface->h != atlas->height)
+                ok = false;
+        }
+        fclose(file);
+
+        if (!ok)
+        {
+            FOR_EACH (std::vector<TextureAtlas*>::iterator, it, atlases)
+            {
+                delete_all((*it)->items);
+                delete *it;
+            }
+            atlases.clear();
+            FOR_EACH (std::vector<SDL_Surface*>::iterator, it, surfaces)
+                MSDL_FreeSurface(*it);
+            surfaces.clear();
+            return false;
+        }
+
+        // mark as recently used for cache size limit
+        const size_t sz = surfaces.size();
+        for (size_t f = 0; f < sz; f ++)
+            Files::touchFile(getPageName(key, f));
+        Files::touchFile(getTableName(key));
+        return true;
+    }
+
+    void save(const std::string &key,
+              const std::vector<TextureAtlas*> &atlases,
+              const std::vector<SDL_Surface*> &surfaces)
+    {
+        if (mDir.empty() || key.empty() || atlases.size() != surfaces.size())
+            return;
+
+        const size_t sz = atlases.size();
+        for (size_t f = 0; f < sz; f ++)
+        {
+            const std::string name = getPageName(key, f);
+            const std::string tempName = name + ".tmp";
+            if (!ImageWriter::writePNG(surfaces[f], tempName)
+                || Files::renameFile(tempName, name))
+            {
+                ::remove(tempName.c_str());
+                return;
+            }
+        }
+
+        const std::string name = getTableName(key);
+        const std::string tempName = name + ".tmp";
+        FILE *const file = fopen(tempName.c_str(), "wb");
+        if (!file)
+            return;
+
+        CacheHeader header;
+        memcpy(header.magic, cacheMagic, 4);
+        header.version = cacheVersion;
+        header.byteOrder = cacheByteOrder;
+        header.pages = static_cast<uint32_t>(sz);
+        bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+
+        FOR_EACH (std::vector<TextureAtlas*>::const_iterator, it, atlases)
+        {
+            const TextureAtlas *const atlas = *it;
+            ok = ok
+                && writeRect(file, 0, 0, atlas->width, atlas->height)
+                && writeString(file, atlas->name);
+            const uint32_t count = static_cast<uint32_t>(
+                atlas->items.size());
+            ok = ok && fwrite(&count, sizeof(count), 1, file) == 1;
+            FOR_EACH (std::vector<AtlasItem*>::const_iterator,
+                      it2, atlas->items)
+            {
+                const AtlasItem *const item = *it2;
+                ok = ok
+                    && writeRect(file, item->x, item->y,
+                    item->width, item->height)
+                    && writeString(file, item->name);
+            }
+            if (!ok)
+                break;
+        }
+        fclose(file);
+
+        if (!ok || Files::renameFile(tempName, name))
+        {
+            ::remove(tempName.c_str());
+            return;
+        }
+        logger->log("Saved baked atlas %s", name.c_str());
+        // atlases saved rarely, so directory can be scanned on each save
+        Files::limitDirSize(mDir, mMaxSize);
+    }
+}  // namespace AtlasCache
+
+#endif  // USE_OPENGL
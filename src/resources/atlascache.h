@@ -0,0 +1,80 @@
+/*
+ *  The ManaPlus Client
+ *  Copyright (C) 2011-2014  The ManaPlus Developers
+ *
+ *  This file is part of The ManaPlus Client.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef RESOURCES_ATLASCACHE_H
+#define RESOURCES_ATLASCACHE_H
+
+#ifdef USE_OPENGL
+
+#include "utils/stringvector.h"
+
+#include <SDL_video.h>
+
+#include "localconsts.h"
+
+struct TextureAtlas;
+
+/**
+ * Disk cache of baked texture atlases.
+ *
+ * Each baked atlas stored as png page images and placement table.
+ * Table written last, so table existence means all pages was written.
+ * Total size of cache files limited, least recently used files
+ * removed first.
+ */
+namespace AtlasCache
+{
+    /**
+     * Sets directory for cache files and limit for their total size.
+     * Empty directory disables cache.
+     */
+    void setDir(const std::string &dir,
+                const size_t maxSize);
+
+    bool isEnabled() A_WARN_UNUSED;
+
+    /**
+     * Returns cache key for atlas built from files.
+     * Key depends on file names, their modification times and texture size.
+     */
+    std::string getKey(const std::string &name,
+                       const StringVect &files,
+                       const int size) A_WARN_UNUSED;
+
+    /**
+     * Loads baked atlases and their page surfaces.
+     * Atlas items created without images.
+     *
+     * @return true if atlases was loaded.
+     */
+    bool load(const std::string &key,
+              std::vector<TextureAtlas*> &atlases,
+              std::vector<SDL_Surface*> &surfaces) A_WARN_UNUSED;
+
+    /**
+     * Saves atlases with their page surfaces.
+     */
+    void save(const std::string &key,
+              const std::vector<TextureAtlas*> &atlases,
+              const std::vector<SDL_Surface*> &surfaces);
+}  // namespace AtlasCache
+
+#endif  // USE_OPENGL
+#endif  // RESOURCES_ATLASCACHE_H
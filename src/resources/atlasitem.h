@@ -39,6 +39,18 @@ struct AtlasItem final
     {
     }
 
+    AtlasItem(const std::string &name0,
+              const int x0, const int y0,
+              const int width0, const int height0) :
+        image(nullptr),
+        name(name0),
+        x(x0),
+        y(y0),
+        width(width0),
+        height(height0)
+    {
+    }
+
     A_DELETE_COPY(AtlasItem)
 
     Image *image;
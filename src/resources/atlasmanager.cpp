@@ -26,15 +26,17 @@
 
 #include "settings.h"
 
-#ifdef DEBUG_IMAGES
+#include "configuration.h"
 #include "logger.h"
-#endif
 
+#include "utils/dtor.h"
 #include "utils/mathutils.h"
 #include "utils/physfscheckutils.h"
 #include "utils/physfsrwops.h"
 #include "utils/sdlcheckutils.h"
+#include "utils/stringutils.h"
 
+#include "resources/atlascache.h"
 #include "resources/atlasitem.h"
 #include "resources/atlasresource.h"
 #include "resources/dye.h"
@@ -44,8 +46,108 @@
 #include "resources/sdlimagehelper.h"
 #include "resources/textureatlas.h"
 
+#include <algorithm>
+
 #include "debug.h"
 
+namespace
+{
+    struct SkylineNode final
+    {
+        int x;
+        int y;
+        int width;
+    };
+
+    struct SkylinePage final
+    {
+        SkylinePage() :
+            atlas(nullptr),
+            nodes()
+        {
+        }
+
+        TextureAtlas *atlas;
+        std::vector<SkylineNode> nodes;
+    };
+
+    struct ImageHeightSorter final
+    {
+        bool operator() (const Image *const image1,
+                         const Image *const image2) const
+        {
+            if (image1->mBounds.h != image2->mBounds.h)
+                return image1->mBounds.h > image2->mBounds.h;
+            return image1->mBounds.w > image2->mBounds.w;
+        }
+    } imageHeightSorter;
+}  // namespace
+
+static int skylineFit(const std::vector<SkylineNode> &nodes,
+                      const size_t index,
+                      const int width, const int height,
+                      const int size)
+{
+    const int x = nodes[index].x;
+    if (x + width > size)
+        return -1;
+
+    int y = nodes[index].y;
+    int widthLeft = width;
+    const size_t sz = nodes.size();
+    for (size_t f = index; widthLeft > 0 && f < sz; f ++)
+    {
+        const SkylineNode &node = nodes[f];
+        if (node.y > y)
+            y = node.y;
+        if (y + height > size)
+            return -1;
+        widthLeft -= node.width;
+    }
+    return y;
+}
+
+static void skylinePlace(std::vector<SkylineNode> &nodes,
+                         const size_t index,
+                         const int x, const int y,
+                         const int width, const int height)
+{
+    SkylineNode newNode;
+    newNode.x = x;
+    newNode.y = y + height;
+    newNode.width = width;
+    nodes.insert(nodes.begin() + index, newNode);
+
+    // cut nodes covered by new node
+    for (size_t f = index + 1; f < nodes.size(); )
+    {
+        const SkylineNode &prev = nodes[f - 1];
+        SkylineNode &node = nodes[f];
+        const int shrink = prev.x + prev.width - node.x;
+        if (shrink <= 0)
+            break;
+        node.x += shrink;
+        node.width -= shrink;
+        if (node.width > 0)
+            break;
+        nodes.erase(nodes.begin() + f);
+    }
+
+    // merge nodes with same height
+    for (size_t f = 1; f < nodes.size(); )
+    {
+        if (nodes[f - 1].y == nodes[f].y)
+        {
+            nodes[f - 1].width += nodes[f].width;
+            nodes.erase(nodes.begin() + f);
+        }
+        else
+        {
+            f ++;
+        }
+    }
+}
+
 AtlasManager::AtlasManager()
 {
 }
@@ -58,7 +160,6 @@ AtlasResource *AtlasManager::loadTextureAtlas(const std::string &name,
     std::vector<Image*> images;
     AtlasResource *resource = new AtlasResource;
 
-    loadImages(files, images);
     int maxSize = OpenGLImageHelper::getTextureSize();
 #if !defined(ANDROID) && !defined(__APPLE__)
     int sz = settings.textureSize;
@@ -66,9 +167,28 @@ AtlasResource *AtlasManager::loadTextureAtlas(const std::string &name,
         maxSize = sz;
 #endif
 
+    const AtlasPacker packer = static_cast<AtlasPacker>(
+        config.getValue("atlasPacker", PACKER_SKYLINE));
+    const std::string key = AtlasCache::getKey(
+        strprintf("%s|%d", name.c_str(), static_cast<int>(packer)),
+        files, maxSize);
+    if (loadBakedAtlas(key, files, resource))
+    {
+        logger->log("Loaded baked atlas %s: %s", name.c_str(),
+            getStatistics(resource).c_str());
+        BLOCK_END("AtlasManager::loadTextureAtlas")
+        return resource;
+    }
+
+    loadImages(files, images);
+
     // sorting images on atlases.
-    simpleSort(name, atlases, images, maxSize);
+    if (packer == PACKER_SKYLINE)
+        skylineSort(name, atlases, images, maxSize);
+    else
+        simpleSort(name, atlases, images, maxSize);
 
+    std::vector<SDL_Surface*> surfaces;
     FOR_EACH (std::vector<TextureAtlas*>::iterator, it, atlases)
     {
         TextureAtlas *const atlas = *it;
@@ -81,43 +201,91 @@ AtlasResource *AtlasManager::loadTextureAtlas(const std::string &name,
         if (!surface)
             continue;
 
-        // debug save
-//        ImageWriter::writePNG(surface, settings.tempDir
-//            + "/atlas" + name + toString(k) + ".png");
-//        k ++;
-
         // convert SDL images to OpenGL
         convertAtlas(atlas);
 
-        // free SDL atlas surface
-        MSDL_FreeSurface(surface);
-
         resource->atlases.push_back(atlas);
+        surfaces.push_back(surface);
     }
 
+    // bake atlases for next loads
+    if (!key.empty())
+        AtlasCache::save(key, resource->atlases, surfaces);
+
+    // free SDL atlas surfaces
+    FOR_EACH (std::vector<SDL_Surface*>::iterator, it, surfaces)
+        MSDL_FreeSurface(*it);
+
+    logger->log("Created atlas %s: %s", name.c_str(),
+        getStatistics(resource).c_str());
+
     BLOCK_END("AtlasManager::loadTextureAtlas")
     return resource;
 }
 
-void AtlasManager::loadImages(const StringVect &files,
-                              std::vector<Image*> &images)
+bool AtlasManager::loadBakedAtlas(const std::string &key,
+                                  const StringVect &files,
+                                  AtlasResource *const resource)
 {
-    BLOCK_START("AtlasManager::loadImages")
-    ResourceManager *const resman = ResourceManager::getInstance();
+    if (key.empty())
+        return false;
+
+    BLOCK_START("AtlasManager::loadBakedAtlas")
+    std::vector<TextureAtlas*> atlases;
+    std::vector<SDL_Surface*> surfaces;
+    if (!AtlasCache::load(key, atlases, surfaces))
+    {
+        BLOCK_END("AtlasManager::loadBakedAtlas")
+        return false;
+    }
 
+    removeCachedImages(files);
+
+    const size_t sz = atlases.size();
+    for (size_t f = 0; f < sz; f ++)
+    {
+        TextureAtlas *const atlas = atlases[f];
+        atlas->atlasImage = imageHelper->load(surfaces[f]);
+        MSDL_FreeSurface(surfaces[f]);
+        if (!atlas->atlasImage)
+        {
+            delete_all(atlas->items);
+            delete atlas;
+            continue;
+        }
+        convertAtlas(atlas);
+        resource->atlases.push_back(atlas);
+    }
+    BLOCK_END("AtlasManager::loadBakedAtlas")
+    return true;
+}
+
+void AtlasManager::removeCachedImages(const StringVect &files)
+{
+    ResourceManager *const resman = ResourceManager::getInstance();
     FOR_EACH (StringVectCIter, it, files)
     {
-        const std::string str = *it;
         // check is image with same name already in cache
         // and if yes, move it to deleted set
-        Resource *const res = resman->getTempResource(str);
+        Resource *const res = resman->getTempResource(*it);
         if (res)
         {
             // increase counter because in moveToDeleted it will be decreased.
             res->incRef();
             resman->moveToDeleted(res);
         }
+    }
+}
+
+void AtlasManager::loadImages(const StringVect &files,
+                              std::vector<Image*> &images)
+{
+    BLOCK_START("AtlasManager::loadImages")
+    removeCachedImages(files);
 
+    FOR_EACH (StringVectCIter, it, files)
+    {
+        const std::string str = *it;
         std::string path = str;
         const size_t p = path.find('|');
         Dye *d = nullptr;
@@ -219,6 +387,95 @@ void AtlasManager::simpleSort(const std::string &restrict name,
     BLOCK_END("AtlasManager::simpleSort")
 }
 
+void AtlasManager::skylineSort(const std::string &restrict name,
+                               std::vector<TextureAtlas*> &restrict atlases,
+                               const std::vector<Image*> &restrict images,
+                               int size)
+{
+    BLOCK_START("AtlasManager::skylineSort")
+    std::vector<Image*> sorted;
+    sorted.reserve(images.size());
+    FOR_EACH (std::vector<Image*>::const_iterator, it, images)
+    {
+        if (*it)
+            sorted.push_back(*it);
+    }
+    // tall images first gives flat skyline for small images
+    std::stable_sort(sorted.begin(), sorted.end(), imageHeightSorter);
+
+    std::vector<SkylinePage> pages;
+    FOR_EACH (std::vector<Image*>::const_iterator, it, sorted)
+    {
+        Image *const img = *it;
+        const int width = img->mBounds.w;
+        const int height = img->mBounds.h;
+
+        // search lowest position in all pages
+        SkylinePage *bestPage = nullptr;
+        size_t bestIndex = 0;
+        int bestY = 0;
+        int bestBottom = size + 1;
+        int bestWidth = 0;
+        FOR_EACH (std::vector<SkylinePage>::iterator, it2, pages)
+        {
+            SkylinePage &page = *it2;
+            const size_t sz = page.nodes.size();
+            for (size_t f = 0; f < sz; f ++)
+            {
+                const int y = skylineFit(page.nodes, f, width, height, size);
+                if (y < 0)
+                    continue;
+                const int nodeWidth = page.nodes[f].width;
+                if (y + height < bestBottom || (y + height == bestBottom
+                    && nodeWidth < bestWidth))
+                {
+                    bestPage = &page;
+                    bestIndex = f;
+                    bestY = y;
+                    bestBottom = y + height;
+                    bestWidth = nodeWidth;
+                }
+            }
+        }
+
+        if (!bestPage)
+        {
+            // too big images also placed on own page like in simpleSort
+            SkylinePage page;
+            page.atlas = new TextureAtlas();
+            page.atlas->name = std::string("atlas_").append(name).append(
+                "_").append(img->getIdPath());
+            SkylineNode node;
+            node.x = 0;
+            node.y = 0;
+            node.width = size;
+            page.nodes.push_back(node);
+            pages.push_back(page);
+            bestPage = &pages.back();
+            bestIndex = 0;
+            bestY = 0;
+        }
+
+        const int x = bestPage->nodes[bestIndex].x;
+        skylinePlace(bestPage->nodes, bestIndex, x, bestY, width, height);
+
+        AtlasItem *const item = new AtlasItem(img);
+        item->name = img->getIdPath();
+        item->x = x;
+        item->y = bestY;
+        TextureAtlas *const atlas = bestPage->atlas;
+        atlas->items.push_back(item);
+        if (x + width > atlas->width)
+            atlas->width = x + width;
+        if (bestY + height > atlas->height)
+            atlas->height = bestY + height;
+    }
+
+    FOR_EACH (std::vector<SkylinePage>::const_iterator, it, pages)
+        atlases.push_back((*it).atlas);
+    BLOCK_END("AtlasManager::skylineSort")
+}
+
 SDL_Surface *AtlasManager::createSDLAtlas(TextureAtlas *const atlas)
 {
     BLOCK_START("AtlasManager::createSDLAtlas")
@@ -258,18 +515,28 @@ SDL_Surface *AtlasManager::createSDLAtlas(TextureAtlas *const atlas)
     }
     BLOCK_END("AtlasManager::createSDLAtlas create surface")
 
-    Image *image = imageHelper->load(surface);
-
     // drawing SDL images to surface
     FOR_EACH (std::vector<AtlasItem*>::iterator, it, atlas->items)
     {
         AtlasItem *const item = *it;
-        if (image)
-        {
-            imageHelper->copySurfaceToImage(image, item->x, item->y,
-                item->image->mSDLSurface);
-        }
+        SDL_Surface *const src = item->image->mSDLSurface;
+        if (!src)
+            continue;
+#ifdef USE_SDL2
+        SDL_SetSurfaceAlphaMod(src, SDL_ALPHA_OPAQUE);
+        SDL_SetSurfaceBlendMode(src, SDL_BLENDMODE_NONE);
+#else
+        // copy alpha channel to atlas instead of blending
+        SDL_SetAlpha(src, 0, SDL_ALPHA_OPAQUE);
+#endif
+        SDL_Rect rect;
+        rect.x = static_cast<int16_t>(item->x);
+        rect.y = static_cast<int16_t>(item->y);
+        SDL_BlitSurface(src, nullptr, surface, &rect);
     }
+
+    // upload whole atlas at once
+    Image *const image = imageHelper->load(surface);
     atlas->atlasImage = image;
     BLOCK_END("AtlasManager::createSDLAtlas")
     return surface;
@@ -319,6 +586,35 @@ void AtlasManager::convertAtlas(TextureAtlas *const atlas)
     }
 }
 
+std::string AtlasManager::getStatistics(const AtlasResource *const resource)
+{
+    if (!resource)
+        return std::string();
+
+    std::string str = strprintf("pages: %u",
+        static_cast<unsigned int>(resource->atlases.size()));
+    FOR_EACH (std::vector<TextureAtlas*>::const_iterator,
+              it, resource->atlases)
+    {
+        const TextureAtlas *const atlas = *it;
+        if (!atlas || atlas->width <= 0 || atlas->height <= 0)
+            continue;
+        unsigned int area = 0;
+        FOR_EACH (std::vector<AtlasItem*>::const_iterator,
+                  it2, atlas->items)
+        {
+            const AtlasItem *const item = *it2;
+            area += item->width * item->height;
+        }
+        str.append(strprintf(", %dx%d %u items %d%%",
+            atlas->width, atlas->height,
+            static_cast<unsigned int>(atlas->items.size()),
+            static_cast<int>(static_cast<double>(area) * 100.0
+            / (static_cast<double>(atlas->width) * atlas->height))));
+    }
+    return str;
+}
+
 void AtlasManager::injectToResources(const AtlasResource *const resource)
 {
     ResourceManager *const resman = ResourceManager::getInstance();
@@ -35,6 +35,12 @@ class Resource;
 struct AtlasItem;
 struct TextureAtlas;
 
+enum AtlasPacker
+{
+    PACKER_SIMPLE = 0,
+    PACKER_SKYLINE = 1
+};
+
 class AtlasManager final
 {
     public:
@@ -50,7 +56,19 @@ class AtlasManager final
 
         static void moveToDeleted(AtlasResource *const resource);
 
+        /**
+         * Returns page count and per page size and occupancy.
+         */
+        static std::string getStatistics(const AtlasResource *const resource)
+                                         A_WARN_UNUSED;
+
     private:
+        static bool loadBakedAtlas(const std::string &key,
+                                   const StringVect &files,
+                                   AtlasResource *const resource);
+
+        static void removeCachedImages(const StringVect &files);
+
         static void loadImages(const StringVect &files,
                                std::vector<Image*> &images);
 
@@ -59,6 +77,11 @@ class AtlasManager final
                                const std::vector<Image*> &restrict images,
                                int size);
 
+        static void skylineSort(const std::string &restrict name,
+                                std::vector<TextureAtlas*> &restrict atlases,
+                                const std::vector<Image*> &restrict images,
+                                int size);
+
         static SDL_Surface *createSDLAtlas(TextureAtlas *const atlas)
                                            A_WARN_UNUSED;
 
@@ -59,6 +59,23 @@ AtlasResource::~AtlasResource()
     resman->clearDeleted(false);
 }
 
+size_t AtlasResource::getMemoryUsage() const
+{
+    // atlas images not stored in resource manager and owned by atlases
+    size_t sz = Resource::getMemoryUsage() + sizeof(AtlasResource)
+        - sizeof(Resource);
+    FOR_EACH (std::vector<TextureAtlas*>::const_iterator, it, atlases)
+    {
+        const TextureAtlas *const atlas = *it;
+        if (!atlas)
+            continue;
+        if (atlas->atlasImage)
+            sz += atlas->atlasImage->getMemoryUsage();
+        sz += atlas->items.size() * sizeof(AtlasItem);
+    }
+    return sz;
+}
+
 void AtlasResource::incRef()
 {
     if (!getRefCount())
@@ -46,6 +46,8 @@ class AtlasResource final : public Resource
 
         void decRef() override final;
 
+        size_t getMemoryUsage() const override final A_WARN_UNUSED;
+
         std::vector<TextureAtlas*> atlases;
 };
 
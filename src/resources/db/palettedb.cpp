@@ -23,18 +23,22 @@
 #include "logger.h"
 
 #include "utils/files.h"
+#include "utils/stringutils.h"
 
 #include "resources/dyecolor.h"
 
 #include <map>
+#include <zlib.h>
 
 #include "debug.h"
 
 namespace
 {
     bool mLoaded = false;
-    std::map<std::string, DyeColor> mColors;
+    typedef std::map<std::string, DyeColor> Colors;
+    Colors mColors;
     DyeColor mEmpty(0, 0, 0, 0);
+    std::string mStamp;
 }
 
 void PaletteDB::load()
@@ -106,11 +110,27 @@ void PaletteDB::loadPalette()
         }
 #endif
     }
+
+    std::string str;
+    FOR_EACH (Colors::const_iterator, it, mColors)
+    {
+        const DyeColor &color = (*it).second;
+        str.append(strprintf("%s %u %u %u\n", (*it).first.c_str(),
+            static_cast<unsigned int>(color.value[0]),
+            static_cast<unsigned int>(color.value[1]),
+            static_cast<unsigned int>(color.value[2])));
+    }
+    const uLong crc = crc32(crc32(0L, Z_NULL, 0),
+        reinterpret_cast<const Bytef*>(str.c_str()),
+        static_cast<uInt>(str.size()));
+    mStamp = strprintf("%08x%u", static_cast<unsigned int>(crc),
+        static_cast<unsigned int>(mColors.size()));
 }
 
 void PaletteDB::unload()
 {
     mColors.clear();
+    mStamp.clear();
 }
 
 const DyeColor &PaletteDB::getColor(const std::string &name)
@@ -121,3 +141,8 @@ const DyeColor &PaletteDB::getColor(const std::string &name)
     else
         return mEmpty;
 }
+
+const std::string &PaletteDB::getStamp()
+{
+    return mStamp;
+}
@@ -34,6 +34,12 @@ namespace PaletteDB
     void loadPalette();
     const DyeColor &getColor(const std::string &name);
 
+    /**
+     * Returns checksum of loaded colors, for caches of images dyed
+     * with palette colors.
+     */
+    const std::string &getStamp();
+
 }  // namespace PaletteDB
 
 #endif  // RESOURCES_DB_PALETTEDB_H
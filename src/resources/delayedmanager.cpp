@@ -22,6 +22,8 @@
 
 #include "animationdelayload.h"
 
+#include "resources/asyncimageloader.h"
+
 #include "utils/timer.h"
 
 #include "debug.h"
@@ -31,6 +33,8 @@ DelayedAnim DelayedManager::mDelayedAnimations;
 void DelayedManager::delayedLoad()
 {
     BLOCK_START("DelayedManager::delayedLoad")
+    AsyncImageLoader::process();
+
     static int loadTime = 0;
     if (loadTime < cur_time)
     {
@@ -41,8 +45,13 @@ void DelayedManager::delayedLoad()
         const DelayedAnimIter it_end = mDelayedAnimations.end();
         while (it != it_end && k < 1)
         {
-            (*it)->load();
             AnimationDelayLoad *tmp = *it;
+            if (!tmp->isReady())
+            {
+                ++ it;
+                continue;
+            }
+            tmp->load();
             it = mDelayedAnimations.erase(it);
             delete tmp;
             k ++;
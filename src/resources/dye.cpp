@@ -26,12 +26,17 @@
 
 #include "resources/dyepalette.h"
 
+#include "utils/cpu.h"
 #include "utils/delete2.h"
 
 #include <sstream>
 
 #include <SDL_endian.h>
 
+#ifdef SIMD_SUPPORTED
+#include <emmintrin.h>
+#endif
+
 #include "debug.h"
 
 Dye::Dye(const std::string &description)
@@ -148,39 +153,38 @@ int Dye::getType() const
     return 0;
 }
 
-void Dye::normalDye(uint32_t *restrict pixels, const int bufSize) const
+/**
+ * Dyes pure colors using precalculated palette colors.
+ * Shifts are positions of red, green and blue channels in pixel.
+ */
+static void dyePixels(uint32_t *restrict pixels,
+                      const int bufSize,
+                      const uint8_t *const *const tables,
+                      const unsigned int shift0,
+                      const unsigned int shift1,
+                      const unsigned int shift2,
+                      const uint32_t alphaMask)
 {
     for (uint32_t *p_end = pixels + static_cast<size_t>(bufSize);
          pixels != p_end;
          ++ pixels)
     {
         const uint32_t p = *pixels;
-#if SDL_BYTEORDER == SDL_BIG_ENDIAN
-        const int alpha = p & 0xff000000;
-#else
-        const int alpha = p & 0xff;
-#endif
-        if (!alpha)
+        if (!(p & alphaMask))
             continue;
-        unsigned int color[3];
-#if SDL_BYTEORDER == SDL_BIG_ENDIAN
-        color[0] = (p) & 255U;
-        color[1] = (p >> 8U) & 255U;
-        color[2] = (p >> 16U) & 255U;
-#else
-        color[0] = (p >> 24U) & 255U;
-        color[1] = (p >> 16U) & 255U;
-        color[2] = (p >> 8U) & 255U;
-#endif
+
+        const unsigned int color0 = (p >> shift0) & 255U;
+        const unsigned int color1 = (p >> shift1) & 255U;
+        const unsigned int color2 = (p >> shift2) & 255U;
 
         const unsigned int cmax = std::max(
-            color[0], std::max(color[1], color[2]));
+            color0, std::max(color1, color2));
         if (cmax == 0)
             continue;
 
         const unsigned int cmin = std::min(
-            color[0], std::min(color[1], color[2]));
-        const unsigned int intensity = color[0] + color[1] + color[2];
+            color0, std::min(color1, color2));
+        const unsigned int intensity = color0 + color1 + color2;
 
         if (cmin != cmax && (cmin != 0 || (intensity != cmax
             && intensity != 2 * cmax)))
@@ -189,75 +193,143 @@ void Dye::normalDye(uint32_t *restrict pixels, const int bufSize) const
             continue;
         }
 
-        const unsigned int i = (color[0] != 0) | ((color[1] != 0) << 1)
-            | ((color[2] != 0) << 2);
-
-        if (mDyePalettes[i - 1])
-            mDyePalettes[i - 1]->getColor(cmax, color);
+        const unsigned int i = (color0 != 0) | ((color1 != 0) << 1)
+            | ((color2 != 0) << 2);
 
-#if SDL_BYTEORDER == SDL_BIG_ENDIAN
-        *pixels = (color[0]) | (color[1] << 8)
-            | (color[2] << 16) | alpha;
-#else
-        *pixels = (color[0] << 24) | (color[1] << 16)
-            | (color[2] << 8) | alpha;
-#endif
+        const uint8_t *const table = tables[i - 1];
+        if (!table)
+            continue;
+        const uint8_t *const color = table + cmax * 3;
+        *pixels = (color[0] << shift0) | (color[1] << shift1)
+            | (color[2] << shift2) | (p & alphaMask);
     }
 }
 
-void Dye::normalOGLDye(uint32_t *restrict pixels, const int bufSize) const
+#ifdef SIMD_SUPPORTED
+__attribute__ ((target ("sse2")))
+static void dyePixelsSse2(uint32_t *restrict pixels,
+                          const int bufSize,
+                          const uint8_t *const *const tables,
+                          const unsigned int shift0,
+                          const unsigned int shift1,
+                          const unsigned int shift2,
+                          const uint32_t alphaMask)
 {
-    for (uint32_t *p_end = pixels + static_cast<size_t>(bufSize);
-         pixels != p_end;
-         ++ pixels)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi32(1);
+    const __m128i byteMask = _mm_set1_epi32(255);
+    const __m128i alphaMaskV = _mm_set1_epi32(static_cast<int>(alphaMask));
+    const __m128i count0 = _mm_cvtsi32_si128(static_cast<int>(shift0));
+    const __m128i count1 = _mm_cvtsi32_si128(static_cast<int>(shift1));
+    const __m128i count2 = _mm_cvtsi32_si128(static_cast<int>(shift2));
+    int cmaxs[4];
+    int idxs[4];
+
+    int f = 0;
+    for (; f + 4 <= bufSize; f += 4)
     {
-        const uint32_t p = *pixels;
-#if SDL_BYTEORDER == SDL_BIG_ENDIAN
-        const int alpha = p & 255;
-#else
-        const int alpha = p & 0xff000000;
-#endif
-        if (!alpha)
+        const __m128i p = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(&pixels[f]));
+        const __m128i color0 = _mm_and_si128(_mm_srl_epi32(p, count0),
+            byteMask);
+        const __m128i color1 = _mm_and_si128(_mm_srl_epi32(p, count1),
+            byteMask);
+        const __m128i color2 = _mm_and_si128(_mm_srl_epi32(p, count2),
+            byteMask);
+
+        // channels fit to low 16 bits, so 16 bit min and max is enough
+        const __m128i cmax = _mm_max_epi16(color0,
+            _mm_max_epi16(color1, color2));
+        const __m128i cmin = _mm_min_epi16(color0,
+            _mm_min_epi16(color1, color2));
+        const __m128i intensity = _mm_add_epi32(color0,
+            _mm_add_epi32(color1, color2));
+
+        const __m128i pure = _mm_or_si128(_mm_cmpeq_epi32(cmin, cmax),
+            _mm_and_si128(_mm_cmpeq_epi32(cmin, zero),
+            _mm_or_si128(_mm_cmpeq_epi32(intensity, cmax),
+            _mm_cmpeq_epi32(intensity, _mm_add_epi32(cmax, cmax)))));
+        const __m128i skip = _mm_or_si128(
+            _mm_cmpeq_epi32(_mm_and_si128(p, alphaMaskV), zero),
+            _mm_cmpeq_epi32(cmax, zero));
+        const int mask = _mm_movemask_ps(_mm_castsi128_ps(
+            _mm_andnot_si128(skip, pure)));
+        if (!mask)
             continue;
-        unsigned int color[3];
-#if SDL_BYTEORDER == SDL_BIG_ENDIAN
-        color[0] = (p >> 24U) & 255U;
-        color[1] = (p >> 16U) & 255U;
-        color[2] = (p >> 8U) & 255U;
-#else
-        color[0] = (p) & 255U;
-        color[1] = (p >> 8U) & 255U;
-        color[2] = (p >> 16U) & 255U;
-#endif
 
-        const unsigned int cmax = std::max(
-            color[0], std::max(color[1], color[2]));
-        if (cmax == 0)
-            continue;
+        const __m128i idx = _mm_or_si128(
+            _mm_andnot_si128(_mm_cmpeq_epi32(color0, zero), one),
+            _mm_or_si128(_mm_slli_epi32(_mm_andnot_si128(
+            _mm_cmpeq_epi32(color1, zero), one), 1),
+            _mm_slli_epi32(_mm_andnot_si128(
+            _mm_cmpeq_epi32(color2, zero), one), 2)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(cmaxs), cmax);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(idxs), idx);
 
-        const unsigned int cmin = std::min(
-            color[0], std::min(color[1], color[2]));
-        const unsigned int intensity = color[0] + color[1] + color[2];
-
-        if (cmin != cmax && (cmin != 0 || (intensity != cmax
-            && intensity != 2 * cmax)))
+        for (int k = 0; k < 4; k ++)
         {
-            // not pure
-            continue;
+            if (!(mask & (1 << k)))
+                continue;
+            const uint8_t *const table = tables[idxs[k] - 1];
+            if (!table)
+                continue;
+            const uint8_t *const color = table + cmaxs[k] * 3;
+            uint32_t &pixel = pixels[f + k];
+            pixel = (color[0] << shift0) | (color[1] << shift1)
+                | (color[2] << shift2) | (pixel & alphaMask);
         }
+    }
+    if (f < bufSize)
+    {
+        dyePixels(pixels + f, bufSize - f, tables,
+            shift0, shift1, shift2, alphaMask);
+    }
+}
+#endif
+
+void Dye::getTables(const uint8_t **const tables) const
+{
+    for (int f = 0; f < 7; f ++)
+    {
+        const DyePalette *const palette = mDyePalettes[f];
+        tables[f] = palette ? palette->getIntensityColors() : nullptr;
+    }
+}
 
-        const unsigned int i = (color[0] != 0) | ((color[1] != 0) << 1)
-            | ((color[2] != 0) << 2);
+void Dye::dye(uint32_t *restrict pixels,
+              const int bufSize,
+              const unsigned int shift0,
+              const unsigned int shift1,
+              const unsigned int shift2,
+              const uint32_t alphaMask) const
+{
+    const uint8_t *tables[7];
+    getTables(tables);
+#ifdef SIMD_SUPPORTED
+    if (Cpu::getFlags() & Cpu::FEATURE_SSE2)
+    {
+        dyePixelsSse2(pixels, bufSize, tables,
+            shift0, shift1, shift2, alphaMask);
+        return;
+    }
+#endif
+    dyePixels(pixels, bufSize, tables, shift0, shift1, shift2, alphaMask);
+}
 
-        if (mDyePalettes[i - 1])
-            mDyePalettes[i - 1]->getColor(cmax, color);
+void Dye::normalDye(uint32_t *restrict pixels, const int bufSize) const
+{
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+    dye(pixels, bufSize, 0U, 8U, 16U, 0xff000000);
+#else
+    dye(pixels, bufSize, 24U, 16U, 8U, 0x000000ff);
+#endif
+}
 
+void Dye::normalOGLDye(uint32_t *restrict pixels, const int bufSize) const
+{
 #if SDL_BYTEORDER == SDL_BIG_ENDIAN
-        *pixels = (color[0] << 24) | (color[1] << 16)
-            | (color[2] << 8) | alpha;
+    dye(pixels, bufSize, 24U, 16U, 8U, 0x000000ff);
 #else
-        *pixels = (color[0]) | (color[1] << 8)
-            | (color[2] << 16) | alpha;
+    dye(pixels, bufSize, 0U, 8U, 16U, 0xff000000);
 #endif
-    }
 }
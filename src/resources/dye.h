@@ -82,6 +82,15 @@ class Dye final
         void normalOGLDye(uint32_t *restrict pixels, const int bufSize) const;
 
     private:
+        void getTables(const uint8_t **const tables) const;
+
+        void dye(uint32_t *restrict pixels,
+                 const int bufSize,
+                 const unsigned int shift0,
+                 const unsigned int shift1,
+                 const unsigned int shift2,
+                 const uint32_t alphaMask) const;
+
         /**
          * The order of the palettes, as well as their uppercase letter, is:
          *
@@ -18,12 +18,22 @@
  *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include "logger.h"
+
 #include "resources/dye.h"
 
 #include "resources/dyepalette.h"
 
+#include "utils/cpu.h"
+#include "utils/stringutils.h"
+
 #include "gtest/gtest.h"
 
+#include <SDL_endian.h>
+
+#include <stdlib.h>
+#include <vector>
+
 #include "debug.h"
 
 TEST(Dye, replaceSOGLColor1)
@@ -253,3 +263,364 @@ TEST(Dye, normalOGLDye1)
     EXPECT_EQ(0x2a, data[2]);
     EXPECT_EQ(0x50, data[3]);
 }
+
+// reference implementations used for checking optimized dye code
+
+static void refNormalDye(const DyePalette *const *const palettes,
+                         uint32_t *pixels,
+                         const int bufSize,
+                         const bool ogl)
+{
+    for (uint32_t *p_end = pixels + static_cast<size_t>(bufSize);
+         pixels != p_end;
+         ++ pixels)
+    {
+        const uint32_t p = *pixels;
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+        const int alpha = ogl ? p & 255 : p & 0xff000000;
+#else
+        const int alpha = ogl ? p & 0xff000000 : p & 0xff;
+#endif
+        if (!alpha)
+            continue;
+        unsigned int color[3];
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+        const bool high = ogl;
+#else
+        const bool high = !ogl;
+#endif
+        if (high)
+        {
+            color[0] = (p >> 24U) & 255U;
+            color[1] = (p >> 16U) & 255U;
+            color[2] = (p >> 8U) & 255U;
+        }
+        else
+        {
+            color[0] = (p) & 255U;
+            color[1] = (p >> 8U) & 255U;
+            color[2] = (p >> 16U) & 255U;
+        }
+
+        const unsigned int cmax = std::max(
+            color[0], std::max(color[1], color[2]));
+        if (cmax == 0)
+            continue;
+
+        const unsigned int cmin = std::min(
+            color[0], std::min(color[1], color[2]));
+        const unsigned int intensity = color[0] + color[1] + color[2];
+
+        if (cmin != cmax && (cmin != 0 || (intensity != cmax
+            && intensity != 2 * cmax)))
+        {
+            continue;
+        }
+
+        const unsigned int i = (color[0] != 0) | ((color[1] != 0) << 1)
+            | ((color[2] != 0) << 2);
+
+        if (palettes[i - 1])
+            palettes[i - 1]->getColor(cmax, color);
+
+        if (high)
+        {
+            *pixels = (color[0] << 24) | (color[1] << 16)
+                | (color[2] << 8) | alpha;
+        }
+        else
+        {
+            *pixels = (color[0]) | (color[1] << 8)
+                | (color[2] << 16) | alpha;
+        }
+    }
+}
+
+static void refReplaceColor(const std::vector<DyeColor> &colors,
+                            uint32_t *pixels,
+                            const int bufSize,
+                            const bool ogl,
+                            const bool useAlpha)
+{
+    std::vector<DyeColor>::const_iterator it_end = colors.end();
+    const size_t sz = colors.size();
+    if (!sz)
+        return;
+    if (sz % 2)
+        -- it_end;
+
+    for (uint32_t *p_end = pixels + static_cast<size_t>(bufSize);
+         pixels != p_end;
+         ++pixels)
+    {
+        uint8_t *const p = reinterpret_cast<uint8_t *>(pixels);
+        unsigned int data = *pixels;
+        if (!useAlpha)
+        {
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+            const int alpha = ogl ? *p & 0xff : *pixels & 0xff000000;
+            data &= ogl ? 0xffffff00 : 0x00ffffff;
+#else
+            const int alpha = ogl ? *pixels & 0xff000000 : *p & 0xff;
+            data &= ogl ? 0x00ffffff : 0xffffff00;
+#endif
+            if (!alpha)
+                continue;
+        }
+
+        std::vector<DyeColor>::const_iterator it = colors.begin();
+        while (it != it_end)
+        {
+            const DyeColor &col = *it;
+            ++ it;
+            const DyeColor &col2 = *it;
+            const unsigned int a = useAlpha ? col.value[3] : 0;
+            unsigned int coldata;
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+            if (ogl)
+            {
+                coldata = (col.value[0] << 24U) | (col.value[1] << 16U)
+                    | (col.value[2] << 8U) | a;
+            }
+            else
+            {
+                coldata = (a << 24U) | (col.value[2] << 16U)
+                    | (col.value[1] << 8U) | (col.value[0]);
+            }
+#else
+            if (ogl)
+            {
+                coldata = (col.value[0]) | (col.value[1] << 8U)
+                    | (col.value[2] << 16U) | (a << 24U);
+            }
+            else
+            {
+                coldata = a | (col.value[2] << 8U)
+                    | (col.value[1] << 16U) | (col.value[0] << 24U);
+            }
+#endif
+            if (data == coldata)
+            {
+                if (ogl)
+                {
+                    p[0] = col2.value[0];
+                    p[1] = col2.value[1];
+                    p[2] = col2.value[2];
+                    if (useAlpha)
+                        p[3] = col2.value[3];
+                }
+                else
+                {
+                    p[3] = col2.value[0];
+                    p[2] = col2.value[1];
+                    p[1] = col2.value[2];
+                    if (useAlpha)
+                        p[0] = col2.value[3];
+                }
+                break;
+            }
+            ++ it;
+        }
+    }
+}
+
+static uint8_t randomChannel()
+{
+    switch (rand() % 4)
+    {
+        case 0:
+            return 0;
+        case 1:
+            return 255;
+        default:
+            return static_cast<uint8_t>(rand() % 256);
+    }
+}
+
+static void fillPixels(std::vector<uint32_t> &pixels,
+                       const std::vector<DyeColor> &colors)
+{
+    const size_t sz = pixels.size();
+    for (size_t f = 0; f < sz; f ++)
+    {
+        uint8_t *const p = reinterpret_cast<uint8_t*>(&pixels[f]);
+        const int type = rand() % 5;
+        if (type == 0)
+        {
+            pixels[f] = 0;
+        }
+        else if (type == 1 && !colors.empty())
+        {
+            // palette color with any byte order
+            const DyeColor &col = colors[rand() % colors.size()];
+            const int shift = rand() % 2;
+            for (int k = 0; k < 4; k ++)
+                p[k] = col.value[shift ? 3 - k : k];
+            if (rand() % 2)
+                p[shift ? 0 : 3] = randomChannel();
+        }
+        else if (type == 2)
+        {
+            // pure color
+            const uint8_t val = static_cast<uint8_t>(rand() % 256);
+            for (int k = 0; k < 4; k ++)
+                p[k] = (rand() % 2) ? val : 0;
+            if (rand() % 2)
+                p[rand() % 4] = val / 2;
+        }
+        else
+        {
+            for (int k = 0; k < 4; k ++)
+                p[k] = randomChannel();
+        }
+        if (f > 0 && rand() % 3 == 0)
+            pixels[f] = pixels[f - 1];
+    }
+}
+
+static std::string colorsToString(const std::vector<DyeColor> &colors,
+                                  const int blockSize)
+{
+    if (colors.empty())
+        return std::string();
+    std::string str("#");
+    for (size_t f = 0; f < colors.size(); f ++)
+    {
+        if (f)
+            str.append(",");
+        const uint8_t *const val = colors[f].value;
+        if (blockSize == 8)
+        {
+            str.append(strprintf("%02x%02x%02x%02x",
+                val[0], val[1], val[2], val[3]));
+        }
+        else
+        {
+            str.append(strprintf("%02x%02x%02x", val[0], val[1], val[2]));
+        }
+    }
+    return str;
+}
+
+static void checkReplaceColors(const int blockSize)
+{
+    for (int test = 0; test < 200; test ++)
+    {
+        std::vector<DyeColor> colors;
+        const int cnt = rand() % 9;
+        for (int f = 0; f < cnt; f ++)
+        {
+            colors.push_back(DyeColor(randomChannel(), randomChannel(),
+                randomChannel(), blockSize == 8 ? randomChannel() : 255));
+        }
+        // duplicate source colors must be handled like in linear search
+        if (cnt > 4 && rand() % 2)
+            colors[2] = colors[0];
+        const DyePalette palette(colorsToString(colors, blockSize),
+            static_cast<uint8_t>(blockSize));
+
+        std::vector<uint32_t> pixels(static_cast<size_t>(rand() % 70));
+        fillPixels(pixels, colors);
+        const int sz = static_cast<int>(pixels.size());
+
+        for (int mode = 0; mode < 2; mode ++)
+        {
+            const bool ogl = mode != 0;
+            std::vector<uint32_t> expected = pixels;
+            std::vector<uint32_t> result = pixels;
+            uint32_t *const exp = sz ? &expected[0] : nullptr;
+            uint32_t *const res = sz ? &result[0] : nullptr;
+            refReplaceColor(colors, exp, sz, ogl, blockSize == 8);
+            if (blockSize == 8)
+            {
+                if (ogl)
+                    palette.replaceAOGLColor(res, sz);
+                else
+                    palette.replaceAColor(res, sz);
+            }
+            else
+            {
+                if (ogl)
+                    palette.replaceSOGLColor(res, sz);
+                else
+                    palette.replaceSColor(res, sz);
+            }
+            EXPECT_TRUE(expected == result);
+        }
+    }
+}
+
+static void checkNormalDye()
+{
+    static const char *const letters = "RGYBMCW";
+    for (int test = 0; test < 200; test ++)
+    {
+        std::string description;
+        DyePalette *palettes[7];
+        for (int f = 0; f < 7; f ++)
+        {
+            palettes[f] = nullptr;
+            if (rand() % 3 == 0)
+                continue;
+            std::vector<DyeColor> colors;
+            const int cnt = 1 + rand() % 4;
+            for (int k = 0; k < cnt; k ++)
+            {
+                colors.push_back(DyeColor(randomChannel(), randomChannel(),
+                    randomChannel()));
+            }
+            const std::string str = colorsToString(colors, 6);
+            palettes[f] = new DyePalette(str, 6);
+            if (!description.empty())
+                description.append(";");
+            description.append(strprintf("%c:", letters[f])).append(str);
+        }
+        const Dye dye(description);
+
+        std::vector<uint32_t> pixels(static_cast<size_t>(rand() % 70));
+        fillPixels(pixels, std::vector<DyeColor>());
+        const int sz = static_cast<int>(pixels.size());
+
+        for (int mode = 0; mode < 2; mode ++)
+        {
+            const bool ogl = mode != 0;
+            std::vector<uint32_t> expected = pixels;
+            std::vector<uint32_t> result = pixels;
+            uint32_t *const exp = sz ? &expected[0] : nullptr;
+            uint32_t *const res = sz ? &result[0] : nullptr;
+            refNormalDye(palettes, exp, sz, ogl);
+            if (ogl)
+                dye.normalOGLDye(res, sz);
+            else
+                dye.normalDye(res, sz);
+            EXPECT_TRUE(expected == result);
+        }
+        for (int f = 0; f < 7; f ++)
+            delete palettes[f];
+    }
+}
+
+TEST(Dye, optimizedReplaceColors)
+{
+    srand(1);
+    checkReplaceColors(6);
+    checkReplaceColors(8);
+
+    // check simd code if cpu supports it
+    if (!logger)
+        logger = new Logger();
+    Cpu::detect();
+    checkReplaceColors(6);
+    checkReplaceColors(8);
+}
+
+TEST(Dye, optimizedNormalDye)
+{
+    srand(2);
+    checkNormalDye();
+
+    if (!logger)
+        logger = new Logger();
+    Cpu::detect();
+    checkNormalDye();
+}
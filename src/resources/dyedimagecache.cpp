@@ -0,0 +1,274 @@
+/*
+ *  The ManaPlus Client
+ *  Copyright (C) 2011-2014  The ManaPlus Developers
+ *
+ *  This file is part of The ManaPlus Client.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "resources/dyedimagecache.h"
+
+#include "logger.h"
+
+#include "resources/imagehelper.h"
+
+#include "resources/db/palettedb.h"
+
+#include "utils/files.h"
+#include "utils/mkdir.h"
+#include "utils/physfstools.h"
+#include "utils/sdlcheckutils.h"
+#include "utils/stringutils.h"
+
+#include <SDL_thread.h>
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <zlib.h>
+
+#include <sys/stat.h>
+
+#include "debug.h"
+
+namespace
+{
+    const char cacheMagic[4] = {'M', 'P', 'D', 'I'};
+    const uint32_t cacheVersion = 2;
+    const uint32_t cacheByteOrder = 0x01020304;
+
+    struct CacheHeader final
+    {
+        char magic[4];
+        uint32_t version;
+        uint32_t byteOrder;
+        int32_t width;
+        int32_t height;
+        int32_t realWidth;
+        int32_t realHeight;
+        uint32_t stampSize;
+    };
+
+    std::string mDir;
+    size_t mMaxSize = 0;
+    // size of cache files, changed from worker threads
+    size_t mSize = 0;
+    SDL_mutex *mMutex = nullptr;
+}  // namespace
+
+static std::string getCacheName(const std::string &stamp)
+{
+    const Bytef *const data = reinterpret_cast<const Bytef*>(
+        stamp.c_str());
+    const uInt sz = static_cast<uInt>(stamp.size());
+    const uLong adler = adler32(adler32(0L, Z_NULL, 0), data, sz);
+    const uLong crc = crc32(crc32(0L, Z_NULL, 0), data, sz);
+    return std::string(mDir).append("/").append(strprintf("%08x%08x",
+        static_cast<unsigned int>(adler),
+        static_cast<unsigned int>(crc)));
+}
+
+namespace DyedImageCache
+{
+    void setDir(const std::string &dir,
+                const size_t maxSize)
+    {
+        mDir = dir;
+        mMaxSize = maxSize;
+        mSize = 0;
+        if (mDir.empty())
+            return;
+        if (mkdir_r(mDir.c_str()))
+        {
+            logger->log("Cant create image cache dir: %s", mDir.c_str());
+            mDir.clear();
+            return;
+        }
+        if (!mMutex)
+            mMutex = SDL_CreateMutex();
+        mSize = Files::limitDirSize(mDir, mMaxSize);
+    }
+
+    bool isEnabled()
+    {
+        return !mDir.empty();
+    }
+
+    std::string getStamp(const std::string &path,
+                         SDL_RWops *const rw,
+                         const std::string &dye)
+    {
+        if (!rw || mDir.empty())
+            return std::string();
+
+        const int size = static_cast<int>(SDL_RWseek(rw, 0, RW_SEEK_END));
+        SDL_RWseek(rw, 0, RW_SEEK_SET);
+        if (size <= 0)
+            return std::string();
+
+        const char *const dir = PhysFs::getRealDir(path.c_str());
+        std::string stamp = strprintf("%s|%s|%lld|%d|%s", dir ? dir : "",
+            path.c_str(), static_cast<long long>(PhysFs::getLastModTime(
+            path.c_str())), size, dye.c_str());
+        // colors from palette file can be changed
+        if (dye.find('@') != std::string::npos)
+            stamp.append("|").append(PaletteDB::getStamp());
+        return stamp;
+    }
+
+    SDL_Surface *load(const std::string &stamp,
+                      const ImageHelper *const helper,
+                      int &width,
+                      int &height)
+    {
+        if (mDir.empty() || stamp.empty() || !helper)
+            return nullptr;
+
+        const std::string name = getCacheName(stamp);
+        FILE *const file = fopen(name.c_str(), "rb");
+        if (!file)
+            return nullptr;
+
+        CacheHeader header;
+        if (fread(&header, sizeof(header), 1, file) != 1
+            || memcmp(header.magic, cacheMagic, 4)
+            || header.version != cacheVersion
+            || header.byteOrder != cacheByteOrder
+            || header.stampSize != stamp.size()
+            || header.width <= 0 || header.height <= 0)
+        {
+            fclose(file);
+            return nullptr;
+        }
+
+        std::string str(stamp.size(), ' ');
+        if (fread(&str[0], 1, stamp.size(), file) != stamp.size()
+            || str != stamp)
+        {
+            fclose(file);
+            return nullptr;
+        }
+        SDL_Surface *const surface = helper->create32BitSurface(
+            header.width, header.height);
+        // texture size settings can be changed since cache was saved
+        if (!surface || surface->w != header.realWidth
+            || surface->h != header.realHeight
+            || surface->format->BitsPerPixel != 32)
+        {
+            if (surface)
+                MSDL_FreeSurface(surface);
+            fclose(file);
+            return nullptr;
+        }
+
+        if (SDL_MUSTLOCK(surface))
+            SDL_LockSurface(surface);
+        const size_t rowSize = static_cast<size_t>(surface->w * 4);
+        bool ok = true;
+        for (int y = 0; y < surface->h; y ++)
+        {
+            char *const row = static_cast<char*>(surface->pixels)
+                + y * surface->pitch;
+            if (fread(row, 1, rowSize, file) != rowSize)
+            {
+                ok = false;
+                break;
+            }
+        }
+        if (SDL_MUSTLOCK(surface))
+            SDL_UnlockSurface(surface);
+        fclose(file);
+
+        if (!ok)
+        {
+            MSDL_FreeSurface(surface);
+            return nullptr;
+        }
+        // mark as recently used for cache size limit
+        Files::touchFile(name);
+        width = header.width;
+        height = header.height;
+        return surface;
+    }
+
+    void save(const std::string &stamp,
+              SDL_Surface *const surface,
+              const int width,
+              const int height)
+    {
+        if (mDir.empty() || stamp.empty() || !surface
+            || surface->format->BitsPerPixel != 32)
+        {
+            return;
+        }
+
+        const std::string name = getCacheName(stamp);
+        // unique name for case if same image saved from other thread
+        const std::string tempName = name + strprintf(".%p.tmp",
+            static_cast<void*>(surface));
+        FILE *const file = fopen(tempName.c_str(), "wb");
+        if (!file)
+            return;
+
+        CacheHeader header;
+        memcpy(header.magic, cacheMagic, 4);
+        header.version = cacheVersion;
+        header.byteOrder = cacheByteOrder;
+        header.width = width;
+        header.height = height;
+        header.realWidth = surface->w;
+        header.realHeight = surface->h;
+        header.stampSize = static_cast<uint32_t>(stamp.size());
+        bool ok = fwrite(&header, sizeof(header), 1, file) == 1
+            && fwrite(stamp.c_str(), 1, stamp.size(), file) == stamp.size();
+
+        if (SDL_MUSTLOCK(surface))
+            SDL_LockSurface(surface);
+        const size_t rowSize = static_cast<size_t>(surface->w * 4);
+        for (int y = 0; ok && y < surface->h; y ++)
+        {
+            const char *const row = static_cast<const char*>(
+                surface->pixels) + y * surface->pitch;
+            ok = fwrite(row, 1, rowSize, file) == rowSize;
+        }
+        if (SDL_MUSTLOCK(surface))
+            SDL_UnlockSurface(surface);
+        fclose(file);
+
+        // replaced file already counted in cache size
+        size_t oldSize = 0;
+        struct stat statbuf;
+        if (!stat(name.c_str(), &statbuf))
+            oldSize = static_cast<size_t>(statbuf.st_size);
+
+        if (!ok || Files::renameFile(tempName, name))
+        {
+            ::remove(tempName.c_str());
+            return;
+        }
+
+        SDL_mutexP(mMutex);
+        mSize += sizeof(header) + stamp.size()
+            + rowSize * static_cast<size_t>(surface->h);
+        mSize = mSize > oldSize ? mSize - oldSize : 0;
+        if (mSize > mMaxSize)
+        {
+            // remove least recently used files with some reserve,
+            // for not scan directory on each save
+            mSize = Files::limitDirSize(mDir, mMaxSize / 4 * 3);
+        }
+        SDL_mutexV(mMutex);
+    }
+}  // namespace DyedImageCache
@@ -0,0 +1,78 @@
+/*
+ *  The ManaPlus Client
+ *  Copyright (C) 2011-2014  The ManaPlus Developers
+ *
+ *  This file is part of The ManaPlus Client.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef RESOURCES_DYEDIMAGECACHE_H
+#define RESOURCES_DYEDIMAGECACHE_H
+
+#include <SDL_rwops.h>
+#include <SDL_video.h>
+
+#include <string>
+
+#include "localconsts.h"
+
+class ImageHelper;
+
+/**
+ * Disk cache of dyed and converted image surfaces.
+ *
+ * Cache files keyed by stamp of source image file and dye string
+ * and store pixels ready for upload. Total size of cache files limited,
+ * least recently used files removed first.
+ */
+namespace DyedImageCache
+{
+    /**
+     * Sets directory for cache files and limit for their total size.
+     * Empty directory disables cache.
+     */
+    void setDir(const std::string &dir,
+                const size_t maxSize);
+
+    bool isEnabled() A_WARN_UNUSED;
+
+    /**
+     * Returns cache stamp for image file and dye.
+     * Stamp built from file real dir, modification time and size,
+     * so file data not read.
+     */
+    std::string getStamp(const std::string &path,
+                         SDL_RWops *const rw,
+                         const std::string &dye) A_WARN_UNUSED;
+
+    /**
+     * Creates surface with cached pixels or returns nullptr.
+     * Width and height set to image size without texture padding.
+     */
+    SDL_Surface *load(const std::string &stamp,
+                      const ImageHelper *const helper,
+                      int &width,
+                      int &height) A_WARN_UNUSED;
+
+    /**
+     * Saves converted 32 bit surface pixels.
+     */
+    void save(const std::string &stamp,
+              SDL_Surface *const surface,
+              const int width,
+              const int height);
+}  // namespace DyedImageCache
+
+#endif  // RESOURCES_DYEDIMAGECACHE_H
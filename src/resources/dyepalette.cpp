@@ -26,15 +26,31 @@
 
 #include "resources/db/palettedb.h"
 
+#include <algorithm>
 #include <cmath>
 
 #include <SDL_endian.h>
 
+#ifdef SIMD_SUPPORTED
+#include <emmintrin.h>
+#endif
+
 #include "debug.h"
 
 DyePalette::DyePalette(const std::string &description,
                        const uint8_t blockSize) :
-    mColors()
+    mColors(),
+    mReplaceS(),
+    mReplaceA(),
+    mReplaceSOGL(),
+    mReplaceAOGL()
+{
+    loadColors(description, blockSize);
+    prepareTables();
+}
+
+void DyePalette::loadColors(const std::string &description,
+                            const uint8_t blockSize)
 {
     const size_t size = static_cast<size_t>(description.length());
     if (size == 0)
@@ -87,6 +103,91 @@ DyePalette::DyePalette(const std::string &description,
     logger->log("Error, invalid embedded palette: %s", description.c_str());
 }
 
+void DyePalette::prepareTables()
+{
+    mIntensityColors[0] = 0;
+    mIntensityColors[1] = 0;
+    mIntensityColors[2] = 0;
+    for (unsigned int f = 1; f < 256; f ++)
+    {
+        unsigned int color[3] = {0, 0, 0};
+        getColor(f, color);
+        uint8_t *const ptr = &mIntensityColors[f * 3];
+        ptr[0] = static_cast<uint8_t>(color[0]);
+        ptr[1] = static_cast<uint8_t>(color[1]);
+        ptr[2] = static_cast<uint8_t>(color[2]);
+    }
+
+    const size_t sz = mColors.size();
+    for (size_t f = 0; f + 1 < sz; f += 2)
+    {
+        const uint8_t *const col = mColors[f].value;
+        const uint8_t *const col2 = mColors[f + 1].value;
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+        addReplaceColor(mReplaceS,
+            (col[2] << 16U) | (col[1] << 8U) | (col[0]),
+            (col2[2] << 16U) | (col2[1] << 8U) | (col2[0]));
+        addReplaceColor(mReplaceA,
+            (col[3] << 24U) | (col[2] << 16U) | (col[1] << 8U) | (col[0]),
+            (col2[3] << 24U) | (col2[2] << 16U) | (col2[1] << 8U)
+            | (col2[0]));
+        addReplaceColor(mReplaceSOGL,
+            (col[0] << 24U) | (col[1] << 16U) | (col[2] << 8U),
+            (col2[0] << 24U) | (col2[1] << 16U) | (col2[2] << 8U));
+        addReplaceColor(mReplaceAOGL,
+            (col[0] << 24U) | (col[1] << 16U) | (col[2] << 8U) | col[3],
+            (col2[0] << 24U) | (col2[1] << 16U) | (col2[2] << 8U)
+            | col2[3]);
+#else
+        addReplaceColor(mReplaceS,
+            (col[2] << 8U) | (col[1] << 16U) | (col[0] << 24U),
+            (col2[2] << 8U) | (col2[1] << 16U) | (col2[0] << 24U));
+        addReplaceColor(mReplaceA,
+            (col[3]) | (col[2] << 8U) | (col[1] << 16U) | (col[0] << 24U),
+            (col2[3]) | (col2[2] << 8U) | (col2[1] << 16U)
+            | (col2[0] << 24U));
+        addReplaceColor(mReplaceSOGL,
+            (col[0]) | (col[1] << 8U) | (col[2] << 16U),
+            (col2[0]) | (col2[1] << 8U) | (col2[2] << 16U));
+        addReplaceColor(mReplaceAOGL,
+            (col[0]) | (col[1] << 8U) | (col[2] << 16U) | (col[3] << 24U),
+            (col2[0]) | (col2[1] << 8U) | (col2[2] << 16U)
+            | (col2[3] << 24U));
+#endif
+    }
+    sortReplaceColors(mReplaceS);
+    sortReplaceColors(mReplaceA);
+    sortReplaceColors(mReplaceSOGL);
+    sortReplaceColors(mReplaceAOGL);
+}
+
+void DyePalette::addReplaceColor(ReplaceColors &colors,
+                                 const uint32_t from,
+                                 const uint32_t to)
+{
+    // first pair with same source color wins
+    FOR_EACH (ReplaceColors::const_iterator, it, colors)
+    {
+        if ((*it).from == from)
+            return;
+    }
+    ReplaceColor color;
+    color.from = from;
+    color.to = to;
+    colors.push_back(color);
+}
+
+bool DyePalette::replaceColorLess(const ReplaceColor &color1,
+                                  const ReplaceColor &color2)
+{
+    return color1.from < color2.from;
+}
+
+void DyePalette::sortReplaceColors(ReplaceColors &colors)
+{
+    std::sort(colors.begin(), colors.end(), &replaceColorLess);
+}
+
 unsigned int DyePalette::hexDecode(const signed char c)
 {
     if ('0' <= c && c <= '9')
@@ -197,212 +298,146 @@ void DyePalette::getColor(double intensity, int color[3]) const
     color[2] = static_cast<int>(rest * b1 + intensity * b2);
 }
 
-void DyePalette::replaceSColor(uint32_t *restrict pixels,
-                               const int bufSize) const
+void DyePalette::replaceColors(uint32_t *restrict pixels,
+                               const int bufSize,
+                               const ReplaceColors &colors,
+                               const uint32_t mask,
+                               const uint32_t alphaMask)
 {
-    std::vector<DyeColor>::const_iterator it_end = mColors.end();
-    const size_t sz = mColors.size();
-    if (!sz)
+    if (colors.empty())
         return;
-    if (sz % 2)
-        -- it_end;
+
+    const ReplaceColors::const_iterator it_begin = colors.begin();
+    const ReplaceColors::const_iterator it_end = colors.end();
+    ReplaceColor key;
+    key.from = 0;
+    key.to = 0;
+    // sprites have long runs of same colors
+    uint32_t lastFrom = 0;
+    uint32_t lastTo = 0;
+    bool lastFound = false;
+    bool hasLast = false;
 
     for (uint32_t *p_end = pixels + static_cast<size_t>(bufSize);
          pixels != p_end;
          ++pixels)
     {
-        uint8_t *const p = reinterpret_cast<uint8_t *>(pixels);
-#if SDL_BYTEORDER == SDL_BIG_ENDIAN
-        const int alpha = *pixels & 0xff000000;
-        const unsigned int data = (*pixels) & 0x00ffffff;
-#else
-        const int alpha = *p & 0xff;
-        const unsigned int data = (*pixels) & 0xffffff00;
-#endif
-//        logger->log("c:%04d   %08x", c, *pixels);
-//        logger->log("data:    %08x", data);
-        if (!alpha)
-        {
-//            logger->log("skip:    %08x", *pixels);
+        const uint32_t p = *pixels;
+        if (alphaMask && !(p & alphaMask))
             continue;
-        }
 
-        std::vector<DyeColor>::const_iterator it = mColors.begin();
-        while (it != it_end)
+        const uint32_t data = p & mask;
+        if (!hasLast || data != lastFrom)
         {
-            const DyeColor &col = *it;
-            ++ it;
-            const DyeColor &col2 = *it;
-
-#if SDL_BYTEORDER == SDL_BIG_ENDIAN
-            const unsigned int coldata = (col.value[2] << 16U)
-                | (col.value[1] << 8U) | (col.value[0]);
-#else
-            const unsigned int coldata = (col.value[2] << 8U)
-                | (col.value[1] << 16U) | (col.value[0] << 24U);
-#endif
-//            logger->log("coldata: %08x", coldata);
-            if (data == coldata)
-            {
-//                logger->log("correct");
-                p[3] = col2.value[0];
-                p[2] = col2.value[1];
-                p[1] = col2.value[2];
-                break;
-            }
-
-            ++ it;
+            key.from = data;
+            const ReplaceColors::const_iterator it = std::lower_bound(
+                it_begin, it_end, key, &replaceColorLess);
+            hasLast = true;
+            lastFrom = data;
+            lastFound = it != it_end && (*it).from == data;
+            if (lastFound)
+                lastTo = (*it).to;
         }
+        if (lastFound)
+            *pixels = (p & ~mask) | lastTo;
     }
 }
 
-void DyePalette::replaceAColor(uint32_t *restrict pixels,
-                               const int bufSize) const
+#ifdef SIMD_SUPPORTED
+__attribute__ ((target ("sse2")))
+void DyePalette::replaceColorsSse2(uint32_t *restrict pixels,
+                                   const int bufSize,
+                                   const ReplaceColors &colors,
+                                   const uint32_t mask,
+                                   const uint32_t alphaMask)
 {
-    std::vector<DyeColor>::const_iterator it_end = mColors.end();
-    const size_t sz = mColors.size();
-    if (!sz)
+    if (colors.empty())
         return;
-    if (sz % 2)
-        -- it_end;
 
-    for (uint32_t *p_end = pixels + static_cast<size_t>(bufSize);
-         pixels != p_end;
-         ++pixels)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i alphaMaskV = _mm_set1_epi32(static_cast<int>(alphaMask));
+    int f = 0;
+    while (f + 4 <= bufSize)
     {
-        uint8_t *const p = reinterpret_cast<uint8_t *>(pixels);
-        const unsigned int data = *pixels;
-
-        std::vector<DyeColor>::const_iterator it = mColors.begin();
-        while (it != it_end)
+        // skip fully transparent blocks
+        const __m128i p = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(&pixels[f]));
+        const __m128i empty = _mm_cmpeq_epi32(
+            _mm_and_si128(p, alphaMaskV), zero);
+        if (_mm_movemask_epi8(empty) == 0xffff)
         {
-            const DyeColor &col = *it;
-            ++ it;
-            const DyeColor &col2 = *it;
-
-#if SDL_BYTEORDER == SDL_BIG_ENDIAN
-            const unsigned int coldata = (col.value[3] << 24U)
-                | (col.value[2] << 16U)
-                | (col.value[1] << 8U)
-                | (col.value[0]);
-#else
-            const unsigned int coldata = (col.value[3])
-                | (col.value[2] << 8U)
-                | (col.value[1] << 16U) |
-                (col.value[0] << 24U);
-#endif
-
-            if (data == coldata)
-            {
-                p[3] = col2.value[0];
-                p[2] = col2.value[1];
-                p[1] = col2.value[2];
-                p[0] = col2.value[3];
+            f += 4;
+            continue;
+        }
+        int end = f + 4;
+        // process run of non transparent pixels
+        while (end + 4 <= bufSize)
+        {
+            const __m128i p2 = _mm_loadu_si128(
+                reinterpret_cast<const __m128i*>(&pixels[end]));
+            const __m128i empty2 = _mm_cmpeq_epi32(
+                _mm_and_si128(p2, alphaMaskV), zero);
+            if (_mm_movemask_epi8(empty2) == 0xffff)
                 break;
-            }
-
-            ++ it;
+            end += 4;
         }
+        replaceColors(pixels + f, end - f, colors, mask, alphaMask);
+        f = end;
     }
+    if (f < bufSize)
+        replaceColors(pixels + f, bufSize - f, colors, mask, alphaMask);
 }
+#endif
 
-void DyePalette::replaceSOGLColor(uint32_t *restrict pixels,
-                                  const int bufSize) const
+void DyePalette::replaceSColor(uint32_t *restrict pixels,
+                               const int bufSize) const
 {
-    std::vector<DyeColor>::const_iterator it_end = mColors.end();
-    const size_t sz = mColors.size();
-    if (!sz)
-        return;
-    if (sz % 2)
-        -- it_end;
-
-    for (uint32_t *p_end = pixels + static_cast<size_t>(bufSize);
-         pixels != p_end;
-         ++pixels)
-    {
-        uint8_t *const p = reinterpret_cast<uint8_t *>(pixels);
 #if SDL_BYTEORDER == SDL_BIG_ENDIAN
-        const int alpha = *p & 0xff;
-        const unsigned int data = (*pixels) & 0xffffff00;
+    const uint32_t mask = 0x00ffffff;
+    const uint32_t alphaMask = 0xff000000;
 #else
-        const int alpha = *pixels & 0xff000000;
-        const unsigned int data = (*pixels) & 0x00ffffff;
+    const uint32_t mask = 0xffffff00;
+    const uint32_t alphaMask = 0x000000ff;
 #endif
-        if (!alpha)
-            continue;
+#ifdef SIMD_SUPPORTED
+    if (Cpu::getFlags() & Cpu::FEATURE_SSE2)
+    {
+        replaceColorsSse2(pixels, bufSize, mReplaceS, mask, alphaMask);
+        return;
+    }
+#endif
+    replaceColors(pixels, bufSize, mReplaceS, mask, alphaMask);
+}
 
-        std::vector<DyeColor>::const_iterator it = mColors.begin();
-        while (it != it_end)
-        {
-            const DyeColor &col = *it;
-            ++ it;
-            const DyeColor &col2 = *it;
+void DyePalette::replaceAColor(uint32_t *restrict pixels,
+                               const int bufSize) const
+{
+    replaceColors(pixels, bufSize, mReplaceA, 0xffffffff, 0);
+}
 
+void DyePalette::replaceSOGLColor(uint32_t *restrict pixels,
+                                  const int bufSize) const
+{
 #if SDL_BYTEORDER == SDL_BIG_ENDIAN
-            const unsigned int coldata = (col.value[0] << 24)
-                | (col.value[1] << 16) | (col.value[2] << 8);
+    const uint32_t mask = 0xffffff00;
+    // alpha check uses first byte
+    const uint32_t alphaMask = 0xff000000;
 #else
-            const unsigned int coldata = (col.value[0])
-                | (col.value[1] << 8) | (col.value[2] << 16);
+    const uint32_t mask = 0x00ffffff;
+    const uint32_t alphaMask = 0xff000000;
 #endif
-            if (data == coldata)
-            {
-                p[0] = col2.value[0];
-                p[1] = col2.value[1];
-                p[2] = col2.value[2];
-                break;
-            }
-
-            ++ it;
-        }
+#ifdef SIMD_SUPPORTED
+    if (Cpu::getFlags() & Cpu::FEATURE_SSE2)
+    {
+        replaceColorsSse2(pixels, bufSize, mReplaceSOGL, mask, alphaMask);
+        return;
     }
+#endif
+    replaceColors(pixels, bufSize, mReplaceSOGL, mask, alphaMask);
 }
 
 void DyePalette::replaceAOGLColor(uint32_t *restrict pixels,
                                   const int bufSize) const
 {
-    std::vector<DyeColor>::const_iterator it_end = mColors.end();
-    const size_t sz = mColors.size();
-    if (!sz)
-        return;
-    if (sz % 2)
-        -- it_end;
-
-    for (uint32_t *p_end = pixels + static_cast<size_t>(bufSize);
-         pixels != p_end;
-         ++pixels)
-    {
-        uint8_t *const p = reinterpret_cast<uint8_t *>(pixels);
-        const unsigned int data = *pixels;
-
-        std::vector<DyeColor>::const_iterator it = mColors.begin();
-        while (it != it_end)
-        {
-            const DyeColor &col = *it;
-            ++ it;
-            const DyeColor &col2 = *it;
-
-#if SDL_BYTEORDER == SDL_BIG_ENDIAN
-            const unsigned int coldata = (col.value[0] << 24U)
-                | (col.value[1] << 16U)
-                | (col.value[2] << 8U)
-                | col.value[3];
-#else
-            const unsigned int coldata = (col.value[0])
-                | (col.value[1] << 8U)
-                | (col.value[2] << 16U)
-                | (col.value[3] << 24U);
-#endif
-            if (data == coldata)
-            {
-                p[0] = col2.value[0];
-                p[1] = col2.value[1];
-                p[2] = col2.value[2];
-                p[3] = col2.value[3];
-                break;
-            }
-
-            ++ it;
-        }
-    }
+    replaceColors(pixels, bufSize, mReplaceAOGL, 0xffffffff, 0);
 }
@@ -25,6 +25,8 @@
 
 #include "resources/dyecolor.h"
 
+#include "utils/cpu.h"
+
 #include <string>
 #include <vector>
 
@@ -79,10 +81,60 @@ class DyePalette final
         void replaceAOGLColor(uint32_t *restrict pixels,
                               const int bufSize) const;
 
+        /**
+         * Returns colors for all intensities, three bytes per intensity,
+         * or nullptr if palette is empty.
+         */
+        const uint8_t *getIntensityColors() const A_WARN_UNUSED
+        { return mColors.empty() ? nullptr : mIntensityColors; }
+
         static unsigned int hexDecode(const signed char c) A_WARN_UNUSED;
 
     private:
+        struct ReplaceColor final
+        {
+            uint32_t from;
+            uint32_t to;
+        };
+
+        typedef std::vector<ReplaceColor> ReplaceColors;
+
+        void loadColors(const std::string &description,
+                        const uint8_t blockSize);
+
+        void prepareTables();
+
+        static void addReplaceColor(ReplaceColors &colors,
+                                    const uint32_t from,
+                                    const uint32_t to);
+
+        static bool replaceColorLess(const ReplaceColor &color1,
+                                     const ReplaceColor &color2);
+
+        static void sortReplaceColors(ReplaceColors &colors);
+
+        static void replaceColors(uint32_t *restrict pixels,
+                                  const int bufSize,
+                                  const ReplaceColors &colors,
+                                  const uint32_t mask,
+                                  const uint32_t alphaMask);
+
+#ifdef SIMD_SUPPORTED
+        static void replaceColorsSse2(uint32_t *restrict pixels,
+                                      const int bufSize,
+                                      const ReplaceColors &colors,
+                                      const uint32_t mask,
+                                      const uint32_t alphaMask);
+#endif
+
         std::vector<DyeColor> mColors;
+        // replace colors sorted by source color for each replace mode
+        ReplaceColors mReplaceS;
+        ReplaceColors mReplaceA;
+        ReplaceColors mReplaceSOGL;
+        ReplaceColors mReplaceAOGL;
+        // precalculated getColor results for all intensities
+        uint8_t mIntensityColors[256 * 3];
 };
 
 #endif  // RESOURCES_DYEPALETTE_H
@@ -50,6 +50,8 @@ struct Frame final
     int rand;
     FrameType type;
     std::string nextAction;
+    // image index in sprite definition or -1 if image field used
+    int imageIndex;
 };
 
 #endif  // RESOURCES_FRAME_H
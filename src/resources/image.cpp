@@ -462,6 +462,32 @@ Image *Image::getSubImage(const int x, const int y,
 #endif
 }
 
+size_t Image::getMemoryUsage() const
+{
+    size_t sz = Resource::getMemoryUsage() + sizeof(Image) - sizeof(Resource);
+#ifdef USE_OPENGL
+    if (mGLImage)
+        sz += static_cast<size_t>(mTexWidth * mTexHeight * 4);
+#endif
+#ifdef USE_SDL2
+    if (mTexture)
+        sz += static_cast<size_t>(mBounds.w * mBounds.h * 4);
+#endif
+    if (mSDLSurface)
+        sz += static_cast<size_t>(mSDLSurface->pitch * mSDLSurface->h);
+    if (mAlphaChannel)
+        sz += static_cast<size_t>(mBounds.w * mBounds.h);
+    for (std::map<float, SDL_Surface*>::const_iterator
+         it = mAlphaCache.begin(), it_end = mAlphaCache.end();
+         it != it_end; ++ it)
+    {
+        const SDL_Surface *const surface = (*it).second;
+        if (surface)
+            sz += static_cast<size_t>(surface->pitch * surface->h);
+    }
+    return sz;
+}
+
 void Image::SDLTerminateAlphaCache()
 {
     SDLCleanCache();
@@ -133,6 +133,8 @@ class Image notfinal : public Resource
                                    const int width,
                                    const int height) A_WARN_UNUSED;
 
+        size_t getMemoryUsage() const override A_WARN_UNUSED;
+
 
         // SDL only public functions
 
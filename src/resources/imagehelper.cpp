@@ -58,11 +58,26 @@ Image *ImageHelper::load(SDL_RWops *const rw)
 Image *ImageHelper::load(SDL_RWops *const rw, Dye const &dye)
 {
     BLOCK_START("ImageHelper::load")
+    SDL_Surface *const surf = loadDyedRgbaSurface(rw, dye);
+    if (!surf)
+    {
+        BLOCK_END("ImageHelper::load")
+        return nullptr;
+    }
+
+    Image *const image = load(surf);
+    MSDL_FreeSurface(surf);
+    BLOCK_END("ImageHelper::load")
+    return image;
+}
+
+SDL_Surface *ImageHelper::loadDyedRgbaSurface(SDL_RWops *const rw,
+                                              Dye const &dye)
+{
     SDL_Surface *const tmpImage = loadPng(rw);
     if (!tmpImage)
     {
         logger->log("Error, image load failed: %s", IMG_GetError());
-        BLOCK_END("ImageHelper::load")
         return nullptr;
     }
 
@@ -114,10 +129,33 @@ Image *ImageHelper::load(SDL_RWops *const rw, Dye const &dye)
         }
     }
 
-    Image *const image = load(surf);
-    MSDL_FreeSurface(surf);
-    BLOCK_END("ImageHelper::load")
-    return image;
+    return surf;
+}
+
+SDL_Surface *ImageHelper::loadSurface(SDL_RWops *const rw,
+                                      const Dye *const dye,
+                                      const std::string &path A_UNUSED,
+                                      const std::string &dyeString A_UNUSED,
+                                      int &width,
+                                      int &height)
+{
+    SDL_Surface *surf = nullptr;
+    if (dye)
+    {
+        surf = loadDyedRgbaSurface(rw, *dye);
+    }
+    else
+    {
+        surf = loadPng(rw);
+        if (!surf)
+            logger->log("Error, image load failed: %s", IMG_GetError());
+    }
+    if (!surf)
+        return nullptr;
+
+    width = surf->w;
+    height = surf->h;
+    return surf;
 }
 
 SDL_Surface* ImageHelper::convertTo32Bit(SDL_Surface *const tmpImage)
@@ -31,6 +31,8 @@
 
 #include <SDL_video.h>
 
+#include <string>
+
 class Dye;
 class Image;
 
@@ -60,6 +62,45 @@ class ImageHelper notfinal
 
         virtual Image *load(SDL_RWops *const rw, Dye const &dye) A_WARN_UNUSED;
 
+        /**
+         * Loads dyed image using dyed images disk cache if it supported.
+         */
+        virtual Image *loadCached(SDL_RWops *const rw,
+                                  Dye const &dye,
+                                  const std::string &path A_UNUSED,
+                                  const std::string &dyeString A_UNUSED)
+                                  A_WARN_UNUSED
+        { return load(rw, dye); }
+
+        /**
+         * Loads and recolors an image without creating texture or display
+         * surface. Safe to call from worker threads.
+         * Result must be passed to loadPrepared on main thread.
+         *
+         * @param rw         The SDL_RWops to load the image from.
+         * @param dye        The dye used to recolor the image or nullptr.
+         * @param path       The image file path for dyed images disk cache.
+         * @param dyeString  The dye description for dyed images disk cache.
+         * @param width      Set to the width of loaded image.
+         * @param height     Set to the height of loaded image.
+         */
+        virtual SDL_Surface *loadSurface(SDL_RWops *const rw,
+                                         const Dye *const dye,
+                                         const std::string &path,
+                                         const std::string &dyeString,
+                                         int &width,
+                                         int &height) A_WARN_UNUSED;
+
+        /**
+         * Creates an image from a surface returned by loadSurface.
+         * Surface still owned by caller.
+         */
+        virtual Image *loadPrepared(SDL_Surface *const surface,
+                                    const int width A_UNUSED,
+                                    const int height A_UNUSED)
+                                    A_WARN_UNUSED
+        { return load(surface); }
+
 #ifdef __GNUC__
         virtual Image *load(SDL_Surface *const) A_WARN_UNUSED = 0;
 
@@ -109,6 +150,12 @@ class ImageHelper notfinal
         ImageHelper()
         { }
 
+        /**
+         * Loads image from SDL_RWops, converts it to 32 bit and recolors it.
+         */
+        static SDL_Surface *loadDyedRgbaSurface(SDL_RWops *const rw,
+                                                Dye const &dye) A_WARN_UNUSED;
+
         static bool mEnableAlpha;
         static RenderType mUseOpenGL;
 };
@@ -24,7 +24,7 @@
 
 #include "logger.h"
 
-#include "resources/image.h"
+#include "resources/subimage.h"
 
 #include "utils/dtor.h"
 
@@ -62,6 +62,13 @@ ImageSet::~ImageSet()
     delete_all(mImages);
 }
 
+size_t ImageSet::getMemoryUsage() const
+{
+    // sub images share pixels with parent image
+    return Resource::getMemoryUsage() + sizeof(ImageSet) - sizeof(Resource)
+        + mImages.size() * sizeof(SubImage);
+}
+
 Image* ImageSet::get(const size_type i) const
 {
     if (i >= mImages.size())
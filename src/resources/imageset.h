@@ -84,6 +84,8 @@ class ImageSet notfinal : public Resource
         const std::vector<Image*> &getImages() const
         { return mImages; }
 
+        size_t getMemoryUsage() const override A_WARN_UNUSED;
+
     private:
         std::vector<Image*> mImages;
 
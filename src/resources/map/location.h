@@ -23,8 +23,6 @@
 #ifndef RESOURCES_MAP_LOCATION_H
 #define RESOURCES_MAP_LOCATION_H
 
-#include "resources/map/metatile.h"
-
 #include "localconsts.h"
 
 /**
@@ -35,8 +33,8 @@ struct Location final
     /**
      * Constructor.
      */
-    Location(const int px, const int py, MetaTile *const ptile) :
-        x(px), y(py), tile(ptile)
+    Location(const int px, const int py, const int pFcost) :
+        x(px), y(py), Fcost(pFcost)
     {}
 
     /**
@@ -44,11 +42,11 @@ struct Location final
      */
     bool operator< (const Location &loc) const
     {
-        return tile->Fcost > loc.tile->Fcost;
+        return Fcost > loc.Fcost;
     }
 
     int x, y;
-    MetaTile *tile;
+    int Fcost;      /**< Estimation of total path cost */
 };
 
 #endif  // RESOURCES_MAP_LOCATION_H
@@ -47,8 +47,10 @@
 #include "resources/resourcemanager.h"
 #include "resources/subimage.h"
 
-#include "resources/map/location.h"
 #include "resources/map/mapobjectlist.h"
+#include "resources/map/pathcache.h"
+#include "resources/map/pathsearch.h"
+#include "resources/map/pathworker.h"
 #include "resources/map/tileanimation.h"
 
 #include "render/renderers.h"
@@ -60,38 +62,31 @@
 #include "utils/timer.h"
 
 #include <climits>
-#include <queue>
 
 #include <sys/stat.h>
 
 #include "debug.h"
 
-class ActorFunctuator final
-{
-    public:
-        bool operator()(const Actor *const a, const Actor *const b) const
-        {
-            if (!a || !b)
-                return false;
-            return a->getSortPixelY() < b->getSortPixelY();
-        }
-} actorCompare;
-
 Map::Map(const int width, const int height,
          const int tileWidth, const int tileHeight) :
     Properties(),
     mWidth(width), mHeight(height),
     mTileWidth(tileWidth), mTileHeight(tileHeight),
     mMaxTileHeight(height),
-    mMetaTiles(new MetaTile[mWidth * mHeight]),
+    mBlockMasks(new unsigned char[mWidth * mHeight]),
     mWalkLayer(nullptr),
     mLayers(),
     mTilesets(),
     mActors(),
+    mActorKeys(),
+    mRemovedActors(0),
     mHasWarps(false),
     mDrawLayersFlags(MapType::NORMAL),
-    mOnClosedList(1),
-    mOnOpenList(2),
+    mPathSearch(nullptr),
+    mPathWorker(nullptr),
+    mBlockMasksVersion(1),
+    mPathWorkerVersion(0),
+    mPathCache(new PathCache(32)),
     mBackgrounds(),
     mForegrounds(),
     mLastAScrollX(0.0F),
@@ -133,6 +128,7 @@ Map::Map(const int width, const int height,
     mCustom(false)
 {
     const int size = mWidth * mHeight;
+    memset(mBlockMasks, 0, static_cast<size_t>(size));
     for (int i = 0; i < BlockType::NB_BLOCKTYPES; i++)
     {
         mOccupation[i] = new unsigned[static_cast<size_t>(size)];
@@ -155,7 +151,10 @@ Map::~Map()
     config.removeListeners(this);
     CHECKLISTENERS
 
-    delete [] mMetaTiles;
+    delete2(mPathWorker);
+    delete [] mBlockMasks;
+    delete2(mPathSearch);
+    delete2(mPathCache);
     for (int i = 0; i < BlockType::NB_BLOCKTYPES; i++)
         delete [] mOccupation[i];
 
@@ -330,7 +329,7 @@ void Map::draw(Graphics *const graphics, int scrollX, int scrollY)
     // Make sure actors are sorted ascending by Y-coordinate
     // so that they overlap correctly
     BLOCK_START("Map::draw sort")
-        mActors.sort(actorCompare);
+        sortActors();
     BLOCK_END("Map::draw sort")
 
     // update scrolling of all ambient layers
@@ -441,21 +440,18 @@ void Map::draw(Graphics *const graphics, int scrollX, int scrollY)
     {
         // Draws beings with a lower opacity to make them visible
         // even when covered by a wall or some other elements...
-        ActorsCIter ai = mActors.begin();
-        const ActorsCIter ai_end = mActors.end();
-        while (ai != ai_end)
+        // index loop, drawing can add actors
+        const size_t actorsSize = mActors.size();
+        for (size_t ai = 0; ai < actorsSize; ++ai)
         {
-            if (Actor *const actor = *ai)
+            if (Actor *const actor = mActors[ai])
             {
                 if (mOpenGL == RENDER_SOFTWARE)
                 {
                     const int x = actor->getTileX();
                     const int y = actor->getTileY();
                     if (x < startX || x > endX || y < startY || y > endY)
-                    {
-                        ++ai;
                         continue;
-                    }
                 }
                 // For now, just draw actors with only one layer.
                 if (actor->getNumberOfLayers() == 1)
@@ -465,7 +461,6 @@ void Map::draw(Graphics *const graphics, int scrollX, int scrollY)
                     actor->setAlpha(1.0F);
                 }
             }
-            ++ai;
         }
     }
 
@@ -474,12 +469,12 @@ void Map::draw(Graphics *const graphics, int scrollX, int scrollY)
 }
 
 #define fillCollision(collision, color) \
-    if (x < endX && mMetaTiles[tilePtr].blockmask & collision)\
+    if (x < endX && mBlockMasks[tilePtr] & collision)\
     {\
         width = mapTileSize;\
         for (int x2 = tilePtr + 1; x < endX; x2 ++)\
         {\
-            if (!(mMetaTiles[x2].blockmask & collision))\
+            if (!(mBlockMasks[x2] & collision))\
                 break;\
             width += mapTileSize;\
             x ++;\
@@ -641,28 +636,29 @@ void Map::blockTile(const int x, const int y,
     if (mOccupation[static_cast<size_t>(type)][tileNum] < UINT_MAX &&
         (++mOccupation[static_cast<size_t>(type)][tileNum]) > 0)
     {
+        unsigned char mask = 0;
         switch (type)
         {
             case BlockType::WALL:
-                mMetaTiles[tileNum].blockmask |= BlockMask::WALL;
+                mask = BlockMask::WALL;
                 break;
             case BlockType::CHARACTER:
-                mMetaTiles[tileNum].blockmask |= BlockMask::CHARACTER;
+                mask = BlockMask::CHARACTER;
                 break;
             case BlockType::MONSTER:
-                mMetaTiles[tileNum].blockmask |= BlockMask::MONSTER;
+                mask = BlockMask::MONSTER;
                 break;
             case BlockType::AIR:
-                mMetaTiles[tileNum].blockmask |= BlockMask::AIR;
+                mask = BlockMask::AIR;
                 break;
             case BlockType::WATER:
-                mMetaTiles[tileNum].blockmask |= BlockMask::WATER;
+                mask = BlockMask::WATER;
                 break;
             case BlockType::GROUND:
-                mMetaTiles[tileNum].blockmask |= BlockMask::GROUND;
+                mask = BlockMask::GROUND;
                 break;
             case BlockType::GROUNDTOP:
-                mMetaTiles[tileNum].blockmask |= BlockMask::GROUNDTOP;
+                mask = BlockMask::GROUNDTOP;
                 break;
             default:
             case BlockType::NONE:
@@ -670,9 +666,20 @@ void Map::blockTile(const int x, const int y,
                 // Do nothing.
                 break;
         }
+        if (mask && !(mBlockMasks[tileNum] & mask))
+        {
+            mBlockMasks[tileNum] |= mask;
+            blockMaskChanged(mask);
+        }
     }
 }
 
+void Map::blockMaskChanged(const unsigned char blockBits)
+{
+    mBlockMasksVersion ++;
+    mPathCache->invalidate(blockBits);
+}
+
 bool Map::getWalk(const int x, const int y, const unsigned char walkmask) const
 {
     // You can't walk outside of the map
@@ -680,7 +687,7 @@ bool Map::getWalk(const int x, const int y, const unsigned char walkmask) const
         return false;
 
     // Check if the tile is walkable
-    return !(mMetaTiles[x + y * mWidth].blockmask & walkmask);
+    return !(mBlockMasks[x + y * mWidth] & walkmask);
 }
 
 unsigned char Map::getBlockMask(const int x, const int y) const
@@ -690,7 +697,7 @@ unsigned char Map::getBlockMask(const int x, const int y) const
         return 0;
 
     // Check if the tile is walkable
-    return mMetaTiles[x + y * mWidth].blockmask;
+    return mBlockMasks[x + y * mWidth];
 }
 
 void Map::setWalk(const int x, const int y, const bool walkable A_UNUSED)
@@ -703,22 +710,72 @@ bool Map::contains(const int x, const int y) const
     return x >= 0 && y >= 0 && x < mWidth && y < mHeight;
 }
 
-const MetaTile *Map::getMetaTile(const int x, const int y) const
+void Map::addActor(Actor *const actor)
 {
-    return &mMetaTiles[x + y * mWidth];
+    // real position will be found in next sortActors call
+    actor->mMapIndex = static_cast<int>(mActors.size());
+    mActors.push_back(actor);
+    mActorKeys.push_back(0);
+//    mSpritesUpdated = true;
 }
 
-Actors::iterator Map::addActor(Actor *const actor)
+void Map::removeActor(Actor *const actor)
 {
-    mActors.push_front(actor);
+    const int index = actor->mMapIndex;
+    if (index < 0 || static_cast<size_t>(index) >= mActors.size()
+        || mActors[index] != actor)
+    {
+        return;
+    }
+    mActors[index] = nullptr;
+    actor->mMapIndex = -1;
+    mRemovedActors ++;
 //    mSpritesUpdated = true;
-    return mActors.begin();
 }
 
-void Map::removeActor(const Actors::iterator &iterator)
+void Map::sortActors()
 {
-    mActors.erase(iterator);
-//    mSpritesUpdated = true;
+    const size_t sz = mActors.size();
+    size_t cnt = 0;
+
+    // remove holes and cache sort keys
+    for (size_t f = 0; f < sz; f ++)
+    {
+        Actor *const actor = mActors[f];
+        if (!actor)
+            continue;
+        mActors[cnt] = actor;
+        mActorKeys[cnt] = actor->getSortPixelY();
+        cnt ++;
+    }
+    if (cnt != sz)
+    {
+        mActors.resize(cnt);
+        mActorKeys.resize(cnt);
+    }
+    mRemovedActors = 0;
+
+    // stable insertion sort
+    for (size_t f = 1; f < cnt; f ++)
+    {
+        const int key = mActorKeys[f];
+        if (mActorKeys[f - 1] <= key)
+            continue;
+        Actor *const actor = mActors[f];
+        size_t pos = f;
+        do
+        {
+            mActors[pos] = mActors[pos - 1];
+            mActorKeys[pos] = mActorKeys[pos - 1];
+            pos --;
+        }
+        while (pos > 0 && mActorKeys[pos - 1] > key);
+        mActors[pos] = actor;
+        mActorKeys[pos] = key;
+    }
+
+    for (size_t f = 0; f < cnt; f ++)
+        mActors[f]->mMapIndex = static_cast<int>(f);
 }
 
 const std::string Map::getMusicFile() const
@@ -746,11 +803,6 @@ Path Map::findPath(const int startX, const int startY,
                    const unsigned char walkmask, const int maxCost)
 {
     BLOCK_START("Map::findPath")
-    // The basic walking cost of a tile.
-    static const int basicCost = 100;
-    const int basicCost2 = 100 * 362 / 256;
-    const float basicCostF = 100.0 * 362 / 256;
-
     // Path to be built up (empty by default)
     Path path;
 
@@ -767,213 +819,49 @@ Path Map::findPath(const int startX, const int startY,
         return path;
     }
 
-    // Reset starting tile's G cost to 0
-    MetaTile *const startTile = &mMetaTiles[startX + startY * mWidth];
-    if (!startTile)
+    if (mPathCache->get(startX, startY, destX, destY,
+        walkmask, maxCost, path))
     {
         BLOCK_END("Map::findPath")
         return path;
     }
 
-    startTile->Gcost = 0;
-
-    // Declare open list, a list with open tiles sorted on F cost
-    std::priority_queue<Location> openList;
-
-    // Add the start point to the open list
-    openList.push(Location(startX, startY, startTile));
-
-    bool foundPath = false;
-
-    // Keep trying new open tiles until no more tiles to try or target found
-    while (!openList.empty() && !foundPath)
-    {
-        // Take the location with the lowest F cost from the open list.
-        const Location curr = openList.top();
-        openList.pop();
-
-        const MetaTile *const tile = curr.tile;
-
-        // If the tile is already on the closed list, this means it has already
-        // been processed with a shorter path to the start point (lower G cost)
-        if (tile->whichList == mOnClosedList)
-            continue;
-
-        // Put the current tile on the closed list
-        curr.tile->whichList = mOnClosedList;
-
-        const int curWidth = curr.y * mWidth;
-        const int tileGcost = tile->Gcost;
-
-        // Check the adjacent tiles
-        for (int dy = -1; dy <= 1; dy++)
-        {
-            const int y = curr.y + dy;
-            if (y < 0 || y >= mHeight)
-                continue;
-
-            const int yWidth = y * mWidth;
-            const int dy1 = std::abs(y - destY);
-
-            for (int dx = -1; dx <= 1; dx++)
-            {
-                // Calculate location of tile to check
-                const int x = curr.x + dx;
-
-                // Skip if if we're checking the same tile we're leaving from,
-                // or if the new location falls outside of the map boundaries
-                if ((dx == 0 && dy == 0) || x < 0 || x >= mWidth)
-                    continue;
-
-                MetaTile *const newTile = &mMetaTiles[x + yWidth];
+    if (!mPathSearch)
+        mPathSearch = new PathSearch;
+    path = mPathSearch->findPath(mBlockMasks, mWidth, mHeight,
+        startX, startY, destX, destY, walkmask, maxCost);
 
-                // Skip if the tile is on the closed list or is not walkable
-                // unless its the destination tile
-                // +++ here need check block must depend on player abilities.
-                if (newTile->whichList == mOnClosedList ||
-                    ((newTile->blockmask & walkmask)
-                    && !(x == destX && y == destY))
-                    || (newTile->blockmask & BlockMask::WALL))
-                {
-                    continue;
-                }
-
-                // When taking a diagonal step, verify that we can skip the
-                // corner.
-                if (dx != 0 && dy != 0)
-                {
-                    const MetaTile *const t1 = &mMetaTiles[curr.x +
-                        (curr.y + dy) * mWidth];
-                    const MetaTile *const t2 = &mMetaTiles[curr.x +
-                        dx + curWidth];
-
-                    // +++ here need check block must depend
-                    // on player abilities.
-                    if (((t1->blockmask | t2->blockmask) & BlockMask::WALL))
-                        continue;
-                }
-
-                // Calculate G cost for this route, ~sqrt(2) for moving diagonal
-                int Gcost = tileGcost + (dx == 0 || dy == 0
-                    ? basicCost : basicCost2);
-
-                /* Demote an arbitrary direction to speed pathfinding by
-                   adding a defect (TODO: change depending on the desired
-                   visual effect, e.g. a cross-product defect toward
-                   destination).
-                   Important: as long as the total defect along any path is
-                   less than the basicCost, the pathfinder will still find one
-                   of the shortest paths! */
-                if (dx == 0 || dy == 0)
-                {
-                    // Demote horizontal and vertical directions, so that two
-                    // consecutive directions cannot have the same Fcost.
-                    ++Gcost;
-                }
-
-                // It costs extra to walk through a being (needs to be enough
-                // to make it more attractive to walk around).
-//                if (occupied(x, y))
-//                {
-//                    Gcost += 3 * basicCost;
-//                }
-
-                // Skip if Gcost becomes too much
-                // Warning: probably not entirely accurate
-                if (maxCost > 0 && Gcost > maxCost * basicCost)
-                    continue;
-
-                if (newTile->whichList != mOnOpenList)
-                {
-                    // Found a new tile (not on open nor on closed list)
-
-                    /* Update Hcost of the new tile. The pathfinder does not
-                       work reliably if the heuristic cost is higher than the
-                       real cost. In particular, using Manhattan distance is
-                       forbidden here. */
-                    const int dx1 = std::abs(x - destX);
-                    newTile->Hcost = std::abs(dx1 - dy1) * basicCost +
-                        std::min(dx1, dy1) * (basicCostF);
-
-                    // Set the current tile as the parent of the new tile
-                    newTile->parentX = curr.x;
-                    newTile->parentY = curr.y;
-
-                    // Update Gcost and Fcost of new tile
-                    newTile->Gcost = Gcost;
-                    newTile->Fcost = Gcost + newTile->Hcost;
-
-                    if (x != destX || y != destY)
-                    {
-                        // Add this tile to the open list
-                        newTile->whichList = mOnOpenList;
-                        openList.push(Location(x, y, newTile));
-                    }
-                    else
-                    {
-                        // Target location was found
-                        foundPath = true;
-                    }
-                }
-                else if (Gcost < newTile->Gcost)
-                {
-                    // Found a shorter route.
-                    // Update Gcost and Fcost of the new tile
-                    newTile->Gcost = Gcost;
-                    newTile->Fcost = Gcost + newTile->Hcost;
-
-                    // Set the current tile as the parent of the new tile
-                    newTile->parentX = curr.x;
-                    newTile->parentY = curr.y;
-
-                    // Add this tile to the open list (it's already
-                    // there, but this instance has a lower F score)
-                    openList.push(Location(x, y, newTile));
-                }
-            }
-        }
-    }
+    mPathCache->put(startX, startY, destX, destY, walkmask, maxCost, path);
+    BLOCK_END("Map::findPath")
+    return path;
+}
 
-    // Two new values to indicate whether a tile is on the open or closed list,
-    // this way we don't have to clear all the values between each pathfinding.
-    if (mOnOpenList > UINT_MAX - 2)
-    {
-        // We reset the list memebers value.
-        mOnClosedList = 1;
-        mOnOpenList = 2;
-
-        // Clean up the metaTiles
-        const int size = mWidth * mHeight;
-        for (int i = 0; i < size; ++i)
-            mMetaTiles[i].whichList = 0;
-    }
-    else
+int Map::requestPath(const int startX, const int startY,
+                     const int destX, const int destY,
+                     const unsigned char walkmask, const int maxCost)
+{
+    if (!mPathWorker)
+        mPathWorker = new PathWorker;
+    if (mPathWorkerVersion != mBlockMasksVersion)
     {
-        mOnClosedList += 2;
-        mOnOpenList += 2;
+        mPathWorker->setBlockMasks(mBlockMasks, mWidth, mHeight);
+        mPathWorkerVersion = mBlockMasksVersion;
     }
+    return mPathWorker->addRequest(startX, startY, destX, destY,
+        walkmask, maxCost);
+}
 
-    // If a path has been found, iterate backwards using the parent locations
-    // to extract it.
-    if (foundPath)
-    {
-        int pathX = destX;
-        int pathY = destY;
-
-        while (pathX != startX || pathY != startY)
-        {
-            // Add the new path node to the start of the path list
-            path.push_front(Position(pathX, pathY));
-
-            // Find out the next parent
-            const MetaTile *const tile = &mMetaTiles[pathX + pathY * mWidth];
-            pathX = tile->parentX;
-            pathY = tile->parentY;
-        }
-    }
+bool Map::getPathResult(const int id, Path &path)
+{
+    if (!mPathWorker || !id)
+        return false;
+    return mPathWorker->getResult(id, path);
+}
 
-    BLOCK_END("Map::findPath")
-    return path;
+void Map::cancelPathRequest(const int id)
+{
+    if (mPathWorker && id)
+        mPathWorker->cancelRequest(id);
 }
 
 void Map::addParticleEffect(const std::string &effectFile,
@@ -44,14 +44,15 @@ class MapItem;
 class MapLayer;
 class ObjectsLayer;
 class Particle;
+class PathCache;
+class PathSearch;
+class PathWorker;
 class Resource;
 class SpecialLayer;
 class Tileset;
 class TileAnimation;
 class WalkLayer;
 
-struct MetaTile;
-
 typedef std::vector<Tileset*> Tilesets;
 typedef std::vector<MapLayer*> Layers;
 typedef Layers::const_iterator LayersCIter;
@@ -132,12 +133,6 @@ class Map final : public Properties, public ConfigListener
          */
         const Tileset *getTilesetWithGid(const int gid) const A_WARN_UNUSED;
 
-        /**
-         * Get tile reference.
-         */
-        const MetaTile *getMetaTile(const int x,
-                                    const int y) const A_WARN_UNUSED;
-
         /**
          * Marks a tile as occupied.
          */
@@ -199,6 +194,25 @@ class Map final : public Properties, public ConfigListener
                       const unsigned char walkmask,
                       const int maxCost = 20) A_WARN_UNUSED;
 
+        /**
+         * Queues path search in background thread and returns request id,
+         * or 0 if request can't be added. Searches without cost limit use
+         * precomputed map clusters, so path can be slightly longer than
+         * one from findPath.
+         */
+        int requestPath(const int startX, const int startY,
+                        const int destX, const int destY,
+                        const unsigned char walkmask,
+                        const int maxCost = 20) A_WARN_UNUSED;
+
+        /**
+         * Gets path found for request. Returns false if search is
+         * not finished yet.
+         */
+        bool getPathResult(const int id, Path &path) A_WARN_UNUSED;
+
+        void cancelPathRequest(const int id);
+
         /**
          * Adds a particle effect
          */
@@ -268,7 +282,7 @@ class Map final : public Properties, public ConfigListener
         MapItem *findPortalXY(const int x, const int y) const A_WARN_UNUSED;
 
         int getActorsCount() const A_WARN_UNUSED
-        { return static_cast<int>(mActors.size()); }
+        { return static_cast<int>(mActors.size()) - mRemovedActors; }
 
         void setPvpMode(const int mode);
 
@@ -311,8 +325,11 @@ class Map final : public Properties, public ConfigListener
         void setAtlas(Resource *const atlas)
         { mAtlas = atlas; }
 
-        const MetaTile *getMetaTiles() const
-        { return mMetaTiles; }
+        Resource *getAtlas() const A_WARN_UNUSED
+        { return mAtlas; }
+
+        const unsigned char *getBlockMasks() const A_WARN_UNUSED
+        { return mBlockMasks; }
 
         WalkLayer *getWalkLayer()
         { return mWalkLayer; }
@@ -333,12 +350,12 @@ class Map final : public Properties, public ConfigListener
         /**
          * Adds an actor to the map.
          */
-        Actors::iterator addActor(Actor *const actor);
+        void addActor(Actor *const actor);
 
         /**
          * Removes an actor from the map.
          */
-        void removeActor(const Actors::iterator &iterator);
+        void removeActor(Actor *const actor);
 
     private:
         enum LayerType
@@ -352,6 +369,13 @@ class Map final : public Properties, public ConfigListener
          */
         void updateAmbientLayers(const float scrollX, const float scrollY);
 
+        /**
+         * Removes holes left by removed actors and restores drawing order
+         * by Y coordinate. Actors move little between frames, so insertion
+         * sort of almost sorted array is near linear.
+         */
+        void sortActors();
+
         /**
          * Draws the foreground or background layers to the given graphics output.
          */
@@ -363,6 +387,11 @@ class Map final : public Properties, public ConfigListener
          */
         bool contains(const int x, const int y) const A_WARN_UNUSED;
 
+        /**
+         * Drops cached pathfinding data affected by blockmask change.
+         */
+        void blockMaskChanged(const unsigned char blockBits);
+
         /**
          * Blockmasks for different entities
          */
@@ -372,19 +401,31 @@ class Map final : public Properties, public ConfigListener
         int mHeight;
         int mTileWidth, mTileHeight;
         int mMaxTileHeight;
-        MetaTile *mMetaTiles;
+        /**
+         * Blocking properties of tiles
+         */
+        unsigned char *mBlockMasks;
         WalkLayer *mWalkLayer;
         Layers mLayers;
         Tilesets mTilesets;
+        /**
+         * Actors in drawing order. Removed actors leave null holes until
+         * next sortActors call.
+         */
         Actors mActors;
+        std::vector<int> mActorKeys;
+        int mRemovedActors;
         bool mHasWarps;
 
         // debug flags
         int mDrawLayersFlags;
 
         // Pathfinding members
-        unsigned int mOnClosedList;
-        unsigned int mOnOpenList;
+        PathSearch *mPathSearch;
+        PathWorker *mPathWorker;
+        unsigned int mBlockMasksVersion;
+        unsigned int mPathWorkerVersion;
+        PathCache *mPathCache;
 
         // Overlay data
         AmbientLayerVector mBackgrounds;
@@ -391,8 +391,10 @@ void MapLayer::drawFringe(Graphics *const graphics, int startX, int startY,
     if (endY > mHeight)
         endY = mHeight;
 
-    ActorsCIter ai = actors->begin();
-    const ActorsCIter ai_end = actors->end();
+    // actors can be added while drawing, so use indexes.
+    // added actors will be drawn after next sort.
+    const size_t actorsSize = actors->size();
+    size_t ai = 0;
 
     const int dx = (mX * mapTileSize) - scrollX;
     const int dy = (mY * mapTileSize) - scrollY + mapTileSize;
@@ -409,9 +411,16 @@ void MapLayer::drawFringe(Graphics *const graphics, int startX, int startY,
         BLOCK_START("MapLayer::drawFringe drawmobs")
         // If drawing the fringe layer, make sure all actors above this row of
         // tiles have been drawn
-        while (ai != ai_end && (*ai)->getSortPixelY() <= y32s)
+        while (ai < actorsSize)
         {
-            (*ai)->draw(graphics, -scrollX, -scrollY);
+            // removed actors leave null holes
+            const Actor *const actor = (*actors)[ai];
+            if (actor)
+            {
+                if (actor->getSortPixelY() > y32s)
+                    break;
+                actor->draw(graphics, -scrollX, -scrollY);
+            }
             ++ ai;
         }
         BLOCK_END("MapLayer::drawFringe drawmobs")
@@ -531,9 +540,11 @@ void MapLayer::drawFringe(Graphics *const graphics, int startX, int startY,
         && layerDrawFlags != MapType::SPECIAL4)
     {
         BLOCK_START("MapLayer::drawFringe drawmobs")
-        while (ai != ai_end)
+        while (ai < actorsSize)
         {
-            (*ai)->draw(graphics, -scrollX, -scrollY);
+            const Actor *const actor = (*actors)[ai];
+            if (actor)
+                actor->draw(graphics, -scrollX, -scrollY);
             ++ai;
         }
         BLOCK_END("MapLayer::drawFringe drawmobs")
@@ -1,53 +0,0 @@
-/*
- *  The ManaPlus Client
- *  Copyright (C) 2004-2009  The Mana World Development Team
- *  Copyright (C) 2009-2010  The Mana Developers
- *  Copyright (C) 2011-2014  The ManaPlus Developers
- *
- *  This file is part of The ManaPlus Client.
- *
- *  This program is free software; you can redistribute it and/or modify
- *  it under the terms of the GNU General Public License as published by
- *  the Free Software Foundation; either version 2 of the License, or
- *  any later version.
- *
- *  This program is distributed in the hope that it will be useful,
- *  but WITHOUT ANY WARRANTY; without even the implied warranty of
- *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
- *  GNU General Public License for more details.
- *
- *  You should have received a copy of the GNU General Public License
- *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
- */
-
-#ifndef RESOURCES_MAP_METATILE_H
-#define RESOURCES_MAP_METATILE_H
-
-#include "localconsts.h"
-
-/**
- * A meta tile stores additional information about a location on a tile map.
- * This is information that doesn't need to be repeated for each tile in each
- * layer of the map.
- */
-struct MetaTile final
-{
-    /**
-     * Constructor.
-     */
-    MetaTile() : Fcost(0), Gcost(0), Hcost(0), whichList(0),
-        parentX(0), parentY(0), blockmask(0)
-    {}
-
-    A_DELETE_COPY(MetaTile)
-
-    // Pathfinding members
-    int Fcost;               /**< Estimation of total path cost */
-    int Gcost;               /**< Cost from start to this location */
-    int Hcost;               /**< Estimated cost to goal */
-    unsigned whichList;      /**< No list, open list or closed list */
-    int parentX;             /**< X coordinate of parent tile */
-    int parentY;             /**< Y coordinate of parent tile */
-    unsigned char blockmask; /**< Blocking properties of this tile */
-};
-#endif  // RESOURCES_MAP_METATILE_H
@@ -0,0 +1,100 @@
+/*
+ *  The ManaPlus Client
+ *  Copyright (C) 2011-2014  The ManaPlus Developers
+ *
+ *  This file is part of The ManaPlus Client.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "resources/map/pathcache.h"
+
+#include "resources/map/blockmask.h"
+
+#include "debug.h"
+
+PathCache::PathCache(const unsigned int size) :
+    mEntries(size),
+    mUseCounter(0)
+{
+}
+
+bool PathCache::get(const int startX, const int startY,
+                    const int destX, const int destY,
+                    const unsigned char walkmask, const int maxCost,
+                    Path &path)
+{
+    FOR_EACH (std::vector<PathCacheEntry>::iterator, it, mEntries)
+    {
+        PathCacheEntry &entry = *it;
+        if (entry.startX == startX
+            && entry.startY == startY
+            && entry.destX == destX
+            && entry.destY == destY
+            && entry.walkmask == walkmask
+            && entry.maxCost == maxCost)
+        {
+            entry.lastUse = ++ mUseCounter;
+            path = entry.path;
+            return true;
+        }
+    }
+    return false;
+}
+
+void PathCache::put(const int startX, const int startY,
+                    const int destX, const int destY,
+                    const unsigned char walkmask, const int maxCost,
+                    const Path &path)
+{
+    if (mEntries.empty())
+        return;
+
+    std::vector<PathCacheEntry>::iterator oldest = mEntries.begin();
+    FOR_EACH (std::vector<PathCacheEntry>::iterator, it, mEntries)
+    {
+        if ((*it).lastUse < (*oldest).lastUse)
+            oldest = it;
+    }
+
+    PathCacheEntry &entry = *oldest;
+    entry.startX = startX;
+    entry.startY = startY;
+    entry.destX = destX;
+    entry.destY = destY;
+    entry.walkmask = walkmask;
+    entry.maxCost = maxCost;
+    entry.path = path;
+    entry.lastUse = ++ mUseCounter;
+}
+
+void PathCache::invalidate(const unsigned char blockBits)
+{
+    FOR_EACH (std::vector<PathCacheEntry>::iterator, it, mEntries)
+    {
+        PathCacheEntry &entry = *it;
+        if (entry.startX >= 0
+            && ((entry.walkmask | BlockMask::WALL) & blockBits))
+        {
+            entry = PathCacheEntry();
+        }
+    }
+}
+
+void PathCache::clear()
+{
+    FOR_EACH (std::vector<PathCacheEntry>::iterator, it, mEntries)
+        *it = PathCacheEntry();
+    mUseCounter = 0;
+}
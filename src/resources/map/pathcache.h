@@ -0,0 +1,90 @@
+/*
+ *  The ManaPlus Client
+ *  Copyright (C) 2011-2014  The ManaPlus Developers
+ *
+ *  This file is part of The ManaPlus Client.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef RESOURCES_MAP_PATHCACHE_H
+#define RESOURCES_MAP_PATHCACHE_H
+
+#include "position.h"
+
+#include <vector>
+
+#include "localconsts.h"
+
+/**
+ * Small LRU cache of recently found paths.
+ */
+class PathCache final
+{
+    public:
+        explicit PathCache(const unsigned int size);
+
+        A_DELETE_COPY(PathCache)
+
+        /**
+         * Copies cached path to path and returns true if it was found.
+         */
+        bool get(const int startX, const int startY,
+                 const int destX, const int destY,
+                 const unsigned char walkmask, const int maxCost,
+                 Path &path);
+
+        void put(const int startX, const int startY,
+                 const int destX, const int destY,
+                 const unsigned char walkmask, const int maxCost,
+                 const Path &path);
+
+        /**
+         * Drops paths found with walkmask what can be affected by
+         * changed blockmask bits.
+         */
+        void invalidate(const unsigned char blockBits);
+
+        void clear();
+
+    private:
+        struct PathCacheEntry final
+        {
+            PathCacheEntry() :
+                path(),
+                startX(-1),
+                startY(-1),
+                destX(-1),
+                destY(-1),
+                maxCost(0),
+                lastUse(0),
+                walkmask(0)
+            {
+            }
+
+            Path path;
+            int startX;
+            int startY;
+            int destX;
+            int destY;
+            int maxCost;
+            unsigned int lastUse;
+            unsigned char walkmask;
+        };
+
+        std::vector<PathCacheEntry> mEntries;
+        unsigned int mUseCounter;
+};
+
+#endif  // RESOURCES_MAP_PATHCACHE_H
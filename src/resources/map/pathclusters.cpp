@@ -0,0 +1,470 @@
+/*
+ *  The ManaPlus Client
+ *  Copyright (C) 2011-2014  The ManaPlus Developers
+ *
+ *  This file is part of The ManaPlus Client.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "resources/map/pathclusters.h"
+
+#include "resources/map/blockmask.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <functional>
+#include <queue>
+
+#include "debug.h"
+
+namespace
+{
+    // same costs as in Map::findPath
+    const int basicCost = 100;
+    const int straightCost = basicCost + 1;
+    const int diagonalCost = 100 * 362 / 256;
+    const float basicCostF = 100.0 * 362 / 256;
+
+    typedef std::pair<int, int> CostNode;
+    typedef std::priority_queue<CostNode, std::vector<CostNode>,
+        std::greater<CostNode> > CostQueue;
+
+    int estimateCost(const int x1, const int y1,
+                     const int x2, const int y2)
+    {
+        const int dx = std::abs(x1 - x2);
+        const int dy = std::abs(y1 - y2);
+        return std::abs(dx - dy) * basicCost
+            + static_cast<int>(std::min(dx, dy) * basicCostF);
+    }
+}  // namespace
+
+PathClusters::PathClusters(const unsigned char *const blockMasks,
+                           const int width, const int height,
+                           const unsigned char walkmask) :
+    mBlockMasks(blockMasks),
+    mWidth(width),
+    mHeight(height),
+    mClustersWidth(0),
+    mClustersHeight(0),
+    mNodes(),
+    mNodeByTile(),
+    mClusterNodes(),
+    mCosts(clusterSize * clusterSize),
+    mParents(clusterSize * clusterSize),
+    mVisited(clusterSize * clusterSize),
+    mSearchId(0),
+    mSearchX(0),
+    mSearchY(0),
+    mWalkMask(walkmask),
+    mBlockMask(static_cast<unsigned char>(walkmask | BlockMask::WALL)),
+    mDirty(true)
+{
+}
+
+bool PathClusters::isWalkable(const int x, const int y) const
+{
+    return !(mBlockMasks[x + y * mWidth] & mBlockMask);
+}
+
+void PathClusters::build()
+{
+    mNodes.clear();
+    mNodeByTile.clear();
+    mClustersWidth = (mWidth + clusterSize - 1) / clusterSize;
+    mClustersHeight = (mHeight + clusterSize - 1) / clusterSize;
+    mClusterNodes.clear();
+    mClusterNodes.resize(static_cast<size_t>(
+        mClustersWidth * mClustersHeight));
+
+    for (int cy = 0; cy < mClustersHeight; cy ++)
+    {
+        const int y = cy * clusterSize;
+        for (int cx = 0; cx < mClustersWidth; cx ++)
+        {
+            const int x = cx * clusterSize;
+            // border with right neighbour
+            if (cx + 1 < mClustersWidth)
+            {
+                addEntrances(x + clusterSize - 1, y,
+                    x + clusterSize, y, 0, 1);
+            }
+            // border with bottom neighbour
+            if (cy + 1 < mClustersHeight)
+            {
+                addEntrances(x, y + clusterSize - 1,
+                    x, y + clusterSize, 1, 0);
+            }
+        }
+    }
+
+    connectClusterNodes();
+    mDirty = false;
+}
+
+void PathClusters::addEntrances(const int x1, const int y1,
+                                const int x2, const int y2,
+                                const int dx, const int dy)
+{
+    int start = -1;
+    for (int f = 0; f <= clusterSize; f ++)
+    {
+        const int ax = x1 + f * dx;
+        const int ay = y1 + f * dy;
+        const bool open = f < clusterSize
+            && ax < mWidth && ay < mHeight
+            && isWalkable(ax, ay)
+            && isWalkable(x2 + f * dx, y2 + f * dy);
+        if (open)
+        {
+            if (start < 0)
+                start = f;
+            continue;
+        }
+        if (start < 0)
+            continue;
+
+        // long openings get transitions at both ends, short one in middle
+        const int end = f - 1;
+        int points[2];
+        int count = 0;
+        if (end - start >= 5)
+        {
+            points[count ++] = start;
+            points[count ++] = end;
+        }
+        else
+        {
+            points[count ++] = (start + end) / 2;
+        }
+        for (int k = 0; k < count; k ++)
+        {
+            const int p = points[k];
+            const int node1 = addNode(x1 + p * dx, y1 + p * dy);
+            const int node2 = addNode(x2 + p * dx, y2 + p * dy);
+            mNodes[static_cast<size_t>(node1)].edges.push_back(
+                Edge(node2, straightCost));
+            mNodes[static_cast<size_t>(node2)].edges.push_back(
+                Edge(node1, straightCost));
+        }
+        start = -1;
+    }
+}
+
+int PathClusters::addNode(const int x, const int y)
+{
+    const int tile = x + y * mWidth;
+    const std::map<int, int>::const_iterator it = mNodeByTile.find(tile);
+    if (it != mNodeByTile.end())
+        return (*it).second;
+
+    const int node = static_cast<int>(mNodes.size());
+    mNodes.push_back(Node(x, y));
+    mNodeByTile[tile] = node;
+    mClusterNodes[static_cast<size_t>(getCluster(x, y))].push_back(node);
+    return node;
+}
+
+void PathClusters::connectClusterNodes()
+{
+    const int clustersCount = mClustersWidth * mClustersHeight;
+    for (int cluster = 0; cluster < clustersCount; cluster ++)
+    {
+        const std::vector<int> &nodes = mClusterNodes[
+            static_cast<size_t>(cluster)];
+        const size_t sz = nodes.size();
+        for (size_t f = 0; f < sz; f ++)
+        {
+            Node &node = mNodes[static_cast<size_t>(nodes[f])];
+            searchInCluster(cluster, node.x, node.y, -1, -1, nullptr);
+            for (size_t k = 0; k < sz; k ++)
+            {
+                if (k == f)
+                    continue;
+                const Node &node2 = mNodes[static_cast<size_t>(nodes[k])];
+                const int cost = getClusterCost(node2.x, node2.y);
+                if (cost >= 0)
+                    node.edges.push_back(Edge(nodes[k], cost));
+            }
+        }
+    }
+}
+
+int PathClusters::getClusterCost(const int x, const int y) const
+{
+    const int x0 = x - mSearchX;
+    const int y0 = y - mSearchY;
+    if (x0 < 0 || y0 < 0 || x0 >= clusterSize || y0 >= clusterSize)
+        return -1;
+    const size_t idx = static_cast<size_t>(x0 + y0 * clusterSize);
+    if (mVisited[idx] != mSearchId)
+        return -1;
+    return mCosts[idx];
+}
+
+int PathClusters::searchInCluster(const int cluster,
+                                  const int startX, const int startY,
+                                  const int destX, const int destY,
+                                  Path *const path)
+{
+    const int minX = (cluster % mClustersWidth) * clusterSize;
+    const int minY = (cluster / mClustersWidth) * clusterSize;
+    const int maxX = std::min(minX + clusterSize, mWidth);
+    const int maxY = std::min(minY + clusterSize, mHeight);
+    const bool hasDest = destX >= 0;
+
+    mSearchX = minX;
+    mSearchY = minY;
+    mSearchId ++;
+    if (!mSearchId)
+    {
+        std::fill(mVisited.begin(), mVisited.end(), 0U);
+        mSearchId = 1;
+    }
+
+    const int startIdx = (startX - minX) + (startY - minY) * clusterSize;
+    const int destIdx = hasDest
+        ? (destX - minX) + (destY - minY) * clusterSize : -1;
+
+    CostQueue queue;
+    mVisited[static_cast<size_t>(startIdx)] = mSearchId;
+    mCosts[static_cast<size_t>(startIdx)] = 0;
+    mParents[static_cast<size_t>(startIdx)] = -1;
+    queue.push(CostNode(hasDest
+        ? estimateCost(startX, startY, destX, destY) : 0, startIdx));
+
+    bool found = false;
+    while (!queue.empty())
+    {
+        const CostNode top = queue.top();
+        queue.pop();
+        const int idx = top.second;
+        const int x = minX + idx % clusterSize;
+        const int y = minY + idx / clusterSize;
+        const int cost = mCosts[static_cast<size_t>(idx)];
+        const int estimate = hasDest
+            ? estimateCost(x, y, destX, destY) : 0;
+        // outdated queue entry
+        if (top.first != cost + estimate)
+            continue;
+        if (idx == destIdx)
+        {
+            found = true;
+            break;
+        }
+
+        for (int dy = -1; dy <= 1; dy ++)
+        {
+            const int y2 = y + dy;
+            if (y2 < minY || y2 >= maxY)
+                continue;
+            for (int dx = -1; dx <= 1; dx ++)
+            {
+                const int x2 = x + dx;
+                if ((!dx && !dy) || x2 < minX || x2 >= maxX
+                    || !isWalkable(x2, y2))
+                {
+                    continue;
+                }
+                int newCost = cost;
+                if (dx && dy)
+                {
+                    // same corner rules as in Map::findPath
+                    if (((mBlockMasks[x + y2 * mWidth]
+                        | mBlockMasks[x2 + y * mWidth])
+                        & BlockMask::WALL))
+                    {
+                        continue;
+                    }
+                    newCost += diagonalCost;
+                }
+                else
+                {
+                    newCost += straightCost;
+                }
+
+                const int idx2 = (x2 - minX) + (y2 - minY) * clusterSize;
+                const size_t uidx2 = static_cast<size_t>(idx2);
+                if (mVisited[uidx2] == mSearchId
+                    && mCosts[uidx2] <= newCost)
+                {
+                    continue;
+                }
+                mVisited[uidx2] = mSearchId;
+                mCosts[uidx2] = newCost;
+                mParents[uidx2] = idx;
+                queue.push(CostNode(newCost + (hasDest
+                    ? estimateCost(x2, y2, destX, destY) : 0), idx2));
+            }
+        }
+    }
+
+    if (!found)
+        return -1;
+
+    if (path)
+    {
+        Path part;
+        int idx = destIdx;
+        while (idx != startIdx)
+        {
+            part.push_front(Position(minX + idx % clusterSize,
+                minY + idx / clusterSize));
+            idx = mParents[static_cast<size_t>(idx)];
+        }
+        path->splice(path->end(), part);
+    }
+    return mCosts[static_cast<size_t>(destIdx)];
+}
+
+bool PathClusters::findPath(const int startX, const int startY,
+                            const int destX, const int destY,
+                            Path &path)
+{
+    if (mDirty)
+        build();
+
+    const int startCluster = getCluster(startX, startY);
+    const int destCluster = getCluster(destX, destY);
+    if (startCluster == destCluster)
+        return false;
+
+    const int nodesCount = static_cast<int>(mNodes.size());
+    const int startNode = nodesCount;
+    const int destNode = nodesCount + 1;
+
+    // costs from destination to nodes in its cluster
+    std::vector<int> destCosts(static_cast<size_t>(nodesCount), -1);
+    const std::vector<int> &destNodes = mClusterNodes[
+        static_cast<size_t>(destCluster)];
+    searchInCluster(destCluster, destX, destY, -1, -1, nullptr);
+    FOR_EACH (std::vector<int>::const_iterator, it, destNodes)
+    {
+        const Node &node = mNodes[static_cast<size_t>(*it)];
+        destCosts[static_cast<size_t>(*it)] = getClusterCost(
+            node.x, node.y);
+    }
+
+    std::vector<Edge> startEdges;
+    const std::vector<int> &startNodes = mClusterNodes[
+        static_cast<size_t>(startCluster)];
+    searchInCluster(startCluster, startX, startY, -1, -1, nullptr);
+    FOR_EACH (std::vector<int>::const_iterator, it, startNodes)
+    {
+        const Node &node = mNodes[static_cast<size_t>(*it)];
+        const int cost = getClusterCost(node.x, node.y);
+        if (cost >= 0)
+            startEdges.push_back(Edge(*it, cost));
+    }
+
+    std::vector<int> costs(static_cast<size_t>(nodesCount + 2), INT_MAX);
+    std::vector<int> parents(static_cast<size_t>(nodesCount + 2), -1);
+    CostQueue queue;
+    costs[static_cast<size_t>(startNode)] = 0;
+    queue.push(CostNode(estimateCost(startX, startY, destX, destY),
+        startNode));
+
+    bool found = false;
+    while (!queue.empty())
+    {
+        const CostNode top = queue.top();
+        queue.pop();
+        const int id = top.second;
+        if (id == destNode)
+        {
+            found = true;
+            break;
+        }
+
+        const int cost = costs[static_cast<size_t>(id)];
+        const std::vector<Edge> &edges = (id == startNode)
+            ? startEdges : mNodes[static_cast<size_t>(id)].edges;
+        if (id != startNode)
+        {
+            const Node &node = mNodes[static_cast<size_t>(id)];
+            if (top.first != cost + estimateCost(node.x, node.y,
+                destX, destY))
+            {
+                continue;
+            }
+            const int destCost = destCosts[static_cast<size_t>(id)];
+            if (destCost >= 0 && cost + destCost
+                < costs[static_cast<size_t>(destNode)])
+            {
+                costs[static_cast<size_t>(destNode)] = cost + destCost;
+                parents[static_cast<size_t>(destNode)] = id;
+                queue.push(CostNode(cost + destCost, destNode));
+            }
+        }
+
+        FOR_EACH (std::vector<Edge>::const_iterator, it, edges)
+        {
+            const Edge &edge = *it;
+            const int newCost = cost + edge.cost;
+            const size_t next = static_cast<size_t>(edge.node);
+            if (newCost >= costs[next])
+                continue;
+            costs[next] = newCost;
+            parents[next] = id;
+            const Node &node = mNodes[next];
+            queue.push(CostNode(newCost + estimateCost(node.x, node.y,
+                destX, destY), edge.node));
+        }
+    }
+
+    if (!found)
+        return false;
+
+    std::vector<int> route;
+    for (int id = parents[static_cast<size_t>(destNode)];
+         id != startNode;
+         id = parents[static_cast<size_t>(id)])
+    {
+        route.push_back(id);
+    }
+    std::reverse(route.begin(), route.end());
+
+    // refine graph route to tiles
+    int x = startX;
+    int y = startY;
+    int cluster = startCluster;
+    FOR_EACH (std::vector<int>::const_iterator, it, route)
+    {
+        const Node &node = mNodes[static_cast<size_t>(*it)];
+        const int nodeCluster = getCluster(node.x, node.y);
+        if (nodeCluster != cluster)
+        {
+            // step between neighbour clusters
+            path.push_back(Position(node.x, node.y));
+        }
+        else if (searchInCluster(cluster, x, y,
+                 node.x, node.y, &path) < 0)
+        {
+            path.clear();
+            return false;
+        }
+        x = node.x;
+        y = node.y;
+        cluster = nodeCluster;
+    }
+    if (searchInCluster(destCluster, x, y, destX, destY, &path) < 0)
+    {
+        path.clear();
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,144 @@
+/*
+ *  The ManaPlus Client
+ *  Copyright (C) 2011-2014  The ManaPlus Developers
+ *
+ *  This file is part of The ManaPlus Client.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef RESOURCES_MAP_PATHCLUSTERS_H
+#define RESOURCES_MAP_PATHCLUSTERS_H
+
+#include "position.h"
+
+#include <map>
+#include <vector>
+
+#include "localconsts.h"
+
+/**
+ * Hierarchical pathfinding data for one walkmask.
+ *
+ * Map is split to square clusters. Walkable openings between neighbour
+ * clusters become graph nodes, and nodes inside one cluster are connected
+ * with precomputed walking costs. Long routes are searched on this graph
+ * and then refined to tiles inside single clusters.
+ */
+class PathClusters final
+{
+    public:
+        PathClusters(const unsigned char *const blockMasks,
+                     const int width, const int height,
+                     const unsigned char walkmask);
+
+        A_DELETE_COPY(PathClusters)
+
+        /**
+         * Marks data as outdated. It will be rebuilt on next search.
+         */
+        void setDirty()
+        { mDirty = true; }
+
+        unsigned char getWalkMask() const A_WARN_UNUSED
+        { return mWalkMask; }
+
+        /**
+         * Finds path between tiles in different clusters.
+         * Returns false if route can't be found on clusters graph.
+         */
+        bool findPath(const int startX, const int startY,
+                      const int destX, const int destY,
+                      Path &path) A_WARN_UNUSED;
+
+        static const int clusterSize = 16;
+
+    private:
+        struct Edge final
+        {
+            Edge(const int node0, const int cost0) :
+                node(node0),
+                cost(cost0)
+            {
+            }
+
+            int node;
+            int cost;
+        };
+
+        struct Node final
+        {
+            Node(const int x0, const int y0) :
+                edges(),
+                x(x0),
+                y(y0)
+            {
+            }
+
+            std::vector<Edge> edges;
+            int x;
+            int y;
+        };
+
+        void build();
+
+        void addEntrances(const int x1, const int y1,
+                          const int x2, const int y2,
+                          const int dx, const int dy);
+
+        int addNode(const int x, const int y);
+
+        void connectClusterNodes();
+
+        bool isWalkable(const int x, const int y) const A_WARN_UNUSED;
+
+        int getCluster(const int x, const int y) const A_WARN_UNUSED
+        {
+            return x / clusterSize + (y / clusterSize) * mClustersWidth;
+        }
+
+        /**
+         * Searches inside cluster. If destX is negative, computes costs
+         * to all cluster tiles. Returns cost to destination or -1.
+         */
+        int searchInCluster(const int cluster,
+                            const int startX, const int startY,
+                            const int destX, const int destY,
+                            Path *const path);
+
+        int getClusterCost(const int x, const int y) const A_WARN_UNUSED;
+
+        const unsigned char *mBlockMasks;
+        int mWidth;
+        int mHeight;
+        int mClustersWidth;
+        int mClustersHeight;
+        std::vector<Node> mNodes;
+        std::map<int, int> mNodeByTile;
+        std::vector<std::vector<int> > mClusterNodes;
+
+        // scratch data for searches inside cluster
+        std::vector<int> mCosts;
+        std::vector<int> mParents;
+        std::vector<unsigned int> mVisited;
+        unsigned int mSearchId;
+        int mSearchX;
+        int mSearchY;
+
+        unsigned char mWalkMask;
+        unsigned char mBlockMask;
+        bool mDirty;
+};
+
+#endif  // RESOURCES_MAP_PATHCLUSTERS_H
@@ -0,0 +1,260 @@
+/*
+ *  The ManaPlus Client
+ *  Copyright (C) 2011-2014  The ManaPlus Developers
+ *
+ *  This file is part of The ManaPlus Client.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "resources/map/pathsearch.h"
+
+#include "resources/map/blockmask.h"
+#include "resources/map/location.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <queue>
+
+#include "debug.h"
+
+PathSearch::PathSearch() :
+    mGcost(),
+    mHcost(),
+    mParent(),
+    mWhichList(),
+    mOnClosedList(1),
+    mOnOpenList(2)
+{
+}
+
+void PathSearch::prepare(const int size)
+{
+    const size_t sz = static_cast<size_t>(size);
+    if (mWhichList.size() != sz)
+    {
+        mGcost.resize(sz);
+        mHcost.resize(sz);
+        mParent.resize(sz);
+        mWhichList.assign(sz, 0U);
+        mOnClosedList = 1;
+        mOnOpenList = 2;
+    }
+    // Two new values to indicate whether a tile is on the open or closed list,
+    // this way we don't have to clear all the values between each pathfinding.
+    else if (mOnOpenList > UINT_MAX - 2)
+    {
+        // We reset the list memebers value.
+        mOnClosedList = 1;
+        mOnOpenList = 2;
+        std::fill(mWhichList.begin(), mWhichList.end(), 0U);
+    }
+    else
+    {
+        mOnClosedList += 2;
+        mOnOpenList += 2;
+    }
+}
+
+Path PathSearch::findPath(const unsigned char *const blockMasks,
+                          const int width, const int height,
+                          const int startX, const int startY,
+                          const int destX, const int destY,
+                          const unsigned char walkmask,
+                          const int maxCost)
+{
+    // The basic walking cost of a tile.
+    static const int basicCost = 100;
+    const int basicCost2 = 100 * 362 / 256;
+    const float basicCostF = 100.0 * 362 / 256;
+
+    // Path to be built up (empty by default)
+    Path path;
+
+    prepare(width * height);
+
+    // Reset starting tile's G cost to 0
+    const int startIndex = startX + startY * width;
+    mGcost[static_cast<size_t>(startIndex)] = 0;
+
+    // Declare open list, a list with open tiles sorted on F cost
+    std::priority_queue<Location> openList;
+
+    // Add the start point to the open list
+    openList.push(Location(startX, startY, 0));
+
+    bool foundPath = false;
+
+    // Keep trying new open tiles until no more tiles to try or target found
+    while (!openList.empty() && !foundPath)
+    {
+        // Take the location with the lowest F cost from the open list.
+        const Location curr = openList.top();
+        openList.pop();
+
+        const size_t currIndex = static_cast<size_t>(
+            curr.x + curr.y * width);
+
+        // If the tile is already on the closed list, this means it has already
+        // been processed with a shorter path to the start point (lower G cost)
+        if (mWhichList[currIndex] == mOnClosedList)
+            continue;
+
+        // Put the current tile on the closed list
+        mWhichList[currIndex] = mOnClosedList;
+
+        const int curWidth = curr.y * width;
+        const int tileGcost = mGcost[currIndex];
+
+        // Check the adjacent tiles
+        for (int dy = -1; dy <= 1; dy++)
+        {
+            const int y = curr.y + dy;
+            if (y < 0 || y >= height)
+                continue;
+
+            const int yWidth = y * width;
+            const int dy1 = std::abs(y - destY);
+
+            for (int dx = -1; dx <= 1; dx++)
+            {
+                // Calculate location of tile to check
+                const int x = curr.x + dx;
+
+                // Skip if if we're checking the same tile we're leaving from,
+                // or if the new location falls outside of the map boundaries
+                if ((dx == 0 && dy == 0) || x < 0 || x >= width)
+                    continue;
+
+                const size_t newIndex = static_cast<size_t>(x + yWidth);
+                const unsigned char newMask = blockMasks[newIndex];
+
+                // Skip if the tile is on the closed list or is not walkable
+                // unless its the destination tile
+                // +++ here need check block must depend on player abilities.
+                if (mWhichList[newIndex] == mOnClosedList ||
+                    ((newMask & walkmask)
+                    && !(x == destX && y == destY))
+                    || (newMask & BlockMask::WALL))
+                {
+                    continue;
+                }
+
+                // When taking a diagonal step, verify that we can skip the
+                // corner.
+                if (dx != 0 && dy != 0)
+                {
+                    const unsigned char t1 = blockMasks[curr.x +
+                        (curr.y + dy) * width];
+                    const unsigned char t2 = blockMasks[curr.x +
+                        dx + curWidth];
+
+                    // +++ here need check block must depend
+                    // on player abilities.
+                    if (((t1 | t2) & BlockMask::WALL))
+                        continue;
+                }
+
+                // Calculate G cost for this route, ~sqrt(2) for moving diagonal
+                int Gcost = tileGcost + (dx == 0 || dy == 0
+                    ? basicCost : basicCost2);
+
+                /* Demote an arbitrary direction to speed pathfinding by
+                   adding a defect (TODO: change depending on the desired
+                   visual effect, e.g. a cross-product defect toward
+                   destination).
+                   Important: as long as the total defect along any path is
+                   less than the basicCost, the pathfinder will still find one
+                   of the shortest paths! */
+                if (dx == 0 || dy == 0)
+                {
+                    // Demote horizontal and vertical directions, so that two
+                    // consecutive directions cannot have the same Fcost.
+                    ++Gcost;
+                }
+
+                // Skip if Gcost becomes too much
+                // Warning: probably not entirely accurate
+                if (maxCost > 0 && Gcost > maxCost * basicCost)
+                    continue;
+
+                if (mWhichList[newIndex] != mOnOpenList)
+                {
+                    // Found a new tile (not on open nor on closed list)
+
+                    /* Update Hcost of the new tile. The pathfinder does not
+                       work reliably if the heuristic cost is higher than the
+                       real cost. In particular, using Manhattan distance is
+                       forbidden here. */
+                    const int dx1 = std::abs(x - destX);
+                    const int Hcost = static_cast<int>(
+                        std::abs(dx1 - dy1) * basicCost +
+                        std::min(dx1, dy1) * (basicCostF));
+                    mHcost[newIndex] = Hcost;
+
+                    // Set the current tile as the parent of the new tile
+                    mParent[newIndex] = static_cast<int>(currIndex);
+
+                    // Update Gcost of new tile
+                    mGcost[newIndex] = Gcost;
+
+                    if (x != destX || y != destY)
+                    {
+                        // Add this tile to the open list
+                        mWhichList[newIndex] = mOnOpenList;
+                        openList.push(Location(x, y, Gcost + Hcost));
+                    }
+                    else
+                    {
+                        // Target location was found
+                        foundPath = true;
+                    }
+                }
+                else if (Gcost < mGcost[newIndex])
+                {
+                    // Found a shorter route.
+                    // Update Gcost of the new tile
+                    mGcost[newIndex] = Gcost;
+
+                    // Set the current tile as the parent of the new tile
+                    mParent[newIndex] = static_cast<int>(currIndex);
+
+                    // Add this tile to the open list (it's already
+                    // there, but this instance has a lower F score)
+                    openList.push(Location(x, y,
+                        Gcost + mHcost[newIndex]));
+                }
+            }
+        }
+    }
+
+    // If a path has been found, iterate backwards using the parent locations
+    // to extract it.
+    if (foundPath)
+    {
+        int pathIndex = destX + destY * width;
+
+        while (pathIndex != startIndex)
+        {
+            // Add the new path node to the start of the path list
+            path.push_front(Position(pathIndex % width, pathIndex / width));
+
+            // Find out the next parent
+            pathIndex = mParent[static_cast<size_t>(pathIndex)];
+        }
+    }
+
+    return path;
+}
@@ -0,0 +1,69 @@
+/*
+ *  The ManaPlus Client
+ *  Copyright (C) 2011-2014  The ManaPlus Developers
+ *
+ *  This file is part of The ManaPlus Client.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef RESOURCES_MAP_PATHSEARCH_H
+#define RESOURCES_MAP_PATHSEARCH_H
+
+#include "position.h"
+
+#include <vector>
+
+#include "localconsts.h"
+
+/**
+ * Reusable A* search context over map blockmask plane.
+ *
+ * Scratch data is kept between searches, and open / closed list marks are
+ * stamped with search generation, so nothing need to be cleaned after
+ * each search.
+ */
+class PathSearch final
+{
+    public:
+        PathSearch();
+
+        A_DELETE_COPY(PathSearch)
+
+        /**
+         * Find a path from one location to the next.
+         */
+        Path findPath(const unsigned char *const blockMasks,
+                      const int width, const int height,
+                      const int startX, const int startY,
+                      const int destX, const int destY,
+                      const unsigned char walkmask,
+                      const int maxCost) A_WARN_UNUSED;
+
+    private:
+        void prepare(const int size);
+
+        /** Cost from start to location */
+        std::vector<int> mGcost;
+        /** Estimated cost to goal */
+        std::vector<int> mHcost;
+        /** Index of parent location */
+        std::vector<int> mParent;
+        /** No list, open list or closed list */
+        std::vector<unsigned int> mWhichList;
+        unsigned int mOnClosedList;
+        unsigned int mOnOpenList;
+};
+
+#endif  // RESOURCES_MAP_PATHSEARCH_H
@@ -0,0 +1,276 @@
+/*
+ *  The ManaPlus Client
+ *  Copyright (C) 2011-2014  The ManaPlus Developers
+ *
+ *  This file is part of The ManaPlus Client.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "resources/map/pathworker.h"
+
+#include "resources/map/pathcache.h"
+#include "resources/map/pathclusters.h"
+#include "resources/map/pathsearch.h"
+
+#include "utils/delete2.h"
+#include "utils/dtor.h"
+#include "utils/sdlhelper.h"
+
+#include <string.h>
+
+#include "debug.h"
+
+PathWorker::PathSnapshot::PathSnapshot(const unsigned char *const blockMasks0,
+                                       const int width0,
+                                       const int height0,
+                                       const int id0) :
+    blockMasks(new unsigned char[static_cast<size_t>(width0 * height0)]),
+    width(width0),
+    height(height0),
+    id(id0),
+    refs(1)
+{
+    memcpy(blockMasks, blockMasks0, static_cast<size_t>(width * height));
+}
+
+PathWorker::PathSnapshot::~PathSnapshot()
+{
+    delete [] blockMasks;
+}
+
+PathWorker::PathWorker() :
+    mRequests(),
+    mResults(),
+    mSnapshot(nullptr),
+    mSearch(new PathSearch),
+    mCache(new PathCache(32)),
+    mClusters(),
+    mSearchSnapshotId(0),
+    mThread(nullptr),
+    mMutex(SDL_CreateMutex()),
+    mCondition(SDL_CreateCond()),
+    mLastId(0),
+    mLastSnapshotId(0),
+    mCurrentId(0),
+    mRunning(true),
+    mCancelCurrent(false)
+{
+    mThread = SDL::createThread(&PathWorker::workerThread, "pathworker", this);
+}
+
+PathWorker::~PathWorker()
+{
+    SDL_mutexP(mMutex);
+    mRunning = false;
+    SDL_CondSignal(mCondition);
+    SDL_mutexV(mMutex);
+    if (mThread)
+        SDL_WaitThread(mThread, nullptr);
+    mThread = nullptr;
+
+    FOR_EACH (std::list<PathRequest>::iterator, it, mRequests)
+        releaseSnapshot((*it).snapshot);
+    mRequests.clear();
+    releaseSnapshot(mSnapshot);
+    mSnapshot = nullptr;
+
+    delete2(mSearch);
+    delete2(mCache);
+    delete_all(mClusters);
+    mClusters.clear();
+
+    SDL_DestroyCond(mCondition);
+    mCondition = nullptr;
+    SDL_DestroyMutex(mMutex);
+    mMutex = nullptr;
+}
+
+void PathWorker::releaseSnapshot(PathSnapshot *const snapshot)
+{
+    if (snapshot && !-- snapshot->refs)
+        delete snapshot;
+}
+
+void PathWorker::setBlockMasks(const unsigned char *const blockMasks,
+                               const int width, const int height)
+{
+    SDL_mutexP(mMutex);
+    mLastSnapshotId ++;
+    PathSnapshot *const snapshot = new PathSnapshot(blockMasks,
+        width, height, mLastSnapshotId);
+    releaseSnapshot(mSnapshot);
+    mSnapshot = snapshot;
+    SDL_mutexV(mMutex);
+}
+
+int PathWorker::addRequest(const int startX, const int startY,
+                           const int destX, const int destY,
+                           const unsigned char walkmask,
+                           const int maxCost)
+{
+    SDL_mutexP(mMutex);
+    if (!mSnapshot)
+    {
+        SDL_mutexV(mMutex);
+        return 0;
+    }
+    mLastId ++;
+    if (mLastId <= 0)
+        mLastId = 1;
+    const int id = mLastId;
+    mSnapshot->refs ++;
+    mRequests.push_back(PathRequest(id, mSnapshot,
+        startX, startY, destX, destY, walkmask, maxCost));
+    SDL_CondSignal(mCondition);
+    SDL_mutexV(mMutex);
+    return id;
+}
+
+bool PathWorker::getResult(const int id, Path &path)
+{
+    SDL_mutexP(mMutex);
+    const std::map<int, Path>::iterator it = mResults.find(id);
+    if (it == mResults.end())
+    {
+        SDL_mutexV(mMutex);
+        return false;
+    }
+    path.swap((*it).second);
+    mResults.erase(it);
+    SDL_mutexV(mMutex);
+    return true;
+}
+
+void PathWorker::cancelRequest(const int id)
+{
+    SDL_mutexP(mMutex);
+    mResults.erase(id);
+    if (mCurrentId == id)
+        mCancelCurrent = true;
+    FOR_EACH (std::list<PathRequest>::iterator, it, mRequests)
+    {
+        if ((*it).id == id)
+        {
+            releaseSnapshot((*it).snapshot);
+            mRequests.erase(it);
+            break;
+        }
+    }
+    SDL_mutexV(mMutex);
+}
+
+int PathWorker::workerThread(void *ptr)
+{
+    PathWorker *const worker = static_cast<PathWorker*>(ptr);
+    if (worker)
+        worker->run();
+    return 0;
+}
+
+Path PathWorker::findPath(const PathRequest &request)
+{
+    const PathSnapshot *const snapshot = request.snapshot;
+    Path path;
+    if (request.startX < 0 || request.startY < 0
+        || request.startX >= snapshot->width
+        || request.startY >= snapshot->height
+        || request.destX < 0 || request.destY < 0
+        || request.destX >= snapshot->width
+        || request.destY >= snapshot->height
+        || (snapshot->blockMasks[request.destX
+        + request.destY * snapshot->width] & request.walkmask))
+    {
+        return path;
+    }
+
+    if (mSearchSnapshotId != snapshot->id)
+    {
+        // clusters points to old blockmasks and cached paths are outdated
+        delete_all(mClusters);
+        mClusters.clear();
+        mCache->clear();
+        mSearchSnapshotId = snapshot->id;
+    }
+
+    if (mCache->get(request.startX, request.startY,
+        request.destX, request.destY,
+        request.walkmask, request.maxCost, path))
+    {
+        return path;
+    }
+
+    bool found = false;
+    if (request.maxCost <= 0)
+    {
+        PathClusters *clusters = nullptr;
+        const std::map<unsigned char, PathClusters*>::const_iterator it
+            = mClusters.find(request.walkmask);
+        if (it == mClusters.end())
+        {
+            clusters = new PathClusters(snapshot->blockMasks,
+                snapshot->width, snapshot->height, request.walkmask);
+            mClusters[request.walkmask] = clusters;
+        }
+        else
+        {
+            clusters = (*it).second;
+        }
+        found = clusters->findPath(request.startX, request.startY,
+            request.destX, request.destY, path);
+    }
+    if (!found)
+    {
+        // same cluster, limited cost or route only through cluster corners
+        path = mSearch->findPath(snapshot->blockMasks,
+            snapshot->width, snapshot->height,
+            request.startX, request.startY,
+            request.destX, request.destY,
+            request.walkmask, request.maxCost);
+    }
+
+    mCache->put(request.startX, request.startY,
+        request.destX, request.destY,
+        request.walkmask, request.maxCost, path);
+    return path;
+}
+
+void PathWorker::run()
+{
+    SDL_mutexP(mMutex);
+    while (mRunning)
+    {
+        if (mRequests.empty())
+        {
+            SDL_CondWait(mCondition, mMutex);
+            continue;
+        }
+
+        const PathRequest request = mRequests.front();
+        mRequests.pop_front();
+        mCurrentId = request.id;
+        mCancelCurrent = false;
+        SDL_mutexV(mMutex);
+
+        // snapshot is never changed and kept alive by request reference
+        Path path = findPath(request);
+
+        SDL_mutexP(mMutex);
+        if (!mCancelCurrent)
+            mResults[request.id].swap(path);
+        mCurrentId = 0;
+        releaseSnapshot(request.snapshot);
+    }
+    SDL_mutexV(mMutex);
+}
@@ -0,0 +1,155 @@
+/*
+ *  The ManaPlus Client
+ *  Copyright (C) 2011-2014  The ManaPlus Developers
+ *
+ *  This file is part of The ManaPlus Client.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef RESOURCES_MAP_PATHWORKER_H
+#define RESOURCES_MAP_PATHWORKER_H
+
+#include "position.h"
+
+#include <SDL_thread.h>
+
+#include <list>
+#include <map>
+
+#include "localconsts.h"
+
+class PathCache;
+class PathClusters;
+class PathSearch;
+
+/**
+ * Searches paths in background thread.
+ *
+ * Thread works on own copy of map blockmasks, so map can be changed
+ * while searches are running. Requests without cost limit use
+ * hierarchical search. Found paths cached until blockmasks changed.
+ * Results are taken by main thread with getResult() on next frames.
+ */
+class PathWorker final
+{
+    public:
+        PathWorker();
+
+        A_DELETE_COPY(PathWorker)
+
+        ~PathWorker();
+
+        /**
+         * Sets blockmasks copy used for requests added after this call.
+         */
+        void setBlockMasks(const unsigned char *const blockMasks,
+                           const int width, const int height);
+
+        /**
+         * Adds path request and returns its id.
+         */
+        int addRequest(const int startX, const int startY,
+                       const int destX, const int destY,
+                       const unsigned char walkmask,
+                       const int maxCost) A_WARN_UNUSED;
+
+        /**
+         * Moves found path to path and returns true if request is done.
+         */
+        bool getResult(const int id, Path &path) A_WARN_UNUSED;
+
+        /**
+         * Forgets request or its result.
+         */
+        void cancelRequest(const int id);
+
+    private:
+        struct PathSnapshot final
+        {
+            PathSnapshot(const unsigned char *const blockMasks0,
+                         const int width0, const int height0,
+                         const int id0);
+
+            A_DELETE_COPY(PathSnapshot)
+
+            ~PathSnapshot();
+
+            unsigned char *blockMasks;
+            int width;
+            int height;
+            int id;
+            int refs;
+        };
+
+        struct PathRequest final
+        {
+            PathRequest(const int id0, PathSnapshot *const snapshot0,
+                        const int startX0, const int startY0,
+                        const int destX0, const int destY0,
+                        const unsigned char walkmask0,
+                        const int maxCost0) :
+                id(id0),
+                snapshot(snapshot0),
+                startX(startX0),
+                startY(startY0),
+                destX(destX0),
+                destY(destY0),
+                maxCost(maxCost0),
+                walkmask(walkmask0)
+            {
+            }
+
+            int id;
+            PathSnapshot *snapshot;
+            int startX;
+            int startY;
+            int destX;
+            int destY;
+            int maxCost;
+            unsigned char walkmask;
+        };
+
+        static int workerThread(void *ptr);
+
+        void run();
+
+        void releaseSnapshot(PathSnapshot *const snapshot);
+
+        /**
+         * Searches path. Called only from worker thread.
+         */
+        Path findPath(const PathRequest &request);
+
+        std::list<PathRequest> mRequests;
+        std::map<int, Path> mResults;
+        PathSnapshot *mSnapshot;
+
+        // used only by worker thread
+        PathSearch *mSearch;
+        PathCache *mCache;
+        std::map<unsigned char, PathClusters*> mClusters;
+        int mSearchSnapshotId;
+
+        SDL_Thread *mThread;
+        SDL_mutex *mMutex;
+        SDL_cond *mCondition;
+        int mLastId;
+        int mLastSnapshotId;
+        int mCurrentId;
+        bool mRunning;
+        bool mCancelCurrent;
+};
+
+#endif  // RESOURCES_MAP_PATHWORKER_H
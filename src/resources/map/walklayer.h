@@ -39,6 +39,12 @@ class WalkLayer final : public Resource
 
         int getDataAt(const int x, const int y) const;
 
+        size_t getMemoryUsage() const override final A_WARN_UNUSED
+        {
+            return sizeof(WalkLayer) + mIdPath.size()
+                + static_cast<size_t>(mWidth * mHeight) * sizeof(int);
+        }
+
     private:
         int mWidth;
         int mHeight;
@@ -35,6 +35,7 @@
 #include "render/safeopenglgraphics.h"
 
 #include "resources/dye.h"
+#include "resources/dyedimagecache.h"
 #include "resources/dyepalette.h"
 #include "resources/image.h"
 
@@ -56,7 +57,8 @@ OpenGLImageHelper::~OpenGLImageHelper()
         &mTextures[mFreeTextureIndex]);
 }
 
-Image *OpenGLImageHelper::load(SDL_RWops *const rw, Dye const &dye)
+SDL_Surface *OpenGLImageHelper::loadDyedSurface(SDL_RWops *const rw,
+                                                Dye const &dye)
 {
     SDL_Surface *const tmpImage = loadPng(rw);
     if (!tmpImage)
@@ -94,12 +96,92 @@ Image *OpenGLImageHelper::load(SDL_RWops *const rw, Dye const &dye)
             break;
         }
     }
+    return surf;
+}
+
+Image *OpenGLImageHelper::load(SDL_RWops *const rw, Dye const &dye)
+{
+    SDL_Surface *const surf = loadDyedSurface(rw, dye);
+    if (!surf)
+        return nullptr;
 
     Image *const image = load(surf);
     MSDL_FreeSurface(surf);
     return image;
 }
 
+Image *OpenGLImageHelper::loadCached(SDL_RWops *const rw,
+                                     Dye const &dye,
+                                     const std::string &path,
+                                     const std::string &dyeString)
+{
+    int width = 0;
+    int height = 0;
+    SDL_Surface *const surf = loadSurface(rw, &dye, path, dyeString,
+        width, height);
+    if (!surf)
+        return nullptr;
+
+    Image *const image = glLoad(surf, width, height);
+    MSDL_FreeSurface(surf);
+    return image;
+}
+
+SDL_Surface *OpenGLImageHelper::loadSurface(SDL_RWops *const rw,
+                                            const Dye *const dye,
+                                            const std::string &path,
+                                            const std::string &dyeString,
+                                            int &width,
+                                            int &height)
+{
+    std::string stamp;
+    if (dye)
+        stamp = DyedImageCache::getStamp(path, rw, dyeString);
+    if (!stamp.empty())
+    {
+        SDL_Surface *const cached = DyedImageCache::load(stamp,
+            this, width, height);
+        if (cached)
+        {
+            SDL_RWclose(rw);
+            return cached;
+        }
+    }
+
+    SDL_Surface *surf = nullptr;
+    if (dye)
+    {
+        surf = loadDyedSurface(rw, *dye);
+    }
+    else
+    {
+        surf = loadPng(rw);
+        if (!surf)
+            logger->log("Error, image load failed: %s", IMG_GetError());
+    }
+    if (!surf)
+        return nullptr;
+
+    width = surf->w;
+    height = surf->h;
+    SDL_Surface *const converted = convertSurface(surf, width, height);
+    if (converted != surf)
+        MSDL_FreeSurface(surf);
+    if (!converted)
+        return nullptr;
+
+    if (!stamp.empty())
+        DyedImageCache::save(stamp, converted, width, height);
+    return converted;
+}
+
+Image *OpenGLImageHelper::loadPrepared(SDL_Surface *const surface,
+                                       const int width,
+                                       const int height)
+{
+    return glLoad(surface, width, height);
+}
+
 Image *OpenGLImageHelper::load(SDL_Surface *const tmpImage)
 {
     return glLoad(tmpImage);
@@ -149,6 +231,16 @@ SDL_Surface *OpenGLImageHelper::convertSurface(SDL_Surface *tmpImage,
                     tmpImage->w, tmpImage->h);
     }
 
+    return convertSurfaceToSize(tmpImage, realWidth, realHeight);
+}
+
+SDL_Surface *OpenGLImageHelper::convertSurfaceToSize(SDL_Surface *tmpImage,
+                                                     const int width,
+                                                     const int height)
+{
+    if (!tmpImage)
+        return nullptr;
+
 #ifdef USE_SDL2
     SDL_SetSurfaceAlphaMod(tmpImage, SDL_ALPHA_OPAQUE);
 #else
@@ -171,7 +263,7 @@ SDL_Surface *OpenGLImageHelper::convertSurface(SDL_Surface *tmpImage,
 #endif
 
     if (tmpImage->format->BitsPerPixel != 32
-        || realWidth != width || realHeight != height
+        || width != tmpImage->w || height != tmpImage->h
         || rmask != tmpImage->format->Rmask
         || gmask != tmpImage->format->Gmask
         || amask != tmpImage->format->Amask)
@@ -180,7 +272,7 @@ SDL_Surface *OpenGLImageHelper::convertSurface(SDL_Surface *tmpImage,
 #ifdef USE_SDL2
         SDL_SetSurfaceBlendMode(oldImage, SDL_BLENDMODE_NONE);
 #endif
-        tmpImage = MSDL_CreateRGBSurface(SDL_SWSURFACE, realWidth, realHeight,
+        tmpImage = MSDL_CreateRGBSurface(SDL_SWSURFACE, width, height,
             32, rmask, gmask, bmask, amask);
 
         if (!tmpImage)
@@ -386,7 +478,10 @@ void OpenGLImageHelper::copySurfaceToImage(Image *const image,
         return;
 
     SDL_Surface *const oldSurface = surface;
-    surface = convertSurface(surface, surface->w, surface->h);
+    // only surface area must be changed, so upload it without padding
+    surface = convertSurfaceToSize(surface, surface->w, surface->h);
+    if (!surface)
+        return;
 
     mglTextureSubImage2D(image->mGLImage,
         mTextureType, 0,
@@ -79,6 +79,31 @@ class OpenGLImageHelper final : public ImageHelper
         Image *load(SDL_RWops *const rw,
                     Dye const &dye) override final A_WARN_UNUSED;
 
+        /**
+         * Loads dyed image from dyed images disk cache, or loads and
+         * recolors it and stores result to cache.
+         */
+        Image *loadCached(SDL_RWops *const rw,
+                          Dye const &dye,
+                          const std::string &path,
+                          const std::string &dyeString)
+                          override final A_WARN_UNUSED;
+
+        /**
+         * Loads and recolors an image, converts it to texture format and
+         * uses dyed images disk cache. Safe to call from worker threads.
+         */
+        SDL_Surface *loadSurface(SDL_RWops *const rw,
+                                 const Dye *const dye,
+                                 const std::string &path,
+                                 const std::string &dyeString,
+                                 int &width,
+                                 int &height) override final A_WARN_UNUSED;
+
+        Image *loadPrepared(SDL_Surface *const surface,
+                            const int width,
+                            const int height) override final A_WARN_UNUSED;
+
         /**
          * Loads an image from an SDL surface.
          */
@@ -138,6 +163,20 @@ class OpenGLImageHelper final : public ImageHelper
         static SDL_Surface *convertSurface(SDL_Surface *tmpImage,
                                            int width, int height);
 
+        /**
+         * Converts surface to 32 bit RGBA surface with given size
+         * without rounding it to power of two.
+         */
+        static SDL_Surface *convertSurfaceToSize(SDL_Surface *tmpImage,
+                                                 const int width,
+                                                 const int height);
+
+        /**
+         * Loads image from SDL_RWops and recolors it.
+         */
+        static SDL_Surface *loadDyedSurface(SDL_RWops *const rw,
+                                            Dye const &dye) A_WARN_UNUSED;
+
         Image *glLoad(SDL_Surface *tmpImage,
                       int width = 0, int height = 0) A_WARN_UNUSED;
 
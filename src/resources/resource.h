@@ -26,6 +26,7 @@
 #include "main.h"
 
 #include <ctime>
+#include <list>
 #include <string>
 
 #include "localconsts.h"
@@ -44,7 +45,8 @@ class Resource notfinal
         Resource() :
             mIdPath(),
             mSource(),
-            mTimeStamp(0),
+            mOrphanIter(),
+            mOrphanMemory(0),
             mRefCount(0),
             mProtected(false),
 #ifdef DEBUG_DUMP_LEAKS
@@ -99,6 +101,13 @@ class Resource notfinal
         void setNotCount(const bool b)
         { mNotCount = b; }
 
+        /**
+         * Returns approximate memory used by this resource in bytes.
+         * Used to limit memory used by orphaned resources.
+         */
+        virtual size_t getMemoryUsage() const A_WARN_UNUSED
+        { return sizeof(Resource) + mIdPath.size() + mSource.size(); }
+
 #ifdef DEBUG_DUMP_LEAKS
         bool getDumped() const A_WARN_UNUSED
         { return mDumped; }
@@ -117,7 +126,9 @@ class Resource notfinal
         std::string mSource;
 
     private:
-        time_t mTimeStamp;   /**< Time at which the resource was orphaned. */
+        /** Position in orphaned resources queue. */
+        std::list<Resource*>::iterator mOrphanIter;
+        size_t mOrphanMemory;  /**< Memory usage at moment of orphaning. */
         unsigned int mRefCount;  /**< Reference count. */
         bool mProtected;
         bool mNotCount;
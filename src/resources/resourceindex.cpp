@@ -0,0 +1,191 @@
+/*
+ *  The ManaPlus Client
+ *  Copyright (C) 2011-2014  The ManaPlus Developers
+ *
+ *  This file is part of The ManaPlus Client.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "resources/resourceindex.h"
+
+#include "debug.h"
+
+namespace
+{
+    const size_t minCapacity = 64;
+}  // namespace
+
+ResourceIndex::ResourceIndex() :
+    mEntries(),
+    mSize(0),
+    mDeleted(0)
+{
+}
+
+ResourceIndex::HashType ResourceIndex::hash(const std::string &key)
+{
+    // FNV-1a
+    HashType h = 2166136261U;
+    const size_t sz = key.size();
+    const char *const str = key.c_str();
+    for (size_t f = 0; f < sz; f ++)
+    {
+        h ^= static_cast<unsigned char>(str[f]);
+        h *= 16777619U;
+    }
+    return h;
+}
+
+int ResourceIndex::findIndex(const std::string &key,
+                             const HashType keyHash) const
+{
+    if (mEntries.empty())
+        return -1;
+
+    const size_t mask = mEntries.size() - 1;
+    size_t idx = keyHash & mask;
+    while (true)
+    {
+        const Entry &entry = mEntries[idx];
+        if (entry.state == ENTRY_EMPTY)
+            return -1;
+        if (entry.state == ENTRY_USED
+            && entry.hash == keyHash
+            && entry.value.first == key)
+        {
+            return static_cast<int>(idx);
+        }
+        idx = (idx + 1) & mask;
+    }
+}
+
+size_t ResourceIndex::findFreeIndex(const HashType keyHash) const
+{
+    const size_t mask = mEntries.size() - 1;
+    size_t idx = keyHash & mask;
+    while (mEntries[idx].state == ENTRY_USED)
+        idx = (idx + 1) & mask;
+    return idx;
+}
+
+void ResourceIndex::reserveOne()
+{
+    const size_t capacity = mEntries.size();
+    // keep at least quarter of entries empty, to make probe chains short
+    if ((mSize + mDeleted + 1) * 4 <= capacity * 3)
+        return;
+
+    if (capacity < minCapacity)
+        rehash(minCapacity);
+    else if ((mSize + 1) * 2 > capacity)
+        rehash(capacity * 2);
+    else
+        rehash(capacity);
+}
+
+void ResourceIndex::rehash(const size_t capacity)
+{
+    std::vector<Entry> oldEntries(capacity);
+    oldEntries.swap(mEntries);
+    mDeleted = 0;
+
+    for (std::vector<Entry>::iterator it = oldEntries.begin(),
+         it_end = oldEntries.end(); it != it_end; ++ it)
+    {
+        if ((*it).state != ENTRY_USED)
+            continue;
+        Entry &entry = mEntries[findFreeIndex((*it).hash)];
+        entry.value.first.swap((*it).value.first);
+        entry.value.second = (*it).value.second;
+        entry.hash = (*it).hash;
+        entry.state = ENTRY_USED;
+    }
+}
+
+size_t ResourceIndex::add(const std::string &key, const HashType keyHash)
+{
+    reserveOne();
+    const size_t idx = findFreeIndex(keyHash);
+    Entry &entry = mEntries[idx];
+    if (entry.state == ENTRY_DELETED)
+        mDeleted --;
+    entry.value.first = key;
+    entry.value.second = nullptr;
+    entry.hash = keyHash;
+    entry.state = ENTRY_USED;
+    mSize ++;
+    return idx;
+}
+
+ResourceIndex::iterator ResourceIndex::find(const std::string &key,
+                                            const HashType keyHash)
+{
+    const int idx = findIndex(key, keyHash);
+    if (idx < 0)
+        return end();
+    return iterator(&mEntries[idx], endEntry());
+}
+
+ResourceIndex::const_iterator ResourceIndex::find(const std::string &key,
+                                                  const HashType keyHash)
+                                                  const
+{
+    const int idx = findIndex(key, keyHash);
+    if (idx < 0)
+        return end();
+    return const_iterator(&mEntries[idx], endEntry());
+}
+
+Resource *&ResourceIndex::get(const std::string &key,
+                              const HashType keyHash)
+{
+    const int idx = findIndex(key, keyHash);
+    if (idx >= 0)
+        return mEntries[idx].value.second;
+    return mEntries[add(key, keyHash)].value.second;
+}
+
+std::pair<ResourceIndex::iterator, bool> ResourceIndex::insert(
+    const value_type &value, const HashType keyHash)
+{
+    const int idx = findIndex(value.first, keyHash);
+    if (idx >= 0)
+    {
+        return std::pair<iterator, bool>(
+            iterator(&mEntries[idx], endEntry()), false);
+    }
+    Entry &entry = mEntries[add(value.first, keyHash)];
+    entry.value.second = value.second;
+    return std::pair<iterator, bool>(iterator(&entry, endEntry()), true);
+}
+
+void ResourceIndex::erase(const iterator &it)
+{
+    Entry *const entry = it.mEntry;
+    if (!entry || entry == endEntry() || entry->state != ENTRY_USED)
+        return;
+    std::string().swap(entry->value.first);
+    entry->value.second = nullptr;
+    entry->state = ENTRY_DELETED;
+    mSize --;
+    mDeleted ++;
+}
+
+void ResourceIndex::clear()
+{
+    mEntries.clear();
+    mSize = 0;
+    mDeleted = 0;
+}
@@ -0,0 +1,255 @@
+/*
+ *  The ManaPlus Client
+ *  Copyright (C) 2011-2014  The ManaPlus Developers
+ *
+ *  This file is part of The ManaPlus Client.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef RESOURCES_RESOURCEINDEX_H
+#define RESOURCES_RESOURCEINDEX_H
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "localconsts.h"
+
+class Resource;
+
+/**
+ * Open addressing hash table of resources indexed by id path.
+ *
+ * Each key stored once together with its hash, so lookups compare
+ * strings only for matching hashes. Callers what look up same id many
+ * times can calculate hash once and use lookup functions with hash.
+ * Erasing elements does not invalidate iterators, inserting can.
+ */
+class ResourceIndex final
+{
+    public:
+        typedef uint32_t HashType;
+        typedef std::pair<std::string, Resource*> value_type;
+
+    private:
+        enum EntryState
+        {
+            ENTRY_EMPTY = 0,
+            ENTRY_USED,
+            ENTRY_DELETED
+        };
+
+        struct Entry final
+        {
+            Entry() :
+                value(),
+                hash(0),
+                state(ENTRY_EMPTY)
+            { }
+
+            value_type value;
+            HashType hash;
+            EntryState state;
+        };
+
+        template <typename EntryT, typename ValueT>
+        class Iterator final
+        {
+            friend class ResourceIndex;
+            template <typename EntryT2, typename ValueT2>
+            friend class Iterator;
+
+            public:
+                Iterator() :
+                    mEntry(nullptr),
+                    mEnd(nullptr)
+                { }
+
+                template <typename EntryT2, typename ValueT2>
+                Iterator(const Iterator<EntryT2, ValueT2> &it) :
+                    mEntry(it.mEntry),
+                    mEnd(it.mEnd)
+                { }
+
+                ValueT &operator*() const
+                { return mEntry->value; }
+
+                ValueT *operator->() const
+                { return &mEntry->value; }
+
+                Iterator &operator++()
+                {
+                    ++ mEntry;
+                    skipFree();
+                    return *this;
+                }
+
+                Iterator operator++(int)
+                {
+                    const Iterator it = *this;
+                    ++ *this;
+                    return it;
+                }
+
+                template <typename EntryT2, typename ValueT2>
+                bool operator==(const Iterator<EntryT2, ValueT2> &it) const
+                { return mEntry == it.mEntry; }
+
+                template <typename EntryT2, typename ValueT2>
+                bool operator!=(const Iterator<EntryT2, ValueT2> &it) const
+                { return mEntry != it.mEntry; }
+
+            private:
+                Iterator(EntryT *const entry, EntryT *const end) :
+                    mEntry(entry),
+                    mEnd(end)
+                { }
+
+                void skipFree()
+                {
+                    while (mEntry != mEnd && mEntry->state != ENTRY_USED)
+                        ++ mEntry;
+                }
+
+                EntryT *mEntry;
+                EntryT *mEnd;
+        };
+
+    public:
+        typedef Iterator<Entry, value_type> iterator;
+        typedef Iterator<const Entry, const value_type> const_iterator;
+
+        ResourceIndex();
+
+        A_DELETE_COPY(ResourceIndex)
+
+        /**
+         * Returns hash of id path used by this table.
+         */
+        static HashType hash(const std::string &key) A_WARN_UNUSED;
+
+        iterator find(const std::string &key) A_WARN_UNUSED
+        { return find(key, hash(key)); }
+
+        iterator find(const std::string &key,
+                      const HashType keyHash) A_WARN_UNUSED;
+
+        const_iterator find(const std::string &key) const A_WARN_UNUSED
+        { return find(key, hash(key)); }
+
+        const_iterator find(const std::string &key,
+                            const HashType keyHash) const A_WARN_UNUSED;
+
+        /**
+         * Returns reference to value for key, adding null value if key
+         * is not in table.
+         */
+        Resource *&get(const std::string &key,
+                       const HashType keyHash) A_WARN_UNUSED;
+
+        Resource *&operator[](const std::string &key)
+        { return get(key, hash(key)); }
+
+        /**
+         * Adds value if key is not in table.
+         */
+        std::pair<iterator, bool> insert(const value_type &value)
+        { return insert(value, hash(value.first)); }
+
+        std::pair<iterator, bool> insert(const value_type &value,
+                                         const HashType keyHash);
+
+        template <typename InputIterator>
+        void insert(InputIterator first, const InputIterator last)
+        {
+            for (; first != last; ++ first)
+                insert(*first);
+        }
+
+        void erase(const iterator &it);
+
+        void clear();
+
+        iterator begin() A_WARN_UNUSED
+        {
+            iterator it(beginEntry(), endEntry());
+            it.skipFree();
+            return it;
+        }
+
+        iterator end() A_WARN_UNUSED
+        { return iterator(endEntry(), endEntry()); }
+
+        const_iterator begin() const A_WARN_UNUSED
+        {
+            const_iterator it(beginEntry(), endEntry());
+            it.skipFree();
+            return it;
+        }
+
+        const_iterator end() const A_WARN_UNUSED
+        { return const_iterator(endEntry(), endEntry()); }
+
+        size_t size() const A_WARN_UNUSED
+        { return mSize; }
+
+        bool empty() const A_WARN_UNUSED
+        { return mSize == 0; }
+
+    private:
+        Entry *beginEntry() A_WARN_UNUSED
+        { return mEntries.empty() ? nullptr : &mEntries[0]; }
+
+        const Entry *beginEntry() const A_WARN_UNUSED
+        { return mEntries.empty() ? nullptr : &mEntries[0]; }
+
+        Entry *endEntry() A_WARN_UNUSED
+        { return beginEntry() + mEntries.size(); }
+
+        const Entry *endEntry() const A_WARN_UNUSED
+        { return beginEntry() + mEntries.size(); }
+
+        /**
+         * Returns index of entry with key, or -1.
+         */
+        int findIndex(const std::string &key,
+                      const HashType keyHash) const A_WARN_UNUSED;
+
+        /**
+         * Returns index of free entry for new key.
+         * Key must not be in table.
+         */
+        size_t findFreeIndex(const HashType keyHash) const A_WARN_UNUSED;
+
+        /**
+         * Adds new key with null value and returns its index.
+         * Key must not be in table.
+         */
+        size_t add(const std::string &key, const HashType keyHash);
+
+        /**
+         * Resizes table if it has not enough free entries for new key.
+         */
+        void reserveOne();
+
+        void rehash(const size_t capacity);
+
+        std::vector<Entry> mEntries;
+        size_t mSize;
+        size_t mDeleted;
+};
+
+#endif  // RESOURCES_RESOURCEINDEX_H
@@ -0,0 +1,131 @@
+/*
+ *  The ManaPlus Client
+ *  Copyright (C) 2011-2014  The ManaPlus Developers
+ *
+ *  This file is part of The ManaPlus Client.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "resources/resourceindex.h"
+
+#include "gtest/gtest.h"
+
+#include <cstdlib>
+#include <map>
+
+#include "debug.h"
+
+static Resource *toResource(const size_t val)
+{
+    return reinterpret_cast<Resource*>(val);
+}
+
+TEST(ResourceIndex, empty)
+{
+    ResourceIndex index;
+    EXPECT_TRUE(index.empty());
+    EXPECT_EQ(0U, index.size());
+    EXPECT_TRUE(index.begin() == index.end());
+    EXPECT_TRUE(index.find("test") == index.end());
+}
+
+TEST(ResourceIndex, insert)
+{
+    ResourceIndex index;
+    EXPECT_TRUE(index.insert(ResourceIndex::value_type(
+        "test1", toResource(1))).second);
+    EXPECT_FALSE(index.insert(ResourceIndex::value_type(
+        "test1", toResource(2))).second);
+    index["test2"] = toResource(3);
+    EXPECT_EQ(2U, index.size());
+
+    ResourceIndex::iterator it = index.find("test1");
+    ASSERT_TRUE(it != index.end());
+    EXPECT_EQ("test1", it->first);
+    EXPECT_EQ(toResource(1), it->second);
+    it = index.find("test2", ResourceIndex::hash("test2"));
+    ASSERT_TRUE(it != index.end());
+    EXPECT_EQ(toResource(3), it->second);
+    EXPECT_TRUE(index.find("test3") == index.end());
+}
+
+TEST(ResourceIndex, erase)
+{
+    ResourceIndex index;
+    index["test1"] = toResource(1);
+    index["test2"] = toResource(2);
+    index.erase(index.find("test1"));
+    EXPECT_EQ(1U, index.size());
+    EXPECT_TRUE(index.find("test1") == index.end());
+    EXPECT_TRUE(index.find("test2") != index.end());
+
+    // erase during iteration
+    index["test3"] = toResource(3);
+    ResourceIndex::iterator it = index.begin();
+    while (it != index.end())
+    {
+        const ResourceIndex::iterator toErase = it;
+        ++ it;
+        index.erase(toErase);
+    }
+    EXPECT_TRUE(index.empty());
+    EXPECT_TRUE(index.begin() == index.end());
+}
+
+TEST(ResourceIndex, random)
+{
+    ResourceIndex index;
+    std::map<std::string, Resource*> map;
+    srand(1);
+    for (size_t f = 0; f < 20000; f ++)
+    {
+        const std::string key = std::string("key").append(
+            1, static_cast<char>('a' + rand() % 26)).append(
+            1, static_cast<char>('a' + rand() % 26)).append(
+            1, static_cast<char>('a' + rand() % 4));
+        if (rand() % 3)
+        {
+            index[key] = toResource(f);
+            map[key] = toResource(f);
+        }
+        else
+        {
+            const ResourceIndex::iterator it = index.find(key);
+            const std::map<std::string, Resource*>::iterator
+                it2 = map.find(key);
+            ASSERT_EQ(it2 == map.end(), it == index.end());
+            if (it2 != map.end())
+            {
+                EXPECT_EQ(it2->second, it->second);
+                index.erase(it);
+                map.erase(it2);
+            }
+        }
+        ASSERT_EQ(map.size(), index.size());
+    }
+
+    size_t cnt = 0;
+    const ResourceIndex &constIndex = index;
+    for (ResourceIndex::const_iterator it = constIndex.begin(),
+         it_end = constIndex.end(); it != it_end; ++ it)
+    {
+        const std::map<std::string, Resource*>::const_iterator
+            it2 = map.find(it->first);
+        ASSERT_TRUE(it2 != map.end());
+        EXPECT_EQ(it2->second, it->second);
+        cnt ++;
+    }
+    EXPECT_EQ(map.size(), cnt);
+}
@@ -28,6 +28,7 @@
 
 #include "resources/map/walklayer.h"
 
+#include "resources/asyncimageloader.h"
 #include "resources/atlasmanager.h"
 #include "resources/atlasresource.h"
 #include "resources/dye.h"
@@ -37,6 +38,7 @@
 #include "resources/sdlmusic.h"
 #include "resources/soundeffect.h"
 #include "resources/spritedef.h"
+#include "resources/spritetemplate.h"
 
 #include "utils/delete2.h"
 #include "utils/physfscheckutils.h"
@@ -49,7 +51,8 @@
 
 #include <SDL_image.h>
 
-#include <sys/time.h>
+#include <cstdio>
+#include <cstring>
 
 #include "debug.h"
 
@@ -60,11 +63,17 @@ ResourceManager::ResourceManager() :
     mResources(),
     mOrphanedResources(),
     mDeletedResources(),
-    mOldestOrphan(0),
+    mOrphansQueue(),
+    mOrphansMemory(0),
+    mOrphansMemoryLimit(0),
     mDestruction(0),
     mUseLongLiveSprites(config.getBoolValue("uselonglivesprites"))
 {
     logger->log1("Initializing resource manager...");
+    // size in megabytes
+    const int limit = config.getValue("orphansCacheSize", 64);
+    if (limit > 0)
+        mOrphansMemoryLimit = static_cast<size_t>(limit) * 1024 * 1024;
 }
 
 ResourceManager::~ResourceManager()
@@ -211,48 +220,38 @@ void ResourceManager::cleanProtected()
 
 bool ResourceManager::cleanOrphans(const bool always)
 {
-    timeval tv;
-    gettimeofday(&tv, nullptr);
-    // Delete orphaned resources after 30 seconds.
-    time_t oldest = static_cast<time_t>(tv.tv_sec);
-    const time_t threshold = oldest - 30;
-
-    if (mOrphanedResources.empty() || (!always && mOldestOrphan >= threshold))
+    if (mOrphansQueue.empty()
+        || (!always && mOrphansMemory <= mOrphansMemoryLimit))
+    {
         return false;
+    }
 
     bool status(false);
-    ResourceIterator iter = mOrphanedResources.begin();
-    while (iter != mOrphanedResources.end())
+    // deleted resources can release other resources to end of queue
+    while (!mOrphansQueue.empty()
+           && (always || mOrphansMemory > mOrphansMemoryLimit))
     {
-        Resource *const res = iter->second;
-        if (!res)
-        {
-            ++iter;
-            continue;
-        }
-        const time_t t = res->mTimeStamp;
-        if (!always && t >= threshold)
-        {
-            if (t < oldest)
-                oldest = t;
-            ++ iter;
-        }
-        else
-        {
-            logResource(res);
-            const ResourceIterator toErase = iter;
-            ++iter;
-            mOrphanedResources.erase(toErase);
-            delete res;  // delete only after removal from list,
-                         // to avoid issues in recursion
-            status = true;
-        }
+        Resource *const res = mOrphansQueue.front();
+        removeOrphan(res);
+        const ResourceIterator iter = mOrphanedResources.find(res->mIdPath);
+        if (iter != mOrphanedResources.end() && iter->second == res)
+            mOrphanedResources.erase(iter);
+        logResource(res);
+        delete res;  // delete only after removal from list,
+                     // to avoid issues in recursion
+        status = true;
     }
-
-    mOldestOrphan = oldest;
     return status;
 }
 
+void ResourceManager::removeOrphan(Resource *const res)
+{
+    mOrphansQueue.erase(res->mOrphanIter);
+    mOrphansMemory -= res->mOrphanMemory;
+    res->mOrphanIter = mOrphansQueue.end();
+    res->mOrphanMemory = 0;
+}
+
 void ResourceManager::logResource(const Resource *const res)
 {
 #ifdef USE_OPENGL
@@ -409,9 +408,17 @@ bool ResourceManager::addResource(const std::string &idPath,
 Resource *ResourceManager::getFromCache(const std::string &filename,
                                         const int variant)
 {
-    std::stringstream ss;
-    ss << filename << "[" << variant << "]";
-    return getFromCache(ss.str());
+    return getFromCache(getSpriteId(filename, variant));
+}
+
+std::string ResourceManager::getSpriteId(const std::string &path,
+                                         const int variant)
+{
+    char buf[20];
+    snprintf(buf, sizeof(buf), "[%d]", variant);
+    std::string id;
+    id.reserve(path.size() + strlen(buf));
+    return id.append(path).append(buf);
 }
 
 bool ResourceManager::isInCache(const std::string &idPath) const
@@ -420,6 +427,14 @@ bool ResourceManager::isInCache(const std::string &idPath) const
     return (resIter != mResources.end() && resIter->second);
 }
 
+bool ResourceManager::isLoaded(const std::string &idPath) const
+{
+    if (isInCache(idPath))
+        return true;
+    const ResourceCIterator &resIter = mOrphanedResources.find(idPath);
+    return (resIter != mOrphanedResources.end() && resIter->second);
+}
+
 Resource *ResourceManager::getTempResource(const std::string &idPath)
 {
     const ResourceCIterator &resIter = mResources.find(idPath);
@@ -432,10 +447,11 @@ Resource *ResourceManager::getTempResource(const std::string &idPath)
     return nullptr;
 }
 
-Resource *ResourceManager::getFromCache(const std::string &idPath)
+Resource *ResourceManager::getFromCache(const std::string &idPath,
+                                        const ResourceIndex::HashType hash)
 {
     // Check if the id exists, and return the value if it does.
-    ResourceIterator resIter = mResources.find(idPath);
+    ResourceIterator resIter = mResources.find(idPath, hash);
     if (resIter != mResources.end())
     {
         if (resIter->second)
@@ -443,14 +459,17 @@ Resource *ResourceManager::getFromCache(const std::string &idPath)
         return resIter->second;
     }
 
-    resIter = mOrphanedResources.find(idPath);
+    resIter = mOrphanedResources.find(idPath, hash);
     if (resIter != mOrphanedResources.end())
     {
         Resource *const res = resIter->second;
-        mResources.insert(*resIter);
+        mResources.insert(*resIter, hash);
         mOrphanedResources.erase(resIter);
         if (res)
+        {
+            removeOrphan(res);
             res->incRef();
+        }
         return res;
     }
     return nullptr;
@@ -460,7 +479,8 @@ Resource *ResourceManager::get(const std::string &idPath, const generator fun,
                                const void *const data)
 {
 #ifndef DISABLE_RESOURCE_CACHING
-    Resource *resource = getFromCache(idPath);
+    const ResourceIndex::HashType hash = ResourceIndex::hash(idPath);
+    Resource *resource = getFromCache(idPath, hash);
     if (resource)
         return resource;
     resource = fun(data);
@@ -473,7 +493,7 @@ Resource *ResourceManager::get(const std::string &idPath, const generator fun,
         logger->log("set name %p, %s", static_cast<void*>(resource),
             resource->mIdPath.c_str());
 #endif
-        mResources[idPath] = resource;
+        mResources.get(idPath, hash) = resource;
         cleanOrphans();
     }
     else
@@ -552,12 +572,18 @@ struct DyedImageLoader final
         if (!rl->manager)
             return nullptr;
 
+        Image *const prepared = AsyncImageLoader::takeImage(rl->path);
+        if (prepared)
+            return prepared;
+
         std::string path1 = rl->path;
+        std::string dyeString;
         const size_t p = path1.find('|');
         Dye *d = nullptr;
         if (p != std::string::npos)
         {
-            d = new Dye(path1.substr(p + 1));
+            dyeString = path1.substr(p + 1);
+            d = new Dye(dyeString);
             path1 = path1.substr(0, p);
         }
         SDL_RWops *const rw = MPHYSFSRWOPS_openRead(path1.c_str());
@@ -566,7 +592,8 @@ struct DyedImageLoader final
             delete d;
             return nullptr;
         }
-        Resource *const res = d ? imageHelper->load(rw, *d)
+        Resource *const res = d
+            ? imageHelper->loadCached(rw, *d, path1, dyeString)
             : imageHelper->load(rw);
         delete d;
         return res;
@@ -806,9 +833,32 @@ SpriteDef *ResourceManager::getSprite(const std::string &path,
                                       const int variant)
 {
     SpriteDefLoader rl = { path, variant, mUseLongLiveSprites };
-    std::stringstream ss;
-    ss << path << "[" << variant << "]";
-    return static_cast<SpriteDef*>(get(ss.str(), &SpriteDefLoader::load, &rl));
+    return static_cast<SpriteDef*>(get(getSpriteId(path, variant),
+        &SpriteDefLoader::load, &rl));
+}
+
+struct SpriteTemplateLoader final
+{
+    std::string path;
+    bool fixDead;
+    static Resource *load(const void *const v)
+    {
+        if (!v)
+            return nullptr;
+
+        const SpriteTemplateLoader *const
+            rl = static_cast<const SpriteTemplateLoader *const>(v);
+        return SpriteTemplate::load(rl->path, rl->fixDead);
+    }
+};
+
+SpriteTemplate *ResourceManager::getSpriteTemplate(const std::string &path,
+                                                   const bool fixDead)
+{
+    SpriteTemplateLoader rl = { path, fixDead };
+    return static_cast<SpriteTemplate*>(get(std::string(
+        fixDead ? "template_dead_" : "template_").append(path),
+        &SpriteTemplateLoader::load, &rl));
 }
 
 void ResourceManager::release(Resource *const res)
@@ -841,13 +891,9 @@ void ResourceManager::release(Resource *const res)
         return;
     }
 
-    timeval tv;
-    gettimeofday(&tv, nullptr);
-    const time_t timestamp = static_cast<time_t>(tv.tv_sec);
-
-    res->mTimeStamp = timestamp;
-    if (mOrphanedResources.empty())
-        mOldestOrphan = timestamp;
+    res->mOrphanMemory = res->getMemoryUsage();
+    mOrphansMemory += res->mOrphanMemory;
+    res->mOrphanIter = mOrphansQueue.insert(mOrphansQueue.end(), res);
 
     mOrphanedResources.insert(*resIter);
     mResources.erase(resIter);
@@ -877,6 +923,7 @@ void ResourceManager::moveToDeleted(Resource *const res)
         resIter = mOrphanedResources.find(res->mIdPath);
         if (resIter != mOrphanedResources.end() && resIter->second == res)
         {
+            removeOrphan(res);
             mOrphanedResources.erase(resIter);
             found = true;
         }
@@ -909,7 +956,10 @@ void ResourceManager::decRefDelete(Resource *const res)
         {
             resIter = mOrphanedResources.find(res->mIdPath);
             if (resIter != mOrphanedResources.end() && resIter->second == res)
+            {
+                removeOrphan(res);
                 mOrphanedResources.erase(resIter);
+            }
         }
 
         delete res;
@@ -25,10 +25,11 @@
 
 #include "main.h"
 
+#include "resources/resourceindex.h"
+
 #include "utils/stringvector.h"
 
-#include <ctime>
-#include <map>
+#include <list>
 #include <set>
 
 #include "localconsts.h"
@@ -40,6 +41,7 @@ class SDLMusic;
 class Resource;
 class SoundEffect;
 class SpriteDef;
+class SpriteTemplate;
 class WalkLayer;
 
 struct SDL_Surface;
@@ -115,11 +117,25 @@ class ResourceManager final
         Resource *get(const std::string &idPath, const generator fun,
                       const void *const data) A_WARN_UNUSED;
 
-        Resource *getFromCache(const std::string &idPath) A_WARN_UNUSED;
+        Resource *getFromCache(const std::string &idPath) A_WARN_UNUSED
+        { return getFromCache(idPath, ResourceIndex::hash(idPath)); }
+
+        /**
+         * Returns resource from cache using precalculated hash of id path.
+         */
+        Resource *getFromCache(const std::string &idPath,
+                               const ResourceIndex::HashType hash)
+                               A_WARN_UNUSED;
 
         Resource *getFromCache(const std::string &filename,
                                const int variant) A_WARN_UNUSED;
 
+        /**
+         * Returns id path of sprite resource.
+         */
+        static std::string getSpriteId(const std::string &path,
+                                       const int variant) A_WARN_UNUSED;
+
         /**
          * Loads a resource from a file and adds it to the resource map.
          *
@@ -192,6 +208,13 @@ class ResourceManager final
         SpriteDef *getSprite(const std::string &path,
                              const int variant = 0) A_WARN_UNUSED;
 
+        /**
+         * Returns parsed sprite definition file shared by all palettes
+         * and variants.
+         */
+        SpriteTemplate *getSpriteTemplate(const std::string &path,
+                                          const bool fixDead) A_WARN_UNUSED;
+
         /**
          * Releases a resource, placing it in the set of orphaned resources.
          */
@@ -237,7 +260,7 @@ class ResourceManager final
         int size() const A_WARN_UNUSED
         { return static_cast<int>(mResources.size()); }
 
-        typedef std::map<std::string, Resource*> Resources;
+        typedef ResourceIndex Resources;
         typedef Resources::iterator ResourceIterator;
         typedef Resources::const_iterator ResourceCIterator;
 
@@ -249,12 +272,24 @@ class ResourceManager final
         { return &mOrphanedResources; }
 #endif
 
+        /**
+         * Deletes least recently released orphaned resources while they
+         * use more memory than allowed, or all orphaned resources.
+         */
         bool cleanOrphans(const bool always = false);
 
+        size_t getOrphansMemory() const A_WARN_UNUSED
+        { return mOrphansMemory; }
+
         void cleanProtected();
 
         bool isInCache(const std::string &idPath) const A_WARN_UNUSED;
 
+        /**
+         * Checks if resource is loaded, including orphaned resources.
+         */
+        bool isLoaded(const std::string &idPath) const A_WARN_UNUSED;
+
         Resource *getTempResource(const std::string &idPath) A_WARN_UNUSED;
 
         void clearCache();
@@ -265,12 +300,20 @@ class ResourceManager final
          */
         static void cleanUp(Resource *const resource);
 
+        /**
+         * Removes resource from orphaned resources queue.
+         */
+        void removeOrphan(Resource *const res);
+
         static ResourceManager *instance;
         std::set<SDL_Surface*> deletedSurfaces;
         Resources mResources;
         Resources mOrphanedResources;
         std::set<Resource*> mDeletedResources;
-        time_t mOldestOrphan;
+        /** Orphaned resources, least recently released first. */
+        std::list<Resource*> mOrphansQueue;
+        size_t mOrphansMemory;
+        size_t mOrphansMemoryLimit;
         bool mDestruction;
         bool mUseLongLiveSprites;
 };
@@ -65,6 +65,12 @@ class SoundEffect final : public Resource
         bool play(const int loops, const int volume,
                   const int channel = -1) const;
 
+        size_t getMemoryUsage() const override final A_WARN_UNUSED
+        {
+            return sizeof(SoundEffect) + mIdPath.size()
+                + (mChunk ? mChunk->alen : 0);
+        }
+
     protected:
         /**
          * Constructor.
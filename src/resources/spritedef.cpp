@@ -24,15 +24,11 @@
 
 #include "logger.h"
 
-#include "resources/map/mapconsts.h"
-
-#include "resources/action.h"
-#include "resources/animation.h"
 #include "resources/dye.h"
 #include "resources/imageset.h"
 #include "resources/resourcemanager.h"
-#include "resources/spriteaction.h"
 #include "resources/spritereference.h"
+#include "resources/spritetemplate.h"
 
 #include "configuration.h"
 
@@ -44,39 +40,16 @@ extern int serverVersion;
 const Action *SpriteDef::getAction(const std::string &action,
                                    const unsigned num) const
 {
-    Actions::const_iterator i = mActions.find(num);
-    if (i == mActions.end() && num != 100)
-        i = mActions.find(100);
-
-    if (i == mActions.end() || !(*i).second)
-        return nullptr;
-
-    const ActionMap *const actMap = (*i).second;
-    if (!actMap)
-        return nullptr;
-    const ActionMap::const_iterator it = actMap->find(action);
-
-    if (it == actMap->end())
-    {
-        logger->log("Warning: no action \"%s\" defined!", action.c_str());
-        return nullptr;
-    }
-
-    return (*it).second;
+    if (mOwnActions)
+        return SpriteTemplate::findAction(mActions, action, num);
+    return mTemplate->getAction(action, num);
 }
 
 unsigned SpriteDef::findNumber(const unsigned num) const
 {
-    unsigned min = 101;
-    FOR_EACH (Actions::const_iterator, it, mActions)
-    {
-        const unsigned n = (*it).first;
-        if (n >= num && n < min)
-            min = n;
-    }
-    if (min == 101)
-        return 0;
-    return min;
+    if (mOwnActions)
+        return SpriteTemplate::findNumber(mActions, num);
+    return mTemplate->findNumber(num);
 }
 
 SpriteDef *SpriteDef::load(const std::string &animationFile,
@@ -87,10 +60,11 @@ SpriteDef *SpriteDef::load(const std::string &animationFile,
     if (pos != std::string::npos)
         palettes = animationFile.substr(pos + 1);
 
-    XML::Document doc(animationFile.substr(0, pos));
-    XmlNodePtrConst rootNode = doc.rootNode();
+    ResourceManager *const resman = ResourceManager::getInstance();
+    SpriteTemplate *const spriteTemplate = resman->getSpriteTemplate(
+        animationFile.substr(0, pos), serverVersion < 1);
 
-    if (!rootNode || !xmlNameEqual(rootNode, "sprite"))
+    if (!spriteTemplate)
     {
         logger->log("Error, failed to parse %s", animationFile.c_str());
 
@@ -102,12 +76,8 @@ SpriteDef *SpriteDef::load(const std::string &animationFile,
             return nullptr;
     }
 
-    SpriteDef *const def = new SpriteDef;
-    def->mProcessedFiles.insert(animationFile);
-    def->loadSprite(rootNode, variant, palettes);
-    def->substituteActions();
-    if (serverVersion < 1)
-        def->fixDeadAction();
+    SpriteDef *const def = new SpriteDef(spriteTemplate);
+    def->loadImages(palettes, variant);
     if (prot)
     {
         def->incRef();
@@ -116,455 +86,88 @@ SpriteDef *SpriteDef::load(const std::string &animationFile,
     return def;
 }
 
-void SpriteDef::fixDeadAction()
-{
-    FOR_EACH (ActionsIter, it, mActions)
-    {
-        ActionMap *const d = (*it).second;
-        if (!d)
-            continue;
-        const ActionMap::iterator i = d->find(SpriteAction::DEAD);
-        const ActionMap::iterator i2 = d->find(SpriteAction::STAND);
-        // search dead action and check what it not same with stand action
-        if (i != d->end() && i->second && i->second != i2->second)
-            (i->second)->setLastFrameDelay(0);
-    }
-}
-
-void SpriteDef::substituteAction(const std::string &restrict complete,
-                                 const std::string &restrict with)
+void SpriteDef::loadImages(const std::string &palettes,
+                           const int variant)
 {
-    FOR_EACH (ActionsConstIter, it, mActions)
-    {
-        ActionMap *const d = (*it).second;
-        if (!d)
-            continue;
-        if (d->find(complete) == d->end())
+    ResourceManager *const resman = ResourceManager::getInstance();
+    const std::vector<SpriteImageSet> &imageSets
+        = mTemplate->getImageSets();
+    mImageSets.reserve(imageSets.size());
+    bool failed = false;
+    FOR_EACH (std::vector<SpriteImageSet>::const_iterator, it, imageSets)
+    {
+        const SpriteImageSet &set = *it;
+        std::string imageSrc = set.src;
+        // included sprites not use palettes
+        Dye::instantiate(imageSrc, set.dye ? palettes : "");
+
+        ImageSet *const imageSet = resman->getImageSet(imageSrc,
+            set.width, set.height);
+        if (imageSet)
         {
-            const ActionMap::iterator i = d->find(with);
-            if (i != d->end())
-                (*d)[complete] = i->second;
+            imageSet->setOffsetX(set.offsetX);
+            imageSet->setOffsetY(set.offsetY);
         }
+        else
+        {
+            logger->log1("Couldn't load imageset!");
+            failed = true;
+        }
+        mImageSets.push_back(imageSet);
     }
-}
-
-void SpriteDef::substituteActions()
-{
-    substituteAction(SpriteAction::STAND, SpriteAction::DEFAULT);
-    substituteAction(SpriteAction::MOVE, SpriteAction::STAND);
-    substituteAction(SpriteAction::ATTACK, SpriteAction::STAND);
-    substituteAction(SpriteAction::CAST_MAGIC, SpriteAction::ATTACK);
-    substituteAction(SpriteAction::USE_ITEM, SpriteAction::CAST_MAGIC);
-    substituteAction(SpriteAction::SIT, SpriteAction::STAND);
-    substituteAction(SpriteAction::SITTOP, SpriteAction::SIT);
-    substituteAction(SpriteAction::SLEEP, SpriteAction::SIT);
-    substituteAction(SpriteAction::HURT, SpriteAction::STAND);
-    substituteAction(SpriteAction::DEAD, SpriteAction::HURT);
-    substituteAction(SpriteAction::SPAWN, SpriteAction::STAND);
-    substituteAction(SpriteAction::FLY, SpriteAction::MOVE);
-    substituteAction(SpriteAction::SWIM, SpriteAction::MOVE);
-    substituteAction(SpriteAction::STANDSKY, SpriteAction::STAND);
-    substituteAction(SpriteAction::STANDWATER, SpriteAction::STAND);
-    substituteAction(SpriteAction::SITSKY, SpriteAction::SIT);
-    substituteAction(SpriteAction::SITWATER, SpriteAction::SIT);
-    substituteAction(SpriteAction::ATTACKSKY, SpriteAction::ATTACK);
-    substituteAction(SpriteAction::ATTACKWATER, SpriteAction::ATTACK);
-    substituteAction(SpriteAction::SPAWNSKY, SpriteAction::SPAWN);
-    substituteAction(SpriteAction::SPAWNWATER, SpriteAction::SPAWN);
-    substituteAction(SpriteAction::DEADSKY, SpriteAction::DEAD);
-    substituteAction(SpriteAction::DEADWATER, SpriteAction::DEAD);
-}
-
-void SpriteDef::loadSprite(const XmlNodePtr spriteNode, const int variant,
-                           const std::string &palettes)
-{
-    // Get the variant
-    const int variantCount = XML::getProperty(spriteNode, "variants", 0);
-    int variant_offset = 0;
-
-    if (variantCount > 0 && variant < variantCount)
-    {
-        variant_offset =
-            variant * XML::getProperty(spriteNode, "variant_offset", 0);
-    }
-
-    for_each_xml_child_node(node, spriteNode)
-    {
-        if (xmlNameEqual(node, "imageset"))
-            loadImageSet(node, palettes);
-        else if (xmlNameEqual(node, "action"))
-            loadAction(node, variant_offset);
-        else if (xmlNameEqual(node, "include"))
-            includeSprite(node);
-    }
-}
-
-void SpriteDef::loadImageSet(const XmlNodePtr node,
-                             const std::string &palettes)
-{
-    const std::string name = XML::getProperty(node, "name", "");
-
-    // We don't allow redefining image sets. This way, an included sprite
-    // definition will use the already loaded image set with the same name.
-    if (mImageSets.find(name) != mImageSets.end())
-        return;
-
-    const int width = XML::getProperty(node, "width", 0);
-    const int height = XML::getProperty(node, "height", 0);
-    std::string imageSrc = XML::getProperty(node, "src", "");
-    Dye::instantiate(imageSrc, palettes);
-
-    ResourceManager *const resman = ResourceManager::getInstance();
-    ImageSet *const imageSet = resman->getImageSet(imageSrc, width, height);
-
-    if (!imageSet)
-    {
-        logger->log1("Couldn't load imageset!");
-        return;
-    }
-
-    imageSet->setOffsetX(XML::getProperty(node, "offsetX", 0));
-    imageSet->setOffsetY(XML::getProperty(node, "offsetY", 0));
-    mImageSets[name] = imageSet;
-}
-
-void SpriteDef::loadAction(const XmlNodePtr node,
-                           const int variant_offset)
-{
-    const std::string actionName = XML::getProperty(node, "name", "");
-    const std::string imageSetName = XML::getProperty(node, "imageset", "");
-    const unsigned hp = XML::getProperty(node, "hp", 100);
-
-    const ImageSetIterator si = mImageSets.find(imageSetName);
-    if (si == mImageSets.end())
-    {
-        logger->log("Warning: imageset \"%s\" not defined in %s",
-            imageSetName.c_str(), getIdPath().c_str());
-        return;
-    }
-    const ImageSet *const imageSet = si->second;
-
-    if (actionName == SpriteAction::INVALID)
-    {
-        logger->log("Warning: Unknown action \"%s\" defined in %s",
-            actionName.c_str(), getIdPath().c_str());
-        return;
-    }
-    Action *const action = new Action;
-    action->setNumber(hp);
-    addAction(hp, actionName, action);
-
-    // dirty hack to fix bad resources in tmw server
-    if (actionName == "attack_stab")
-        addAction(hp, "attack", action);
-
-    // When first action set it as default direction
-    const Actions::const_iterator i = mActions.find(hp);
-    if ((*i).second->size() == 1)
-        addAction(hp, SpriteAction::DEFAULT, action);
-
-    // Load animations
-    for_each_xml_child_node(animationNode, node)
-    {
-        if (xmlNameEqual(animationNode, "animation"))
-            loadAnimation(animationNode, action, imageSet, variant_offset);
-    }
-}
-
-void SpriteDef::loadAnimation(const XmlNodePtr animationNode,
-                              Action *const action,
-                              const ImageSet *const imageSet,
-                              const int variant_offset) const
-{
-    if (!action || !imageSet)
-        return;
-
-    const std::string directionName =
-        XML::getProperty(animationNode, "direction", "");
-    const SpriteDirection::Type directionType
-        = makeSpriteDirection(directionName);
-
-    if (directionType == SpriteDirection::INVALID)
-    {
-        logger->log("Warning: Unknown direction \"%s\" used in %s",
-                directionName.c_str(), getIdPath().c_str());
-        return;
-    }
-
-    Animation *const animation = new Animation;
-    action->setAnimation(directionType, animation);
 
-    // Get animation frames
-    for_each_xml_child_node(frameNode, animationNode)
+    const int variantOffset = mTemplate->getVariantOffset(variant);
+    const std::vector<SpriteFrameImage> &frameImages
+        = mTemplate->getFrameImages();
+    mImages.reserve(frameImages.size());
+    FOR_EACH (std::vector<SpriteFrameImage>::const_iterator,
+              it, frameImages)
     {
-        const int delay = XML::getIntProperty(
-            frameNode, "delay", 0, 0, 100000);
-        const int offsetX = XML::getProperty(frameNode, "offsetX", 0)
-            + imageSet->getOffsetX() - imageSet->getWidth() / 2
-            + mapTileSize / 2;
-        const int offsetY = XML::getProperty(frameNode, "offsetY", 0)
-            + imageSet->getOffsetY() - imageSet->getHeight() + mapTileSize;
-        const int rand = XML::getIntProperty(frameNode, "rand", 100, 0, 100);
-
-        if (xmlNameEqual(frameNode, "frame"))
+        const SpriteFrameImage &frame = *it;
+        const ImageSet *const imageSet = mImageSets[frame.imageSet];
+        Image *img = nullptr;
+        if (imageSet)
         {
-            const int index = XML::getProperty(frameNode, "index", -1);
-
-            if (index < 0)
-            {
-                logger->log1("No valid value for 'index'");
-                continue;
-            }
-
-            Image *const img = imageSet->get(index + variant_offset);
-
+            const int index = frame.variant
+                ? frame.index + variantOffset : frame.index;
+            img = imageSet->get(index);
             if (!img)
             {
-                logger->log("No image at index %d", index + variant_offset);
-                continue;
+                logger->log("No image at index %d", index);
+                failed = true;
             }
-
-            animation->addFrame(img, delay, offsetX, offsetY, rand);
-        }
-        else if (xmlNameEqual(frameNode, "sequence"))
-        {
-            const int start = XML::getProperty(frameNode, "start", -1);
-            const int end = XML::getProperty(frameNode, "end", -1);
-            const std::string value = XML::getProperty(frameNode, "value", "");
-            const int repeat = XML::getIntProperty(
-                frameNode, "repeat", 1, 0, 100);
-
-            if (repeat < 1)
-            {
-                logger->log1("No valid value for 'repeat'");
-                continue;
-            }
-
-            if (value.empty())
-            {
-                if (addSequence(start, end, delay, offsetX, offsetY,
-                    variant_offset, repeat, rand, imageSet, animation))
-                {
-                    continue;
-                }
-            }
-            else
-            {
-                StringVect vals;
-                splitToStringVector(vals, value, ',');
-                FOR_EACH (StringVectCIter, it, vals)
-                {
-                    const std::string str = *it;
-                    const size_t idx = str.find("-");
-                    if (str == "p")
-                    {
-                        animation->addPause(delay, rand);
-                    }
-                    else if (idx != std::string::npos)
-                    {
-                        const int v1 = atoi(str.substr(0, idx).c_str());
-                        const int v2 = atoi(str.substr(idx + 1).c_str());
-                        addSequence(v1, v2, delay, offsetX, offsetY,
-                            variant_offset, repeat, rand, imageSet, animation);
-                    }
-                    else
-                    {
-                        Image *const img = imageSet->get(atoi(
-                            str.c_str()) + variant_offset);
-                        if (img)
-                        {
-                            animation->addFrame(img, delay,
-                                offsetX, offsetY, rand);
-                        }
-                    }
-                }
-            }
-        }
-        else if (xmlNameEqual(frameNode, "pause"))
-        {
-            animation->addPause(delay, rand);
         }
-        else if (xmlNameEqual(frameNode, "end"))
-        {
-            animation->addTerminator(rand);
-        }
-        else if (xmlNameEqual(frameNode, "jump"))
-        {
-            animation->addJump(XML::getProperty(
-                frameNode, "action", ""), rand);
-        }
-        else if (xmlNameEqual(frameNode, "label"))
-        {
-            const std::string name = XML::getProperty(frameNode, "name", "");
-            if (!name.empty())
-                animation->addLabel(name);
-        }
-        else if (xmlNameEqual(frameNode, "goto"))
-        {
-            const std::string name = XML::getProperty(frameNode, "label", "");
-            if (!name.empty())
-                animation->addGoto(name, rand);
-        }
-    }  // for frameNode
-}
-
-void SpriteDef::includeSprite(const XmlNodePtr includeNode)
-{
-    std::string filename = XML::getProperty(includeNode, "file", "");
-
-    if (filename.empty())
-        return;
-    filename = paths.getStringValue("sprites").append(filename);
-
-    if (mProcessedFiles.find(filename) != mProcessedFiles.end())
-    {
-        logger->log("Error, Tried to include %s which already is included.",
-            filename.c_str());
-        return;
+        mImages.push_back(img);
     }
-    mProcessedFiles.insert(filename);
-
-    XML::Document doc(filename);
-    const XmlNodePtr rootNode = doc.rootNode();
 
-    if (!rootNode || !xmlNameEqual(rootNode, "sprite"))
+    // actions with not loaded image sets dropped like not defined,
+    // and frames without images dropped from animations.
+    if (failed)
     {
-        logger->log("Error, no sprite root node in %s", filename.c_str());
-        return;
+        mTemplate->createActions(mActions, mActionCopies,
+            mImageSets, mImages);
+        mOwnActions = true;
     }
-
-    loadSprite(rootNode, 0);
 }
 
 SpriteDef::~SpriteDef()
 {
-    // Actions are shared, so ensure they are deleted only once.
-    std::set<Action*> actions;
-    FOR_EACH (Actions::iterator, i, mActions)
+    FOR_EACH (std::vector<ImageSet*>::iterator, i, mImageSets)
     {
-        FOR_EACHP (ActionMap::iterator, it, (*i).second)
-            actions.insert(it->second);
-        delete (*i).second;
-    }
-
-    FOR_EACH (std::set<Action*>::const_iterator, i, actions)
-        delete *i;
-
-    mActions.clear();
-
-    FOR_EACH (ImageSetIterator, i, mImageSets)
-    {
-        if (i->second)
-        {
-            i->second->decRef();
-            i->second = nullptr;
-        }
+        if (*i)
+            (*i)->decRef();
     }
     mImageSets.clear();
+    mImages.clear();
+    SpriteTemplate::deleteActions(mActions, mActionCopies);
+    if (mTemplate)
+        mTemplate->decRef();
 }
 
-SpriteDirection::Type SpriteDef::makeSpriteDirection(const std::string
-                                                     &direction)
-{
-    if (direction.empty() || direction == "default")
-        return SpriteDirection::DEFAULT;
-    else if (direction == "up")
-        return SpriteDirection::UP;
-    else if (direction == "left")
-        return SpriteDirection::LEFT;
-    else if (direction == "right")
-        return SpriteDirection::RIGHT;
-    else if (direction == "down")
-        return SpriteDirection::DOWN;
-    else if (direction == "upleft")
-        return SpriteDirection::UPLEFT;
-    else if (direction == "upright")
-        return SpriteDirection::UPRIGHT;
-    else if (direction == "downleft")
-        return SpriteDirection::DOWNLEFT;
-    else if (direction == "downright")
-        return SpriteDirection::DOWNRIGHT;
-    else
-        return SpriteDirection::INVALID;
-}
-
-void SpriteDef::addAction(const unsigned hp, const std::string &name,
-                          Action *const action)
+size_t SpriteDef::getMemoryUsage() const
 {
-    const Actions::const_iterator i = mActions.find(hp);
-    if (i == mActions.end())
-        mActions[hp] = new ActionMap();
-
-    (*mActions[hp])[name] = action;
-}
-
-bool SpriteDef::addSequence(const int start,
-                            const int end,
-                            const int delay,
-                            const int offsetX,
-                            const int offsetY,
-                            const int variant_offset,
-                            int repeat,
-                            const int rand,
-                            const ImageSet *const imageSet,
-                            Animation *const animation)
-{
-    if (!imageSet || !animation)
-        return true;
-
-    if (start < 0 || end < 0)
-    {
-        logger->log1("No valid value for 'start' or 'end'");
-        return true;
-    }
-
-    if (start <= end)
-    {
-        while (repeat > 0)
-        {
-            int pos = start;
-            while (end >= pos)
-            {
-                Image *const img = imageSet->get(pos + variant_offset);
-
-                if (!img)
-                {
-                    logger->log("No image at index %d",
-                        pos + variant_offset);
-                    pos ++;
-                    continue;
-                }
-
-                animation->addFrame(img, delay,
-                    offsetX, offsetY, rand);
-                pos ++;
-            }
-            repeat --;
-        }
-    }
-    else
-    {
-        while (repeat > 0)
-        {
-            int pos = start;
-            while (end <= pos)
-            {
-                Image *const img = imageSet->get(pos + variant_offset);
-
-                if (!img)
-                {
-                    logger->log("No image at index %d",
-                        pos + variant_offset);
-                    pos ++;
-                    continue;
-                }
-
-                animation->addFrame(img, delay,
-                    offsetX, offsetY, rand);
-                pos --;
-            }
-            repeat --;
-        }
-    }
-    return false;
+    // actions and image sets counted in own resources
+    return Resource::getMemoryUsage() + sizeof(SpriteDef) - sizeof(Resource)
+        + mImageSets.capacity() * sizeof(ImageSet*)
+        + mImages.capacity() * sizeof(Image*);
 }
@@ -23,21 +23,29 @@
 #ifndef RESOURCES_SPRITEDEF_H
 #define RESOURCES_SPRITEDEF_H
 
+#include "resources/frame.h"
 #include "resources/resource.h"
 
 #include "resources/spritedirection.h"
+#include "resources/spritetemplate.h"
 
 #include "utils/xml.h"
 
 #include <map>
 #include <set>
+#include <vector>
 
 class Action;
-class Animation;
+class Image;
 class ImageSet;
 
 /**
- * Defines a class to load an animation.
+ * Sprite definition for one palette and variant.
+ *
+ * Actions and animations shared with other palettes and variants in
+ * SpriteTemplate. Sprite definition only stores frame images and, if some
+ * image sets or frame images failed to load, own action maps without
+ * actions and frames using them.
  */
 class SpriteDef final : public Resource
 {
@@ -60,34 +68,44 @@ class SpriteDef final : public Resource
         unsigned findNumber(const unsigned num) const A_WARN_UNUSED;
 
         /**
-         * Converts a string into a SpriteDirection enum.
+         * Returns image of animation frame.
+         */
+        Image *getImage(const Frame &frame) const A_WARN_UNUSED
+        {
+            if (frame.imageIndex < 0)
+                return frame.image;
+            if (static_cast<size_t>(frame.imageIndex) >= mImages.size())
+                return nullptr;
+            return mImages[frame.imageIndex];
+        }
+
+        /**
+         * Returns pointer unique for frame of this sprite definition.
          */
-        static SpriteDirection::Type
-            makeSpriteDirection(const std::string &direction) A_WARN_UNUSED;
-
-        void addAction(const unsigned hp, const std::string &name,
-                       Action *const action);
-
-        static bool addSequence(const int start,
-                                const int end,
-                                const int delay,
-                                const int offsetX,
-                                const int offsetY,
-                                const int variant_offset,
-                                int repeat,
-                                const int rand,
-                                const ImageSet *const imageSet,
-                                Animation *const animation);
+        const void *getHash(const Frame &frame) const A_WARN_UNUSED
+        {
+            if (frame.imageIndex < 0
+                || static_cast<size_t>(frame.imageIndex) >= mImages.size())
+            {
+                return &frame;
+            }
+            return &mImages[frame.imageIndex];
+        }
+
+        size_t getMemoryUsage() const override final A_WARN_UNUSED;
 
     private:
         /**
          * Constructor.
          */
-        SpriteDef() :
+        explicit SpriteDef(SpriteTemplate *const spriteTemplate) :
             Resource(),
+            mTemplate(spriteTemplate),
             mImageSets(),
+            mImages(),
             mActions(),
-            mProcessedFiles()
+            mActionCopies(),
+            mOwnActions(false)
         { }
 
         /**
@@ -96,64 +114,17 @@ class SpriteDef final : public Resource
         ~SpriteDef();
 
         /**
-         * Loads a sprite element.
-         */
-        void loadSprite(const XmlNodePtr spriteNode,
-                        const int variant,
-                        const std::string &palettes = "");
-
-        /**
-         * Loads an imageset element.
-         */
-        void loadImageSet(const XmlNodePtr node,
-                          const std::string &palettes);
-
-        /**
-         * Loads an action element.
-         */
-        void loadAction(const XmlNodePtr node,
-                        const int variant_offset);
-
-        /**
-         * Loads an animation element.
-         */
-        void loadAnimation(const XmlNodePtr animationNode,
-                           Action *const action,
-                           const ImageSet *const imageSet,
-                           const int variant_offset) const;
-
-        /**
-         * Include another sprite into this one.
-         */
-        void includeSprite(const XmlNodePtr includeNode);
-
-        /**
-         * Complete missing actions by copying existing ones.
-         */
-        void substituteActions();
-
-        /**
-         * Fix bad timeout in last dead action frame
-         */
-        void fixDeadAction();
-
-        /**
-         * When there are no animations defined for the action "complete", its
-         * animations become a copy of those of the action "with".
+         * Loads image sets and frame images for palettes and variant.
          */
-        void substituteAction(const std::string &restrict complete,
-                              const std::string &restrict with);
-
-        typedef std::map<std::string, ImageSet*> ImageSets;
-        typedef ImageSets::iterator ImageSetIterator;
-        typedef std::map<std::string, Action*> ActionMap;
-        typedef std::map<unsigned, ActionMap*> Actions;
-        typedef Actions::const_iterator ActionsConstIter;
-        typedef Actions::iterator ActionsIter;
-
-        ImageSets mImageSets;
-        Actions mActions;
-        std::set<std::string> mProcessedFiles;
+        void loadImages(const std::string &palettes,
+                        const int variant);
+
+        SpriteTemplate *mTemplate;
+        std::vector<ImageSet*> mImageSets;
+        std::vector<Image*> mImages;
+        SpriteTemplate::Actions mActions;
+        std::vector<Action*> mActionCopies;
+        bool mOwnActions;
 };
 
 #endif  // RESOURCES_SPRITEDEF_H
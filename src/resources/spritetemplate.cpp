@@ -0,0 +1,605 @@
+/*
+ *  The ManaPlus Client
+ *  Copyright (C) 2011-2014  The ManaPlus Developers
+ *
+ *  This file is part of The ManaPlus Client.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "resources/spritetemplate.h"
+
+#include "logger.h"
+
+#include "resources/map/mapconsts.h"
+
+#include "resources/action.h"
+#include "resources/animation.h"
+#include "resources/spriteaction.h"
+
+#include "utils/dtor.h"
+
+#include "configuration.h"
+
+#include "debug.h"
+
+const Action *SpriteTemplate::getAction(const std::string &action,
+                                        const unsigned num) const
+{
+    return findAction(mActions, action, num);
+}
+
+const Action *SpriteTemplate::findAction(const Actions &actions,
+                                         const std::string &action,
+                                         const unsigned num)
+{
+    Actions::const_iterator i = actions.find(num);
+    if (i == actions.end() && num != 100)
+        i = actions.find(100);
+
+    if (i == actions.end() || !(*i).second)
+        return nullptr;
+
+    const ActionMap *const actMap = (*i).second;
+    if (!actMap)
+        return nullptr;
+    const ActionMap::const_iterator it = actMap->find(action);
+
+    if (it == actMap->end())
+    {
+        logger->log("Warning: no action \"%s\" defined!", action.c_str());
+        return nullptr;
+    }
+
+    return (*it).second;
+}
+
+unsigned SpriteTemplate::findNumber(const unsigned num) const
+{
+    return findNumber(mActions, num);
+}
+
+unsigned SpriteTemplate::findNumber(const Actions &actions,
+                                    const unsigned num)
+{
+    unsigned min = 101;
+    FOR_EACH (Actions::const_iterator, it, actions)
+    {
+        const unsigned n = (*it).first;
+        if (n >= num && n < min)
+            min = n;
+    }
+    if (min == 101)
+        return 0;
+    return min;
+}
+
+int SpriteTemplate::getVariantOffset(const int variant) const
+{
+    if (mVariants > 0 && variant < mVariants)
+        return variant * mVariantOffset;
+    return 0;
+}
+
+SpriteTemplate *SpriteTemplate::load(const std::string &file,
+                                     const bool fixDead)
+{
+    XML::Document doc(file);
+    XmlNodePtrConst rootNode = doc.rootNode();
+
+    if (!rootNode || !xmlNameEqual(rootNode, "sprite"))
+        return nullptr;
+
+    SpriteTemplate *const sprite = new SpriteTemplate;
+    sprite->mProcessedFiles.insert(file);
+    sprite->loadSprite(rootNode, true);
+    sprite->mProcessedFiles.clear();
+    substituteActions(sprite->mActions);
+    sprite->mFixDead = fixDead;
+    if (fixDead)
+        fixDeadAction(sprite->mActions);
+    return sprite;
+}
+
+void SpriteTemplate::fixDeadAction(Actions &actions)
+{
+    FOR_EACH (ActionsIter, it, actions)
+    {
+        ActionMap *const d = (*it).second;
+        if (!d)
+            continue;
+        const ActionMap::iterator i = d->find(SpriteAction::DEAD);
+        const ActionMap::iterator i2 = d->find(SpriteAction::STAND);
+        // search dead action and check what it not same with stand action
+        if (i != d->end() && i->second && i->second != i2->second)
+            (i->second)->setLastFrameDelay(0);
+    }
+}
+
+void SpriteTemplate::substituteAction(Actions &actions,
+                                      const std::string &restrict complete,
+                                      const std::string &restrict with)
+{
+    FOR_EACH (ActionsConstIter, it, actions)
+    {
+        ActionMap *const d = (*it).second;
+        if (!d)
+            continue;
+        if (d->find(complete) == d->end())
+        {
+            const ActionMap::iterator i = d->find(with);
+            if (i != d->end())
+                (*d)[complete] = i->second;
+        }
+    }
+}
+
+void SpriteTemplate::substituteActions(Actions &actions)
+{
+    substituteAction(actions, SpriteAction::STAND, SpriteAction::DEFAULT);
+    substituteAction(actions, SpriteAction::MOVE, SpriteAction::STAND);
+    substituteAction(actions, SpriteAction::ATTACK, SpriteAction::STAND);
+    substituteAction(actions, SpriteAction::CAST_MAGIC, SpriteAction::ATTACK);
+    substituteAction(actions, SpriteAction::USE_ITEM, SpriteAction::CAST_MAGIC);
+    substituteAction(actions, SpriteAction::SIT, SpriteAction::STAND);
+    substituteAction(actions, SpriteAction::SITTOP, SpriteAction::SIT);
+    substituteAction(actions, SpriteAction::SLEEP, SpriteAction::SIT);
+    substituteAction(actions, SpriteAction::HURT, SpriteAction::STAND);
+    substituteAction(actions, SpriteAction::DEAD, SpriteAction::HURT);
+    substituteAction(actions, SpriteAction::SPAWN, SpriteAction::STAND);
+    substituteAction(actions, SpriteAction::FLY, SpriteAction::MOVE);
+    substituteAction(actions, SpriteAction::SWIM, SpriteAction::MOVE);
+    substituteAction(actions, SpriteAction::STANDSKY, SpriteAction::STAND);
+    substituteAction(actions, SpriteAction::STANDWATER, SpriteAction::STAND);
+    substituteAction(actions, SpriteAction::SITSKY, SpriteAction::SIT);
+    substituteAction(actions, SpriteAction::SITWATER, SpriteAction::SIT);
+    substituteAction(actions, SpriteAction::ATTACKSKY, SpriteAction::ATTACK);
+    substituteAction(actions, SpriteAction::ATTACKWATER, SpriteAction::ATTACK);
+    substituteAction(actions, SpriteAction::SPAWNSKY, SpriteAction::SPAWN);
+    substituteAction(actions, SpriteAction::SPAWNWATER, SpriteAction::SPAWN);
+    substituteAction(actions, SpriteAction::DEADSKY, SpriteAction::DEAD);
+    substituteAction(actions, SpriteAction::DEADWATER, SpriteAction::DEAD);
+}
+
+void SpriteTemplate::loadSprite(const XmlNodePtr spriteNode, const bool root)
+{
+    // Get the variant
+    if (root)
+    {
+        mVariants = XML::getProperty(spriteNode, "variants", 0);
+        mVariantOffset = XML::getProperty(spriteNode, "variant_offset", 0);
+    }
+
+    for_each_xml_child_node(node, spriteNode)
+    {
+        if (xmlNameEqual(node, "imageset"))
+            loadImageSet(node, root);
+        else if (xmlNameEqual(node, "action"))
+            loadAction(node, root);
+        else if (xmlNameEqual(node, "include"))
+            includeSprite(node);
+    }
+}
+
+void SpriteTemplate::loadImageSet(const XmlNodePtr node, const bool root)
+{
+    const std::string name = XML::getProperty(node, "name", "");
+
+    // We don't allow redefining image sets. This way, an included sprite
+    // definition will use the already loaded image set with the same name.
+    if (mImageSetNames.find(name) != mImageSetNames.end())
+        return;
+
+    const SpriteImageSet imageSet =
+    {
+        name,
+        XML::getProperty(node, "src", ""),
+        XML::getProperty(node, "width", 0),
+        XML::getProperty(node, "height", 0),
+        XML::getProperty(node, "offsetX", 0),
+        XML::getProperty(node, "offsetY", 0),
+        root
+    };
+    mImageSetNames[name] = static_cast<int>(mImageSets.size());
+    mImageSets.push_back(imageSet);
+}
+
+void SpriteTemplate::loadAction(const XmlNodePtr node, const bool root)
+{
+    const std::string actionName = XML::getProperty(node, "name", "");
+    const std::string imageSetName = XML::getProperty(node, "imageset", "");
+    const unsigned hp = XML::getProperty(node, "hp", 100);
+
+    const std::map<std::string, int>::const_iterator si
+        = mImageSetNames.find(imageSetName);
+    if (si == mImageSetNames.end())
+    {
+        logger->log("Warning: imageset \"%s\" not defined in %s",
+            imageSetName.c_str(), getIdPath().c_str());
+        return;
+    }
+    const int imageSet = si->second;
+
+    if (actionName == SpriteAction::INVALID)
+    {
+        logger->log("Warning: Unknown action \"%s\" defined in %s",
+            actionName.c_str(), getIdPath().c_str());
+        return;
+    }
+    Action *const action = new Action;
+    action->setNumber(hp);
+    addLoadedAction(mActions, hp, actionName, action);
+    mActionDefs.push_back(ActionDef(hp, actionName, action, imageSet));
+
+    // Load animations
+    for_each_xml_child_node(animationNode, node)
+    {
+        if (xmlNameEqual(animationNode, "animation"))
+            loadAnimation(animationNode, action, imageSet, root);
+    }
+}
+
+void SpriteTemplate::loadAnimation(const XmlNodePtr animationNode,
+                                   Action *const action,
+                                   const int imageSet,
+                                   const bool root)
+{
+    if (!action)
+        return;
+
+    const std::string directionName =
+        XML::getProperty(animationNode, "direction", "");
+    const SpriteDirection::Type directionType
+        = makeSpriteDirection(directionName);
+
+    if (directionType == SpriteDirection::INVALID)
+    {
+        logger->log("Warning: Unknown direction \"%s\" used in %s",
+                directionName.c_str(), getIdPath().c_str());
+        return;
+    }
+
+    Animation *const animation = new Animation;
+    action->setAnimation(directionType, animation);
+
+    const SpriteImageSet &set = mImageSets[imageSet];
+
+    // Get animation frames
+    for_each_xml_child_node(frameNode, animationNode)
+    {
+        const int delay = XML::getIntProperty(
+            frameNode, "delay", 0, 0, 100000);
+        const int offsetX = XML::getProperty(frameNode, "offsetX", 0)
+            + set.offsetX - set.width / 2 + mapTileSize / 2;
+        const int offsetY = XML::getProperty(frameNode, "offsetY", 0)
+            + set.offsetY - set.height + mapTileSize;
+        const int rand = XML::getIntProperty(frameNode, "rand", 100, 0, 100);
+
+        if (xmlNameEqual(frameNode, "frame"))
+        {
+            const int index = XML::getProperty(frameNode, "index", -1);
+
+            if (index < 0)
+            {
+                logger->log1("No valid value for 'index'");
+                continue;
+            }
+
+            addFrame(animation, imageSet, index, root,
+                delay, offsetX, offsetY, rand);
+        }
+        else if (xmlNameEqual(frameNode, "sequence"))
+        {
+            const int start = XML::getProperty(frameNode, "start", -1);
+            const int end = XML::getProperty(frameNode, "end", -1);
+            const std::string value = XML::getProperty(frameNode, "value", "");
+            const int repeat = XML::getIntProperty(
+                frameNode, "repeat", 1, 0, 100);
+
+            if (repeat < 1)
+            {
+                logger->log1("No valid value for 'repeat'");
+                continue;
+            }
+
+            if (value.empty())
+            {
+                if (addSequence(start, end, delay, offsetX, offsetY,
+                    repeat, rand, imageSet, root, animation))
+                {
+                    continue;
+                }
+            }
+            else
+            {
+                StringVect vals;
+                splitToStringVector(vals, value, ',');
+                FOR_EACH (StringVectCIter, it, vals)
+                {
+                    const std::string str = *it;
+                    const size_t idx = str.find("-");
+                    if (str == "p")
+                    {
+                        animation->addPause(delay, rand);
+                    }
+                    else if (idx != std::string::npos)
+                    {
+                        const int v1 = atoi(str.substr(0, idx).c_str());
+                        const int v2 = atoi(str.substr(idx + 1).c_str());
+                        addSequence(v1, v2, delay, offsetX, offsetY,
+                            repeat, rand, imageSet, root, animation);
+                    }
+                    else
+                    {
+                        addFrame(animation, imageSet, atoi(str.c_str()),
+                            root, delay, offsetX, offsetY, rand);
+                    }
+                }
+            }
+        }
+        else if (xmlNameEqual(frameNode, "pause"))
+        {
+            animation->addPause(delay, rand);
+        }
+        else if (xmlNameEqual(frameNode, "end"))
+        {
+            animation->addTerminator(rand);
+        }
+        else if (xmlNameEqual(frameNode, "jump"))
+        {
+            animation->addJump(XML::getProperty(
+                frameNode, "action", ""), rand);
+        }
+        else if (xmlNameEqual(frameNode, "label"))
+        {
+            const std::string name = XML::getProperty(frameNode, "name", "");
+            if (!name.empty())
+                animation->addLabel(name);
+        }
+        else if (xmlNameEqual(frameNode, "goto"))
+        {
+            const std::string name = XML::getProperty(frameNode, "label", "");
+            if (!name.empty())
+                animation->addGoto(name, rand);
+        }
+    }  // for frameNode
+}
+
+void SpriteTemplate::includeSprite(const XmlNodePtr includeNode)
+{
+    std::string filename = XML::getProperty(includeNode, "file", "");
+
+    if (filename.empty())
+        return;
+    filename = paths.getStringValue("sprites").append(filename);
+
+    if (mProcessedFiles.find(filename) != mProcessedFiles.end())
+    {
+        logger->log("Error, Tried to include %s which already is included.",
+            filename.c_str());
+        return;
+    }
+    mProcessedFiles.insert(filename);
+
+    XML::Document doc(filename);
+    const XmlNodePtr rootNode = doc.rootNode();
+
+    if (!rootNode || !xmlNameEqual(rootNode, "sprite"))
+    {
+        logger->log("Error, no sprite root node in %s", filename.c_str());
+        return;
+    }
+
+    loadSprite(rootNode, false);
+}
+
+SpriteTemplate::~SpriteTemplate()
+{
+    // Actions are shared, so ensure they are deleted only once.
+    std::set<Action*> actions;
+    FOR_EACH (Actions::iterator, i, mActions)
+    {
+        FOR_EACHP (ActionMap::iterator, it, (*i).second)
+            actions.insert(it->second);
+        delete (*i).second;
+    }
+
+    FOR_EACH (std::set<Action*>::const_iterator, i, actions)
+        delete *i;
+
+    mActions.clear();
+    mActionDefs.clear();
+}
+
+size_t SpriteTemplate::getMemoryUsage() const
+{
+    return Resource::getMemoryUsage() + sizeof(SpriteTemplate)
+        - sizeof(Resource)
+        + mImageSets.capacity() * sizeof(SpriteImageSet)
+        + mFrameImages.capacity() * (sizeof(SpriteFrameImage) + sizeof(Frame))
+        + mActionDefs.capacity() * sizeof(ActionDef);
+}
+
+SpriteDirection::Type SpriteTemplate::makeSpriteDirection(const std::string
+                                                          &direction)
+{
+    if (direction.empty() || direction == "default")
+        return SpriteDirection::DEFAULT;
+    else if (direction == "up")
+        return SpriteDirection::UP;
+    else if (direction == "left")
+        return SpriteDirection::LEFT;
+    else if (direction == "right")
+        return SpriteDirection::RIGHT;
+    else if (direction == "down")
+        return SpriteDirection::DOWN;
+    else if (direction == "upleft")
+        return SpriteDirection::UPLEFT;
+    else if (direction == "upright")
+        return SpriteDirection::UPRIGHT;
+    else if (direction == "downleft")
+        return SpriteDirection::DOWNLEFT;
+    else if (direction == "downright")
+        return SpriteDirection::DOWNRIGHT;
+    else
+        return SpriteDirection::INVALID;
+}
+
+void SpriteTemplate::addAction(Actions &actions,
+                               const unsigned hp,
+                               const std::string &name,
+                               Action *const action)
+{
+    const Actions::const_iterator i = actions.find(hp);
+    if (i == actions.end())
+        actions[hp] = new ActionMap();
+
+    (*actions[hp])[name] = action;
+}
+
+void SpriteTemplate::addLoadedAction(Actions &actions,
+                                     const unsigned hp,
+                                     const std::string &name,
+                                     Action *const action)
+{
+    addAction(actions, hp, name, action);
+
+    // dirty hack to fix bad resources in tmw server
+    if (name == "attack_stab")
+        addAction(actions, hp, "attack", action);
+
+    // When first action set it as default direction
+    const Actions::const_iterator i = actions.find(hp);
+    if ((*i).second->size() == 1)
+        addAction(actions, hp, SpriteAction::DEFAULT, action);
+}
+
+void SpriteTemplate::createActions(Actions &actions,
+                                   std::vector<Action*> &copies,
+                                   const std::vector<ImageSet*> &imageSets,
+                                   const std::vector<Image*> &images) const
+{
+    bool missedImages = false;
+    FOR_EACH (std::vector<Image*>::const_iterator, it, images)
+    {
+        if (!*it)
+        {
+            missedImages = true;
+            break;
+        }
+    }
+
+    // same action can be added with different names
+    std::map<const Action*, Action*> copied;
+    const int sz = static_cast<int>(imageSets.size());
+    FOR_EACH (std::vector<ActionDef>::const_iterator, it, mActionDefs)
+    {
+        const ActionDef &def = *it;
+        if (def.imageSet >= sz || !imageSets[def.imageSet])
+            continue;
+        Action *action = def.action;
+        if (missedImages && action)
+        {
+            const std::map<const Action*, Action*>::const_iterator
+                i = copied.find(action);
+            if (i != copied.end())
+            {
+                action = (*i).second;
+            }
+            else
+            {
+                action = def.action->copyLoaded(images);
+                copied[def.action] = action;
+                copies.push_back(action);
+            }
+        }
+        addLoadedAction(actions, def.hp, def.name, action);
+    }
+    substituteActions(actions);
+    if (mFixDead && missedImages)
+        fixDeadAction(actions);
+}
+
+void SpriteTemplate::deleteActions(Actions &actions,
+                                   std::vector<Action*> &copies)
+{
+    // Actions itself owned by template, except copies.
+    FOR_EACH (Actions::iterator, i, actions)
+        delete (*i).second;
+    actions.clear();
+    delete_all(copies);
+    copies.clear();
+}
+
+void SpriteTemplate::addFrame(Animation *const animation,
+                              const int imageSet,
+                              const int index,
+                              const bool root,
+                              const int delay,
+                              const int offsetX,
+                              const int offsetY,
+                              const int rand)
+{
+    const SpriteFrameImage image = { imageSet, index, root };
+    animation->addSpriteFrame(static_cast<int>(mFrameImages.size()),
+        delay, offsetX, offsetY, rand);
+    mFrameImages.push_back(image);
+}
+
+bool SpriteTemplate::addSequence(const int start,
+                                 const int end,
+                                 const int delay,
+                                 const int offsetX,
+                                 const int offsetY,
+                                 int repeat,
+                                 const int rand,
+                                 const int imageSet,
+                                 const bool root,
+                                 Animation *const animation)
+{
+    if (!animation)
+        return true;
+
+    if (start < 0 || end < 0)
+    {
+        logger->log1("No valid value for 'start' or 'end'");
+        return true;
+    }
+
+    if (start <= end)
+    {
+        while (repeat > 0)
+        {
+            for (int pos = start; pos <= end; pos ++)
+            {
+                addFrame(animation, imageSet, pos, root,
+                    delay, offsetX, offsetY, rand);
+            }
+            repeat --;
+        }
+    }
+    else
+    {
+        while (repeat > 0)
+        {
+            for (int pos = start; pos >= end; pos --)
+            {
+                addFrame(animation, imageSet, pos, root,
+                    delay, offsetX, offsetY, rand);
+            }
+            repeat --;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,274 @@
+/*
+ *  The ManaPlus Client
+ *  Copyright (C) 2011-2014  The ManaPlus Developers
+ *
+ *  This file is part of The ManaPlus Client.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef RESOURCES_SPRITETEMPLATE_H
+#define RESOURCES_SPRITETEMPLATE_H
+
+#include "resources/resource.h"
+
+#include "resources/spritedirection.h"
+
+#include "utils/xml.h"
+
+#include <map>
+#include <set>
+#include <vector>
+
+class Action;
+class Animation;
+class Image;
+class ImageSet;
+
+/**
+ * Image set declared in sprite definition.
+ */
+struct SpriteImageSet final
+{
+    std::string name;
+    std::string src;
+    int width;
+    int height;
+    int offsetX;
+    int offsetY;
+    bool dye;
+};
+
+/**
+ * Image of animation frame. Resolved separately for each sprite variant.
+ */
+struct SpriteFrameImage final
+{
+    int imageSet;
+    int index;
+    bool variant;
+};
+
+/**
+ * Parsed sprite definition file with all includes.
+ *
+ * Actions and animations not depend on palettes and variants and shared
+ * by all sprite definitions loaded from same file.
+ */
+class SpriteTemplate final : public Resource
+{
+    public:
+        typedef std::map<std::string, Action*> ActionMap;
+        typedef std::map<unsigned, ActionMap*> Actions;
+        typedef Actions::const_iterator ActionsConstIter;
+        typedef Actions::iterator ActionsIter;
+
+        A_DELETE_COPY(SpriteTemplate)
+
+        /**
+         * Parses a sprite definition file.
+         */
+        static SpriteTemplate *load(const std::string &file,
+                                    const bool fixDead) A_WARN_UNUSED;
+
+        /**
+         * Returns the specified action.
+         */
+        const Action *getAction(const std::string &action,
+                                const unsigned num) const A_WARN_UNUSED;
+
+        unsigned findNumber(const unsigned num) const A_WARN_UNUSED;
+
+        static const Action *findAction(const Actions &actions,
+                                        const std::string &action,
+                                        const unsigned num) A_WARN_UNUSED;
+
+        static unsigned findNumber(const Actions &actions,
+                                   const unsigned num) A_WARN_UNUSED;
+
+        /**
+         * Fills actions skipping actions with not loaded image sets,
+         * same way as if these actions was not defined.
+         * If some frame images not loaded, actions copied without these
+         * frames and copies added to copies.
+         */
+        void createActions(Actions &actions,
+                           std::vector<Action*> &copies,
+                           const std::vector<ImageSet*> &imageSets,
+                           const std::vector<Image*> &images) const;
+
+        /**
+         * Deletes action maps and action copies created by createActions.
+         */
+        static void deleteActions(Actions &actions,
+                                  std::vector<Action*> &copies);
+
+        /**
+         * Returns frame offset for given variant.
+         */
+        int getVariantOffset(const int variant) const A_WARN_UNUSED;
+
+        const std::vector<SpriteImageSet> &getImageSets() const A_WARN_UNUSED
+        { return mImageSets; }
+
+        const std::vector<SpriteFrameImage> &getFrameImages() const
+                                                               A_WARN_UNUSED
+        { return mFrameImages; }
+
+        /**
+         * Converts a string into a SpriteDirection enum.
+         */
+        static SpriteDirection::Type
+            makeSpriteDirection(const std::string &direction) A_WARN_UNUSED;
+
+        size_t getMemoryUsage() const override final A_WARN_UNUSED;
+
+    private:
+        /**
+         * Constructor.
+         */
+        SpriteTemplate() :
+            Resource(),
+            mImageSets(),
+            mImageSetNames(),
+            mFrameImages(),
+            mActions(),
+            mActionDefs(),
+            mProcessedFiles(),
+            mVariants(0),
+            mVariantOffset(0),
+            mFixDead(false)
+        { }
+
+        /**
+         * Destructor.
+         */
+        ~SpriteTemplate();
+
+        /**
+         * Loads a sprite element.
+         */
+        void loadSprite(const XmlNodePtr spriteNode,
+                        const bool root);
+
+        /**
+         * Loads an imageset element.
+         */
+        void loadImageSet(const XmlNodePtr node,
+                          const bool root);
+
+        /**
+         * Loads an action element.
+         */
+        void loadAction(const XmlNodePtr node,
+                        const bool root);
+
+        /**
+         * Loads an animation element.
+         */
+        void loadAnimation(const XmlNodePtr animationNode,
+                           Action *const action,
+                           const int imageSet,
+                           const bool root);
+
+        /**
+         * Include another sprite into this one.
+         */
+        void includeSprite(const XmlNodePtr includeNode);
+
+        static void addAction(Actions &actions,
+                              const unsigned hp,
+                              const std::string &name,
+                              Action *const action);
+
+        /**
+         * Adds loaded action with its aliases.
+         */
+        static void addLoadedAction(Actions &actions,
+                                    const unsigned hp,
+                                    const std::string &name,
+                                    Action *const action);
+
+        void addFrame(Animation *const animation,
+                      const int imageSet,
+                      const int index,
+                      const bool root,
+                      const int delay,
+                      const int offsetX,
+                      const int offsetY,
+                      const int rand);
+
+        bool addSequence(const int start,
+                         const int end,
+                         const int delay,
+                         const int offsetX,
+                         const int offsetY,
+                         int repeat,
+                         const int rand,
+                         const int imageSet,
+                         const bool root,
+                         Animation *const animation);
+
+        /**
+         * Complete missing actions by copying existing ones.
+         */
+        static void substituteActions(Actions &actions);
+
+        /**
+         * Fix bad timeout in last dead action frame
+         */
+        static void fixDeadAction(Actions &actions);
+
+        /**
+         * When there are no animations defined for the action "complete", its
+         * animations become a copy of those of the action "with".
+         */
+        static void substituteAction(Actions &actions,
+                                     const std::string &restrict complete,
+                                     const std::string &restrict with);
+
+        /**
+         * Action as defined in sprite file.
+         */
+        struct ActionDef final
+        {
+            ActionDef(const unsigned hp0,
+                      const std::string &name0,
+                      Action *const action0,
+                      const int imageSet0) :
+                name(name0),
+                action(action0),
+                hp(hp0),
+                imageSet(imageSet0)
+            {
+            }
+
+            std::string name;
+            Action *action;
+            unsigned hp;
+            int imageSet;
+        };
+
+        std::vector<SpriteImageSet> mImageSets;
+        std::map<std::string, int> mImageSetNames;
+        std::vector<SpriteFrameImage> mFrameImages;
+        Actions mActions;
+        std::vector<ActionDef> mActionDefs;
+        std::set<std::string> mProcessedFiles;
+        int mVariants;
+        int mVariantOffset;
+        bool mFixDead;
+};
+
+#endif  // RESOURCES_SPRITETEMPLATE_H
@@ -79,6 +79,12 @@ class SubImage final : public Image
                            const int width,
                            const int height) override final A_WARN_UNUSED;
 
+        /**
+         * Pixels are owned by parent image.
+         */
+        size_t getMemoryUsage() const override final A_WARN_UNUSED
+        { return sizeof(SubImage); }
+
 #ifdef USE_OPENGL
         void decRef() override final;
 #endif
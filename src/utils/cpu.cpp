@@ -44,6 +44,8 @@ void Cpu::detect()
         mCpuFlags |= FEATURE_SSE4;
     if (__builtin_cpu_supports ("sse4.2"))
         mCpuFlags |= FEATURE_SSE42;
+    if (__builtin_cpu_supports ("avx2"))
+        mCpuFlags |= FEATURE_AVX2;
     printFlags();
 #elif defined(__linux__) || defined(__linux)
     FILE *file = fopen("/proc/cpuinfo", "r");
@@ -77,6 +79,8 @@ void Cpu::detect()
                     mCpuFlags |= FEATURE_SSE4;
                 else if (flag == "sse4_2")
                     mCpuFlags |= FEATURE_SSE42;
+                else if (flag == "avx2")
+                    mCpuFlags |= FEATURE_AVX2;
             }
             fclose(file);
             printFlags();
@@ -103,5 +107,12 @@ void Cpu::printFlags()
         str.append(" sse4");
     if (mCpuFlags & FEATURE_SSE42)
         str.append(" sse4_2");
+    if (mCpuFlags & FEATURE_AVX2)
+        str.append(" avx2");
     logger->log(str);
 }
+
+int Cpu::getFlags()
+{
+    return mCpuFlags;
+}
@@ -23,6 +23,11 @@
 
 #include "localconsts.h"
 
+#if defined(__GNUC__) && (GCC_VERSION >= 40900) \
+    && (defined(__x86_64__) || defined(__i386__))
+#define SIMD_SUPPORTED
+#endif
+
 namespace Cpu
 {
     enum
@@ -33,12 +38,15 @@ namespace Cpu
         FEATURE_SSE2  = 4,
         FEATURE_SSSE3 = 8,
         FEATURE_SSE4  = 16,
-        FEATURE_SSE42 = 32
+        FEATURE_SSE42 = 32,
+        FEATURE_AVX2  = 64
     };
 
     void detect();
 
     void printFlags();
+
+    int getFlags() A_WARN_UNUSED;
 }  // namespace CPU
 
 #endif  // UTILS_CPU_H
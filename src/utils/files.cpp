@@ -32,12 +32,37 @@
 #include "utils/paths.h"
 #include "utils/physfstools.h"
 
+#include <algorithm>
 #include <dirent.h>
 #include <fstream>
 #include <sstream>
+#include <utime.h>
+#include <vector>
+
+#include <sys/stat.h>
 
 #include "debug.h"
 
+namespace
+{
+    struct DirFile final
+    {
+        std::string name;
+        time_t time;
+        size_t size;
+    };
+
+    class DirFileSorter final
+    {
+        public:
+            bool operator() (const DirFile &file1,
+                             const DirFile &file2) const
+            {
+                return file1.time < file2.time;
+            }
+    } dirFileSorter;
+}  // namespace
+
 #ifdef ANDROID
 void Files::extractLocale()
 {
@@ -358,3 +383,53 @@ void Files::deleteFilesInDirectory(std::string path)
     if (dir)
         closedir(dir);
 }
+
+size_t Files::limitDirSize(std::string path,
+                           const size_t maxSize)
+{
+    path += "/";
+    DIR *const dir = opendir(path.c_str());
+    if (!dir)
+        return 0;
+
+    std::vector<DirFile> files;
+    size_t total = 0;
+    struct dirent *next_file = nullptr;
+    while ((next_file = readdir(dir)))
+    {
+        const std::string name = path + next_file->d_name;
+        struct stat statbuf;
+        if (!stat(name.c_str(), &statbuf) && S_ISREG(statbuf.st_mode))
+        {
+            const DirFile file =
+            {
+                name,
+                statbuf.st_mtime,
+                static_cast<size_t>(statbuf.st_size)
+            };
+            files.push_back(file);
+            total += file.size;
+        }
+    }
+    closedir(dir);
+
+    if (total <= maxSize)
+        return total;
+
+    std::sort(files.begin(), files.end(), dirFileSorter);
+    FOR_EACH (std::vector<DirFile>::const_iterator, it, files)
+    {
+        if (total <= maxSize)
+            break;
+        if (!::remove((*it).name.c_str()))
+            total -= (*it).size;
+    }
+    logger->log("Cache dir %s trimmed to %u bytes", path.c_str(),
+        static_cast<unsigned int>(total));
+    return total;
+}
+
+void Files::touchFile(const std::string &name)
+{
+    utime(name.c_str(), nullptr);
+}
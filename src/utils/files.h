@@ -79,6 +79,21 @@ namespace Files
                       const std::string &restrict text);
 
     void deleteFilesInDirectory(std::string path);
+
+    /**
+     * Removes files from directory, oldest modified first, until total
+     * size of files is not bigger than maxSize.
+     *
+     * @return total size of files left in directory.
+     */
+    size_t limitDirSize(std::string path,
+                        const size_t maxSize);
+
+    /**
+     * Sets file modification time to current time.
+     * Used for marking recently used cache files.
+     */
+    void touchFile(const std::string &name);
 }  // namespace Files
 
 #endif  // UTILS_FILES_H
@@ -22,12 +22,17 @@
 
 #include "logger.h"
 
+#include "utils/mkdir.h"
 #include "utils/physfstools.h"
 
 #include "gtest/gtest.h"
 
 #include "resources/resourcemanager.h"
 
+#include <string.h>
+#include <unistd.h>
+#include <utime.h>
+
 #include "debug.h"
 
 static void init()
@@ -69,3 +74,42 @@ TEST(Files, renameFile)
     delete [] buf;
     delete [] buf2;
 }
+
+TEST(Files, limitDirSize)
+{
+    init();
+    const std::string dir = "limitdir.test";
+    mkdir_r(dir.c_str());
+    const char *const names[3] =
+    {
+        "limitdir.test/1", "limitdir.test/2", "limitdir.test/3"
+    };
+    char buf[100];
+    memset(buf, 0, sizeof(buf));
+    for (int f = 0; f < 3; f ++)
+    {
+        FILE *file = fopen(names[f], "wb");
+        fwrite(buf, 1, sizeof(buf), file);
+        fclose(file);
+        // oldest file first
+        struct utimbuf times;
+        times.actime = 1000 * (f + 1);
+        times.modtime = 1000 * (f + 1);
+        utime(names[f], &times);
+    }
+
+    EXPECT_EQ(300U, Files::limitDirSize(dir, 1000));
+    EXPECT_EQ(200U, Files::limitDirSize(dir, 250));
+    EXPECT_FALSE(Files::existsLocal(names[0]));
+    EXPECT_TRUE(Files::existsLocal(names[1]));
+    EXPECT_TRUE(Files::existsLocal(names[2]));
+
+    // used file must be kept
+    Files::touchFile(names[1]);
+    EXPECT_EQ(100U, Files::limitDirSize(dir, 150));
+    EXPECT_TRUE(Files::existsLocal(names[1]));
+    EXPECT_FALSE(Files::existsLocal(names[2]));
+
+    ::remove(names[1]);
+    ::rmdir(dir.c_str());
+}
@@ -132,6 +132,11 @@ namespace PhysFs
         return PHYSFS_getRealDir(filename);
     }
 
+    PHYSFS_sint64 getLastModTime(const char *const filename)
+    {
+        return PHYSFS_getLastModTime(filename);
+    }
+
     bool mkdir(const char *const dirname)
     {
         return PHYSFS_mkdir(dirname);
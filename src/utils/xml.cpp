@@ -27,6 +27,7 @@
 #include "utils/fuzzer.h"
 #include "utils/physfstools.h"
 #include "utils/stringutils.h"
+#include "utils/xmlpreloader.h"
 
 #include "utils/translation/podict.h"
 
@@ -90,6 +91,14 @@ namespace XML
         valid = true;
         if (useResman)
         {
+            mDoc = XmlPreloader::take(filename);
+            if (mDoc)
+            {
+                logger->log("Loaded %s/%s (preloaded)",
+                    PhysFs::getRealDir(filename.c_str()), filename.c_str());
+                mIsValid = true;
+                return;
+            }
             data = static_cast<char*>(PhysFs::loadFile(
                 filename.c_str(), size));
         }
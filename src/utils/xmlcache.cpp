@@ -0,0 +1,507 @@
+/*
+ *  The ManaPlus Client
+ *  Copyright (C) 2011-2014  The ManaPlus Developers
+ *
+ *  This file is part of The ManaPlus Client.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "utils/xmlcache.h"
+
+#include "logger.h"
+
+#include "utils/files.h"
+#include "utils/mkdir.h"
+#include "utils/physfstools.h"
+#include "utils/stringutils.h"
+#include "utils/xml.h"
+
+#include <map>
+#include <vector>
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "debug.h"
+
+namespace
+{
+    const char cacheMagic[4] = {'M', 'P', 'X', 'C'};
+    const uint32_t cacheVersion = 2;
+    const uint32_t cacheByteOrder = 0x01020304;
+
+    enum
+    {
+        NODE_ELEMENT = 1,
+        NODE_TEXT = 2,
+        NODE_CDATA = 3,
+        NODE_COMMENT = 4,
+        NODE_PI = 5
+    };
+
+    std::string mDir;
+
+    typedef std::map<std::string, uint32_t> StringIds;
+
+    class CacheWriter final
+    {
+        public:
+            CacheWriter() :
+                mStrings(),
+                mStringIds(),
+                mNodes()
+            {
+            }
+
+            A_DELETE_COPY(CacheWriter)
+
+            bool writeNodes(const XmlNodePtr first) A_WARN_UNUSED;
+
+            bool save(FILE *const file,
+                      const std::string &stamp) const A_WARN_UNUSED;
+
+        private:
+            void writeInt(const uint32_t val)
+            {
+                const unsigned char *const ptr =
+                    reinterpret_cast<const unsigned char*>(&val);
+                mNodes.insert(mNodes.end(), ptr, ptr + sizeof(val));
+            }
+
+            void writeString(const xmlChar *const str);
+
+            bool writeNode(const XmlNodePtr node) A_WARN_UNUSED;
+
+            std::vector<std::string> mStrings;
+            StringIds mStringIds;
+            std::vector<unsigned char> mNodes;
+    };
+
+    class CacheReader final
+    {
+        public:
+            CacheReader(const unsigned char *const data,
+                        const size_t size) :
+                mData(data),
+                mEnd(data + size),
+                mStrings()
+            {
+            }
+
+            A_DELETE_COPY(CacheReader)
+
+            xmlDocPtr load(const std::string &stamp) A_WARN_UNUSED;
+
+        private:
+            bool readInt(uint32_t &val) A_WARN_UNUSED
+            {
+                if (static_cast<size_t>(mEnd - mData) < sizeof(val))
+                    return false;
+                memcpy(&val, mData, sizeof(val));
+                mData += sizeof(val);
+                return true;
+            }
+
+            bool readString(const xmlChar *&str) A_WARN_UNUSED;
+
+            bool readNodes(const xmlDocPtr doc,
+                           const XmlNodePtr parent) A_WARN_UNUSED;
+
+            XmlNodePtr readNode(const xmlDocPtr doc) A_WARN_UNUSED;
+
+            static XmlNodePtr newText(const xmlDocPtr doc,
+                                      const xmlChar *const content)
+                                      A_WARN_UNUSED;
+
+            const unsigned char *mData;
+            const unsigned char *const mEnd;
+            std::vector<const xmlChar*> mStrings;
+    };
+}  // namespace
+
+void CacheWriter::writeString(const xmlChar *const str)
+{
+    const std::string val = str ? reinterpret_cast<const char*>(str) : "";
+    const StringIds::const_iterator it = mStringIds.find(val);
+    if (it != mStringIds.end())
+    {
+        writeInt((*it).second);
+        return;
+    }
+    const uint32_t id = static_cast<uint32_t>(mStrings.size());
+    mStringIds[val] = id;
+    mStrings.push_back(val);
+    writeInt(id);
+}
+
+bool CacheWriter::writeNodes(const XmlNodePtr first)
+{
+    uint32_t cnt = 0;
+    for (XmlNodePtr node = first; node; node = node->next)
+        cnt ++;
+    writeInt(cnt);
+    for (XmlNodePtr node = first; node; node = node->next)
+    {
+        if (!writeNode(node))
+            return false;
+    }
+    return true;
+}
+
+bool CacheWriter::writeNode(const XmlNodePtr node)
+{
+    switch (node->type)
+    {
+        case XML_ELEMENT_NODE:
+            break;
+        case XML_TEXT_NODE:
+            mNodes.push_back(NODE_TEXT);
+            writeString(node->content);
+            return true;
+        case XML_CDATA_SECTION_NODE:
+            mNodes.push_back(NODE_CDATA);
+            writeString(node->content);
+            return true;
+        case XML_COMMENT_NODE:
+            mNodes.push_back(NODE_COMMENT);
+            writeString(node->content);
+            return true;
+        case XML_PI_NODE:
+            mNodes.push_back(NODE_PI);
+            writeString(node->name);
+            writeString(node->content);
+            return true;
+        default:
+            // entity references, dtd and other rare nodes
+            return false;
+    }
+
+    if (node->ns || node->nsDef)
+        return false;
+
+    mNodes.push_back(NODE_ELEMENT);
+    writeString(node->name);
+
+    uint32_t attrs = 0;
+    for (xmlAttrPtr attr = node->properties; attr; attr = attr->next)
+    {
+        if (attr->ns)
+            return false;
+        attrs ++;
+    }
+    writeInt(attrs);
+    for (xmlAttrPtr attr = node->properties; attr; attr = attr->next)
+    {
+        writeString(attr->name);
+        xmlChar *const value = xmlNodeListGetString(node->doc,
+            attr->children, 1);
+        writeString(value);
+        if (value)
+            xmlFree(value);
+    }
+    return writeNodes(node->children);
+}
+
+bool CacheWriter::save(FILE *const file,
+                       const std::string &stamp) const
+{
+    std::vector<unsigned char> header;
+    header.insert(header.end(), cacheMagic, cacheMagic + 4);
+    const uint32_t vals[3] =
+    {
+        cacheVersion,
+        cacheByteOrder,
+        static_cast<uint32_t>(stamp.size())
+    };
+    const unsigned char *ptr = reinterpret_cast<const unsigned char*>(vals);
+    header.insert(header.end(), ptr, ptr + sizeof(vals));
+    header.insert(header.end(), stamp.begin(), stamp.end());
+    const uint32_t strings = static_cast<uint32_t>(mStrings.size());
+    ptr = reinterpret_cast<const unsigned char*>(&strings);
+    header.insert(header.end(), ptr, ptr + sizeof(strings));
+    if (fwrite(&header[0], 1, header.size(), file) != header.size())
+        return false;
+
+    FOR_EACH (std::vector<std::string>::const_iterator, it, mStrings)
+    {
+        const std::string &str = *it;
+        const uint32_t len = static_cast<uint32_t>(str.size());
+        if (fwrite(&len, sizeof(len), 1, file) != 1)
+            return false;
+        if (len && fwrite(str.c_str(), 1, len, file) != len)
+            return false;
+    }
+    return mNodes.empty() || fwrite(&mNodes[0], 1, mNodes.size(), file)
+        == mNodes.size();
+}
+
+XmlNodePtr CacheReader::newText(const xmlDocPtr doc,
+                                const xmlChar *const content)
+{
+    const XmlNodePtr node = xmlNewDocText(doc, nullptr);
+    // dictionary strings not freed by xmlFreeNode
+    if (node)
+        node->content = const_cast<xmlChar*>(content);
+    return node;
+}
+
+bool CacheReader::readString(const xmlChar *&str)
+{
+    uint32_t id = 0;
+    if (!readInt(id) || id >= mStrings.size())
+        return false;
+    str = mStrings[id];
+    return true;
+}
+
+bool CacheReader::readNodes(const xmlDocPtr doc, const XmlNodePtr parent)
+{
+    uint32_t cnt = 0;
+    if (!readInt(cnt))
+        return false;
+    for (uint32_t f = 0; f < cnt; f ++)
+    {
+        const XmlNodePtr node = readNode(doc);
+        if (!node)
+            return false;
+        xmlAddChild(parent, node);
+    }
+    return true;
+}
+
+XmlNodePtr CacheReader::readNode(const xmlDocPtr doc)
+{
+    if (mData >= mEnd)
+        return nullptr;
+    const unsigned char type = *mData;
+    mData ++;
+
+    const xmlChar *name = nullptr;
+    const xmlChar *content = nullptr;
+    switch (type)
+    {
+        case NODE_TEXT:
+            if (!readString(content))
+                return nullptr;
+            return newText(doc, content);
+        case NODE_CDATA:
+            if (!readString(content))
+                return nullptr;
+            return xmlNewCDataBlock(doc, content,
+                xmlStrlen(content));
+        case NODE_COMMENT:
+            if (!readString(content))
+                return nullptr;
+            return xmlNewDocComment(doc, content);
+        case NODE_PI:
+            if (!readString(name) || !readString(content))
+                return nullptr;
+            return xmlNewDocPI(doc, name, *content ? content : nullptr);
+        case NODE_ELEMENT:
+            break;
+        default:
+            return nullptr;
+    }
+
+    if (!readString(name))
+        return nullptr;
+    // name already owned by document dictionary
+    const XmlNodePtr node = xmlNewDocNodeEatName(doc, nullptr,
+        const_cast<xmlChar*>(name), nullptr);
+    if (!node)
+        return nullptr;
+
+    uint32_t attrs = 0;
+    bool res = readInt(attrs);
+    for (uint32_t f = 0; res && f < attrs; f ++)
+    {
+        const xmlChar *attrName = nullptr;
+        const xmlChar *value = nullptr;
+        res = readString(attrName) && readString(value);
+        if (res)
+        {
+            const xmlAttrPtr attr = xmlNewProp(node, attrName, nullptr);
+            const XmlNodePtr text = newText(doc, value);
+            if (!attr || !text)
+            {
+                if (text)
+                    xmlFreeNode(text);
+                res = false;
+                break;
+            }
+            text->parent = reinterpret_cast<XmlNodePtr>(attr);
+            attr->children = text;
+            attr->last = text;
+        }
+    }
+    if (!res || !readNodes(doc, node))
+    {
+        xmlFreeNode(node);
+        return nullptr;
+    }
+    return node;
+}
+
+xmlDocPtr CacheReader::load(const std::string &stamp)
+{
+    if (static_cast<size_t>(mEnd - mData) < 4
+        || memcmp(mData, cacheMagic, 4))
+    {
+        return nullptr;
+    }
+    mData += 4;
+
+    uint32_t val = 0;
+    if (!readInt(val) || val != cacheVersion)
+        return nullptr;
+    if (!readInt(val) || val != cacheByteOrder)
+        return nullptr;
+    if (!readInt(val) || val != stamp.size()
+        || static_cast<size_t>(mEnd - mData) < val
+        || memcmp(mData, stamp.c_str(), val))
+    {
+        return nullptr;
+    }
+    mData += val;
+
+    uint32_t strings = 0;
+    if (!readInt(strings))
+        return nullptr;
+    // all strings go to document dictionary, so nodes share them
+    // instead of copying each value
+    xmlDocPtr doc = xmlNewDoc(reinterpret_cast<const xmlChar*>("1.0"));
+    doc->dict = xmlDictCreate();
+    if (!doc->dict)
+    {
+        xmlFreeDoc(doc);
+        return nullptr;
+    }
+    mStrings.reserve(strings);
+    for (uint32_t f = 0; f < strings; f ++)
+    {
+        uint32_t len = 0;
+        const xmlChar *str = nullptr;
+        if (readInt(len) && static_cast<size_t>(mEnd - mData) >= len)
+            str = xmlDictLookup(doc->dict, mData, static_cast<int>(len));
+        if (!str)
+        {
+            xmlFreeDoc(doc);
+            return nullptr;
+        }
+        mStrings.push_back(str);
+        mData += len;
+    }
+
+    if (!readNodes(doc, reinterpret_cast<XmlNodePtr>(doc))
+        || mData != mEnd || !xmlDocGetRootElement(doc))
+    {
+        xmlFreeDoc(doc);
+        return nullptr;
+    }
+    return doc;
+}
+
+static std::string getCacheName(const std::string &fileName)
+{
+    std::string name = fileName;
+    const size_t sz = name.size();
+    for (size_t f = 0; f < sz; f ++)
+    {
+        const char c = name[f];
+        if (c == '/' || c == '\\' || c == ':')
+            name[f] = '_';
+    }
+    return std::string(mDir).append("/").append(name).append(".bin");
+}
+
+namespace XmlCache
+{
+    void setDir(const std::string &dir)
+    {
+        mDir = dir;
+        if (!mDir.empty() && mkdir_r(mDir.c_str()))
+        {
+            logger->log("Cant create xml cache dir: %s", mDir.c_str());
+            mDir.clear();
+        }
+    }
+
+    std::string getStamp(const std::string &fileName,
+                         const int size)
+    {
+        const char *const dir = PhysFs::getRealDir(fileName.c_str());
+        return strprintf("%s|%lld|%d", dir ? dir : "",
+            static_cast<long long>(PhysFs::getLastModTime(
+            fileName.c_str())), size);
+    }
+
+    xmlDocPtr load(const std::string &fileName,
+                   const std::string &stamp)
+    {
+        if (mDir.empty())
+            return nullptr;
+
+        FILE *const file = fopen(getCacheName(fileName).c_str(), "rb");
+        if (!file)
+            return nullptr;
+        fseek(file, 0, SEEK_END);
+        const long fileSize = ftell(file);
+        rewind(file);
+        if (fileSize <= 0)
+        {
+            fclose(file);
+            return nullptr;
+        }
+        std::vector<unsigned char> buf(static_cast<size_t>(fileSize));
+        const size_t read = fread(&buf[0], 1, buf.size(), file);
+        fclose(file);
+        if (read != buf.size())
+            return nullptr;
+
+        CacheReader reader(&buf[0], buf.size());
+        return reader.load(stamp);
+    }
+
+    bool save(const std::string &fileName,
+              const std::string &stamp,
+              const xmlDocPtr doc)
+    {
+        if (mDir.empty() || !doc)
+            return false;
+
+        CacheWriter writer;
+        if (!writer.writeNodes(doc->children))
+        {
+            logger->log("Xml cache not supports nodes in %s",
+                fileName.c_str());
+            return false;
+        }
+
+        const std::string name = getCacheName(fileName);
+        const std::string tempName = name + ".tmp";
+        FILE *const file = fopen(tempName.c_str(), "wb");
+        if (!file)
+            return false;
+        const bool res = writer.save(file, stamp);
+        fclose(file);
+        if (!res || Files::renameFile(tempName, name))
+        {
+            ::remove(tempName.c_str());
+            return false;
+        }
+        return true;
+    }
+}  // namespace XmlCache
@@ -0,0 +1,69 @@
+/*
+ *  The ManaPlus Client
+ *  Copyright (C) 2011-2014  The ManaPlus Developers
+ *
+ *  This file is part of The ManaPlus Client.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef UTILS_XMLCACHE_H
+#define UTILS_XMLCACHE_H
+
+#include <libxml/tree.h>
+
+#include <string>
+
+#include "localconsts.h"
+
+/**
+ * Binary snapshots of parsed xml database files.
+ *
+ * Snapshot stores document tree with interned strings and is keyed by
+ * stamp of source xml file, so source file not read if snapshot is actual.
+ * Elements, attributes, text, cdata, comments and processing instructions
+ * are stored. Documents with namespaces or other nodes are not cached.
+ * Stale or broken snapshots are ignored and source file is parsed as usual.
+ */
+namespace XmlCache
+{
+    /**
+     * Sets directory for snapshots. Empty directory disables cache.
+     */
+    void setDir(const std::string &dir);
+
+    /**
+     * Returns stamp of source file in PhysFS from its real directory,
+     * modification time and size.
+     */
+    std::string getStamp(const std::string &fileName,
+                         const int size) A_WARN_UNUSED;
+
+    /**
+     * Builds document from snapshot of given source file,
+     * or returns nullptr if there is no snapshot with same stamp.
+     */
+    xmlDocPtr load(const std::string &fileName,
+                   const std::string &stamp) A_WARN_UNUSED;
+
+    /**
+     * Saves snapshot of document parsed from given source file.
+     * Returns false if document can't be cached.
+     */
+    bool save(const std::string &fileName,
+              const std::string &stamp,
+              const xmlDocPtr doc);
+}  // namespace XmlCache
+
+#endif  // UTILS_XMLCACHE_H
@@ -0,0 +1,164 @@
+/*
+ *  The ManaPlus Client
+ *  Copyright (C) 2014  The ManaPlus Developers
+ *
+ *  This file is part of The ManaPlus Client.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "utils/xmlcache.h"
+
+#include "logger.h"
+
+#include "gtest/gtest.h"
+
+#include "utils/xml.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <string>
+
+#include "debug.h"
+
+static const char *const cacheDir = "xmlcachetest";
+
+static const char *const testXml =
+    "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
+    "<!-- header comment -->\n"
+    "<?test-pi some data?>\n"
+    "<items>\n"
+    "    <!-- item comment -->\n"
+    "    <item id=\"1\" name=\"A &amp; B\" description=\"\"/>\n"
+    "    <item id=\"2\">text &lt;value&gt;<![CDATA[raw <data>]]></item>\n"
+    "    <?inner?>\n"
+    "    <sprite variant=\"1\">sprite.xml|#000000</sprite>\n"
+    "</items>\n";
+
+static void init()
+{
+    if (!logger)
+        logger = new Logger();
+    XmlCache::setDir(cacheDir);
+}
+
+static std::string toString(const xmlChar *const str)
+{
+    return str ? reinterpret_cast<const char*>(str) : "";
+}
+
+static void compareNodes(const XmlNodePtr node1, const XmlNodePtr node2)
+{
+    XmlNodePtr n1 = node1;
+    XmlNodePtr n2 = node2;
+    for (; n1 && n2; n1 = n1->next, n2 = n2->next)
+    {
+        EXPECT_EQ(n1->type, n2->type);
+        EXPECT_EQ(toString(n1->name), toString(n2->name));
+        EXPECT_EQ(toString(n1->content), toString(n2->content));
+
+        xmlAttrPtr a1 = n1->properties;
+        xmlAttrPtr a2 = n2->properties;
+        for (; a1 && a2; a1 = a1->next, a2 = a2->next)
+        {
+            EXPECT_EQ(toString(a1->name), toString(a2->name));
+            xmlChar *const v1 = xmlNodeListGetString(n1->doc,
+                a1->children, 1);
+            xmlChar *const v2 = xmlNodeListGetString(n2->doc,
+                a2->children, 1);
+            EXPECT_EQ(toString(v1), toString(v2));
+            xmlFree(v1);
+            xmlFree(v2);
+        }
+        EXPECT_TRUE(!a1 && !a2);
+
+        compareNodes(n1->children, n2->children);
+    }
+    EXPECT_TRUE(!n1 && !n2);
+}
+
+TEST(xmlcache, roundTrip)
+{
+    init();
+    const xmlDocPtr doc = xmlParseMemory(testXml,
+        static_cast<int>(strlen(testXml)));
+    ASSERT_TRUE(doc != nullptr);
+
+    EXPECT_TRUE(XmlCache::save("test/items.xml", "stamp1", doc));
+    const xmlDocPtr doc2 = XmlCache::load("test/items.xml", "stamp1");
+    ASSERT_TRUE(doc2 != nullptr);
+
+    compareNodes(doc->children, doc2->children);
+    const XmlNodePtr root = xmlDocGetRootElement(doc2);
+    ASSERT_TRUE(root != nullptr);
+    EXPECT_EQ("items", toString(root->name));
+
+    xmlFreeDoc(doc2);
+    xmlFreeDoc(doc);
+}
+
+TEST(xmlcache, stale)
+{
+    init();
+    const xmlDocPtr doc = xmlParseMemory(testXml,
+        static_cast<int>(strlen(testXml)));
+    ASSERT_TRUE(doc != nullptr);
+
+    EXPECT_TRUE(XmlCache::save("test/items.xml", "stamp1", doc));
+    EXPECT_TRUE(XmlCache::load("test/items.xml", "stamp2") == nullptr);
+    EXPECT_TRUE(XmlCache::load("test/other.xml", "stamp1") == nullptr);
+    xmlFreeDoc(doc);
+}
+
+TEST(xmlcache, broken)
+{
+    init();
+    const xmlDocPtr doc = xmlParseMemory(testXml,
+        static_cast<int>(strlen(testXml)));
+    ASSERT_TRUE(doc != nullptr);
+    EXPECT_TRUE(XmlCache::save("test/items.xml", "stamp1", doc));
+    xmlFreeDoc(doc);
+
+    // cut snapshot in middle of nodes
+    const std::string name = std::string(cacheDir).append(
+        "/test_items.xml.bin");
+    FILE *file = fopen(name.c_str(), "rb");
+    ASSERT_TRUE(file != nullptr);
+    char buf[4096];
+    const size_t sz = fread(buf, 1, sizeof(buf), file);
+    fclose(file);
+    ASSERT_TRUE(sz > 10);
+    file = fopen(name.c_str(), "wb");
+    ASSERT_TRUE(file != nullptr);
+    EXPECT_EQ(sz - 10, fwrite(buf, 1, sz - 10, file));
+    fclose(file);
+
+    EXPECT_TRUE(XmlCache::load("test/items.xml", "stamp1") == nullptr);
+}
+
+TEST(xmlcache, namespaces)
+{
+    init();
+    const char *const xml =
+        "<items xmlns:t=\"http://example.com/t\">\n"
+        "    <t:item id=\"1\"/>\n"
+        "</items>\n";
+    const xmlDocPtr doc = xmlParseMemory(xml, static_cast<int>(strlen(xml)));
+    ASSERT_TRUE(doc != nullptr);
+
+    EXPECT_FALSE(XmlCache::save("test/ns.xml", "stamp1", doc));
+    EXPECT_TRUE(XmlCache::load("test/ns.xml", "stamp1") == nullptr);
+    xmlFreeDoc(doc);
+}
@@ -0,0 +1,232 @@
+/*
+ *  The ManaPlus Client
+ *  Copyright (C) 2011-2014  The ManaPlus Developers
+ *
+ *  This file is part of The ManaPlus Client.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "utils/xmlpreloader.h"
+
+#include "logger.h"
+
+#include "utils/physfstools.h"
+#include "utils/sdlhelper.h"
+#include "utils/xml.h"
+#include "utils/xmlcache.h"
+
+#include <SDL_thread.h>
+
+#include <map>
+#include <set>
+
+#ifndef USE_SDL2
+#include <unistd.h>
+#endif
+
+#include "debug.h"
+
+namespace
+{
+    const unsigned int maxThreads = 8;
+
+    StringVect mQueue;
+    std::set<std::string> mQueued;
+    std::map<std::string, xmlDocPtr> mDocs;
+    SDL_mutex *mMutex = nullptr;
+    SDL_cond *mCondition = nullptr;
+    size_t mNext = 0;
+    int mBusy = 0;
+}  // namespace
+
+static void preloadErrorLogger(void *ctx, const char *msg A_UNUSED, ...)
+{
+    // errors will be reported by main thread while parsing file again
+    *static_cast<bool*>(ctx) = false;
+}
+
+static unsigned int getThreadsCount()
+{
+    int cpus = 2;
+#ifdef USE_SDL2
+    cpus = SDL_GetCPUCount();
+#elif defined(_SC_NPROCESSORS_ONLN)
+    cpus = static_cast<int>(sysconf(_SC_NPROCESSORS_ONLN));
+#endif
+    if (cpus < 1)
+        return 1;
+    if (static_cast<unsigned int>(cpus) > maxThreads)
+        return maxThreads;
+    return static_cast<unsigned int>(cpus);
+}
+
+static xmlDocPtr parseFile(const std::string &fileName, const bool &valid)
+{
+    if (!PhysFs::exists(fileName.c_str()))
+        return nullptr;
+    PHYSFS_file *const file = PhysFs::openRead(fileName.c_str());
+    if (!file)
+        return nullptr;
+
+    const int size = static_cast<int>(PHYSFS_fileLength(file));
+    const std::string stamp = XmlCache::getStamp(fileName, size);
+    xmlDocPtr doc = XmlCache::load(fileName, stamp);
+    if (doc)
+    {
+        PHYSFS_close(file);
+        return doc;
+    }
+
+    char *const data = static_cast<char*>(calloc(size, 1));
+    PHYSFS_read(file, data, 1, size);
+    PHYSFS_close(file);
+
+    doc = xmlParseMemory(data, size);
+    if (doc && valid)
+        XmlCache::save(fileName, stamp, doc);
+    free(data);
+    return doc;
+}
+
+static void getIncludes(const xmlDocPtr doc, StringVect &list)
+{
+    const XmlNodePtr rootNode = xmlDocGetRootElement(doc);
+    if (!rootNode)
+        return;
+    for_each_xml_child_node(node, rootNode)
+    {
+        if (xmlNameEqual(node, "include"))
+        {
+            const std::string name = XML::getProperty(node, "name", "");
+            if (!name.empty())
+                list.push_back(name);
+        }
+    }
+}
+
+static int SDLCALL preloadThread(void *ptr A_UNUSED)
+{
+    bool valid = true;
+    xmlSetGenericErrorFunc(&valid, &preloadErrorLogger);
+
+    SDL_mutexP(mMutex);
+    while (true)
+    {
+        if (mNext >= mQueue.size())
+        {
+            // other threads still can add included files
+            if (!mBusy)
+                break;
+            SDL_CondWait(mCondition, mMutex);
+            continue;
+        }
+        const std::string fileName = mQueue[mNext];
+        mNext ++;
+        mBusy ++;
+        SDL_mutexV(mMutex);
+
+        valid = true;
+        xmlDocPtr doc = parseFile(fileName, valid);
+        if (doc && !valid)
+        {
+            xmlFreeDoc(doc);
+            doc = nullptr;
+        }
+        StringVect includes;
+        if (doc)
+            getIncludes(doc, includes);
+
+        SDL_mutexP(mMutex);
+        mBusy --;
+        if (doc)
+            mDocs[fileName] = doc;
+        FOR_EACH (StringVectCIter, it, includes)
+        {
+            if (mQueued.insert(*it).second)
+                mQueue.push_back(*it);
+        }
+        SDL_CondBroadcast(mCondition);
+    }
+    SDL_mutexV(mMutex);
+    return 0;
+}
+
+namespace XmlPreloader
+{
+    void preload(const StringVect &files)
+    {
+        clear();
+        FOR_EACH (StringVectCIter, it, files)
+        {
+            const std::string &name = *it;
+            if (!name.empty() && mQueued.insert(name).second)
+                mQueue.push_back(name);
+        }
+        if (mQueue.empty())
+            return;
+
+        mMutex = SDL_CreateMutex();
+        mCondition = SDL_CreateCond();
+        mNext = 0;
+        mBusy = 0;
+
+        unsigned int threads = getThreadsCount();
+        if (threads > mQueue.size())
+            threads = static_cast<unsigned int>(mQueue.size());
+        SDL_Thread **const workers = new SDL_Thread*[threads];
+        for (unsigned int f = 0; f < threads; f ++)
+        {
+            workers[f] = SDL::createThread(&preloadThread,
+                "xmlpreloader", nullptr);
+        }
+        for (unsigned int f = 0; f < threads; f ++)
+        {
+            if (workers[f])
+                SDL_WaitThread(workers[f], nullptr);
+        }
+        delete [] workers;
+
+        SDL_DestroyCond(mCondition);
+        mCondition = nullptr;
+        SDL_DestroyMutex(mMutex);
+        mMutex = nullptr;
+
+        logger->log("Preloaded %u xml files in %u threads",
+            static_cast<unsigned int>(mDocs.size()), threads);
+    }
+
+    xmlDocPtr take(const std::string &fileName)
+    {
+        const std::map<std::string, xmlDocPtr>::iterator
+            it = mDocs.find(fileName);
+        if (it == mDocs.end())
+            return nullptr;
+        xmlDocPtr doc = (*it).second;
+        mDocs.erase(it);
+        return doc;
+    }
+
+    void clear()
+    {
+        for (std::map<std::string, xmlDocPtr>::iterator it = mDocs.begin(),
+             it_end = mDocs.end(); it != it_end; ++ it)
+        {
+            xmlFreeDoc((*it).second);
+        }
+        mDocs.clear();
+        mQueue.clear();
+        mQueued.clear();
+    }
+}  // namespace XmlPreloader
@@ -0,0 +1,57 @@
+/*
+ *  The ManaPlus Client
+ *  Copyright (C) 2011-2014  The ManaPlus Developers
+ *
+ *  This file is part of The ManaPlus Client.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef UTILS_XMLPRELOADER_H
+#define UTILS_XMLPRELOADER_H
+
+#include "utils/stringvector.h"
+
+#include <libxml/tree.h>
+
+#include "localconsts.h"
+
+/**
+ * Parses xml databases in worker threads before they are loaded.
+ *
+ * Databases still read own files with XML::Document on main thread in
+ * dependency order, but get already parsed documents from here.
+ * Included files found in preloaded documents are preloaded too.
+ */
+namespace XmlPreloader
+{
+    /**
+     * Parses given files and all files included from them.
+     * Returns after all files are parsed.
+     */
+    void preload(const StringVect &files);
+
+    /**
+     * Returns preloaded document and passes its ownership to caller,
+     * or nullptr if file was not preloaded.
+     */
+    xmlDocPtr take(const std::string &fileName) A_WARN_UNUSED;
+
+    /**
+     * Frees documents what was not taken.
+     */
+    void clear();
+}  // namespace XmlPreloader
+
+#endif  // UTILS_XMLPRELOADER_H